@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "aabb.h"
+#include "bench_timing.h"
+#include "dynamic_aabb_tree.h"
+#include "frustum.h"
+
+// Compares DynamicAabbTree queries with linear scans over the same boxes,
+// for 10k, 100k and 1M objects spread over a flat belt like the asteroid
+// field. Also times the refit of 10% of the objects moving each frame.
+
+namespace {
+
+	using gl::Measure;
+
+	bool Visible(const gl::Frustum& frustum, const gl::Aabb& box)
+	{
+		const glm::vec3 center = box.GetCenter();
+		const glm::vec3 extents = box.GetExtents();
+		for (const auto& plane : frustum.planes)
+		{
+			const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			const float radius =
+				extents.x * std::abs(plane.x) +
+				extents.y * std::abs(plane.y) +
+				extents.z * std::abs(plane.z);
+			if (distance < -radius) return false;
+		}
+		return true;
+	}
+
+	bool HitBySegment(
+		const gl::Aabb& box,
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance)
+	{
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+			const float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+		return tMin <= tMax;
+	}
+
+	void Run(std::size_t count)
+	{
+		// Same density for every size: the belt grows with the count.
+		const float radius = 15.0f * std::sqrt(static_cast<float>(count) / 100000.0f);
+		std::mt19937 generator(5300);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+		std::vector<gl::Aabb> boxes(count);
+		for (auto& box : boxes)
+		{
+			const float angle = 6.2831853f * unit(generator);
+			const float distance = radius * (0.6f + 0.4f * unit(generator));
+			const glm::vec3 center(
+				distance * std::cos(angle),
+				signedUnit(generator),
+				distance * std::sin(angle));
+			box = gl::Aabb::FromSphere(center, 0.05f + 0.2f * unit(generator));
+		}
+
+		gl::DynamicAabbTree tree(0.1f);
+		std::vector<int> proxies(count);
+		const double buildTime = Measure(1, [&]()
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					proxies[i] = tree.CreateProxy(boxes[i], static_cast<std::uint32_t>(i));
+				}
+			});
+
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+		// Camera inside the belt looking along it, as in the demo.
+		const glm::mat4 view = glm::lookAt(
+			glm::vec3(radius * 0.8f, 1.0f, 0.0f),
+			glm::vec3(radius * 0.8f, 0.0f, -radius),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const gl::Frustum frustum(projection * view);
+		const glm::vec3 sphereCenter(radius * 0.8f, 0.0f, 0.0f);
+		const float sphereRadius = 1.0f;
+		const glm::vec3 rayOrigin(-radius * 1.5f, 0.0f, 0.3f);
+		const glm::vec3 rayDirection = glm::normalize(glm::vec3(1.0f, 0.01f, 0.02f));
+		const glm::vec3 inverseDirection = 1.0f / rayDirection;
+		const float rayLength = radius * 3.0f;
+
+		std::vector<std::uint32_t> result;
+		result.reserve(count);
+		std::size_t frustumHits = 0;
+		std::size_t sphereHits = 0;
+		std::size_t rayHits = 0;
+		constexpr int kIterations = 11;
+
+		const double treeFrustum = Measure(kIterations, [&]()
+			{
+				result.clear();
+				tree.QueryFrustum(frustum, result);
+				frustumHits = result.size();
+			});
+		const double linearFrustum = Measure(kIterations, [&]()
+			{
+				result.clear();
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					if (Visible(frustum, boxes[i])) result.push_back(static_cast<std::uint32_t>(i));
+				}
+			});
+		const double treeSphere = Measure(kIterations, [&]()
+			{
+				result.clear();
+				tree.QuerySphere(sphereCenter, sphereRadius, result);
+				sphereHits = result.size();
+			});
+		const double linearSphere = Measure(kIterations, [&]()
+			{
+				result.clear();
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					const glm::vec3 closest = glm::clamp(sphereCenter, boxes[i].min, boxes[i].max) - sphereCenter;
+					if (glm::dot(closest, closest) <= sphereRadius * sphereRadius)
+					{
+						result.push_back(static_cast<std::uint32_t>(i));
+					}
+				}
+			});
+		const double treeRay = Measure(kIterations, [&]()
+			{
+				result.clear();
+				tree.QueryRay(rayOrigin, rayDirection, rayLength, result);
+				rayHits = result.size();
+			});
+		const double linearRay = Measure(kIterations, [&]()
+			{
+				result.clear();
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					if (HitBySegment(boxes[i], rayOrigin, inverseDirection, rayLength))
+					{
+						result.push_back(static_cast<std::uint32_t>(i));
+					}
+				}
+			});
+
+		// 10% of the objects move by about a box size per frame.
+		std::size_t reinserted = 0;
+		const double refit = Measure(kIterations, [&]()
+			{
+				for (std::size_t i = 0; i < count; i += 10)
+				{
+					const glm::vec3 move(0.05f * signedUnit(generator), 0.0f, 0.05f * signedUnit(generator));
+					boxes[i].min += move;
+					boxes[i].max += move;
+					reinserted += tree.MoveProxy(proxies[i], boxes[i], move) ? 1 : 0;
+				}
+			});
+
+		std::cout
+			<< "objects: " << count << " (tree height " << tree.GetHeight() << ")\n"
+			<< "  build:          " << buildTime << " ms\n"
+			<< "  frustum (" << frustumHits << " hits): tree " << treeFrustum
+			<< " ms, linear " << linearFrustum << " ms\n"
+			<< "  sphere (" << sphereHits << " hits):  tree " << treeSphere
+			<< " ms, linear " << linearSphere << " ms\n"
+			<< "  ray (" << rayHits << " hits):     tree " << treeRay
+			<< " ms, linear " << linearRay << " ms\n"
+			<< "  refit 10%:      " << refit << " ms ("
+			<< reinserted / kIterations << " reinserted per frame)\n";
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	for (const std::size_t count : { 10000u, 100000u, 1000000u })
+	{
+		Run(count);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench_field.h"
+#include "bench_timing.h"
+#include "frustum.h"
+#include "instance_kernels.h"
+#include "job_system.h"
+
+// Measures the asteroid culling pipeline of Instancing without a GL
+// context: advance + cull (8 spheres per step) and compaction of the
+// visible matrices, for one million instances.
+
+namespace {
+
+	using gl::Median;
+	using gl::milliseconds;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	constexpr std::size_t kCount = 1000000;
+	constexpr int kIterations = 20;
+	constexpr std::size_t kChunk = gl::kInstanceChunkSize;
+
+	gl::JobSystem jobSystem;
+	gl::InstanceSoA state = gl::MakeAsteroidField(kCount);
+	const float boundsRadius = 2.5f;
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	const glm::mat4 view = glm::lookAt(
+		glm::vec3(0.0f, 2.0f, 30.0f),
+		glm::vec3(0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	const gl::Frustum frustum(projection * view);
+
+	const std::size_t chunkCount = (kCount + kChunk - 1) / kChunk;
+	std::vector<std::uint32_t> visibleIndices(kCount);
+	std::vector<std::size_t> offsets(chunkCount + 1);
+	std::vector<glm::mat4> instanceBuffer(kCount);
+
+	std::vector<double> cullTimes;
+	std::vector<double> compactTimes;
+	std::vector<double> allTimes;
+	std::size_t visible = 0;
+	for (int iteration = 0; iteration < kIterations; ++iteration)
+	{
+		const float time = 0.016f * static_cast<float>(iteration);
+
+		const auto cullStart = std::chrono::steady_clock::now();
+		jobSystem.ParallelFor(kCount, kChunk, [&](std::size_t begin, std::size_t end)
+			{
+				gl::AdvanceInstances(state, begin, end, time, glm::vec3(0.0f));
+				offsets[begin / kChunk] = gl::CullInstances(
+					state, begin, end, frustum, boundsRadius, &visibleIndices[begin]);
+			});
+		std::size_t total = 0;
+		for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			const std::size_t count = offsets[chunk];
+			offsets[chunk] = total;
+			total += count;
+		}
+		offsets[chunkCount] = total;
+		visible = total;
+
+		const auto compactStart = std::chrono::steady_clock::now();
+		jobSystem.ParallelFor(kCount, kChunk, [&](std::size_t begin, std::size_t)
+			{
+				const std::size_t chunk = begin / kChunk;
+				gl::WriteInstanceTransforms(
+					state,
+					&visibleIndices[begin],
+					offsets[chunk + 1] - offsets[chunk],
+					instanceBuffer.data() + offsets[chunk]);
+			});
+		const auto compactEnd = std::chrono::steady_clock::now();
+
+		// Reference: no culling, every matrix written.
+		const auto allStart = std::chrono::steady_clock::now();
+		jobSystem.ParallelFor(kCount, kChunk, [&](std::size_t begin, std::size_t end)
+			{
+				gl::UpdateInstanceTransforms(
+					state, begin, end, time, glm::vec3(0.0f), instanceBuffer.data() + begin);
+			});
+		const auto allEnd = std::chrono::steady_clock::now();
+
+		cullTimes.push_back(milliseconds(compactStart - cullStart).count());
+		compactTimes.push_back(milliseconds(compactEnd - compactStart).count());
+		allTimes.push_back(milliseconds(allEnd - allStart).count());
+	}
+
+	const double perMillion = 1000000.0 / static_cast<double>(kCount);
+	std::cout
+		<< "threads:             " << jobSystem.GetThreadCount() << "\n"
+		<< "instances:           " << kCount << "\n"
+		<< "visible:             " << visible << "\n"
+		<< "culled:              " << kCount - visible << "\n"
+		<< "advance+cull:        " << Median(cullTimes) * perMillion << " ms / M instances\n"
+		<< "compact visible:     " << Median(compactTimes) * perMillion << " ms / M instances\n"
+		<< "total with culling:  "
+		<< (Median(cullTimes) + Median(compactTimes)) * perMillion << " ms / M instances\n"
+		<< "no culling (all):    " << Median(allTimes) * perMillion << " ms / M instances\n";
+	return EXIT_SUCCESS;
+}
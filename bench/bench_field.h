@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <random>
+
+#include <glm/glm.hpp>
+
+#include "instance_kernels.h"
+
+// The asteroid belt the benchmarks run the instance kernels on: the same
+// seed and distributions in every one of them, so their numbers compare.
+// A flatter, fixed radius version of Instancing::GenerateField.
+
+namespace gl {
+
+	inline InstanceSoA MakeAsteroidField(std::size_t count)
+	{
+		std::mt19937 generator(5300);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+		InstanceSoA state;
+		state.Resize(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const glm::vec3 axis = glm::normalize(glm::vec3(
+				signedUnit(generator), signedUnit(generator), 1.0f));
+			state.axisX[i] = axis.x;
+			state.axisY[i] = axis.y;
+			state.axisZ[i] = axis.z;
+			state.scale[i] = 0.05f + 0.2f * unit(generator);
+			state.orbitRadius[i] = 15.0f + 3.0f * signedUnit(generator);
+			state.orbitHeight[i] = 0.75f * signedUnit(generator);
+			state.orbitSpeed[i] = 0.5f * (0.9f + 0.2f * unit(generator));
+			state.orbitPhase[i] = 6.2831853f * unit(generator);
+			state.spinSpeed[i] = signedUnit(generator);
+		}
+		return state;
+	}
+
+} // End namespace gl.
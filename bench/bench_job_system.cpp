@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "bench_field.h"
+#include "bench_timing.h"
+#include "instance_kernels.h"
+#include "job_system.h"
+#include "task_graph.h"
+
+// Scalability of the job system from 1 thread to every hardware thread:
+//   parallel for  asteroid transforms of one million instances;
+//   task graph    16 tasks of uneven size fanning out of one task and
+//                 joining in another, each splitting its range again;
+//   nested        a parallel for whose chunks run parallel fors, the
+//                 outer chunks growing in size so threads must steal.
+
+namespace {
+
+	using gl::Measure;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	constexpr std::size_t kCount = 1000000;
+	constexpr std::size_t kChunk = gl::kInstanceChunkSize;
+	constexpr std::size_t kGraphTasks = 16;
+	constexpr int kIterations = 15;
+
+	gl::InstanceSoA state = gl::MakeAsteroidField(kCount);
+	std::vector<glm::mat4> instanceBuffer(kCount);
+	const auto updateRange = [&](std::size_t begin, std::size_t end, float time)
+		{
+			gl::UpdateInstanceTransforms(
+				state, begin, end, time, glm::vec3(0.0f), instanceBuffer.data() + begin);
+		};
+
+	// Task i of the graph covers a range proportional to i + 1.
+	std::vector<std::size_t> graphRanges(kGraphTasks + 1, 0);
+	for (std::size_t i = 0; i < kGraphTasks; ++i)
+	{
+		graphRanges[i + 1] = graphRanges[i] + (i + 1);
+	}
+	for (auto& bound : graphRanges)
+	{
+		bound = bound * kCount / graphRanges.back();
+	}
+
+	// An explicit thread count can go past the hardware threads.
+	const unsigned int maxThreads = argc > 1 ?
+		static_cast<unsigned int>(std::max(1, std::atoi(argv[1]))) :
+		std::max(1u, std::thread::hardware_concurrency());
+	double baseFor = 0.0;
+	double baseGraph = 0.0;
+	double baseNested = 0.0;
+	std::cout << "threads  parallel for (ms)  task graph (ms)  nested (ms)  steals\n";
+	for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+	{
+		gl::JobSystem jobSystem(threads - 1);
+
+		const double parallelFor = Measure(kIterations, [&](int iteration)
+			{
+				const float time = 0.016f * static_cast<float>(iteration);
+				jobSystem.ParallelFor(kCount, kChunk, [&](std::size_t begin, std::size_t end)
+					{
+						updateRange(begin, end, time);
+					});
+			});
+
+		gl::TaskGraph graph;
+		float graphTime = 0.0f;
+		const auto fanOut = graph.AddTask("fan out", []() {});
+		std::vector<gl::TaskGraph::TaskId> branches;
+		for (std::size_t i = 0; i < kGraphTasks; ++i)
+		{
+			branches.push_back(graph.AddTask("branch", [&, i]()
+				{
+					const std::size_t first = graphRanges[i];
+					jobSystem.ParallelFor(
+						graphRanges[i + 1] - first,
+						kChunk,
+						[&](std::size_t begin, std::size_t end)
+						{
+							updateRange(first + begin, first + end, graphTime);
+						});
+				}, { fanOut }));
+		}
+		graph.AddTask("fan in", []() {}, branches);
+		const double taskGraph = Measure(kIterations, [&](int iteration)
+			{
+				graphTime = 0.016f * static_cast<float>(iteration);
+				graph.Run(jobSystem);
+			});
+
+		const double nested = Measure(kIterations, [&](int iteration)
+			{
+				const float time = 0.016f * static_cast<float>(iteration);
+				jobSystem.ParallelFor(kGraphTasks, 1, [&](std::size_t outerBegin, std::size_t)
+					{
+						const std::size_t first = graphRanges[outerBegin];
+						jobSystem.ParallelFor(
+							graphRanges[outerBegin + 1] - first,
+							kChunk,
+							[&](std::size_t begin, std::size_t end)
+							{
+								updateRange(first + begin, first + end, time);
+							});
+					});
+			});
+
+		if (threads == 1)
+		{
+			baseFor = parallelFor;
+			baseGraph = taskGraph;
+			baseNested = nested;
+		}
+		std::cout
+			<< threads << "        "
+			<< parallelFor << " (x" << baseFor / parallelFor << ")  "
+			<< taskGraph << " (x" << baseGraph / taskGraph << ")  "
+			<< nested << " (x" << baseNested / nested << ")  "
+			<< jobSystem.GetStealCount() << "\n";
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "bench_timing.h"
+#include "fast_random.h"
+#include "job_system.h"
+#include "particle.h"
+
+// Measures one emitter at steady state without a GL context: advance,
+// swap-remove of the dead particles, emission, and the write of the
+// instance stream, with about one million particles alive.
+
+namespace {
+
+	using gl::Median;
+	using gl::milliseconds;
+
+	void ForEachChunk(gl::JobSystem& jobSystem, std::size_t count, const gl::JobSystem::RangeFunction& func)
+	{
+		jobSystem.ParallelFor(count, gl::kParticleChunkSize, func);
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	constexpr std::size_t kCapacity = 1000000;
+	constexpr float kDt = 1.0f / 60.0f;
+	// Particles live one second: this many per frame fill the emitter.
+	constexpr std::size_t kPerFrame = 16667;
+	constexpr int kWarmupFrames = 90;
+	constexpr int kFrames = 120;
+
+	gl::JobSystem jobSystem;
+	gl::FastRandom random(5300);
+	gl::ParticleSoA particles;
+	particles.Reserve(kCapacity);
+	std::vector<gl::ParticleInstance> instances(kCapacity);
+
+	std::vector<double> advanceTimes;
+	std::vector<double> removeTimes;
+	std::vector<double> emitTimes;
+	std::vector<double> writeTimes;
+	std::vector<double> singleThreadTimes;
+	for (int frame = 0; frame < kWarmupFrames + kFrames; ++frame)
+	{
+		const glm::vec2 origin(512.0f + 100.0f * static_cast<float>(frame % 7), 360.0f);
+
+		const auto advanceStart = std::chrono::steady_clock::now();
+		ForEachChunk(jobSystem, particles.count, [&](std::size_t begin, std::size_t end)
+			{
+				gl::AdvanceParticles(particles, begin, end, kDt);
+			});
+		const auto removeStart = std::chrono::steady_clock::now();
+		gl::RemoveDeadParticles(particles);
+		const auto emitStart = std::chrono::steady_clock::now();
+		gl::EmitParticles(particles, kPerFrame, origin, glm::vec2(3.0f, -1.0f), random);
+		const auto writeStart = std::chrono::steady_clock::now();
+		ForEachChunk(jobSystem, particles.count, [&](std::size_t begin, std::size_t end)
+			{
+				gl::WriteParticleInstances(particles, begin, end, instances.data() + begin);
+			});
+		const auto writeEnd = std::chrono::steady_clock::now();
+
+		// Reference: the same advance on one thread.
+		const auto singleStart = std::chrono::steady_clock::now();
+		gl::AdvanceParticles(particles, 0, particles.count, 0.0f);
+		const auto singleEnd = std::chrono::steady_clock::now();
+
+		if (frame < kWarmupFrames) continue;
+		advanceTimes.push_back(milliseconds(removeStart - advanceStart).count());
+		removeTimes.push_back(milliseconds(emitStart - removeStart).count());
+		emitTimes.push_back(milliseconds(writeStart - emitStart).count());
+		writeTimes.push_back(milliseconds(writeEnd - writeStart).count());
+		singleThreadTimes.push_back(milliseconds(singleEnd - singleStart).count());
+	}
+
+	const double total =
+		Median(advanceTimes) + Median(removeTimes) + Median(emitTimes) + Median(writeTimes);
+	std::cout
+		<< "threads:               " << jobSystem.GetThreadCount() << "\n"
+		<< "alive:                 " << particles.count << " / " << kCapacity << "\n"
+		<< "advance:               " << Median(advanceTimes) << " ms\n"
+		<< "advance (1 thread):    " << Median(singleThreadTimes) << " ms\n"
+		<< "swap-remove dead:      " << Median(removeTimes) << " ms\n"
+		<< "emit " << kPerFrame << ":            " << Median(emitTimes) << " ms\n"
+		<< "write instances:       " << Median(writeTimes) << " ms\n"
+		<< "total per frame:       " << total << " ms (budget 16.7 ms)\n";
+	return EXIT_SUCCESS;
+}
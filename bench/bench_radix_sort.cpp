@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "bench_timing.h"
+#include "fast_random.h"
+#include "job_system.h"
+#include "particle.h"
+#include "radix_sort.h"
+
+// Back-to-front particle sort at 100k, 1M and 4M particles: std::sort of
+// an index array by key against RadixSorter on one thread and on the job
+// system. Keys come from particle lifetimes, like ParticleGenerator::Draw.
+
+namespace {
+
+	using gl::Measure;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	constexpr int kIterations = 7;
+	gl::JobSystem jobSystem;
+	gl::RadixSorter singleThread;
+	gl::RadixSorter parallel(&jobSystem);
+	gl::FastRandom random(5300);
+
+	std::cout << "threads: " << jobSystem.GetThreadCount() << "\n";
+	for (const std::size_t count : { std::size_t(100000), std::size_t(1000000), std::size_t(4000000) })
+	{
+		gl::ParticleSoA particles;
+		particles.Reserve(count);
+		particles.count = count;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			particles.life[i] = random.NextFloat();
+		}
+		std::vector<std::uint32_t> keys(count);
+		gl::WriteParticleSortKeys(particles, 0, count, keys.data());
+
+		std::vector<std::uint32_t> reference(count);
+		const double stdSort = Measure(kIterations, [&]()
+			{
+				std::iota(reference.begin(), reference.end(), 0u);
+				std::sort(reference.begin(), reference.end(), [&](std::uint32_t a, std::uint32_t b)
+					{
+						return keys[a] < keys[b];
+					});
+			});
+
+		std::vector<std::uint32_t> order;
+		const double radixSingle = Measure(kIterations, [&]() { singleThread.SortIndices(keys, order); });
+		const double radixParallel = Measure(kIterations, [&]() { parallel.SortIndices(keys, order); });
+
+		bool sorted = true;
+		for (std::size_t i = 1; i < count; ++i)
+		{
+			sorted = sorted && keys[order[i - 1]] <= keys[order[i]];
+		}
+		std::cout
+			<< "particles:             " << count << (sorted ? "" : " (NOT SORTED)") << "\n"
+			<< "  std::sort:           " << stdSort << " ms\n"
+			<< "  radix, 1 thread:     " << radixSingle << " ms\n"
+			<< "  radix, job system:   " << radixParallel << " ms\n";
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bench_timing.h"
+#include "frame_packet.h"
+#include "render_thread.h"
+
+// Single threaded loop against the render thread, without a GL context.
+// Simulation burns CPU for a given time and records a packet of draws;
+// "rendering" walks the packet, burns CPU for the submission and sleeps
+// for the swap (driver and GPU time the CPU only waits on). Reports the
+// frame time (throughput) and the latency from the start of a frame's
+// simulation to the end of its swap.
+
+namespace {
+
+	using clock = std::chrono::steady_clock;
+	using gl::Median;
+	using gl::milliseconds;
+
+	struct Workload
+	{
+		double simulation;
+		double submission;
+		double swap;
+	};
+
+	struct Result
+	{
+		double frame;
+		double latency;
+	};
+
+	void Spin(double duration)
+	{
+		const auto end = clock::now() + std::chrono::duration_cast<clock::duration>(milliseconds(duration));
+		while (clock::now() < end)
+		{
+		}
+	}
+
+	void Simulate(const Workload& workload, gl::FramePacket& packet)
+	{
+		Spin(workload.simulation);
+		for (std::uint32_t i = 0; i < 1000; ++i)
+		{
+			gl::DrawItem draw;
+			draw.mesh = i;
+			packet.draws.push_back(draw);
+		}
+	}
+
+	void Render(const Workload& workload, const gl::FramePacket& packet)
+	{
+		volatile std::uint32_t sink = 0;
+		for (const auto& draw : packet.draws)
+		{
+			sink = sink + draw.mesh;
+		}
+		Spin(workload.submission);
+		std::this_thread::sleep_for(milliseconds(workload.swap));
+	}
+
+	Result RunSingleThread(const Workload& workload, int frames)
+	{
+		gl::FramePacket packet;
+		std::vector<double> frameTimes;
+		std::vector<double> latencies;
+		auto previous = clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			const auto start = clock::now();
+			packet.Clear();
+			Simulate(workload, packet);
+			Render(workload, packet);
+			const auto end = clock::now();
+			latencies.push_back(milliseconds(end - start).count());
+			frameTimes.push_back(milliseconds(end - previous).count());
+			previous = end;
+		}
+		return { Median(frameTimes), Median(latencies) };
+	}
+
+	Result RunRenderThread(const Workload& workload, int frames)
+	{
+		std::vector<double> latencies;
+		latencies.reserve(frames);
+		gl::RenderThread renderThread;
+		renderThread.Start([&](gl::FramePacket& packet)
+			{
+				Render(workload, packet);
+				// Only this thread writes latencies until Stop.
+				latencies.push_back(milliseconds(clock::now() - packet.simulationStart).count());
+			});
+		const auto start = clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			gl::FramePacket& packet = renderThread.BeginFrame();
+			Simulate(workload, packet);
+			renderThread.SubmitFrame();
+		}
+		renderThread.Stop();
+		const double frame = milliseconds(clock::now() - start).count() / frames;
+		return { frame, Median(latencies) };
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	constexpr int kFrames = 120;
+	const Workload workloads[] = {
+		{ 4.0, 2.0, 4.0 },
+		{ 8.0, 2.0, 6.0 },
+		{ 2.0, 2.0, 10.0 },
+		{ 10.0, 1.0, 1.0 },
+	};
+
+	std::cout << "threads: " << std::thread::hardware_concurrency() << "\n";
+	for (const auto& workload : workloads)
+	{
+		const Result single = RunSingleThread(workload, kFrames);
+		const Result threaded = RunRenderThread(workload, kFrames);
+		std::cout
+			<< "simulation " << workload.simulation << " ms, submission " << workload.submission
+			<< " ms, swap " << workload.swap << " ms\n"
+			<< "  single thread:  " << single.frame << " ms / frame, latency "
+			<< single.latency << " ms\n"
+			<< "  render thread:  " << threaded.frame << " ms / frame, latency "
+			<< threaded.latency << " ms\n";
+	}
+	return EXIT_SUCCESS;
+}
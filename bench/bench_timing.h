@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
+// Timing helpers of the standalone benchmarks (bench/*.cpp), which report
+// the median of a few runs rather than going through Google Benchmark.
+
+namespace gl {
+
+	using milliseconds = std::chrono::duration<double, std::milli>;
+
+	inline double Median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	// Median time in milliseconds of iterations calls to function, which
+	// may take the index of the iteration.
+	template <typename Function>
+	double Measure(int iterations, Function&& function)
+	{
+		std::vector<double> times;
+		times.reserve(iterations);
+		for (int iteration = 0; iteration < iterations; ++iteration)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			if constexpr (std::is_invocable_v<Function&, int>)
+			{
+				function(iteration);
+			}
+			else
+			{
+				function();
+			}
+			times.push_back(milliseconds(std::chrono::steady_clock::now() - start).count());
+		}
+		return Median(times);
+	}
+
+} // End namespace gl.
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+
+// Camera::GetViewMatrix, called by every program once or more per frame,
+// and the mouse look that rebuilds the camera vectors.
+
+namespace gl {
+
+	namespace {
+
+		void CameraViewMatrix(benchmark::State& state)
+		{
+			Camera camera(glm::vec3(50.0f, 90.0f, 50.0f));
+			for (auto _ : state)
+			{
+				benchmark::DoNotOptimize(camera.GetViewMatrix());
+			}
+		}
+
+		void CameraMouseMovement(benchmark::State& state)
+		{
+			Camera camera(glm::vec3(50.0f, 90.0f, 50.0f));
+			float offset = 1.0f;
+			for (auto _ : state)
+			{
+				camera.ProcessMouseMovement(offset, -offset);
+				offset = -offset;
+				benchmark::DoNotOptimize(camera.front);
+			}
+		}
+
+	} // namespace
+
+	BENCHMARK(CameraViewMatrix);
+	BENCHMARK(CameraMouseMovement);
+
+} // End namespace gl.
@@ -0,0 +1,54 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+
+#include "bench_field.h"
+#include "instance_kernels.h"
+
+// The per frame CPU work of Instancing in SimulationMode::Cpu: advance
+// every asteroid and write its model matrix (or compact record) to the
+// instance buffer, for 1k to 1M instances.
+
+namespace gl {
+
+	namespace {
+
+		void InstanceMatrices(benchmark::State& state)
+		{
+			const auto count = static_cast<std::size_t>(state.range(0));
+			InstanceSoA field = MakeAsteroidField(count);
+			std::vector<glm::mat4> matrices(count);
+			float time = 0.0f;
+			for (auto _ : state)
+			{
+				time += 1.0f / 60.0f;
+				UpdateInstanceTransforms(field, 0, count, time, glm::vec3(0.0f), matrices.data());
+				benchmark::DoNotOptimize(matrices.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		void CompactInstances(benchmark::State& state)
+		{
+			const auto count = static_cast<std::size_t>(state.range(0));
+			InstanceSoA field = MakeAsteroidField(count);
+			std::vector<CompactInstance> instances(count);
+			float time = 0.0f;
+			for (auto _ : state)
+			{
+				time += 1.0f / 60.0f;
+				UpdateCompactInstances(field, 0, count, time, glm::vec3(0.0f), instances.data());
+				benchmark::DoNotOptimize(instances.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+	} // namespace
+
+	BENCHMARK(InstanceMatrices)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+	BENCHMARK(CompactInstances)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+
+} // End namespace gl.
@@ -0,0 +1,84 @@
+#include "common_lib_bench.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <tiny_obj_loader.h>
+
+#include "model.h"
+
+// Loading of every mesh in data/meshes, in its two CPU halves: the OBJ
+// parse (tinyobjloader) and Model::BuildVertices, the per face corner
+// vertices and tangents the Model constructor uploads. Materials and
+// textures are left out, see bench_texture.cpp.
+
+namespace gl {
+
+	namespace {
+
+		void ParseObj(benchmark::State& state, const std::string& path)
+		{
+			std::error_code error;
+			const auto fileSize = std::filesystem::file_size(path, error);
+			for (auto _ : state)
+			{
+				tinyobj::ObjReader reader;
+				if (!reader.ParseFromFile(path))
+				{
+					state.SkipWithError(("Cannot load file: " + path).c_str());
+					return;
+				}
+				benchmark::DoNotOptimize(reader.GetShapes().data());
+			}
+			state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * fileSize));
+		}
+
+		void BuildVertices(benchmark::State& state, const std::string& path)
+		{
+			tinyobj::ObjReader reader;
+			if (!reader.ParseFromFile(path))
+			{
+				state.SkipWithError(("Cannot load file: " + path).c_str());
+				return;
+			}
+			std::vector<Vertex> vertices;
+			std::vector<std::uint32_t> indices;
+			std::size_t vertexCount = 0;
+			for (auto _ : state)
+			{
+				vertexCount = 0;
+				for (const auto& shape : reader.GetShapes())
+				{
+					Model::BuildVertices(shape, reader.GetAttrib(), vertices, indices);
+					vertexCount += vertices.size();
+					benchmark::DoNotOptimize(vertices.data());
+				}
+			}
+			state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * vertexCount));
+		}
+
+	} // namespace
+
+	void RegisterModelBenchmarks(const std::filesystem::path& dataDirectory)
+	{
+		std::error_code error;
+		std::vector<std::filesystem::path> paths;
+		for (const auto& entry : std::filesystem::directory_iterator(dataDirectory / "meshes", error))
+		{
+			if (entry.path().extension() == ".obj") paths.push_back(entry.path());
+		}
+		std::sort(paths.begin(), paths.end());
+		for (const auto& file : paths)
+		{
+			const std::string path = file.string();
+			const std::string name = file.filename().string();
+			benchmark::RegisterBenchmark(("ObjParse/" + name).c_str(), ParseObj, path)
+				->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark(("ModelBuildVertices/" + name).c_str(), BuildVertices, path)
+				->Unit(benchmark::kMillisecond);
+		}
+	}
+
+} // End namespace gl.
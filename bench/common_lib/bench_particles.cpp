@@ -0,0 +1,67 @@
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "job_system.h"
+#include "particle.h"
+#include "shader.h"
+#include "texture.h"
+
+// ParticleGenerator::Update at its steady state (as many particles dying
+// as spawned each frame), on the calling thread and on the job system.
+// The generator's GL buffers come from the mock, Update itself makes no
+// GL call. The random generator has its fixed default seed.
+
+namespace gl {
+
+	namespace {
+
+		constexpr unsigned int kCapacity = 1000000;
+		constexpr float kDt = 1.0f / 60.0f;
+
+		// A Shader without program, the generator only keeps it.
+		class NullShader : public Shader
+		{
+		public:
+			NullShader() = default;
+		};
+
+		void UpdateParticles(benchmark::State& state, JobSystem* jobSystem)
+		{
+			ParticleGenerator generator(
+				std::make_shared<NullShader>(),
+				std::make_shared<Texture>(),
+				kCapacity,
+				jobSystem);
+			const auto newParticles = static_cast<unsigned int>(state.range(0));
+			// Particles live one second: two seconds reach the steady
+			// state.
+			for (int frame = 0; frame < 120; ++frame)
+			{
+				generator.Update(kDt, glm::vec2(0.0f), glm::vec2(0.0f), newParticles);
+			}
+			for (auto _ : state)
+			{
+				generator.Update(kDt, glm::vec2(0.0f), glm::vec2(0.0f), newParticles);
+			}
+			state.SetItemsProcessed(
+				state.iterations() * static_cast<std::int64_t>(generator.GetLiveCount()));
+		}
+
+		void UpdateParticlesSingleThread(benchmark::State& state)
+		{
+			UpdateParticles(state, nullptr);
+		}
+
+		void UpdateParticlesJobSystem(benchmark::State& state)
+		{
+			static JobSystem jobSystem;
+			UpdateParticles(state, &jobSystem);
+		}
+
+	} // namespace
+
+	BENCHMARK(UpdateParticlesSingleThread)->Arg(1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(UpdateParticlesJobSystem)->Arg(1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+
+} // End namespace gl.
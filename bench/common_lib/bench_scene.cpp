@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+
+#include "components.h"
+#include "job_system.h"
+#include "scene.h"
+
+// Scene queries over a few hundred thousand entities: IntegrateVelocities
+// (reads Transform and Velocity, writes Transform) on the calling thread
+// and on the job system, a chunk query touching positions only, and the
+// same integration over an array of fat objects holding every component,
+// the layout the Scene replaces. Bytes processed count the components
+// each loop actually needs.
+
+namespace gl {
+
+	namespace {
+
+		constexpr float kDt = 1.0f / 60.0f;
+
+		// Every component side by side, as the removed GameObject held
+		// them.
+		struct FatObject
+		{
+			Transform transform;
+			Velocity velocity;
+			Renderable renderable;
+			Collider collider;
+			Emitter emitter;
+		};
+
+		// Half the entities also have a Collider: two archetypes match.
+		void Populate(Scene& scene, std::size_t count)
+		{
+			scene.Reserve<Transform, Velocity, Renderable>(count / 2);
+			scene.Reserve<Transform, Velocity, Renderable, Collider>(count - count / 2);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const float x = static_cast<float>(i % 1024);
+				const float z = static_cast<float>(i / 1024);
+				Transform transform;
+				transform.position = glm::vec3(x, 0.0f, z);
+				const Velocity velocity{ glm::vec3(1.0f, 0.0f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f) };
+				if (i % 2 == 0)
+				{
+					scene.CreateEntity(transform, velocity, Renderable{});
+				}
+				else
+				{
+					scene.CreateEntity(transform, velocity, Renderable{}, Collider{});
+				}
+			}
+		}
+
+		void SetProcessed(benchmark::State& state, std::size_t bytesPerEntity)
+		{
+			const auto count = static_cast<std::int64_t>(state.range(0));
+			state.SetItemsProcessed(state.iterations() * count);
+			state.SetBytesProcessed(state.iterations() * count * static_cast<std::int64_t>(bytesPerEntity));
+		}
+
+		void SceneIntegrate(benchmark::State& state, JobSystem* jobSystem)
+		{
+			Scene scene;
+			Populate(scene, static_cast<std::size_t>(state.range(0)));
+			for (auto _ : state)
+			{
+				IntegrateVelocities(scene, kDt, jobSystem);
+			}
+			SetProcessed(state, 2 * sizeof(Transform) + sizeof(Velocity));
+		}
+
+		void SceneIntegrateSingleThread(benchmark::State& state)
+		{
+			SceneIntegrate(state, nullptr);
+		}
+
+		void SceneIntegrateJobSystem(benchmark::State& state)
+		{
+			static JobSystem jobSystem;
+			SceneIntegrate(state, &jobSystem);
+		}
+
+		void SceneSumPositions(benchmark::State& state)
+		{
+			Scene scene;
+			Populate(scene, static_cast<std::size_t>(state.range(0)));
+			for (auto _ : state)
+			{
+				glm::vec3 sum(0.0f);
+				scene.ForEachChunk<const Transform>([&sum](std::size_t count, const Transform* transforms)
+					{
+						for (std::size_t i = 0; i < count; ++i)
+						{
+							sum += transforms[i].position;
+						}
+					});
+				benchmark::DoNotOptimize(sum);
+			}
+			SetProcessed(state, sizeof(Transform));
+		}
+
+		void FatObjectIntegrate(benchmark::State& state)
+		{
+			std::vector<FatObject> objects(static_cast<std::size_t>(state.range(0)));
+			for (auto& object : objects)
+			{
+				object.velocity = { glm::vec3(1.0f, 0.0f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f) };
+			}
+			for (auto _ : state)
+			{
+				for (auto& object : objects)
+				{
+					object.transform.position += object.velocity.linear * kDt;
+					const glm::quat spin(0.0f, object.velocity.angular * (0.5f * kDt));
+					object.transform.rotation = glm::normalize(
+						object.transform.rotation + spin * object.transform.rotation);
+				}
+				benchmark::ClobberMemory();
+			}
+			SetProcessed(state, 2 * sizeof(Transform) + sizeof(Velocity));
+		}
+
+		void SceneCreateDestroy(benchmark::State& state)
+		{
+			Scene scene;
+			std::vector<Entity> entities(static_cast<std::size_t>(state.range(0)));
+			for (auto _ : state)
+			{
+				for (auto& entity : entities)
+				{
+					entity = scene.CreateEntity(Transform{}, Velocity{});
+				}
+				for (const Entity entity : entities)
+				{
+					scene.DestroyEntity(entity);
+				}
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+	} // namespace
+
+	BENCHMARK(SceneIntegrateSingleThread)->Arg(1 << 18)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(SceneIntegrateJobSystem)->Arg(1 << 18)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(SceneSumPositions)->Arg(1 << 18)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(FatObjectIntegrate)->Arg(1 << 18)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(SceneCreateDestroy)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+
+} // End namespace gl.
@@ -0,0 +1,160 @@
+#include "common_lib_bench.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "job_system.h"
+#include "level.h"
+#include "model.h"
+#include "scene_file.h"
+
+// Loading of every level in data/scenes. SceneCook is the JSON to cooked
+// file step, SceneFileOpen what remains of it at load time: a map, the
+// fixups and the checks. LevelLoad is the whole load through Level, the
+// models parsed side by side on a JobSystem; LevelLoadSequential is the
+// path the demos had, one Model constructor after the other, then the
+// entities from hard-coded transforms.
+
+namespace gl {
+
+	namespace {
+
+		void SceneCook(benchmark::State& state, const std::filesystem::path& source)
+		{
+			const auto destination = std::filesystem::temp_directory_path() / "CommonLib_bench.scene";
+			for (auto _ : state)
+			{
+				if (!CookScene(source, destination))
+				{
+					state.SkipWithError(("Cannot cook " + source.string()).c_str());
+					return;
+				}
+			}
+			std::error_code error;
+			std::filesystem::remove(destination, error);
+		}
+
+		void SceneFileOpen(benchmark::State& state, const std::filesystem::path& source)
+		{
+			auto cooked = source;
+			cooked.replace_extension(".scene");
+			if (!CookScene(source, cooked))
+			{
+				state.SkipWithError(("Cannot cook " + source.string()).c_str());
+				return;
+			}
+			SceneFile file;
+			for (auto _ : state)
+			{
+				if (!file.Open(cooked))
+				{
+					state.SkipWithError(("Cannot open " + cooked.string()).c_str());
+					return;
+				}
+				benchmark::DoNotOptimize(file.GetHeader().entities);
+				file.Close();
+			}
+		}
+
+		void LevelLoad(benchmark::State& state, const std::filesystem::path& source)
+		{
+			static JobSystem jobSystem;
+			for (auto _ : state)
+			{
+				Scene scene;
+				TransformHierarchy transforms;
+				Level level;
+				if (!level.Load(source.string(), jobSystem, scene, transforms))
+				{
+					state.SkipWithError(("Cannot load " + source.string()).c_str());
+					return;
+				}
+				benchmark::DoNotOptimize(level.GetEntities().data());
+			}
+		}
+
+		void LevelLoadSequential(benchmark::State& state, const std::filesystem::path& source)
+		{
+			// The content as the demos held it: asset paths and transforms
+			// already in memory.
+			auto cooked = source;
+			cooked.replace_extension(".scene");
+			SceneFile file;
+			if (!CookScene(source, cooked) || !file.Open(cooked))
+			{
+				state.SkipWithError(("Cannot cook " + source.string()).c_str());
+				return;
+			}
+			const SceneFileHeader& header = file.GetHeader();
+			const std::vector<SceneFileEntity> entries(header.entities, header.entities + header.entityCount);
+			const std::vector<Transform> locals(header.transforms, header.transforms + header.entityCount);
+			std::vector<std::pair<std::string, bool>> assets;
+			for (std::uint32_t i = 0; i < header.assetCount; ++i)
+			{
+				assets.emplace_back(
+					(source.parent_path() / header.assets[i].path).string(),
+					(header.assets[i].flags & kSceneAssetOccluder) != 0);
+			}
+			for (auto _ : state)
+			{
+				std::vector<std::unique_ptr<Model>> models;
+				try
+				{
+					for (const auto& [path, occluder] : assets)
+					{
+						models.push_back(std::make_unique<Model>(path, occluder));
+					}
+				}
+				catch (const std::exception& error)
+				{
+					state.SkipWithError(error.what());
+					return;
+				}
+				Scene scene;
+				TransformHierarchy transforms;
+				std::vector<TransformHierarchy::NodeId> nodes(entries.size());
+				for (std::size_t i = 0; i < entries.size(); ++i)
+				{
+					nodes[i] = transforms.CreateNode(
+						locals[i],
+						entries[i].parent == kSceneFileNone ? TransformHierarchy::kNullNode : nodes[entries[i].parent]);
+					scene.CreateEntity(locals[i], TransformNode{ nodes[i] });
+				}
+				benchmark::DoNotOptimize(models.data());
+			}
+		}
+
+	} // namespace
+
+	void RegisterSceneFileBenchmarks(const std::filesystem::path& dataDirectory)
+	{
+		std::error_code error;
+		std::vector<std::filesystem::path> paths;
+		for (const auto& entry : std::filesystem::directory_iterator(dataDirectory / "scenes", error))
+		{
+			if (entry.path().extension() == ".json") paths.push_back(entry.path());
+		}
+		std::sort(paths.begin(), paths.end());
+		for (const auto& file : paths)
+		{
+			const std::string name = file.filename().string();
+			benchmark::RegisterBenchmark(("SceneCook/" + name).c_str(), SceneCook, file)
+				->Unit(benchmark::kMicrosecond);
+			benchmark::RegisterBenchmark(("SceneFileOpen/" + name).c_str(), SceneFileOpen, file)
+				->Unit(benchmark::kMicrosecond);
+			benchmark::RegisterBenchmark(("LevelLoad/" + name).c_str(), LevelLoad, file)
+				->Unit(benchmark::kMillisecond)
+				->UseRealTime();
+			benchmark::RegisterBenchmark(("LevelLoadSequential/" + name).c_str(), LevelLoadSequential, file)
+				->Unit(benchmark::kMillisecond)
+				->UseRealTime();
+		}
+	}
+
+} // End namespace gl.
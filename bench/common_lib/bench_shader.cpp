@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+
+// Cost of Shader::Set* around the GL call: the lookup of the cached
+// uniform location by name, against asking GL every call, which the
+// mock answers from a hash map like a driver would. The uniforms are the
+// ones Model::Update sets for every mesh.
+
+namespace gl {
+
+	namespace {
+
+		class NullShader : public Shader
+		{
+		public:
+			NullShader() { id = GlProgram(1, "Benchmark shader"); }
+		};
+
+		// What Model::Update does per mesh, call sites unchanged.
+		void SetMeshUniforms(benchmark::State& state)
+		{
+			const NullShader shader;
+			const glm::mat4 model(1.0f);
+			const glm::vec3 specular(0.5f);
+			for (auto _ : state)
+			{
+				shader.SetMat4("model", model);
+				shader.SetMat4("inv_model", model);
+				shader.SetInt("diffuseMap", 0);
+				shader.SetInt("normalMap", 1);
+				shader.SetFloat("specular_pow", 32.0f);
+				shader.SetVec3("specular_vec", specular);
+			}
+			state.SetItemsProcessed(state.iterations() * 6);
+		}
+
+		// Same uniforms with a glGetUniformLocation per call, what Set*
+		// did before the cache.
+		void SetMeshUniformsDriverLookup(benchmark::State& state)
+		{
+			const NullShader shader;
+			const glm::mat4 model(1.0f);
+			const glm::vec3 specular(0.5f);
+			for (auto _ : state)
+			{
+				glUniformMatrix4fv(glGetUniformLocation(shader.id, "model"), 1, GL_FALSE, &model[0][0]);
+				glUniformMatrix4fv(glGetUniformLocation(shader.id, "inv_model"), 1, GL_FALSE, &model[0][0]);
+				glUniform1i(glGetUniformLocation(shader.id, "diffuseMap"), 0);
+				glUniform1i(glGetUniformLocation(shader.id, "normalMap"), 1);
+				glUniform1f(glGetUniformLocation(shader.id, "specular_pow"), 32.0f);
+				glUniform3fv(glGetUniformLocation(shader.id, "specular_vec"), 1, &specular[0]);
+			}
+			state.SetItemsProcessed(state.iterations() * 6);
+		}
+
+	} // namespace
+
+	BENCHMARK(SetMeshUniforms);
+	BENCHMARK(SetMeshUniformsDriverLookup);
+
+} // End namespace gl.
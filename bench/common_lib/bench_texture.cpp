@@ -0,0 +1,114 @@
+#include "common_lib_bench.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "stb_image.h"
+
+// stb_image decode of every texture set in data/textures: a directory is
+// one set (the maps of a material, the faces of a skybox), a loose image
+// is a set of its own. Files are read into memory first, so only the
+// decode is timed, with the vertical flip Texture asks for.
+
+namespace gl {
+
+	namespace {
+
+		using FileData = std::vector<stbi_uc>;
+
+		bool IsImage(const std::filesystem::path& path)
+		{
+			const auto extension = path.extension().string();
+			return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+		}
+
+		FileData ReadFile(const std::filesystem::path& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			return FileData(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		void DecodeTextures(benchmark::State& state, const std::vector<FileData>& files)
+		{
+			stbi_set_flip_vertically_on_load(true);
+			std::int64_t pixels = 0;
+			std::int64_t bytes = 0;
+			for (auto _ : state)
+			{
+				pixels = 0;
+				bytes = 0;
+				for (const auto& file : files)
+				{
+					int width = 0;
+					int height = 0;
+					int channels = 0;
+					stbi_uc* data = stbi_load_from_memory(
+						file.data(),
+						static_cast<int>(file.size()),
+						&width,
+						&height,
+						&channels,
+						0);
+					if (data == nullptr)
+					{
+						state.SkipWithError(stbi_failure_reason());
+						return;
+					}
+					benchmark::DoNotOptimize(data);
+					stbi_image_free(data);
+					pixels += static_cast<std::int64_t>(width) * height;
+					bytes += static_cast<std::int64_t>(file.size());
+				}
+			}
+			state.SetItemsProcessed(state.iterations() * pixels);
+			state.SetBytesProcessed(state.iterations() * bytes);
+		}
+
+		void RegisterSet(const std::string& name, std::vector<std::filesystem::path> paths)
+		{
+			if (paths.empty()) return;
+			std::sort(paths.begin(), paths.end());
+			std::vector<FileData> files;
+			for (const auto& path : paths)
+			{
+				files.push_back(ReadFile(path));
+			}
+			benchmark::RegisterBenchmark(("TextureDecode/" + name).c_str(), DecodeTextures, std::move(files))
+				->Unit(benchmark::kMillisecond);
+		}
+
+	} // namespace
+
+	void RegisterTextureBenchmarks(const std::filesystem::path& dataDirectory)
+	{
+		std::error_code error;
+		std::vector<std::filesystem::directory_entry> entries;
+		for (const auto& entry : std::filesystem::directory_iterator(dataDirectory / "textures", error))
+		{
+			entries.push_back(entry);
+		}
+		// Same order, so the same names, on every file system.
+		std::sort(entries.begin(), entries.end());
+		for (const auto& entry : entries)
+		{
+			if (entry.is_directory())
+			{
+				std::vector<std::filesystem::path> paths;
+				for (const auto& file : std::filesystem::directory_iterator(entry.path(), error))
+				{
+					if (IsImage(file.path())) paths.push_back(file.path());
+				}
+				RegisterSet(entry.path().filename().string(), std::move(paths));
+			}
+			else if (IsImage(entry.path()))
+			{
+				RegisterSet(entry.path().filename().string(), { entry.path() });
+			}
+		}
+	}
+
+} // End namespace gl.
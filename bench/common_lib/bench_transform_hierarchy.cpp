@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+
+#include "transform_hierarchy.h"
+
+// TransformHierarchy::Update over 1024 roots with 63 descendants each
+// (three levels), with nothing, one root in a hundred, or every root
+// moved since the last Update; against recomputing every world matrix
+// with 4x4 products and a full inverse, as Model::SetModelMatrix did.
+// And the normal matrix alone, from cofactors against transpose(inverse).
+
+namespace gl {
+
+	namespace {
+
+		constexpr std::size_t kRoots = 1024;
+
+		struct Forest
+		{
+			TransformHierarchy hierarchy;
+			std::vector<TransformHierarchy::NodeId> roots;
+		};
+
+		Transform MakeLocal(float x)
+		{
+			Transform local;
+			local.position = glm::vec3(x, 1.0f, -x);
+			local.rotation = glm::normalize(glm::quat(1.0f, 0.1f, 0.2f, 0.0f));
+			local.scale = glm::vec3(1.0f, 2.0f, 1.0f);
+			return local;
+		}
+
+		// Breadth first, four children per node until the tree has 64
+		// nodes: 1 + 4 + 16 + 43.
+		void Populate(Forest& forest)
+		{
+			for (std::size_t root = 0; root < kRoots; ++root)
+			{
+				const auto rootNode = forest.hierarchy.CreateNode(MakeLocal(static_cast<float>(root)));
+				forest.roots.push_back(rootNode);
+				std::vector<TransformHierarchy::NodeId> level{ rootNode };
+				std::size_t count = 1;
+				while (count < 64)
+				{
+					std::vector<TransformHierarchy::NodeId> next;
+					for (const auto parent : level)
+					{
+						for (int child = 0; child < 4 && count < 64; ++child, ++count)
+						{
+							next.push_back(forest.hierarchy.CreateNode(MakeLocal(1.0f), parent));
+						}
+					}
+					level = std::move(next);
+				}
+			}
+			forest.hierarchy.Update();
+		}
+
+		void MoveRoots(benchmark::State& state, std::size_t stride)
+		{
+			Forest forest;
+			Populate(forest);
+			float time = 0.0f;
+			for (auto _ : state)
+			{
+				time += 0.01f;
+				for (std::size_t root = 0; stride != 0 && root < kRoots; root += stride)
+				{
+					forest.hierarchy.SetLocal(forest.roots[root], MakeLocal(time));
+				}
+				forest.hierarchy.Update();
+				benchmark::DoNotOptimize(forest.hierarchy.GetUpdatedNodes().data());
+			}
+			state.counters["updated"] = static_cast<double>(forest.hierarchy.GetUpdatedNodes().size());
+			state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(forest.hierarchy.GetNodeCount()));
+		}
+
+		void HierarchyStatic(benchmark::State& state)
+		{
+			MoveRoots(state, 0);
+		}
+
+		void HierarchyOnePercentMoved(benchmark::State& state)
+		{
+			MoveRoots(state, 100);
+		}
+
+		void HierarchyAllMoved(benchmark::State& state)
+		{
+			MoveRoots(state, 1);
+		}
+
+		// Every node recomputed from its parent with full 4x4 math.
+		void FullRecompute(benchmark::State& state)
+		{
+			Forest forest;
+			Populate(forest);
+			const std::size_t count = forest.hierarchy.GetNodeCount();
+			std::vector<glm::mat4> worlds(count);
+			std::vector<glm::mat4> normals(count);
+			for (auto _ : state)
+			{
+				for (std::size_t node = 0; node < count; ++node)
+				{
+					const auto id = static_cast<TransformHierarchy::NodeId>(node);
+					const auto parent = forest.hierarchy.GetParent(id);
+					const glm::mat4 local = forest.hierarchy.GetLocal(id).ToMatrix();
+					worlds[node] = parent == TransformHierarchy::kNullNode ? local : worlds[parent] * local;
+					normals[node] = glm::transpose(glm::inverse(worlds[node]));
+				}
+				benchmark::DoNotOptimize(normals.data());
+			}
+			state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(count));
+		}
+
+		std::vector<glm::mat4> MakeMatrices()
+		{
+			std::vector<glm::mat4> matrices;
+			for (std::size_t i = 0; i < 4096; ++i)
+			{
+				matrices.push_back(MakeLocal(static_cast<float>(i)).ToMatrix());
+			}
+			return matrices;
+		}
+
+		void NormalMatrixCofactors(benchmark::State& state)
+		{
+			const auto matrices = MakeMatrices();
+			std::vector<glm::mat3> normals(matrices.size());
+			for (auto _ : state)
+			{
+				for (std::size_t i = 0; i < matrices.size(); ++i)
+				{
+					normals[i] = ComputeNormalMatrix(matrices[i]);
+				}
+				benchmark::DoNotOptimize(normals.data());
+			}
+			state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(matrices.size()));
+		}
+
+		void NormalMatrixInverse(benchmark::State& state)
+		{
+			const auto matrices = MakeMatrices();
+			std::vector<glm::mat4> normals(matrices.size());
+			for (auto _ : state)
+			{
+				for (std::size_t i = 0; i < matrices.size(); ++i)
+				{
+					normals[i] = glm::transpose(glm::inverse(matrices[i]));
+				}
+				benchmark::DoNotOptimize(normals.data());
+			}
+			state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(matrices.size()));
+		}
+
+	} // namespace
+
+	BENCHMARK(HierarchyStatic)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(HierarchyOnePercentMoved)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(HierarchyAllMoved)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(FullRecompute)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(NormalMatrixCofactors)->Unit(benchmark::kMicrosecond);
+	BENCHMARK(NormalMatrixInverse)->Unit(benchmark::kMicrosecond);
+
+} // End namespace gl.
@@ -0,0 +1,133 @@
+#include "common_lib_bench.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "vfs.h"
+
+// Reading every file of data/ through the Vfs: from the loose files, then
+// from a pack of them, entries stored as they are (views of the mapping,
+// no copy) or LZ4 compressed when it pays (decompressed into a buffer per
+// file). Every cache line read is touched, as a decoder would. VfsMount is
+// what mounting a pack costs: a map and a pass over its table.
+
+namespace gl {
+
+	namespace {
+
+		enum class Source
+		{
+			Loose,
+			PackStored,
+			PackLz4,
+		};
+
+		std::vector<std::string> ListFiles(const std::filesystem::path& dataDirectory)
+		{
+			std::error_code error;
+			std::vector<std::string> names;
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(dataDirectory, error))
+			{
+				if (!entry.is_regular_file()) continue;
+				names.push_back(Vfs::Normalize(entry.path().lexically_relative(dataDirectory).generic_string()));
+			}
+			std::sort(names.begin(), names.end());
+			return names;
+		}
+
+		// Written once per run: LZ4 HC over data/ takes seconds.
+		const std::filesystem::path& GetPack(const std::filesystem::path& dataDirectory, bool compress)
+		{
+			static std::filesystem::path packs[2];
+			std::filesystem::path& pack = packs[compress ? 1 : 0];
+			if (pack.empty())
+			{
+				const auto path = std::filesystem::temp_directory_path() /
+					(compress ? "CommonLib_bench_lz4.pack" : "CommonLib_bench_stored.pack");
+				if (WritePack(dataDirectory, path, compress)) pack = path;
+			}
+			return pack;
+		}
+
+		void VfsReadAll(benchmark::State& state, const std::filesystem::path& dataDirectory, Source source)
+		{
+			const std::vector<std::string> names = ListFiles(dataDirectory);
+			if (source != Source::Loose)
+			{
+				const auto& pack = GetPack(dataDirectory, source == Source::PackLz4);
+				if (pack.empty() || !Vfs::Mount(pack))
+				{
+					state.SkipWithError("Cannot write the pack");
+					return;
+				}
+			}
+			std::size_t bytes = 0;
+			for (auto _ : state)
+			{
+				bytes = 0;
+				for (const auto& name : names)
+				{
+					const VfsFile file = Vfs::Read(name);
+					if (!file.IsValid())
+					{
+						Vfs::Unmount();
+						state.SkipWithError(("Cannot read " + name).c_str());
+						return;
+					}
+					const auto data = file.GetBytes();
+					std::byte sum{};
+					for (std::size_t i = 0; i < data.size(); i += 64)
+					{
+						sum ^= data[i];
+					}
+					benchmark::DoNotOptimize(sum);
+					bytes += data.size();
+				}
+			}
+			Vfs::Unmount();
+			state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+			state.counters["files"] = static_cast<double>(names.size());
+		}
+
+		void VfsMount(benchmark::State& state, const std::filesystem::path& dataDirectory)
+		{
+			const auto& pack = GetPack(dataDirectory, true);
+			if (pack.empty())
+			{
+				state.SkipWithError("Cannot write the pack");
+				return;
+			}
+			for (auto _ : state)
+			{
+				if (!Vfs::Mount(pack))
+				{
+					state.SkipWithError(("Cannot mount " + pack.string()).c_str());
+					return;
+				}
+				benchmark::DoNotOptimize(Vfs::IsMounted());
+				Vfs::Unmount();
+			}
+		}
+
+	} // namespace
+
+	void RegisterVfsBenchmarks(const std::filesystem::path& dataDirectory)
+	{
+		benchmark::RegisterBenchmark("VfsReadAll/Loose", VfsReadAll, dataDirectory, Source::Loose)
+			->Unit(benchmark::kMillisecond)
+			->UseRealTime();
+		benchmark::RegisterBenchmark("VfsReadAll/PackStored", VfsReadAll, dataDirectory, Source::PackStored)
+			->Unit(benchmark::kMillisecond)
+			->UseRealTime();
+		benchmark::RegisterBenchmark("VfsReadAll/PackLz4", VfsReadAll, dataDirectory, Source::PackLz4)
+			->Unit(benchmark::kMillisecond)
+			->UseRealTime();
+		benchmark::RegisterBenchmark("VfsMount", VfsMount, dataDirectory)
+			->Unit(benchmark::kMicrosecond);
+	}
+
+} // End namespace gl.
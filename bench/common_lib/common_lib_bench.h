@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+
+// Google Benchmark suite of the CPU hot paths of CommonLib. The GL
+// functions are no-op stand-ins (gl_mock.cpp), so everything runs without
+// a context; what is measured is the CPU work around the GL calls.
+
+namespace gl {
+
+	// Points the glad function pointers the suite reaches at the stand-ins.
+	void InstallGlMock();
+
+	// One benchmark per file found under dataDirectory.
+	void RegisterModelBenchmarks(const std::filesystem::path& dataDirectory);
+	void RegisterTextureBenchmarks(const std::filesystem::path& dataDirectory);
+	void RegisterSceneFileBenchmarks(const std::filesystem::path& dataDirectory);
+	void RegisterVfsBenchmarks(const std::filesystem::path& dataDirectory);
+
+} // End namespace gl.
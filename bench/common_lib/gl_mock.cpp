@@ -0,0 +1,108 @@
+#include "common_lib_bench.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gl {
+
+	namespace {
+
+		GLuint nextName = 1;
+		std::vector<std::byte> mappedBuffer;
+		// Stands in for the driver's uniform name lookup, the part of
+		// Shader::Set* that is not ours.
+		std::unordered_map<std::string, GLint> uniformLocations;
+
+		void APIENTRY GenNames(GLsizei count, GLuint* names)
+		{
+			for (GLsizei i = 0; i < count; ++i)
+			{
+				names[i] = nextName++;
+			}
+		}
+
+		void APIENTRY DeleteNames(GLsizei, const GLuint*) {}
+		void APIENTRY Bind(GLenum, GLuint) {}
+		void APIENTRY BindVertexArray(GLuint) {}
+		void APIENTRY UseProgram(GLuint) {}
+		void APIENTRY BufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+		void APIENTRY BufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+		void APIENTRY EnableVertexAttribArray(GLuint) {}
+		void APIENTRY VertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+		void APIENTRY VertexAttribDivisor(GLuint, GLuint) {}
+		void APIENTRY BlendFunc(GLenum, GLenum) {}
+		void APIENTRY DrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei) {}
+		void APIENTRY DrawElements(GLenum, GLsizei, GLenum, const void*) {}
+		GLenum APIENTRY GetError() { return GL_NO_ERROR; }
+
+		void* APIENTRY MapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield)
+		{
+			if (mappedBuffer.size() < static_cast<std::size_t>(length))
+			{
+				mappedBuffer.resize(static_cast<std::size_t>(length));
+			}
+			return mappedBuffer.data();
+		}
+
+		GLboolean APIENTRY UnmapBuffer(GLenum) { return GL_TRUE; }
+
+		GLint APIENTRY GetUniformLocation(GLuint, const GLchar* name)
+		{
+			const auto [it, inserted] = uniformLocations.try_emplace(
+				name,
+				static_cast<GLint>(uniformLocations.size()));
+			return it->second;
+		}
+
+		void APIENTRY Uniform1i(GLint, GLint) {}
+		void APIENTRY Uniform1f(GLint, GLfloat) {}
+		void APIENTRY Uniform2f(GLint, GLfloat, GLfloat) {}
+		void APIENTRY Uniform3f(GLint, GLfloat, GLfloat, GLfloat) {}
+		void APIENTRY Uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) {}
+		void APIENTRY UniformVector(GLint, GLsizei, const GLfloat*) {}
+		void APIENTRY UniformMatrix(GLint, GLsizei, GLboolean, const GLfloat*) {}
+
+	} // namespace
+
+	void InstallGlMock()
+	{
+		glad_glGenBuffers = &GenNames;
+		glad_glGenVertexArrays = &GenNames;
+		glad_glGenTextures = &GenNames;
+		glad_glDeleteBuffers = &DeleteNames;
+		glad_glDeleteVertexArrays = &DeleteNames;
+		glad_glDeleteTextures = &DeleteNames;
+		glad_glBindBuffer = &Bind;
+		glad_glBindTexture = &Bind;
+		glad_glBindVertexArray = &BindVertexArray;
+		glad_glUseProgram = &UseProgram;
+		glad_glBufferData = &BufferData;
+		glad_glBufferSubData = &BufferSubData;
+		glad_glMapBufferRange = &MapBufferRange;
+		glad_glUnmapBuffer = &UnmapBuffer;
+		glad_glEnableVertexAttribArray = &EnableVertexAttribArray;
+		glad_glVertexAttribPointer = &VertexAttribPointer;
+		glad_glVertexAttribDivisor = &VertexAttribDivisor;
+		glad_glBlendFunc = &BlendFunc;
+		glad_glDrawArraysInstanced = &DrawArraysInstanced;
+		glad_glDrawElements = &DrawElements;
+		glad_glGetError = &GetError;
+		glad_glGetUniformLocation = &GetUniformLocation;
+		glad_glUniform1i = &Uniform1i;
+		glad_glUniform1f = &Uniform1f;
+		glad_glUniform2f = &Uniform2f;
+		glad_glUniform3f = &Uniform3f;
+		glad_glUniform4f = &Uniform4f;
+		glad_glUniform2fv = &UniformVector;
+		glad_glUniform3fv = &UniformVector;
+		glad_glUniform4fv = &UniformVector;
+		glad_glUniformMatrix2fv = &UniformMatrix;
+		glad_glUniformMatrix3fv = &UniformMatrix;
+		glad_glUniformMatrix4fv = &UniformMatrix;
+	}
+
+} // End namespace gl.
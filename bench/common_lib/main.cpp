@@ -0,0 +1,62 @@
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common_lib_bench.h"
+#include "vfs.h"
+
+// CommonLib_bench [Google Benchmark flags]
+// Without --benchmark_format the console gets CSV; without --benchmark_out
+// the JSON report goes to CommonLib_bench.json.
+
+namespace {
+
+	bool HasFlag(int argc, char** argv, std::string_view flag)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]).starts_with(flag)) return true;
+		}
+		return false;
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> defaults;
+	if (!HasFlag(argc, argv, "--benchmark_format"))
+	{
+		defaults.emplace_back("--benchmark_format=csv");
+	}
+	if (!HasFlag(argc, argv, "--benchmark_out="))
+	{
+		defaults.emplace_back("--benchmark_out=CommonLib_bench.json");
+		defaults.emplace_back("--benchmark_out_format=json");
+	}
+	std::vector<char*> arguments(argv, argv + argc);
+	for (auto& argument : defaults)
+	{
+		arguments.push_back(argument.data());
+	}
+	int argumentCount = static_cast<int>(arguments.size());
+
+	gl::InstallGlMock();
+	// Models and levels name their files relative to data/.
+	gl::Vfs::SetLooseRoot(GPR5300_DATA_DIR);
+	gl::RegisterModelBenchmarks(GPR5300_DATA_DIR);
+	gl::RegisterTextureBenchmarks(GPR5300_DATA_DIR);
+	gl::RegisterSceneFileBenchmarks(GPR5300_DATA_DIR);
+	gl::RegisterVfsBenchmarks(GPR5300_DATA_DIR);
+
+	benchmark::Initialize(&argumentCount, arguments.data());
+	if (benchmark::ReportUnrecognizedArguments(argumentCount, arguments.data()))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// xy position, zw texture coordinates of the unit quad.
+layout (location = 0) in vec4 vertex;
+// Per instance.
+layout (location = 1) in vec2 aOffset;
+layout (location = 2) in vec4 aColor;
+
+out vec2 TexCoords;
+out vec4 ParticleColor;
+
+uniform mat4 projection;
+uniform float scale;
+
+void main()
+{
+    TexCoords = vertex.zw;
+    ParticleColor = aColor;
+    gl_Position = projection * vec4((vertex.xy * scale) + aOffset, 0.0, 1.0);
+}
@@ -26,16 +26,20 @@
 
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTex;
+layout (location = 4) in mat4 aInstanceMatrix;
 
 out vec2 out_tex;
+out vec3 out_normal;
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 camera_position;
 
 void main()
 {
     out_tex = aTex;
-    gl_Position = projection * view * camera_position * vec4(aPos, 1.0f); 
+    // Instances only use a uniform scale.
+    out_normal = normalize(mat3(aInstanceMatrix) * aNormal);
+    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0f); 
 }
\ No newline at end of file
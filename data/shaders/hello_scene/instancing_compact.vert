@@ -0,0 +1,46 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTex;
+// xyz translation, w uniform scale.
+layout (location = 4) in vec4 aPositionScale;
+// snorm16 quaternion (x, y, z, w).
+layout (location = 5) in vec4 aRotation;
+
+out vec2 out_tex;
+out vec3 out_normal;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+mat3 QuaternionToMat3(vec4 q)
+{
+    float xx = q.x * q.x;
+    float yy = q.y * q.y;
+    float zz = q.z * q.z;
+    float xy = q.x * q.y;
+    float xz = q.x * q.z;
+    float yz = q.y * q.z;
+    float wx = q.w * q.x;
+    float wy = q.w * q.y;
+    float wz = q.w * q.z;
+    return mat3(
+        vec3(1.0 - 2.0 * (yy + zz), 2.0 * (xy + wz), 2.0 * (xz - wy)),
+        vec3(2.0 * (xy - wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz + wx)),
+        vec3(2.0 * (xz + wy), 2.0 * (yz - wx), 1.0 - 2.0 * (xx + yy)));
+}
+
+void main()
+{
+    mat3 rotation = QuaternionToMat3(normalize(aRotation));
+    float scale = aPositionScale.w;
+    mat4 model = mat4(
+        vec4(rotation[0] * scale, 0.0),
+        vec4(rotation[1] * scale, 0.0),
+        vec4(rotation[2] * scale, 0.0),
+        vec4(aPositionScale.xyz, 1.0));
+    out_tex = aTex;
+    // With a uniform scale the normal matrix is the rotation itself.
+    out_normal = rotation * aNormal;
+    gl_Position = projection * view * model * vec4(aPos, 1.0); 
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace gl {
+
+	// Axis aligned bounding box. An empty box has min > max.
+	struct Aabb
+	{
+		glm::vec3 min = glm::vec3(0.0f);
+		glm::vec3 max = glm::vec3(0.0f);
+
+		glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+		glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+		// Half the surface area, the cost metric of the AABB tree.
+		float GetPerimeter() const
+		{
+			const glm::vec3 size = max - min;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		bool Contains(const Aabb& other) const
+		{
+			return
+				min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+		}
+
+		bool Overlaps(const Aabb& other) const
+		{
+			return
+				min.x <= other.max.x && other.min.x <= max.x &&
+				min.y <= other.max.y && other.min.y <= max.y &&
+				min.z <= other.max.z && other.min.z <= max.z;
+		}
+
+		static Aabb Union(const Aabb& a, const Aabb& b)
+		{
+			return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+		}
+
+		static Aabb FromSphere(const glm::vec3& center, float radius)
+		{
+			return { center - glm::vec3(radius), center + glm::vec3(radius) };
+		}
+
+		// Box around this one once transformed by model (Arvo's method).
+		Aabb Transform(const glm::mat4& model) const;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gl {
+
+	// Counts the heap allocations (global operator new, any thread) made
+	// between BeginFrame and EndFrame. A steady state frame should make
+	// none: per frame data goes to reused containers or a FrameArena.
+	// operator new is only replaced with GPR5300_ALLOCATION_TRACKING (CMake
+	// option of the same name, left out of Release builds); without it the
+	// counts stay 0. To find an allocation, break in OnFrameAllocation.
+	class AllocationTracker
+	{
+	public:
+		// Main thread, around the frame.
+		static void BeginFrame();
+		static void EndFrame();
+
+		static std::size_t GetLastFrameCount();
+		static std::size_t GetLastFrameBytes();
+		static std::uint64_t GetFramesWithAllocations();
+
+		// Prints an error for every frame that allocated.
+		static void SetReport(bool report);
+		static bool GetReport();
+
+		// Called for every allocation counted in a frame.
+		static void OnFrameAllocation(std::size_t size);
+
+		// While one is alive, the allocations of the calling thread are not
+		// counted: tooling, such as the profiler.
+		class IgnoreScope
+		{
+		public:
+			IgnoreScope();
+			~IgnoreScope();
+
+			IgnoreScope(const IgnoreScope&) = delete;
+			IgnoreScope& operator=(const IgnoreScope&) = delete;
+		};
+	};
+
+} // End namespace gl.
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gl_stats.h"
+
+namespace gl {
+
+	// Command line of a demo in benchmark mode:
+	//   hello_scene --benchmark [--frames N] [--warmup N] [--dt S]
+	//               [--output path.json] [--capture directory [--raw]]
+	// The window is hidden, vsync is off, every frame advances by dt and
+	// the camera follows the program's benchmark path, so two runs draw
+	// the same frames. --capture writes the measured frames there, as PNG
+	// files or one raw stream (see FrameCapture); the report then gives
+	// the capture's GL thread time and its share of the frame, and
+	// frame_ms compares with a run without --capture.
+	struct BenchmarkOptions
+	{
+		bool enabled = false;
+		std::size_t frames = 600;
+		// Frames run before measuring: shader compiles, first uploads.
+		std::size_t warmupFrames = 60;
+		float dt = 1.0f / 60.0f;
+		// Executable name; the default output is <name>_benchmark.json.
+		std::string name;
+		std::string output;
+		std::string captureDirectory;
+		bool captureRaw = false;
+	};
+
+	BenchmarkOptions ParseBenchmarkOptions(int argc, char** argv);
+
+	// Camera keyframes, linearly interpolated, t in [0, 1] over the run.
+	class CameraPath
+	{
+	public:
+		struct Pose
+		{
+			glm::vec3 position;
+			glm::vec3 target;
+		};
+
+		void AddKeyframe(float t, const Pose& pose);
+		Pose Evaluate(float t) const;
+		bool IsEmpty() const { return keyframes_.empty(); }
+
+		// One turn around center at radius and height, looking at center.
+		static CameraPath Orbit(
+			const glm::vec3& center,
+			float radius,
+			float height,
+			std::size_t keyframeCount = 16);
+
+	private:
+		struct Keyframe
+		{
+			float t;
+			Pose pose;
+		};
+
+		std::vector<Keyframe> keyframes_;
+	};
+
+	// Summary of a set of samples, in milliseconds.
+	struct BenchmarkDistribution
+	{
+		float min = 0.0f;
+		float mean = 0.0f;
+		float p50 = 0.0f;
+		float p90 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+
+		static BenchmarkDistribution FromSamples(std::vector<float> samples);
+	};
+
+	// Per frame measurements of a benchmark run, written out as JSON.
+	class BenchmarkRecorder
+	{
+	public:
+		void SetName(std::string name) { name_ = std::move(name); }
+		void SetRenderer(std::string renderer) { renderer_ = std::move(renderer); }
+		void SetLoadMilliseconds(float context, float program)
+		{
+			contextMilliseconds_ = context;
+			programMilliseconds_ = program;
+		}
+		// gpuMilliseconds < 0 when the GPU time is not known.
+		// frameMilliseconds is the whole frame, capture and swap included;
+		// captureMilliseconds the GL thread time of FrameCapture::Capture,
+		// < 0 without a capture.
+		void AddFrame(
+			float cpuMilliseconds,
+			float gpuMilliseconds,
+			float frameMilliseconds,
+			float captureMilliseconds,
+			const GlCallCounts& calls);
+		void SetCaptureCounts(std::uint64_t stalls, std::uint64_t dropped)
+		{
+			captureStalls_ = stalls;
+			captureDropped_ = dropped;
+		}
+		// Source of the GPU times, "timer_query" or "finish".
+		void SetGpuSource(std::string source) { gpuSource_ = std::move(source); }
+
+		std::size_t GetFrameCount() const { return cpuMilliseconds_.size(); }
+		std::string ToJson(const BenchmarkOptions& options) const;
+		bool Write(const BenchmarkOptions& options) const;
+
+	private:
+		std::string name_;
+		std::string renderer_;
+		std::string gpuSource_ = "finish";
+		float contextMilliseconds_ = 0.0f;
+		float programMilliseconds_ = 0.0f;
+		std::vector<float> cpuMilliseconds_;
+		std::vector<float> gpuMilliseconds_;
+		std::vector<float> frameMilliseconds_;
+		std::vector<float> captureMilliseconds_;
+		std::uint64_t captureStalls_ = 0;
+		std::uint64_t captureDropped_ = 0;
+		std::vector<GlCallCounts> calls_;
+	};
+
+} // End namespace gl.
@@ -77,6 +77,9 @@ namespace gl {
 		// requires input on the vertical wheel-axis
 		void ProcessMouseScroll(float yoffset);
 
+		// turns the camera towards target (yaw and pitch, no roll)
+		void LookAt(const glm::vec3& target);
+
 	private:
 		// calculates the front vector from the Camera's (updated) Euler Angles
 		void updateCameraVectors();
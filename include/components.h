@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace gl {
+
+	class JobSystem;
+	class Material;
+	class Mesh;
+	class Scene;
+
+	// Components of the Scene: plain data, the behavior is in systems.
+
+	struct Transform
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+
+		glm::mat4 ToMatrix() const;
+	};
+
+	struct Velocity
+	{
+		glm::vec3 linear = glm::vec3(0.0f);
+		// Rotation axis times radians per second.
+		glm::vec3 angular = glm::vec3(0.0f);
+	};
+
+	// What to draw; the Model owning both must outlive the entity.
+	struct Renderable
+	{
+		const Mesh* mesh = nullptr;
+		const Material* material = nullptr;
+	};
+
+	// Bounding sphere, offset from the Transform position and scaled by
+	// its largest scale.
+	struct Collider
+	{
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = 0.5f;
+		// Bit mask, colliders only meet when their layers share a bit.
+		std::uint32_t layers = 1;
+	};
+
+	// Particle source, for ParticleGenerator or GpuParticleSystem.
+	struct Emitter
+	{
+		std::uint32_t particlesPerFrame = 0;
+		glm::vec2 offset = glm::vec2(0.0f);
+		// Share of the entity velocity the particles inherit.
+		float inheritVelocity = 0.1f;
+	};
+
+	// Moves and spins every entity with a Transform and a Velocity by dt,
+	// over jobSystem when given.
+	void IntegrateVelocities(Scene& scene, float dt, JobSystem* jobSystem = nullptr);
+
+} // End namespace gl.
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+#include "shader.h"
+
+namespace gl {
+
+	// Program made of a single compute stage (GL 4.3 / GLES 3.1). Uniforms
+	// are set through the Shader interface.
+	class ComputeShader : public Shader
+	{
+	public:
+		explicit ComputeShader(const std::string& computePath);
+
+		// Use() the program and launch the given number of work groups.
+		void Dispatch(
+			unsigned int groupsX,
+			unsigned int groupsY = 1,
+			unsigned int groupsZ = 1) const;
+	};
+
+} // End namespace gl.
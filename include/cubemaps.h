@@ -10,6 +10,7 @@
 #include <stb_image.h>
 //#include <GLFW/glfw3.h>
 
+#include "gl_object.h"
 #include "shader.h"
 
 namespace gl 
@@ -17,9 +18,9 @@ namespace gl
 	class Cubemaps 
 	{
 	public:
-		unsigned int textureID;
-		unsigned int vao;
-		unsigned int vbo;
+		GlTexture textureID;
+		GlVertexArray vao;
+		GlBuffer vbo;
 
         int width, height, nrChannels;
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+#include "frustum.h"
+
+namespace gl {
+
+	// Dynamic bounding volume hierarchy of AABBs (surface area heuristic
+	// insertion, AVL style rotations). Every object is a leaf ("proxy")
+	// holding a fat box: the real box grown by a margin, so small moves do
+	// not touch the tree. Queries test the fat boxes and are therefore
+	// conservative; they return the user data given at creation.
+	class DynamicAabbTree
+	{
+	public:
+		static constexpr int kNullNode = -1;
+
+		explicit DynamicAabbTree(float margin = 0.1f);
+
+		// Returns the proxy id of a new leaf.
+		int CreateProxy(const Aabb& box, std::uint32_t userData);
+		void DestroyProxy(int proxy);
+		// Refits a proxy to its new box. The tree is only changed when box
+		// leaves the fat box; displacement (the expected move until the
+		// next call) stretches the new fat box. Returns true if the leaf
+		// was reinserted.
+		bool MoveProxy(
+			int proxy,
+			const Aabb& box,
+			const glm::vec3& displacement = glm::vec3(0.0f));
+
+		std::uint32_t GetUserData(int proxy) const;
+		const Aabb& GetFatAabb(int proxy) const;
+		std::size_t GetProxyCount() const;
+		// 0 for a single leaf, -1 when empty.
+		int GetHeight() const;
+		void Clear();
+
+		// All queries append to out.
+		void QueryAabb(const Aabb& box, std::vector<std::uint32_t>& out) const;
+		// Subtrees fully inside a plane skip its test, so subtrees fully
+		// inside the frustum are walked without any box test.
+		void QueryFrustum(const Frustum& frustum, std::vector<std::uint32_t>& out) const;
+		void QuerySphere(
+			const glm::vec3& center,
+			float radius,
+			std::vector<std::uint32_t>& out) const;
+		// Proxies hit by the segment origin + t * direction, t in
+		// [0, maxDistance]. direction does not need to be normalized.
+		void QueryRay(
+			const glm::vec3& origin,
+			const glm::vec3& direction,
+			float maxDistance,
+			std::vector<std::uint32_t>& out) const;
+
+	private:
+		struct Node
+		{
+			Aabb box;
+			// Parent while in the tree, next free node in the free list.
+			int parent = kNullNode;
+			int child1 = kNullNode;
+			int child2 = kNullNode;
+			// Leaf = 0, free node = -1.
+			int height = -1;
+			std::uint32_t userData = 0;
+
+			bool IsLeaf() const { return child1 == kNullNode; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int node);
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		// Rotates the subtree at node if it is unbalanced, returns its new root.
+		int Balance(int node);
+		// Recomputes box and height of node from its children.
+		void UpdateNode(int node);
+
+		std::vector<Node> nodes_;
+		int root_ = kNullNode;
+		int freeList_ = kNullNode;
+		std::size_t proxyCount_ = 0;
+		float margin_ = 0.1f;
+	};
+
+} // End namespace gl.
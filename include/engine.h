@@ -1,15 +1,28 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <vector>
 
 #include "SDL.h"
 
 #include "glm/vec2.hpp"
+#include "imgui.h"
+
+#include "benchmark.h"
+#include "frame_packet.h"
+#include "frame_pacing.h"
+#include "gl_stats.h"
+#include "job_system.h"
+#include "render_thread.h"
 
 namespace gl
 {
     using seconds = std::chrono::duration<float, std::ratio<1, 1>>;
 
+    class Camera;
+
     class Program
     {
     public:
@@ -19,22 +32,140 @@ namespace gl
         virtual void Destroy() = 0;
         virtual void OnEvent(SDL_Event& event) = 0;
         virtual void DrawImGui() = 0;
+
+        // Programs that can split a frame in two override these three.
+        // With the render thread on, Simulate runs on the main thread and
+        // records the frame into packet, then Render draws it on the
+        // thread owning the GL context while the next frame simulates.
+        // Render must only read the packet and GL side state. Update is
+        // still used when the render thread is off.
+        virtual bool SupportsRenderThread() const { return false; }
+        virtual void Simulate(seconds dt, FramePacket& packet) {}
+        virtual void Render(const FramePacket& packet) {}
+
+        // Programs whose simulation can run at a fixed rate override
+        // these. With the fixed timestep on, the Engine calls FixedUpdate
+        // zero or more times per frame, then Update (or Simulate), which
+        // should only move state for rendering: interpolate between the
+        // last two steps by GetInterpolationAlpha().
+        virtual bool SupportsFixedTimestep() const { return false; }
+        virtual void FixedUpdate(seconds step) {}
+
+        // Benchmark mode (--benchmark): before every Update the Engine
+        // moves the camera GetCamera returns along GetBenchmarkPath, t
+        // going from 0 to 1 over the run. Programs without a camera keep
+        // the defaults.
+        virtual Camera* GetCamera() { return nullptr; }
+        virtual CameraPath GetBenchmarkPath() const { return {}; }
+
+        // Set by the Engine before Init, valid until Destroy returns.
+        void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+        // Set by the Engine every frame, before Update or Simulate.
+        void SetFixedTimestep(bool enabled, float interpolationAlpha)
+        {
+            fixedTimestep_ = enabled;
+            interpolationAlpha_ = interpolationAlpha;
+        }
+    protected:
+        JobSystem* GetJobSystem() const { return jobSystem_; }
+        bool IsFixedTimestep() const { return fixedTimestep_; }
+        // Fraction of a step between the last FixedUpdate and now, in [0, 1).
+        float GetInterpolationAlpha() const { return interpolationAlpha_; }
+    private:
+        JobSystem* jobSystem_ = nullptr;
+        bool fixedTimestep_ = false;
+        float interpolationAlpha_ = 0.0f;
     };
 
     class Engine
     {
     public:
         Engine(Program& program);
+        // Reads the benchmark options (see benchmark.h) from the command
+        // line, and --loose: read data/ from the loose files, not the pack.
+        Engine(Program& program, int argc, char** argv);
         void Run();
     private:
-        void Init();
+        // False, the error reported, when no window, GL context or GL
+        // functions could be had.
+        bool Init();
+        bool OpenWindow();
+        // Mounts data.pack (see vfs.h), next to the executable or one
+        // directory up for the multi-config generators.
+        void MountData();
+        // Fixed dt, scripted camera, no ImGui; writes the JSON report.
+        // False when a shader program failed to build or the report could
+        // not be written.
+        bool RunBenchmark();
         void Destroy();
         void DrawImGui();
+        void StartRenderThread();
+        void StopRenderThread();
+        void RenderFrame(FramePacket& packet);
+        // ImGui reuses its draw lists every frame: the render thread gets
+        // a copy per packet.
+        void CaptureImGui(std::size_t slot);
+        void ReleaseImGuiCaptures();
+        // Runs the FixedUpdate steps dt covers, at most maxSteps_.
+        void StepFixed(seconds dt);
+        void DrawFrameTimingImGui();
+        void SetSwapInterval();
+        // GL thread: installs or removes the GlCallCounter as asked.
+        void ApplyGlCallCounter();
+        void DrawGlCallsImGui();
+
+        struct ImGuiCapture
+        {
+            std::vector<ImDrawList*> lists;
+            ImDrawData drawData;
+        };
+
+        // Moving averages, to compare the single threaded loop with the
+        // render thread.
+        struct FrameStats
+        {
+            float frameMilliseconds = 0.0f;
+            float latencyMilliseconds = 0.0f;
+
+            void Add(float frame, float latency);
+        };
 
         Program& program_;
-        SDL_Window* window_;
-        SDL_GLContext glRenderContext_;
+        // Shared by the programs and the engine, created before the window.
+        JobSystem jobSystem_;
+        SDL_Window* window_ = nullptr;
+        SDL_GLContext glRenderContext_ = nullptr;
         glm::vec2 windowSize_{1024,720};
         float deltaTime_ = 0.0f;
+
+        bool fixedTimestepEnabled_ = false;
+        float fixedRate_ = 60.0f;
+        // Steps a frame may run to catch up; time beyond is dropped.
+        int maxSteps_ = 5;
+        seconds accumulator_{ 0.0f };
+        std::size_t droppedSteps_ = 0;
+
+        FramePacing pacing_ = FramePacing::Vsync;
+        // Swap interval the context has, changed on the thread owning it.
+        std::atomic<int> swapInterval_{ 1 };
+        int appliedSwapInterval_ = 1;
+        float targetFps_ = 0.0f;
+        FrameLimiter limiter_;
+        FrameTimeHistory frameTimes_;
+
+        // Asked from ImGui, applied on the thread owning the context.
+        std::atomic<bool> glCallCounting_{ false };
+        // Per frame counts (KiB for bytes), for the graphs.
+        std::array<FrameTimeHistory, kGlStatCount> glCallHistory_;
+
+        RenderThread renderThread_;
+        bool renderThreadEnabled_ = false;
+        std::array<ImGuiCapture, 2> imguiCaptures_;
+        FrameStats singleThreadStats_;
+        FrameStats renderThreadStats_;
+
+        BenchmarkOptions benchmark_;
+        BenchmarkRecorder benchmarkRecorder_;
+        bool looseData_ = false;
     };
 } // namespace gl
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gl {
+
+	// xoshiro128+ generator: four words of state and a handful of integer
+	// ops per number. Not suitable for anything security related, but a
+	// lot cheaper than rand() or the <random> engines in hot loops.
+	class FastRandom
+	{
+	public:
+		explicit FastRandom(std::uint64_t seed = 0x9E3779B97F4A7C15ull)
+		{
+			// splitmix64 spreads any seed, including 0, over the state.
+			for (int i = 0; i < 4; i += 2)
+			{
+				seed += 0x9E3779B97F4A7C15ull;
+				std::uint64_t z = seed;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				z ^= z >> 31;
+				state_[i] = static_cast<std::uint32_t>(z);
+				state_[i + 1] = static_cast<std::uint32_t>(z >> 32);
+			}
+		}
+
+		std::uint32_t NextUint()
+		{
+			const std::uint32_t result = state_[0] + state_[3];
+			const std::uint32_t t = state_[1] << 9;
+			state_[2] ^= state_[0];
+			state_[3] ^= state_[1];
+			state_[1] ^= state_[2];
+			state_[0] ^= state_[3];
+			state_[2] ^= t;
+			state_[3] = (state_[3] << 11) | (state_[3] >> 21);
+			return result;
+		}
+
+		// Uniform in [0, 1). The low bits of xoshiro128+ are weak, only
+		// the top 24 are used.
+		float NextFloat()
+		{
+			return static_cast<float>(NextUint() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		// Uniform in [min, max).
+		float NextFloat(float min, float max)
+		{
+			return min + (max - min) * NextFloat();
+		}
+
+	private:
+		std::uint32_t state_[4];
+	};
+
+} // End namespace gl.
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace gl {
+
+	// Linear allocator for data that lives one frame: Allocate bumps an
+	// offset, Reset takes everything back at once. Allocate may be called
+	// from several threads (jobs filling a frame), Reset only once they
+	// are done. When a frame does not fit, the rest goes to the heap and
+	// the next Reset grows the buffer, so the steady state never touches
+	// the heap.
+	class FrameArena
+	{
+	public:
+		static constexpr std::size_t kDefaultCapacity = 64 * 1024;
+
+		explicit FrameArena(std::size_t capacity = kDefaultCapacity);
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+		// Everything allocated since the last Reset becomes invalid.
+		void Reset();
+
+		std::size_t GetCapacity() const { return capacity_; }
+		// Bytes of the buffer in use, and what went to the heap beyond.
+		std::size_t GetUsed() const { return offset_.load(std::memory_order_relaxed); }
+		std::size_t GetOverflow() const { return overflowBytes_.load(std::memory_order_relaxed); }
+		// Largest frame since construction, overflow included.
+		std::size_t GetHighWater() const { return highWater_; }
+
+	private:
+		void* AllocateOverflow(std::size_t size, std::size_t alignment);
+
+		std::unique_ptr<std::byte[]> buffer_;
+		std::size_t capacity_ = 0;
+		std::atomic<std::size_t> offset_{ 0 };
+		std::atomic<std::size_t> overflowBytes_{ 0 };
+		std::size_t highWater_ = 0;
+
+		// Blocks of the frames that did not fit, freed by Reset.
+		std::mutex overflowMutex_;
+		std::vector<std::unique_ptr<std::byte[]>> overflowBlocks_;
+	};
+
+	// STL allocator drawing from a FrameArena. deallocate does nothing:
+	// the memory comes back with the arena's Reset, so containers using
+	// it must be emptied (or dropped) before.
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		explicit ArenaAllocator(FrameArena& arena) noexcept : arena_(&arena) {}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+		T* allocate(std::size_t count)
+		{
+			if (count > static_cast<std::size_t>(-1) / sizeof(T))
+			{
+				throw std::bad_array_new_length();
+			}
+			return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, std::size_t) noexcept {}
+
+		FrameArena& GetArena() const { return *arena_; }
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena_; }
+
+	private:
+		template <typename U>
+		friend class ArenaAllocator;
+
+		FrameArena* arena_;
+	};
+
+	template <typename T>
+	using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+} // End namespace gl.
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_object.h"
+
+namespace gl {
+
+	class Framebuffer;
+
+	enum class CaptureFormat
+	{
+		// One <directory>/frame_000000.png per frame.
+		Png,
+		// Every frame appended to <directory>/capture.rgba: RGBA8, bottom
+		// row first, as ffmpeg reads with
+		//   -f rawvideo -pixel_format rgba -video_size WxH -vf vflip
+		Raw,
+	};
+
+	// Grabs frames without stalling the pipeline. Capture queues a
+	// glReadPixels into a pixel pack buffer and fences it; the buffer is
+	// mapped kRingSize captures later, when the GPU is long done with it,
+	// and the copy goes to an encoder thread that writes the files. The GL
+	// thread pays for the read command, a map and a memcpy.
+	//
+	// GL thread: Start, Capture every frame to grab, Stop.
+	class FrameCapture
+	{
+	public:
+		static constexpr std::size_t kRingSize = 3;
+
+		struct Options
+		{
+			std::string directory;
+			CaptureFormat format = CaptureFormat::Png;
+			int width = 1024;
+			int height = 720;
+			// Frames read back but not written yet. Past it, a capture
+			// either waits for the encoder (every frame is kept, for
+			// offline runs) or drops its frame (interactive runs).
+			std::size_t maxQueuedFrames = 8;
+			bool waitForEncoder = false;
+		};
+
+		FrameCapture() = default;
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		bool Start(const Options& options);
+		// Reads back the pending captures, then waits for the encoder.
+		void Stop();
+		bool IsCapturing() const { return capturing_; }
+
+		// The color attachment of framebuffer, or the back buffer for 0.
+		// Call after the frame is drawn into it, before the swap.
+		void Capture(GLuint framebuffer = 0);
+		void Capture(const Framebuffer& framebuffer);
+
+		std::uint64_t GetCapturedCount() const { return captured_; }
+		std::uint64_t GetDroppedCount() const { return dropped_; }
+		std::uint64_t GetWrittenCount() const;
+		std::size_t GetQueuedCount() const;
+		// Captures that had to wait for their pack buffer's fence.
+		std::uint64_t GetStallCount() const { return stalls_; }
+		// GL thread time of the last Capture.
+		float GetCaptureMilliseconds() const { return captureMilliseconds_; }
+
+	private:
+		struct Slot
+		{
+			GlBuffer buffer;
+			GLsync fence = nullptr;
+			std::uint64_t frame = 0;
+		};
+
+		struct EncodedFrame
+		{
+			std::uint64_t index = 0;
+			std::vector<std::uint8_t> pixels;
+		};
+
+		// Maps the slot's buffer once its fence signals and hands the
+		// pixels to the encoder.
+		void Resolve(Slot& slot);
+		void EncoderLoop();
+		bool Write(const EncodedFrame& frame, std::FILE* raw) const;
+
+		Options options_;
+		std::size_t frameBytes_ = 0;
+		bool capturing_ = false;
+		std::array<Slot, kRingSize> slots_;
+		std::size_t nextSlot_ = 0;
+		std::uint64_t captured_ = 0;
+		std::uint64_t dropped_ = 0;
+		std::uint64_t stalls_ = 0;
+		float captureMilliseconds_ = 0.0f;
+
+		std::thread encoder_;
+		mutable std::mutex mutex_;
+		std::condition_variable condition_;
+		// Guarded by mutex_.
+		std::deque<EncodedFrame> queue_;
+		// Pixel buffers the encoder is done with, reused so a steady
+		// capture does not allocate.
+		std::vector<std::vector<std::uint8_t>> freeBuffers_;
+		std::uint64_t written_ = 0;
+		bool stopping_ = false;
+	};
+
+} // End namespace gl.
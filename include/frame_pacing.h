@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace gl {
+
+	// How the Engine spaces its frames.
+	enum class FramePacing
+	{
+		// Swap interval 1: one frame per refresh.
+		Vsync,
+		// Swap interval -1: vsync, but a late frame swaps immediately
+		// instead of waiting a whole refresh. Falls back to Vsync where the
+		// driver does not support it.
+		AdaptiveVsync,
+		// Swap interval 0, frame rate limited by FrameLimiter (if set).
+		Uncapped,
+	};
+
+	// Holds frames to a target rate without vsync. Sleeping alone
+	// overshoots by the scheduler granularity (up to ~1-2 ms on Windows),
+	// spinning alone burns a core: sleep until spinMargin before the
+	// deadline, then spin.
+	class FrameLimiter
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		// 0 disables the limiter.
+		void SetTargetFps(float fps);
+		float GetTargetFps() const { return targetFps_; }
+		void SetSpinMargin(std::chrono::microseconds margin) { spinMargin_ = margin; }
+
+		// Blocks until one target frame after the previous Wait.
+		void Wait();
+
+	private:
+		float targetFps_ = 0.0f;
+		clock::duration period_ = clock::duration::zero();
+		std::chrono::microseconds spinMargin_{ 2000 };
+		clock::time_point deadline_ = clock::time_point::min();
+	};
+
+	// The last frame times, for percentiles and a graph.
+	class FrameTimeHistory
+	{
+	public:
+		explicit FrameTimeHistory(std::size_t capacity = 512);
+
+		void Add(float milliseconds);
+		void Clear();
+
+		// p in [0, 1], e.g. 0.99 for the 99th percentile. 0 when empty.
+		float GetPercentile(float p) const;
+		float GetMaximum() const;
+		std::size_t GetCount() const { return count_; }
+
+		// Ring buffer: the oldest sample is at GetOffset() once full, the
+		// layout ImGui::PlotLines expects for its values_offset.
+		const std::vector<float>& GetSamples() const { return samples_; }
+		std::size_t GetOffset() const { return next_; }
+
+	private:
+		std::vector<float> samples_;
+		std::size_t next_ = 0;
+		std::size_t count_ = 0;
+		mutable std::vector<float> sorted_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "frame_arena.h"
+
+namespace gl {
+
+	// One draw the render side of a Program issues. mesh and material
+	// are ids the program gives meaning to.
+	struct DrawItem
+	{
+		std::uint32_t mesh = 0;
+		std::uint32_t material = 0;
+		glm::mat4 model = glm::mat4(1.0f);
+		// transpose(inverse()) of the model's 3x3, for the normals.
+		glm::mat3 normal = glm::mat3(1.0f);
+	};
+
+	// Everything needed to render one frame, recorded by the simulation
+	// and read by the render thread. The lists live in the packet's arena,
+	// which programs may use for other data of the frame too. Clear resets
+	// the arena and reserves what the last frame used, so recording a
+	// frame does not touch the heap once the arena has grown.
+	struct FramePacket
+	{
+		std::uint64_t frameIndex = 0;
+		// Which of the RenderThread packets this is (0 or 1), for side
+		// data kept per packet.
+		std::size_t slot = 0;
+		float dt = 0.0f;
+		// Start of the simulation of this frame, for the latency.
+		std::chrono::steady_clock::time_point simulationStart;
+
+		glm::mat4 view = glm::mat4(1.0f);
+		glm::mat4 projection = glm::mat4(1.0f);
+		glm::vec3 cameraPosition = glm::vec3(0.0f);
+
+		// Declared before the lists, which allocate from it.
+		FrameArena arena;
+		FrameVector<DrawItem> draws{ ArenaAllocator<DrawItem>(arena) };
+		// Per instance data the render side uploads, e.g. model matrices.
+		FrameVector<glm::mat4> instances{ ArenaAllocator<glm::mat4>(arena) };
+
+		void Clear()
+		{
+			const std::size_t drawCount = draws.size();
+			const std::size_t instanceCount = instances.size();
+			// The lists let go of their memory before the arena takes it back.
+			draws = FrameVector<DrawItem>(ArenaAllocator<DrawItem>(arena));
+			instances = FrameVector<glm::mat4>(ArenaAllocator<glm::mat4>(arena));
+			arena.Reset();
+			draws.reserve(drawCount);
+			instances.reserve(instanceCount);
+		}
+	};
+
+} // End namespace gl.
@@ -5,24 +5,29 @@
 #include <glm/glm.hpp>
 #include <iostream>
 
+#include "gl_object.h"
 #include "shader.h"
 
 namespace gl {
 	class Framebuffer
 	{
 	public:
-		unsigned int fbo;
+		GlFramebuffer fbo;
 
 		// FBO framebuffer object
-		unsigned int texColorBuffer;
+		GlTexture texColorBuffer;
 
 		// RBO renderbuffer object
-		unsigned int rbo;
+		GlRenderbuffer rbo;
 
-		unsigned int quadVAO;
-		unsigned int quadVBO;
+		// Depth-stencil texture used instead of the RBO when the depth has
+		// to be sampled afterwards (e.g. to build a Hi-Z pyramid).
+		GlTexture depthTexture;
 
-		Framebuffer();
+		GlVertexArray quadVAO;
+		GlBuffer quadVBO;
+
+		explicit Framebuffer(bool sampleableDepth = false);
 
 		void Draw() const;
 
@@ -31,5 +36,7 @@ namespace gl {
 		void Unbind() const;
 
 		unsigned int GetColorBuffer();
+
+		unsigned int GetDepthBuffer() const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace gl {
+
+	// Six normalized planes (xyz normal pointing inside, w distance) of a
+	// view-projection matrix: left, right, bottom, top, near, far.
+	class Frustum
+	{
+	public:
+		std::array<glm::vec4, 6> planes;
+
+		Frustum();
+		explicit Frustum(const glm::mat4& viewProjection);
+
+		bool IntersectsSphere(const glm::vec3& center, float radius) const;
+	};
+
+} // End namespace gl.
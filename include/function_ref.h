@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace gl {
+
+	template <typename Signature>
+	class FunctionRef;
+
+	// Non-owning reference to a callable, two pointers wide. Unlike
+	// std::function it never allocates, so lambdas capturing more than a
+	// pointer or two cost nothing to pass. The callable must outlive the
+	// FunctionRef: use it for parameters, never store it.
+	template <typename Result, typename... Args>
+	class FunctionRef<Result(Args...)>
+	{
+	public:
+		template <typename Function>
+			requires (!std::is_same_v<std::remove_cvref_t<Function>, FunctionRef> &&
+				std::is_object_v<std::remove_reference_t<Function>> &&
+				std::is_invocable_r_v<Result, Function&, Args...>)
+		FunctionRef(Function&& function) noexcept :
+			object_(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+			call_([](void* object, Args... args) -> Result
+				{
+					return std::invoke(
+						*static_cast<std::remove_reference_t<Function>*>(object),
+						std::forward<Args>(args)...);
+				})
+		{
+		}
+
+		Result operator()(Args... args) const
+		{
+			return call_(object_, std::forward<Args>(args)...);
+		}
+
+	private:
+		void* object_;
+		Result (*call_)(void*, Args...);
+	};
+
+} // End namespace gl.
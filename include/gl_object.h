@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gl {
+
+	enum class GlObjectType : std::uint8_t
+	{
+		Buffer,
+		VertexArray,
+		Texture,
+		Framebuffer,
+		Renderbuffer,
+		Program,
+		Count,
+	};
+
+	// Every GL object owned through a GlObject, with the GPU memory its
+	// owner declared and where it was created. Deleting is deferred: a
+	// released object goes to a queue, and EndFrame deletes it once a
+	// fence placed after the release shows the frames in flight, which may
+	// still use it, are done. Releasing needs no GL context, so owners can
+	// go away on any thread.
+	class GlObjectRegistry
+	{
+	public:
+		struct Usage
+		{
+			std::size_t count = 0;
+			std::size_t bytes = 0;
+		};
+
+		static GlObjectRegistry& Get();
+
+		// site is a string literal naming the owner ("Mesh vertices").
+		void Add(GlObjectType type, GLuint name, const char* site);
+		void SetBytes(GlObjectType type, GLuint name, std::size_t bytes);
+		void Release(GlObjectType type, GLuint name);
+
+		// GL thread, once per frame after the swap.
+		void EndFrame();
+		// GL thread, before the context goes: waits for the GPU and deletes
+		// everything released.
+		void Flush();
+
+		Usage GetUsage(GlObjectType type) const;
+		Usage GetTotal() const;
+		// Released, not deleted yet.
+		std::size_t GetPendingCount() const;
+		// Prints the objects still alive, by site; false when there are.
+		bool ReportLeaks() const;
+
+		void DrawImGui();
+
+		static const char* GetTypeName(GlObjectType type);
+
+	private:
+		struct Object
+		{
+			const char* site;
+			std::size_t bytes;
+		};
+
+		struct Deletion
+		{
+			GlObjectType type;
+			GLuint name;
+		};
+
+		struct FencedBatch
+		{
+			GLsync fence;
+			std::vector<Deletion> deletions;
+		};
+
+		GlObjectRegistry() = default;
+
+		static std::uint64_t Key(GlObjectType type, GLuint name)
+		{
+			return (static_cast<std::uint64_t>(type) << 32) | name;
+		}
+		static void Delete(const std::vector<Deletion>& deletions);
+		std::map<std::string_view, Usage> GetSites() const;
+
+		mutable std::mutex mutex_;
+		// Guarded by mutex_.
+		std::unordered_map<std::uint64_t, Object> objects_;
+		std::array<Usage, static_cast<std::size_t>(GlObjectType::Count)> usage_{};
+		std::vector<Deletion> released_;
+		// Released before their fence, oldest first.
+		std::vector<FencedBatch> fenced_;
+	};
+
+	// Move-only owner of one GL object, deleted through the registry.
+	// Converts to its name, so GL calls take it as they took the raw name.
+	template <GlObjectType Type>
+	class GlObject
+	{
+	public:
+		GlObject() = default;
+		// Takes ownership of name, created by the caller (glCreateProgram).
+		GlObject(GLuint name, const char* site) : name_(name)
+		{
+			if (name_ != 0) GlObjectRegistry::Get().Add(Type, name_, site);
+		}
+		~GlObject() { Reset(); }
+
+		GlObject(const GlObject&) = delete;
+		GlObject& operator=(const GlObject&) = delete;
+
+		GlObject(GlObject&& other) noexcept : name_(std::exchange(other.name_, 0)) {}
+		GlObject& operator=(GlObject&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				name_ = std::exchange(other.name_, 0);
+			}
+			return *this;
+		}
+
+		// glGen* of the type; not for programs.
+		static GlObject Create(const char* site);
+
+		GLuint Get() const { return name_; }
+		operator GLuint() const { return name_; }
+
+		// GPU memory behind the object, for the registry: call again when
+		// the storage is respecified.
+		void SetBytes(std::size_t bytes) const
+		{
+			if (name_ != 0) GlObjectRegistry::Get().SetBytes(Type, name_, bytes);
+		}
+
+		void Reset()
+		{
+			if (name_ == 0) return;
+			GlObjectRegistry::Get().Release(Type, name_);
+			name_ = 0;
+		}
+
+	private:
+		GLuint name_ = 0;
+	};
+
+	template <GlObjectType Type>
+	GlObject<Type> GlObject<Type>::Create(const char* site)
+	{
+		static_assert(Type != GlObjectType::Program, "programs come from glCreateProgram");
+		GLuint name = 0;
+		if constexpr (Type == GlObjectType::Buffer) glGenBuffers(1, &name);
+		else if constexpr (Type == GlObjectType::VertexArray) glGenVertexArrays(1, &name);
+		else if constexpr (Type == GlObjectType::Texture) glGenTextures(1, &name);
+		else if constexpr (Type == GlObjectType::Framebuffer) glGenFramebuffers(1, &name);
+		else if constexpr (Type == GlObjectType::Renderbuffer) glGenRenderbuffers(1, &name);
+		return GlObject(name, site);
+	}
+
+	using GlBuffer = GlObject<GlObjectType::Buffer>;
+	using GlVertexArray = GlObject<GlObjectType::VertexArray>;
+	using GlTexture = GlObject<GlObjectType::Texture>;
+	using GlFramebuffer = GlObject<GlObjectType::Framebuffer>;
+	using GlRenderbuffer = GlObject<GlObjectType::Renderbuffer>;
+	using GlProgram = GlObject<GlObjectType::Program>;
+
+	// Bytes of a width x height texture, texelBytes per texel, with its
+	// full mip chain when mipmapped.
+	std::size_t TextureBytes(int width, int height, std::size_t texelBytes, bool mipmapped = false);
+
+} // End namespace gl.
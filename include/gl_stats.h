@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gl {
+
+	// What GlCallCounter counts. State changes are calls, not actual
+	// changes: binding what is already bound counts too, which is what
+	// there is to remove.
+	enum class GlStat : std::uint8_t
+	{
+		// Draw calls, the instanced and indirect ones among them.
+		Draws,
+		InstancedDraws,
+		Dispatches,
+		// glUseProgram.
+		ProgramBinds,
+		// glBindVertexArray.
+		VertexArrayBinds,
+		// glBindBuffer, glBindBufferBase and glBindBufferRange.
+		BufferBinds,
+		// glActiveTexture, glBindTexture and glBindImageTexture.
+		TextureBinds,
+		// glBindFramebuffer.
+		FramebufferBinds,
+		// Enable, disable, blend, depth, cull, mask, viewport and scissor.
+		RenderState,
+		// glUniform*.
+		UniformUploads,
+		// Bytes handed to glBufferData and glBufferSubData, plus the
+		// length of the ranges mapped for writing.
+		BufferBytes,
+		// Bytes handed to glTex(Sub)Image and glCompressedTex(Sub)Image
+		// from client memory; pixel unpack buffer sources are not counted.
+		TextureBytes,
+		Count,
+	};
+
+	constexpr std::size_t kGlStatCount = static_cast<std::size_t>(GlStat::Count);
+
+	struct GlCallCounts
+	{
+		std::array<std::uint64_t, kGlStatCount> values{};
+
+		std::uint64_t operator[](GlStat stat) const
+		{
+			return values[static_cast<std::size_t>(stat)];
+		}
+	};
+
+	// Counts GL calls by swapping the glad function pointers for counting
+	// wrappers, so no call site has to change and nothing is paid while it
+	// is not installed. Only calls made through glad are seen. Install and
+	// Uninstall on the GL thread, after the functions are loaded, and not
+	// while another thread calls GL. The counts themselves are atomic.
+	class GlCallCounter
+	{
+	public:
+		static void Install();
+		static void Uninstall();
+		static bool IsInstalled();
+
+		// Since the last Reset or EndFrame.
+		static GlCallCounts Get();
+		static void Reset();
+		// GL thread, after the swap: the frame's counts become the last
+		// frame's and counting starts over.
+		static void EndFrame();
+		static GlCallCounts GetLastFrame();
+
+		// snake_case, for the benchmark JSON.
+		static const char* GetName(GlStat stat);
+		static const char* GetLabel(GlStat stat);
+		static bool IsBytes(GlStat stat);
+	};
+
+} // End namespace gl.
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gl {
+
+	// GPU timestamps: glQueryCounter(GL_TIMESTAMP) and its result. Core
+	// since GL 3.3 (ARB_timer_query), but glad is generated for GLES and
+	// only loads them as the EXT_disjoint_timer_query functions, which
+	// only an ES context advertises. Load picks the path the context has:
+	// the core functions through SDL_GL_GetProcAddress on desktop, the EXT
+	// ones on ES. GL thread only.
+	class GlTimerQuery
+	{
+	public:
+		// Once the context is current. False when it has no timestamps.
+		static bool Load();
+		static bool IsAvailable();
+
+		// Records the GPU time at which the commands before it completed.
+		static void QueryCounter(unsigned int query);
+		// Waits for the result, in nanoseconds.
+		static std::uint64_t GetResult(unsigned int query);
+		// ES only: timestamps taken since the last call are meaningless
+		// (power change, GPU reset). Always false on desktop.
+		static bool IsDisjoint();
+	};
+
+} // End namespace gl.
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "compute_shader.h"
+#include "frustum.h"
+#include "gl_object.h"
+
+namespace gl {
+
+	// Layout of the command glDrawElementsIndirect reads.
+	struct DrawElementsIndirectCommand
+	{
+		std::uint32_t count;
+		std::uint32_t instanceCount;
+		std::uint32_t firstIndex;
+		std::int32_t baseVertex;
+		std::uint32_t baseInstance;
+	};
+
+	// Result of GpuCuller::Validate.
+	struct GpuCullValidation
+	{
+		std::size_t gpuVisible = 0;
+		std::size_t cpuVisible = 0;
+		// Objects the GPU and the CPU reference disagree on.
+		std::size_t mismatches = 0;
+		// Destination records that are not a copy of their source record.
+		std::size_t corruptRecords = 0;
+	};
+
+	// GPU driven culling of instanced objects, without any readback:
+	//   BuildHiZ  turns a depth texture into a max-depth mip pyramid
+	//             (hiz_copy.comp, hiz_downsample.comp);
+	//   Cull      tests one bounding sphere per object (vec4 SSBO) against
+	//             the frustum and the pyramid and appends the records of
+	//             the visible objects to a destination buffer, counting
+	//             them in an indirect draw command (gpu_cull.comp);
+	//   Draw      consumes that command with glDrawElementsIndirect.
+	class GpuCuller
+	{
+	public:
+		// shaderFolder holds the three compute shaders; width and height
+		// are the size of the depth textures given to BuildHiZ.
+		GpuCuller(const std::string& shaderFolder, unsigned int width, unsigned int height);
+
+		GpuCuller(const GpuCuller&) = delete;
+		GpuCuller& operator=(const GpuCuller&) = delete;
+
+		// depthTexture must be sampleable (GL_NEAREST, no compare mode) and
+		// have been rendered with viewProjection.
+		void BuildHiZ(unsigned int depthTexture, const glm::mat4& viewProjection);
+
+		// Records are strideBytes long (a multiple of 4) in sourceBuffer,
+		// visible ones land packed in destinationBuffer. indexCount is the
+		// element count of the mesh drawn by Draw.
+		void Cull(
+			unsigned int boundsBuffer,
+			unsigned int sourceBuffer,
+			unsigned int destinationBuffer,
+			std::size_t objectCount,
+			std::size_t strideBytes,
+			const Frustum& frustum,
+			unsigned int indexCount);
+
+		// Draws the culled instances with the VAO currently bound.
+		void Draw() const;
+
+		void SetHiZEnabled(bool enabled) { hiZEnabled_ = enabled; }
+		bool IsHiZEnabled() const { return hiZEnabled_; }
+
+		// Validation only, stalls the pipeline: reads the command, the
+		// bounds, both record buffers and the pyramid back and replays the
+		// last Cull on the CPU.
+		GpuCullValidation Validate();
+
+	private:
+		// Replays the visibility test of gpu_cull.comp.
+		bool IsVisibleReference(
+			const glm::vec4& sphere,
+			const std::vector<std::vector<float>>& hiZ) const;
+		std::vector<float> ReadHiZLevel(int level) const;
+
+		unsigned int width_;
+		unsigned int height_;
+		int levelCount_;
+		GlTexture hiZTexture_;
+		GlBuffer commandBuffer_;
+		// Framebuffer used to read pyramid levels back in Validate.
+		GlFramebuffer readFramebuffer_;
+		std::unique_ptr<ComputeShader> copyShader_;
+		std::unique_ptr<ComputeShader> downsampleShader_;
+		std::unique_ptr<ComputeShader> cullShader_;
+		bool hiZEnabled_ = true;
+		bool hiZBuilt_ = false;
+		glm::mat4 hiZViewProjection_ = glm::mat4(1.0f);
+
+		// Inputs of the last Cull, for Validate.
+		unsigned int boundsBuffer_ = 0;
+		unsigned int sourceBuffer_ = 0;
+		unsigned int destinationBuffer_ = 0;
+		std::size_t objectCount_ = 0;
+		std::size_t strideBytes_ = 0;
+		Frustum frustum_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "compute_shader.h"
+#include "fast_random.h"
+#include "gl_object.h"
+#include "particle.h"
+#include "shader.h"
+#include "texture.h"
+
+namespace gl {
+
+	// Layout of the particle counter buffer shared by the particle compute
+	// shaders. It doubles as the indirect dispatch and draw buffer.
+	struct GpuParticleCounters
+	{
+		std::int32_t deadCount;
+		std::int32_t aliveCount[2];
+		std::uint32_t padding0;
+		// DispatchIndirectCommand of the simulate pass.
+		std::uint32_t dispatch[3];
+		std::uint32_t padding1;
+		// DrawArraysIndirectCommand: count, instanceCount, first, baseInstance.
+		std::uint32_t draw[4];
+	};
+	static_assert(sizeof(GpuParticleCounters) == 48, "GpuParticleCounters must match the shaders");
+
+	// Layout of one particle in the particle SSBO (std430).
+	struct GpuParticle
+	{
+		glm::vec2 position;
+		glm::vec2 velocity;
+		float life;
+		float alpha;
+		std::uint32_t color;
+		std::uint32_t padding;
+	};
+	static_assert(sizeof(GpuParticle) == 32, "GpuParticle must match the shaders");
+
+	// Result of GpuParticleSystem::Validate.
+	struct GpuParticleValidation
+	{
+		std::size_t alive = 0;
+		std::size_t dead = 0;
+		// Slots that are in no list or in more than one.
+		std::size_t lostSlots = 0;
+		std::size_t duplicateSlots = 0;
+		// Alive particles with no life left.
+		std::size_t expiredAlive = 0;
+		// Instance records that do not match their particle.
+		std::size_t badInstances = 0;
+		// With ParticleBlend::AlphaSorted: keys out of order, or sorted
+		// records that are not the record their key points to.
+		std::size_t sortErrors = 0;
+		bool drawCountMatches = true;
+	};
+
+	// Compute shader counterpart of ParticleGenerator: the same emitter
+	// parameters and particle behaviour, but the particles never leave the
+	// GPU. Each Update runs
+	//   particle_emit.comp      pops slots off a dead list (atomic counter);
+	//   particle_args.comp      sizes the simulate dispatch;
+	//   particle_simulate.comp  integrates the alive list, bounces off the
+	//                           scene depth buffer, recycles dead slots and
+	//                           writes the instance records;
+	//   particle_args.comp      sets the instance count of the draw;
+	//   particle_sort.comp      with ParticleBlend::AlphaSorted, bitonic
+	//                           sorts the records back to front;
+	// and Draw consumes that count with glDrawArraysIndirect.
+	class GpuParticleSystem
+	{
+	public:
+		// shaderFolder holds the particle compute shaders. shader and texture
+		// are the ones ParticleGenerator uses, the instance layout is the
+		// same ParticleInstance.
+		GpuParticleSystem(
+			const std::string& shaderFolder,
+			std::shared_ptr<Shader> shader,
+			std::shared_ptr<Texture> texture,
+			unsigned int amount);
+
+		GpuParticleSystem(const GpuParticleSystem&) = delete;
+		GpuParticleSystem& operator=(const GpuParticleSystem&) = delete;
+
+		// Same parameters as ParticleGenerator::Update.
+		void Update(
+			float dt,
+			glm::vec2 origin,
+			glm::vec2 velocity,
+			unsigned int newParticles);
+
+		// Render all particles. The shader needs its projection set.
+		void Draw();
+
+		// Particles collide with depthTexture (sampleable, GL_NEAREST),
+		// rendered with viewProjection. 0 turns collisions off.
+		void SetCollisionDepth(unsigned int depthTexture, const glm::mat4& viewProjection);
+
+		void SetBlendMode(ParticleBlend blend) { blend_ = blend; }
+		ParticleBlend GetBlendMode() const { return blend_; }
+
+		Shader& GetShader() { return *shader_; }
+		std::size_t GetCapacity() const { return capacity_; }
+
+		// Validation only, stalls the pipeline: reads the counters, both
+		// lists, the particles and the instance records back and checks
+		// that every slot is accounted for exactly once.
+		GpuParticleValidation Validate();
+
+	private:
+		void Init();
+		void BindBuffers() const;
+		void UnbindBuffers() const;
+		// Sorts the records of the alive list `list` into
+		// sortedInstanceBuffer_. Runs for the whole padded capacity: the
+		// number of steps cannot depend on the alive count without a
+		// readback.
+		void SortBackToFront(int list);
+
+		std::size_t capacity_;
+		// Capacity rounded up to a power of two (at least 512).
+		std::size_t sortSize_;
+		ParticleBlend blend_ = ParticleBlend::Additive;
+		// Alive list the next Update reads from.
+		int current_ = 0;
+		FastRandom random_;
+
+		std::unique_ptr<ComputeShader> emitShader_;
+		std::unique_ptr<ComputeShader> argsShader_;
+		std::unique_ptr<ComputeShader> simulateShader_;
+		std::unique_ptr<ComputeShader> sortShader_;
+		GlBuffer particleBuffer_;
+		GlBuffer deadBuffer_;
+		GlBuffer aliveBuffer_;
+		GlBuffer counterBuffer_;
+		GlBuffer instanceBuffer_;
+		GlBuffer sortBuffer_;
+		GlBuffer sortedInstanceBuffer_;
+
+		unsigned int depthTexture_ = 0;
+		glm::mat4 viewProjection_ = glm::mat4(1.0f);
+
+		//render state
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<Texture> texture_;
+		GlVertexArray VAO_;
+		GlBuffer quadVBO_;
+		GlVertexArray sortedVAO_;
+		GlBuffer sortedQuadVBO_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+
+namespace gl {
+
+	// Number of instances processed by one job. 2048 instances read about
+	// 100 KB of state and write 128 KB of matrices, which keeps a chunk
+	// inside a typical per-core L2.
+	constexpr std::size_t kInstanceChunkSize = 2048;
+
+	// 24 byte alternative to a mat4 per instance: translation and uniform
+	// scale, plus the rotation as a snorm16 quaternion (x, y, z, w). The
+	// vertex shader rebuilds the model and normal matrices.
+	struct CompactInstance
+	{
+		glm::vec4 positionScale;
+		std::int16_t rotation[4];
+	};
+	static_assert(sizeof(CompactInstance) == 24, "CompactInstance must stay 24 bytes");
+
+	// Structure-of-arrays state of an instanced field of rocks. Every array
+	// has the same length, index i describes instance i.
+	struct InstanceSoA
+	{
+		// Current position, written by UpdateInstanceTransforms.
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+
+		// Unit rotation axis and current angle around it (radians).
+		std::vector<float> axisX;
+		std::vector<float> axisY;
+		std::vector<float> axisZ;
+		std::vector<float> angle;
+
+		// Uniform scale.
+		std::vector<float> scale;
+
+		// Circular orbit in the xz plane around the field center.
+		std::vector<float> orbitRadius;
+		std::vector<float> orbitHeight;
+		std::vector<float> orbitSpeed;
+		std::vector<float> orbitPhase;
+		std::vector<float> spinSpeed;
+
+		std::size_t Size() const { return positionX.size(); }
+		void Resize(std::size_t count);
+	};
+
+	// Advances instances [begin, end) to the absolute time `time` and
+	// writes their column-major model matrices to out[0 .. end - begin).
+	// out may point straight into a mapped GL buffer. Uses AVX2 when the
+	// library is built with it, a scalar loop otherwise. Phases are
+	// wrapped to [-pi, pi] first, so time may grow without bound.
+	void UpdateInstanceTransforms(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center,
+		glm::mat4* out);
+
+	// Advances instances [begin, end) to `time` without building matrices.
+	void AdvanceInstances(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center);
+
+	// Tests the bounding spheres of instances [begin, end) against the
+	// frustum, 8 at a time. A sphere is centered on the instance position
+	// with radius scale * boundsRadius. Writes the indices of the visible
+	// instances to visibleOut (room for end - begin entries) and returns
+	// how many there are.
+	std::size_t CullInstances(
+		const InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		const Frustum& frustum,
+		float boundsRadius,
+		std::uint32_t* visibleOut);
+
+	// Writes the model matrices of the listed instances, in list order, to
+	// out[0 .. count). Uses the current position and angle of the state.
+	void WriteInstanceTransforms(
+		const InstanceSoA& state,
+		const std::uint32_t* indices,
+		std::size_t count,
+		glm::mat4* out);
+
+	// Compact counterparts of UpdateInstanceTransforms and
+	// WriteInstanceTransforms.
+	void UpdateCompactInstances(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center,
+		CompactInstance* out);
+
+	void WriteCompactInstances(
+		const InstanceSoA& state,
+		const std::uint32_t* indices,
+		std::size_t count,
+		CompactInstance* out);
+
+	// Scalar reference for a single instance, used for remainders and to
+	// validate the SIMD path.
+	glm::mat4 ComputeInstanceTransform(
+		const InstanceSoA& state,
+		std::size_t i,
+		float time,
+		const glm::vec3& center);
+
+} // End namespace gl.
@@ -4,130 +4,199 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/matrix_decompose.hpp>
 #include <iostream>
-#include <stb_image.h>
+#include <memory>
 #include <vector>
 #include <chrono>
+#include <span>
 #include "model.h"
 #include "shader.h"
 #include "material.h"
-//#include <GLFW/glfw3.h>
-
-#include "shader.h"
+#include "compute_shader.h"
+#include "frustum.h"
+#include "gl_object.h"
+#include "instance_kernels.h"
+#include "job_system.h"
+#include "spatial_grid.h"
+#include "dynamic_aabb_tree.h"
+#include "occlusion_culler.h"
+#include "gpu_culler.h"
 
 namespace gl {
+	// Per instance data streamed to the GPU. Matrix uploads a mat4 (64
+	// bytes) through attributes 4-7, Compact a CompactInstance (24 bytes)
+	// through attributes 4-5 and needs instancing_compact.vert.
+	enum class InstanceFormat
+	{
+		Matrix,
+		Compact
+	};
+
+	// Where the orbits are advanced. Cpu runs the SoA kernels and streams
+	// the instance buffer every frame, Gpu runs asteroid_orbit.comp on
+	// parameters uploaded once and writes the instance buffer in place.
+	enum class SimulationMode
+	{
+		Cpu,
+		Gpu
+	};
+
 	class Instancing {
     public:
         unsigned int nbAsteroid_ = 100;
-        float thicknessAsteroidX_;
-        float thicknessAsteroidY_;
-        int densityAsteroid_ = 1000;
-        unsigned int instanceVBO_;
+        // Radial and vertical spread of the belt around orbitRadius_.
+        float thicknessAsteroidX_ = 6.0f;
+        float thicknessAsteroidY_ = 1.5f;
+        float orbitRadius_ = 15.0f;
+        GlBuffer instanceVBO_;
         std::unique_ptr<Model> model_ = nullptr;
 
+        // Center of the field.
         glm::vec3 transVec_ = glm::vec3(0.0f, 0.0f, 0.0f);
-        std::vector<glm::mat4> modelMatrix_;
-        std::vector<float> initTransDistanceX_;
-        std::vector<float> initTransDistanceY_;
+        InstanceSoA state_;
+        // Only instances whose bounding sphere touches the frustum are drawn.
+        bool cullingEnabled_ = true;
 
-        void SetModelMatrix(std::chrono::duration<float, std::ratio <1, 1>> dt, unsigned int i)
-        {
-            modelMatrix_[i] = glm::mat4(1.0f);
-            modelMatrix_[i] = glm::translate(modelMatrix_[i],
-                transVec_ + glm::vec3(initTransDistanceX_[i], initTransDistanceY_[i],
-                    0.0f));
-        }
-
-        glm::vec3 GetPosition(unsigned int i)
-        {
-            glm::vec3 scale;
-            glm::quat rotation;
-            glm::vec3 translation;
-            glm::vec3 skew;
-            glm::vec4 perspective;
-            glm::decompose(modelMatrix_[i], scale, rotation, translation, skew, perspective);
-
-            return translation;
-        }
         Instancing() = default;
-		Instancing(std::string filepath) {
-            initTransDistanceX_.resize(nbAsteroid_);
-            std::generate(initTransDistanceX_.begin(), initTransDistanceX_.end(), [&]()
-                {
-                    return (rand() % densityAsteroid_) / (densityAsteroid_ / thicknessAsteroidX_);
-                });
-
-            initTransDistanceY_.resize(nbAsteroid_);
-            std::generate(initTransDistanceY_.begin(), initTransDistanceY_.end(), [&]()
-                {
-                    return (rand() % densityAsteroid_) / (densityAsteroid_ / thicknessAsteroidY_);
-                });
-
-            modelMatrix_.resize(nbAsteroid_, glm::mat4(1.0f));
-            model_ = std::make_unique<Model>(filepath);
-            const auto& asteroidMesh = model_->Model::GetMesh(0);
-
-            glBindVertexArray(asteroidMesh.GetVAO());
-
-            // VBO instancing
-            glGenBuffers(1, &instanceVBO_);
-
-            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
-            glEnableVertexAttribArray(3);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(glm::vec4), (void*)0);
-            glEnableVertexAttribArray(4);
-            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(glm::vec4), (void*)(1 * sizeof(glm::vec4)));
-            glEnableVertexAttribArray(5);
-            glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(glm::vec4), (void*)(2 * sizeof(glm::vec4)));
-            glEnableVertexAttribArray(6);
-            glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(glm::vec4), (void*)(3 * sizeof(glm::vec4)));
-
-            glVertexAttribDivisor(3, 1);
-            glVertexAttribDivisor(4, 1);
-            glVertexAttribDivisor(5, 1);
-            glVertexAttribDivisor(6, 1);
-
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glBindVertexArray(0);
-        }
-
-        void Update(std::chrono::duration<float, std::ratio <1, 1>> dt, Shader& shader)
+        Instancing(
+            const std::string& filepath,
+            unsigned int nbAsteroid = 100,
+            JobSystem* jobSystem = nullptr);
+
+        // Scalar model matrix of instance i at the current time.
+        glm::mat4 GetModelMatrix(unsigned int i) const;
+
+        // Positions come straight from the SoA state, O(1) per instance.
+        // In SimulationMode::Gpu they are only brought up to date by the
+        // proximity queries below.
+        glm::vec3 GetPosition(unsigned int i) const;
+        // out[k] = position of instance indices[k].
+        void GetPositions(
+            std::span<const std::uint32_t> indices,
+            std::span<glm::vec3> out) const;
+        // out[k] = position of instance first + k, for k < out.size().
+        void GetPositions(std::size_t first, std::span<glm::vec3> out) const;
+        // Translation of a column-major model matrix, no decomposition.
+        static glm::vec3 GetTranslation(const glm::mat4& model)
         {
-            //shader.Use();
-            shader.SetInt("TexDiffuse", 0);
-            shader.SetInt("TexNormal", 1);
-            // Update asteroids model matrix
-            for (unsigned int i = 0; i < modelMatrix_.size(); i++)
-            {
-                SetModelMatrix(dt, i);
-            }
-            Mesh mesh = model_->GetMesh(0);
-            mesh.Bind();
-            const auto& material = model_->materials[mesh.material_index];
-            material.color.Bind(0);
-            material.specular.Bind(1);
-            shader.SetFloat("specular_pow", material.specular_pow);
-            shader.SetVec3("specular_vec", material.specular_vec);
-            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
-            glBufferData(GL_ARRAY_BUFFER,
-                sizeof(glm::mat4) * modelMatrix_.size(),
-                &modelMatrix_[0],
-                GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glBindVertexArray(mesh.GetVAO());
-            glDrawElementsInstanced(GL_TRIANGLES,
-                mesh.nb_vertices_,
-                GL_UNSIGNED_INT,
-                0,
-                modelMatrix_.size());
-            glBindVertexArray(0);
-
+            return glm::vec3(model[3]);
         }
 
+        // Proximity queries, answered by a grid over the field that is
+        // rebuilt at most once per Update. QueryRadius appends to out,
+        // QueryNearest replaces out with the n nearest, nearest first.
+        std::size_t QueryRadius(
+            const glm::vec3& center,
+            float radius,
+            std::vector<std::uint32_t>& out);
+        void QueryNearest(
+            const glm::vec3& center,
+            std::size_t n,
+            std::vector<std::uint32_t>& out);
+
+        void SetInstanceFormat(InstanceFormat format);
+        InstanceFormat GetInstanceFormat() const;
+        // Size in bytes of one instance record in the current format.
+        std::size_t GetInstanceStride() const;
+        // Bytes written to the instance buffer by the last Update.
+        std::size_t GetUploadedBytes() const;
+
+        // Loads the orbit compute shader and uploads the orbital parameters
+        // to an SSBO. Needed once before SetSimulationMode(Gpu).
+        void InitGpuSimulation(const std::string& computePath);
+        void SetSimulationMode(SimulationMode mode);
+        SimulationMode GetSimulationMode() const;
+        // In SimulationMode::Gpu, culls the simulated instances on the GPU
+        // and draws them indirectly, the CPU never learns how many are
+        // visible. nullptr draws the whole field.
+        void SetGpuCuller(GpuCuller* culler);
+        GpuCuller* GetGpuCuller() const;
+        // Reads the GPU written instance buffer back and returns the largest
+        // difference to the CPU reference at the current time. Stalls the
+        // pipeline, only meant for validation.
+        float ValidateGpuSimulation();
+
+        // Registers one proxy per asteroid (user data = instance index) in
+        // tree; every CPU Update then refits them. Pass nullptr to remove
+        // them again. The tree must outlive the registration.
+        void RegisterInstances(DynamicAabbTree* tree);
+
+        // Frustum used by the culling pass of the next Update.
+        void SetFrustum(const Frustum& frustum);
+
+        // Optional occlusion test run on the frustum culled instances. The
+        // culler must have rasterized this frame's occluders before Update.
+        void SetOcclusionCuller(const OcclusionCuller* culler);
+
+        // Instances drawn by the last Update.
+        std::size_t GetVisibleCount() const;
+        // Instances inside the frustum but rejected by the occlusion culler
+        // during the last Update.
+        std::size_t GetOccludedCount() const;
+
+        // Advances the field and draws every instance.
+        void Update(std::chrono::duration<float, std::ratio <1, 1>> dt, Shader& shader);
+
+    protected:
+        void GenerateField();
+        // Rebuilds all matrices straight into the mapped instance buffer.
+        void UploadInstances();
+        // Advances and culls the field, then writes the matrices of the
+        // visible instances packed at the start of the instance buffer.
+        void UploadVisibleInstances();
+        // Dispatches the orbit compute shader over the whole field. The CPU
+        // side state_ is not advanced in this mode.
+        void SimulateOnGpu();
+        // Grows the instance buffer to hold count records, keeping usage.
+        void ReserveInstanceBuffer(std::size_t count, GLenum usage);
+        // Maps the instance buffer for count records of the current format,
+        // growing it if needed.
+        void* MapInstanceBuffer(std::size_t count);
+        // Points the instance attributes of the mesh VAO at the buffer.
+        void SetupInstanceAttributes();
+        void ForEachChunk(std::size_t count, const JobSystem::RangeFunction& func);
+        // Brings state_ positions to time_ (GPU mode) and rebuilds the grid
+        // if the field moved since the last query.
+        void UpdateSpatialGrid();
+        // World box of instance i at its current position.
+        Aabb GetInstanceBounds(std::size_t i) const;
+        // Moves the tree proxies to the current positions.
+        void RefitTreeProxies(float dt);
+
+        JobSystem* jobSystem_ = nullptr;
+        float time_ = 0.0f;
+        InstanceFormat instanceFormat_ = InstanceFormat::Matrix;
+        SimulationMode simulationMode_ = SimulationMode::Cpu;
+        std::unique_ptr<ComputeShader> orbitShader_ = nullptr;
+        GlBuffer orbitSSBO_;
+        GpuCuller* gpuCuller_ = nullptr;
+        // With a GpuCuller the simulation writes here and the culler packs
+        // the visible records into instanceVBO_.
+        GlBuffer gpuSourceBuffer_;
+        GlBuffer gpuBoundsBuffer_;
+        std::size_t gpuSourceCapacity_ = 0;
+        // Capacity of the instance buffer in bytes.
+        std::size_t instanceCapacity_ = 0;
+        std::size_t visibleCount_ = 0;
+        Frustum frustum_;
+        // Time state_ positions were last advanced to, on the CPU.
+        float positionTime_ = -1.0f;
+        float gridTime_ = -1.0f;
+        SpatialGrid spatialGrid_ = SpatialGrid(2.0f);
+        DynamicAabbTree* tree_ = nullptr;
+        std::vector<int> treeProxies_;
+        // Radius of the mesh bounding sphere as seen from the model origin.
+        float boundsRadius_ = 0.0f;
+        // Per chunk: visible indices (packed at the chunk start) and count.
+        std::vector<std::uint32_t> visibleIndices_;
+        std::vector<std::size_t> chunkVisible_;
+        std::vector<std::size_t> chunkOccluded_;
+        const OcclusionCuller* occlusionCuller_ = nullptr;
+        std::size_t occludedCount_ = 0;
+
        /* void Draw() const
         {
 
         }*/
 	};
-}
\ No newline at end of file
+}
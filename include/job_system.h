@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "function_ref.h"
+
+namespace gl {
+
+	// Number of jobs still running for a group of JobSystem::Run calls.
+	// JobSystem::Wait on it joins the group.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<std::size_t> pending_{ 0 };
+	};
+
+	// Work-stealing scheduler. Every worker owns a deque: it pushes and
+	// pops its own jobs at the back (newest first, still warm in cache)
+	// and, once empty, steals the oldest job at the front of another
+	// deque. Threads that are not workers share one extra deque. Waiting
+	// threads run jobs instead of blocking, so jobs may themselves Run,
+	// Wait and ParallelFor.
+	class JobSystem
+	{
+	public:
+		// Jobs are queued, so they own their callable. Keep captures within
+		// two pointers and std::function stores them without allocating.
+		using Job = std::function<void()>;
+		// Only called while ParallelFor runs: a reference is enough.
+		using RangeFunction = FunctionRef<void(std::size_t, std::size_t)>;
+
+		explicit JobSystem(unsigned int workerCount = DefaultWorkerCount());
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Queues job on the deque of the calling thread. counter, when
+		// given, counts the job until it has returned.
+		void Run(Job job, JobCounter* counter = nullptr);
+
+		// Runs queued jobs on the calling thread until counter is done.
+		void Wait(const JobCounter& counter);
+
+		// Calls func(begin, end) for every chunk of [0, count) and blocks
+		// until all of them are done. Chunks are at most chunkSize long.
+		// May be called from inside a job.
+		void ParallelFor(
+			std::size_t count,
+			std::size_t chunkSize,
+			const RangeFunction& func);
+
+		// Number of threads taking part in a ParallelFor (workers + caller).
+		unsigned int GetThreadCount() const;
+
+		// Jobs taken from another thread's deque since construction.
+		std::size_t GetStealCount() const { return stealCount_.load(std::memory_order_relaxed); }
+
+		static unsigned int DefaultWorkerCount();
+
+	private:
+		struct Task
+		{
+			Job job;
+			JobCounter* counter = nullptr;
+		};
+
+		// Own cache line each, owners and thieves hit them constantly.
+		// The tasks are a ring over a vector that only ever grows: a
+		// std::deque allocates and frees blocks as it slides.
+		struct alignas(64) WorkQueue
+		{
+			std::mutex mutex;
+			std::vector<Task> ring;
+			std::size_t front = 0;
+			std::size_t size = 0;
+
+			void PushBack(Task task);
+			Task PopBack();
+			Task PopFront();
+		};
+
+		void WorkerLoop(unsigned int queueIndex);
+		unsigned int GetQueueIndex() const;
+		bool TryRunOne(unsigned int queueIndex);
+		bool PopBack(unsigned int queueIndex, Task& task);
+		bool Steal(unsigned int thiefIndex, Task& task);
+		void Execute(Task& task);
+
+		// queues_[0] is shared by non-worker threads, queues_[i + 1]
+		// belongs to workers_[i].
+		std::vector<std::unique_ptr<WorkQueue>> queues_;
+		std::vector<std::thread> workers_;
+
+		// Idle workers sleep here until a job is queued.
+		std::mutex sleepMutex_;
+		std::condition_variable wakeCondition_;
+		std::atomic<std::size_t> queuedTasks_{ 0 };
+		std::atomic<unsigned int> sleepingWorkers_{ 0 };
+		std::atomic<bool> stop_{ false };
+		std::atomic<std::size_t> stealCount_{ 0 };
+	};
+
+} // End namespace gl.
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "gl_object.h"
+#include "scene.h"
+#include "scene_file.h"
+#include "transform_hierarchy.h"
+
+namespace gl {
+
+	class JobSystem;
+	class Model;
+
+	// Which of the Level's models an entity draws.
+	struct ModelInstance
+	{
+		std::uint32_t model = 0;
+	};
+
+	// Instanced copies of a Level model, their matrices in a buffer.
+	struct LevelInstances
+	{
+		std::uint32_t model = 0;
+		std::uint32_t count = 0;
+		GlBuffer buffer;
+	};
+
+	// A level loaded from data/scenes: its models, and an entity per
+	// level entity, with its Transform, a TransformNode and a
+	// ModelInstance when it has a model.
+	class Level
+	{
+	public:
+		struct LoadTimes
+		{
+			// JSON to cooked file, when the cooked file was missing or
+			// older than the JSON.
+			float cookMilliseconds = 0.0f;
+			// Map, fixups and checks.
+			float mapMilliseconds = 0.0f;
+			// Entities and nodes, done while the models load.
+			float entityMilliseconds = 0.0f;
+			// From the first model job to the last upload.
+			float assetMilliseconds = 0.0f;
+			float totalMilliseconds = 0.0f;
+		};
+
+		Level();
+		~Level();
+
+		Level(const Level&) = delete;
+		Level& operator=(const Level&) = delete;
+
+		// Loads source, a JSON level (a Vfs path), through its cooked form:
+		// source with the .scene extension, from the pack when packed, else
+		// next to the loose source, cooked first when stale. The models are
+		// parsed and decoded on jobSystem while the entities are created,
+		// then uploaded on the calling thread, which must own the GL
+		// context.
+		bool Load(
+			std::string_view source,
+			JobSystem& jobSystem,
+			Scene& scene,
+			TransformHierarchy& transforms);
+		void Clear();
+
+		std::size_t GetModelCount() const { return models_.size(); }
+		Model& GetModel(std::uint32_t model) const { return *models_[model]; }
+		// Entities in file order, parents first.
+		const std::vector<Entity>& GetEntities() const { return entities_; }
+		// kNullEntity when no entity has this name.
+		Entity FindEntity(std::string_view name) const;
+		const std::vector<LevelInstances>& GetInstances() const { return instances_; }
+		const LoadTimes& GetLoadTimes() const { return loadTimes_; }
+
+	private:
+		SceneFile file_;
+		std::vector<std::unique_ptr<Model>> models_;
+		std::vector<Entity> entities_;
+		std::vector<LevelInstances> instances_;
+		LoadTimes loadTimes_;
+	};
+
+} // End namespace gl.
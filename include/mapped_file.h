@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace gl {
+
+	// A whole file mapped in memory: opening costs no read, pages come in
+	// from the page cache on first touch. The mapping is private: writes
+	// (pointer fixups) stay in this process and only the pages written are
+	// copied, the file itself is never changed.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const { return data_ != nullptr; }
+		std::byte* GetData() const { return data_; }
+		std::size_t GetSize() const { return size_; }
+
+	private:
+		std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+#ifdef _WIN32
+		void* mapping_ = nullptr;
+#endif
+	};
+
+} // End namespace gl.
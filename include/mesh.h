@@ -6,6 +6,8 @@
 #include <glm/glm.hpp>
 #include <iostream>
 
+#include "gl_object.h"
+
 namespace gl {
 
     class Vertex
@@ -20,11 +22,16 @@ namespace gl {
     class Mesh
     {
     public:
-        unsigned int vao_;
-        unsigned int vbo_;
-        unsigned int ebo_;
+        GlVertexArray vao_;
+        GlBuffer vbo_;
+        GlBuffer ebo_;
         unsigned int nb_vertices_;
         unsigned int material_index;
+        // Bounding sphere and box of the vertices in model space.
+        glm::vec3 bounds_center_ = glm::vec3(0.0f);
+        float bounds_radius_ = 0.0f;
+        glm::vec3 bounds_min_ = glm::vec3(0.0f);
+        glm::vec3 bounds_max_ = glm::vec3(0.0f);
 
         Mesh(const std::vector<Vertex>& vertices, 
             const std::vector<std::uint32_t>& indices,
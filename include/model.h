@@ -5,6 +5,8 @@
 #include <vector>
 #include "mesh.h"
 #include "material.h"
+#include "aabb.h"
+#include "occlusion_culler.h"
 #include <string>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -12,25 +14,78 @@
 namespace gl {
 	class Shader; //prototype
 
+	// CPU half of loading a Model: the vertices of every mesh and the
+	// decoded textures. Model::Load builds it on any thread, the Model
+	// constructor uploads it on the GL thread.
+	struct ModelData {
+		struct MeshData {
+			std::vector<Vertex> vertices;
+			std::vector<std::uint32_t> indices;
+			unsigned int material_id = 0;
+		};
+
+		struct MaterialData {
+			TextureImage color;
+			TextureImage normal;
+			float specular_pow = 0.0f;
+			glm::vec3 specular_vec = glm::vec3(0.0f);
+		};
+
+		std::vector<MeshData> meshes;
+		std::vector<MaterialData> materials;
+		bool occluder = false;
+		OccluderMesh occluder_mesh;
+	};
+
 	class Model {
 	public:
 		//glm::vec3 position = glm::vec3(0, 0, 0); // mountain position
 
 		std::vector<Mesh> meshes;
 		std::vector<Material> materials;
-		Model(const std::string& filename);
+		// An occluder model also keeps a simplified copy of its geometry on
+		// the CPU for the OcclusionCuller.
+		Model(const std::string& filename, bool occluder = false);
+		explicit Model(ModelData data);
 
-		Mesh GetMesh(unsigned i);
+		// Parses the file (a Vfs path, see vfs.h) and decodes its textures,
+		// no GL call: safe on a job thread. Throws like the constructor.
+		static ModelData Load(const std::string& filename, bool occluder = false);
+
+		const Mesh& GetMesh(unsigned i) const;
 
 		void Update(const Shader& shader);
 
 		void SetModelMatrix(glm::vec3 position = glm::vec3(0, 0, 0));
+		void SetModelMatrix(const glm::mat4& model);
+		// With the normal matrix already known, e.g. from a
+		// TransformHierarchy.
+		void SetModelMatrix(const glm::mat4& model, const glm::mat3& normal);
+
+		// Box around all meshes in model space, and once placed by the
+		// current model matrix (what a placement registers in a
+		// DynamicAabbTree).
+		Aabb GetBounds() const;
+		Aabb GetWorldBounds() const;
+
+		bool IsOccluder() const;
+		const OccluderMesh& GetOccluderMesh() const;
+		const glm::mat4& GetModelMatrix() const;
+
+		// CPU half of loading a shape: one vertex per face corner, with
+		// the tangents of its triangle. The constructor uploads the result.
+		static void BuildVertices(
+			const tinyobj::shape_t& shape,
+			const tinyobj::attrib_t& attrib,
+			std::vector<Vertex>& vertices,
+			std::vector<std::uint32_t>& indices);
 
 		private:
 		glm::mat4 _model = glm::mat4(1.0f);
 		glm::mat4 _inv_model = glm::mat4(1.0f);
+		bool _occluder = false;
+		OccluderMesh _occluder_mesh;
 
-		void ParseMaterial(const tinyobj::material_t& material);
-		void ParseMesh(const tinyobj::shape_t& shape, const tinyobj::attrib_t& attrib);
+		static ModelData::MaterialData ParseMaterial(const tinyobj::material_t& material);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+#include "job_system.h"
+
+namespace gl {
+
+	// Low polygon copy of a model kept on the CPU to be rasterized as an
+	// occluder.
+	struct OccluderMesh
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<std::uint32_t> indices;
+
+		std::size_t GetTriangleCount() const { return indices.size() / 3; }
+	};
+
+	// Vertex clustering: snaps the vertices to a grid of resolution cells
+	// over the mesh bounds, keeps one vertex per cell and drops the
+	// triangles that collapse.
+	OccluderMesh SimplifyOccluder(
+		const std::vector<glm::vec3>& positions,
+		const std::vector<std::uint32_t>& indices,
+		unsigned int resolution);
+
+	// CPU occlusion culling. Occluders are rasterized into a small depth
+	// buffer holding 1 / w (0 = nothing, larger is closer), 8 pixels at a
+	// time with AVX2 and in horizontal bands on the job system. A
+	// hierarchy of 2x2 minimums (the farthest occluder depth of a region)
+	// then lets IsVisible test the screen rectangle of a box against a
+	// handful of texels.
+	//
+	// Per frame: BeginFrame, AddOccluder for each occluder, Rasterize, then
+	// any number of IsVisible calls, which are safe from several threads.
+	class OcclusionCuller
+	{
+	public:
+		explicit OcclusionCuller(
+			unsigned int width = 256,
+			unsigned int height = 128,
+			JobSystem* jobSystem = nullptr);
+
+		void BeginFrame(const glm::mat4& viewProjection);
+		// mesh is only read during Rasterize and must live until then.
+		void AddOccluder(const OccluderMesh& mesh, const glm::mat4& model);
+		void Rasterize();
+
+		// False only if the box is behind the occluders everywhere it
+		// covers. Boxes crossing the near plane or off screen are visible.
+		bool IsVisible(const Aabb& box) const;
+		bool IsSphereVisible(const glm::vec3& center, float radius) const;
+
+		unsigned int GetWidth() const { return width_; }
+		unsigned int GetHeight() const { return height_; }
+		// Level 0 is the full resolution buffer, row major, bottom row first.
+		const std::vector<float>& GetDepthLevel(std::size_t level) const { return levels_[level]; }
+		std::size_t GetLevelCount() const { return levels_.size(); }
+		// Duration of the last Rasterize (setup, raster and hierarchy).
+		float GetRasterMilliseconds() const { return rasterMilliseconds_; }
+		// Triangles that reached the rasterizer in the last Rasterize.
+		std::size_t GetRasterizedTriangleCount() const { return triangles_.size(); }
+
+	private:
+		struct Occluder
+		{
+			const OccluderMesh* mesh;
+			glm::mat4 model;
+		};
+
+		// Screen space triangle, counter clockwise, with 1 / w as an affine
+		// function of the pixel center.
+		struct Triangle
+		{
+			glm::vec3 edgeA;
+			glm::vec3 edgeB;
+			glm::vec3 edgeC;
+			float depthA;
+			float depthB;
+			float depthC;
+			int minX;
+			int maxX;
+			int minY;
+			int maxY;
+		};
+
+		void SetupTriangles();
+		void RasterizeRows(std::size_t rowBegin, std::size_t rowEnd);
+		void BuildHierarchy();
+
+		unsigned int width_;
+		unsigned int height_;
+		JobSystem* jobSystem_;
+		glm::mat4 viewProjection_ = glm::mat4(1.0f);
+		std::vector<Occluder> occluders_;
+		std::vector<glm::vec4> clipPositions_;
+		std::vector<Triangle> triangles_;
+		// levels_[0] is the depth buffer, each next level half the size.
+		std::vector<std::vector<float>> levels_;
+		std::vector<glm::uvec2> levelSizes_;
+		float rasterMilliseconds_ = 0.0f;
+	};
+
+} // End namespace gl.
@@ -2,67 +2,167 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "gl_object.h"
 #include "shader.h"
 #include "texture.h"
-#include "game_object.h"
+#include "fast_random.h"
+#include "job_system.h"
+#include "radix_sort.h"
 
 namespace gl
 {
-	// Represents a single particle and its state.
-	struct Particle
+	// Number of particles advanced or written by one job.
+	constexpr std::size_t kParticleChunkSize = 16384;
+
+	// Structure-of-arrays particle storage. Live particles are always
+	// packed in [0, count): dead ones are swap-removed, so nothing ever
+	// scans for a free slot. Every array holds Capacity() entries.
+	struct ParticleSoA
+	{
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> velocityX;
+		std::vector<float> velocityY;
+		std::vector<float> alpha;
+
+		// Life left in seconds, the particle dies when it reaches 0.
+		std::vector<float> life;
+
+		// Packed RGB8 tint, alpha is taken from the alpha array.
+		std::vector<std::uint32_t> color;
+
+		std::size_t count = 0;
+
+		std::size_t Capacity() const { return life.size(); }
+		void Reserve(std::size_t capacity);
+	};
+
+	// Per instance data streamed to the GPU: 12 bytes per particle.
+	struct ParticleInstance
 	{
 		glm::vec2 position;
-		glm::vec2 velocity;
-		glm::vec4 color;
+		// RGBA8, read as a normalized attribute.
+		std::uint32_t color;
+	};
+	static_assert(sizeof(ParticleInstance) == 12, "ParticleInstance must stay 12 bytes");
+
+	// Integrates particles [begin, end) over dt: life and alpha decay,
+	// position moves against the velocity. Uses AVX2 when the library is
+	// built with it.
+	void AdvanceParticles(ParticleSoA& particles, std::size_t begin, std::size_t end, float dt);
+
+	// Swap-removes every particle whose life is over. Returns how many
+	// were removed. Order of the survivors is not preserved.
+	std::size_t RemoveDeadParticles(ParticleSoA& particles);
+
+	// Appends up to `amount` particles around origin (within 5 units on
+	// each axis), moving with velocity. Returns how many fit.
+	std::size_t EmitParticles(
+		ParticleSoA& particles,
+		std::size_t amount,
+		glm::vec2 origin,
+		glm::vec2 velocity,
+		FastRandom& random);
 
-		// life variable that slowly decays once its spawned.
-		// When life is less than certain threshold (usually 0),
-		// particle is killed and replaced with new particle when the next spawns.
-		float life;
+	// Writes particles [begin, end) to out[0 .. end - begin). out may
+	// point straight into a mapped GL buffer.
+	void WriteParticleInstances(
+		const ParticleSoA& particles,
+		std::size_t begin,
+		std::size_t end,
+		ParticleInstance* out);
 
-		Particle() : position(0.0f), velocity(0.0f), color(1.0f), life(0.0f) {}
+	// Same as WriteParticleInstances for particles order[begin, end), so
+	// the instance stream follows a sorted permutation.
+	void WriteSortedParticleInstances(
+		const ParticleSoA& particles,
+		const std::uint32_t* order,
+		std::size_t begin,
+		std::size_t end,
+		ParticleInstance* out);
 
-		
+	// Writes the back-to-front sort key of particles [begin, end) to
+	// keys[begin, end). Emitters are flat, so "back" means older: the
+	// particle with the least life left is drawn first.
+	void WriteParticleSortKeys(
+		const ParticleSoA& particles,
+		std::size_t begin,
+		std::size_t end,
+		std::uint32_t* keys);
+
+	enum class ParticleBlend
+	{
+		// Order independent, no sorting.
+		Additive,
+		// Regular alpha blending, particles are radix sorted back to front
+		// every Draw.
+		AlphaSorted
 	};
 
+	// Builds the VAO of the particle shaders: a unit quad (location 0) and
+	// one ParticleInstance per instance read from instanceBuffer
+	// (locations 1 and 2).
+	void CreateParticleVertexArray(GLuint instanceBuffer, GlVertexArray& vao, GlBuffer& quadBuffer);
+
+	// Emits particles behind a game object and draws all of them with one
+	// instanced call from a streamed buffer.
 	class ParticleGenerator
 	{
 	public:
-		ParticleGenerator(Shader shader, Texture texture, unsigned int amount);
+		// jobSystem is optional, without it everything runs on the caller.
+		// The shader and texture may be shared with other systems.
+		ParticleGenerator(
+			std::shared_ptr<Shader> shader,
+			std::shared_ptr<Texture> texture,
+			unsigned int amount,
+			JobSystem* jobSystem = nullptr);
 
-		// Update all particles
+		ParticleGenerator(const ParticleGenerator&) = delete;
+		ParticleGenerator& operator=(const ParticleGenerator&) = delete;
+
+		// Update all particles, then spawn newParticles of them at origin,
+		// moving at velocity (as many as the capacity allows).
 		void Update(
 			float dt,
-			GameObject& object,
-			unsigned int newParticles,
-			glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+			glm::vec2 origin,
+			glm::vec2 velocity,
+			unsigned int newParticles);
 
-		//render all particles
+		// Render all particles. The shader needs its projection set.
 		void Draw();
 
-	private:
-		//state
-		std::vector<Particle> particles;
-		unsigned int amount;
+		void SetBlendMode(ParticleBlend blend) { blend_ = blend; }
+		ParticleBlend GetBlendMode() const { return blend_; }
 
-		//render state
-		Shader shader;
-		Texture texture;
-		unsigned int VAO;
+		Shader& GetShader() { return *shader_; }
+		std::size_t GetLiveCount() const { return particles_.count; }
+		std::size_t GetCapacity() const { return particles_.Capacity(); }
 
+	private:
 		//initializes buffer and vertex attributes
 		void Init();
 
-		//returns the first particle index that is unused
-		// meaning if no particle is currently active
-		unsigned int FirstUnusedParticle();
+		void ForEachChunk(std::size_t count, const JobSystem::RangeFunction& func);
 
-		//respawns particle
-		void RespawnParticle(
-			Particle& particle,
-			GameObject& object,
-			glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+		//state
+		ParticleSoA particles_;
+		FastRandom random_;
+		JobSystem* jobSystem_ = nullptr;
+		ParticleBlend blend_ = ParticleBlend::Additive;
+		RadixSorter sorter_;
+		std::vector<std::uint32_t> sortKeys_;
+		std::vector<std::uint32_t> sortOrder_;
+
+		//render state
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<Texture> texture_;
+		GlVertexArray VAO_;
+		GlBuffer quadVBO_;
+		GlBuffer instanceVBO_;
 	};
-}
\ No newline at end of file
+}
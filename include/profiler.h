@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "frame_pacing.h"
+
+// Zones compile to nothing unless GPR5300_PROFILER is defined (CMake
+// option of the same name, left out of Release builds).
+//   GPR5300_PROFILE_ZONE("Cull");      CPU time of the enclosing scope
+//   GPR5300_PROFILE_GPU_ZONE("Skybox"); GPU time of the GL calls in it
+//   GPR5300_PROFILE_THREAD("Render");  names the calling thread
+// Zone names must outlive the profiler: string literals, or
+// Profiler::Intern for built names.
+#define GPR5300_PROFILE_CONCAT_INNER(a, b) a##b
+#define GPR5300_PROFILE_CONCAT(a, b) GPR5300_PROFILE_CONCAT_INNER(a, b)
+#if defined(GPR5300_PROFILER)
+#define GPR5300_PROFILE_ZONE(name) \
+	const ::gl::ProfileZone GPR5300_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define GPR5300_PROFILE_GPU_ZONE(name) \
+	const ::gl::GpuProfileZone GPR5300_PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+#define GPR5300_PROFILE_THREAD(name) ::gl::Profiler::Get().SetThreadName(name)
+#else
+#define GPR5300_PROFILE_ZONE(name) ((void)0)
+#define GPR5300_PROFILE_GPU_ZONE(name) ((void)0)
+#define GPR5300_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace gl {
+
+	// One finished zone. Times are nanoseconds since the profiler started
+	// (GPU zones: since the first GPU zone of their frame).
+	struct ProfileEvent
+	{
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t end;
+		std::uint32_t depth;
+		std::uint32_t thread;
+	};
+
+	// Rolling statistics of one zone: its total time per frame.
+	struct ProfileZoneStats
+	{
+		FrameTimeHistory milliseconds{ 256 };
+		bool gpu = false;
+	};
+
+	// Collects the zones of every thread. Each thread records into a ring
+	// buffer of its own, single producer / single consumer, so recording
+	// takes no lock; EndFrame drains the rings. GPU zones are timestamp
+	// queries read back kGpuLatency frames later, when they are done, so
+	// the profiler never waits on the GPU.
+	class Profiler
+	{
+	public:
+		static constexpr std::size_t kEventsPerThread = 8192;
+		static constexpr std::size_t kFrameHistory = 120;
+		static constexpr std::size_t kGpuLatency = 4;
+		// ProfileEvent::thread of GPU zones.
+		static constexpr std::uint32_t kGpuThread = 0xFFFFu;
+		// Chrome trace track of the frames themselves.
+		static constexpr std::uint32_t kFrameThread = 0xFFFEu;
+
+		static Profiler& Get();
+
+		void SetThreadName(std::string name);
+		// Copy of name that lives as long as the profiler.
+		const char* Intern(std::string_view name);
+
+		// Recording side, use the macros.
+		void BeginZone();
+		void EndZone(const char* name, std::uint64_t start);
+		std::uint64_t Now() const;
+
+		// Main thread, once per frame: drains the rings into a new frame.
+		void EndFrame();
+		// GL thread, around the GL calls of a frame.
+		void BeginGpuFrame();
+		void EndGpuFrame();
+		void BeginGpuZone(const char* name);
+		void EndGpuZone();
+		// GL thread, while the context is current: deletes the queries.
+		void ReleaseGpuQueries();
+
+		void SetPaused(bool paused) { paused_ = paused; }
+		bool IsPaused() const { return paused_.load(); }
+
+		// Timeline of a recent frame, zone table, Chrome trace export.
+		void DrawImGui();
+		// chrome://tracing / Perfetto JSON of the frames in the history.
+		bool ExportChromeTrace(const std::string& path) const;
+
+	private:
+		struct ThreadProfile
+		{
+			std::string name;
+			std::uint32_t id = 0;
+			std::uint32_t depth = 0;
+			std::array<ProfileEvent, kEventsPerThread> events;
+			// head is written by the owning thread, tail by EndFrame.
+			std::atomic<std::uint64_t> head{ 0 };
+			std::atomic<std::uint64_t> tail{ 0 };
+			std::atomic<std::uint64_t> dropped{ 0 };
+		};
+
+		struct Frame
+		{
+			std::uint64_t start = 0;
+			std::uint64_t end = 0;
+			std::vector<ProfileEvent> events;
+		};
+
+		struct GpuZone
+		{
+			const char* name;
+			std::uint32_t depth;
+			std::size_t startQuery;
+			// SIZE_MAX until the zone ends inside its frame.
+			std::size_t endQuery;
+		};
+
+		struct GpuFrame
+		{
+			std::vector<unsigned int> queries;
+			std::size_t usedQueries = 0;
+			std::vector<GpuZone> zones;
+			std::vector<std::size_t> open;
+			bool pending = false;
+		};
+
+		Profiler();
+
+		ThreadProfile& GetThreadProfile();
+		void CollectGpuFrame(GpuFrame& frame);
+		void AddStats(const std::vector<ProfileEvent>& events, bool gpu);
+		void DrawTimeline(const Frame& frame, const std::vector<ProfileEvent>& gpuEvents);
+
+		const std::chrono::steady_clock::time_point epoch_;
+		mutable std::mutex mutex_;
+		// Guarded by mutex_.
+		std::vector<std::unique_ptr<ThreadProfile>> threads_;
+		std::unordered_set<std::string> internedNames_;
+		std::unordered_map<std::string, ProfileZoneStats> zoneStats_;
+		std::vector<ProfileEvent> lastGpuEvents_;
+
+		// Main thread.
+		std::deque<Frame> frames_;
+		std::uint64_t frameStart_ = 0;
+		std::atomic<bool> paused_{ false };
+		int selectedFrame_ = 0;
+		std::string exportStatus_;
+
+		// GL thread.
+		std::array<GpuFrame, kGpuLatency> gpuFrames_;
+		std::size_t gpuFrameIndex_ = 0;
+		bool gpuFrameOpen_ = false;
+	};
+
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name) :
+			name_(name),
+			start_(Profiler::Get().Now())
+		{
+			Profiler::Get().BeginZone();
+		}
+		~ProfileZone() { Profiler::Get().EndZone(name_, start_); }
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* name_;
+		std::uint64_t start_;
+	};
+
+	class GpuProfileZone
+	{
+	public:
+		explicit GpuProfileZone(const char* name) { Profiler::Get().BeginGpuZone(name); }
+		~GpuProfileZone() { Profiler::Get().EndGpuZone(); }
+
+		GpuProfileZone(const GpuProfileZone&) = delete;
+		GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "job_system.h"
+
+namespace gl {
+
+	// Maps a float to a 32-bit key whose unsigned order is the float
+	// order (negative values flip every bit, positive ones the sign bit).
+	inline std::uint32_t FloatToSortableKey(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const std::uint32_t mask = (bits & 0x80000000u) != 0 ? 0xFFFFFFFFu : 0x80000000u;
+		return bits ^ mask;
+	}
+
+	// Least significant digit radix sort of 32-bit keys, 8 bits per pass.
+	// The array is split in blocks; each pass builds one histogram per
+	// block and scatters the blocks in parallel on the job system. Passes
+	// where every key has the same digit are skipped. Scratch memory is
+	// kept between calls, so sorting every frame does not allocate.
+	class RadixSorter
+	{
+	public:
+		// jobSystem is optional, without it everything runs on the caller.
+		explicit RadixSorter(JobSystem* jobSystem = nullptr);
+
+		// Writes to order the permutation that sorts keys in ascending
+		// order: keys[order[0]] <= keys[order[1]] <= ... The sort is stable.
+		void SortIndices(std::span<const std::uint32_t> keys, std::vector<std::uint32_t>& order);
+
+	private:
+		static constexpr std::size_t kRadix = 256;
+		// Elements per block: large enough to amortize the histograms,
+		// small enough for one block of keys and indices to stay in L2.
+		static constexpr std::size_t kBlockSize = 65536;
+
+		void ForEachBlock(std::size_t count, const JobSystem::RangeFunction& func);
+
+		JobSystem* jobSystem_ = nullptr;
+		std::vector<std::uint32_t> keys_[2];
+		std::vector<std::uint32_t> indices_[2];
+		std::vector<std::array<std::uint32_t, kRadix>> histograms_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "frame_packet.h"
+
+namespace gl {
+
+	// Consumes frame packets on a thread of its own. There are two
+	// packets: while the render thread draws frame N from one, the
+	// simulation records frame N + 1 into the other, and only waits when
+	// it gets a full frame ahead. The thread owning the GL context is
+	// whoever runs the render function, hence the start and exit hooks.
+	//
+	// Simulation side, every frame: BeginFrame, fill the packet,
+	// SubmitFrame.
+	class RenderThread
+	{
+	public:
+		using RenderFunction = std::function<void(FramePacket&)>;
+		using ThreadFunction = std::function<void()>;
+
+		RenderThread() = default;
+		~RenderThread();
+
+		RenderThread(const RenderThread&) = delete;
+		RenderThread& operator=(const RenderThread&) = delete;
+
+		// onStart and onExit run on the render thread, before the first
+		// and after the last frame (make the GL context current, release it).
+		void Start(
+			RenderFunction render,
+			ThreadFunction onStart = {},
+			ThreadFunction onExit = {});
+		// Renders the frames already submitted, then joins the thread.
+		void Stop();
+		bool IsRunning() const { return thread_.joinable(); }
+
+		// Blocks until the render thread is done with the next packet,
+		// then returns it cleared.
+		FramePacket& BeginFrame();
+		void SubmitFrame();
+
+		// From the start of the simulation of the last rendered frame to
+		// the end of its render function (usually the buffer swap).
+		float GetLatencyMilliseconds() const { return latencyMilliseconds_.load(std::memory_order_relaxed); }
+		// Duration of the last render function.
+		float GetRenderMilliseconds() const { return renderMilliseconds_.load(std::memory_order_relaxed); }
+		// Time the last BeginFrame waited for the render thread.
+		float GetWaitMilliseconds() const { return waitMilliseconds_; }
+
+	private:
+		void ThreadLoop(RenderFunction render, ThreadFunction onStart, ThreadFunction onExit);
+
+		std::array<FramePacket, 2> packets_;
+		// Guarded by mutex_: packets submitted and not rendered yet.
+		std::array<bool, 2> filled_ = { false, false };
+		bool stop_ = false;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::thread thread_;
+
+		// Simulation side.
+		std::size_t writeSlot_ = 0;
+		std::uint64_t frameIndex_ = 0;
+		float waitMilliseconds_ = 0.0f;
+
+		std::atomic<float> latencyMilliseconds_{ 0.0f };
+		std::atomic<float> renderMilliseconds_{ 0.0f };
+	};
+
+} // End namespace gl.
@@ -1,26 +1,344 @@
 #pragma once
 
-#include <string>
-#include < vector>
-#include <glad/glad.h>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <iostream>
-#include <stb_image.h>
-
-#include "shader.h"
-
-namespace gl
-{
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "job_system.h"
+
+namespace gl {
+
+	// Index into the Scene's entity table, and the generation of the slot
+	// when the entity was created: a destroyed entity's handle goes stale
+	// instead of naming whatever reuses its slot.
+	struct Entity
+	{
+		std::uint32_t index = 0;
+		std::uint32_t generation = 0;
+
+		bool operator==(const Entity&) const = default;
+	};
+
+	// Generations start at 1, so a default Entity is never alive.
+	constexpr Entity kNullEntity{};
+
+	using ComponentId = std::uint32_t;
+	using ComponentMask = std::uint64_t;
+	constexpr std::size_t kMaxComponentTypes = 64;
+
+	// Id of a component type, handed out on first use. Components are
+	// plain data: they are moved between chunks with memcpy and never
+	// destroyed.
+	ComponentId RegisterComponentType(std::size_t size, std::size_t alignment);
+
+	template <typename T>
+	struct ComponentType
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "components are plain data");
+
+		static ComponentId GetId()
+		{
+			static const ComponentId id = RegisterComponentType(sizeof(T), alignof(T));
+			return id;
+		}
+	};
+
+	// const T names the same component as T.
+	template <typename T>
+	ComponentId GetComponentId()
+	{
+		return ComponentType<std::remove_cv_t<T>>::GetId();
+	}
+
+	template <typename T>
+	ComponentMask GetComponentMask()
+	{
+		return ComponentMask(1) << GetComponentId<T>();
+	}
+
+	// Entities sharing one set of components. Their components are stored
+	// in fixed size chunks, one array per component inside a chunk (plus
+	// one of the entities), so a query walks contiguous arrays of exactly
+	// the components it asks for. Rows are packed: row r is slot
+	// r % capacity of chunk r / capacity, every chunk but the last is full.
+	class Archetype
+	{
+	public:
+		static constexpr std::size_t kChunkBytes = 16 * 1024;
+
+		struct alignas(64) Chunk
+		{
+			std::byte bytes[kChunkBytes];
+		};
+
+		explicit Archetype(ComponentMask mask);
+
+		ComponentMask GetMask() const { return mask_; }
+		bool Has(ComponentId id) const { return (mask_ & (ComponentMask(1) << id)) != 0; }
+		std::size_t GetCount() const { return count_; }
+		std::size_t GetChunkCount() const { return chunks_.size(); }
+		// Rows per chunk.
+		std::size_t GetCapacity() const { return capacity_; }
+		// Rows used in chunk; the chunks past the last row are spares.
+		std::size_t GetChunkSize(std::size_t chunk) const
+		{
+			const std::size_t first = chunk * capacity_;
+			return first >= count_ ? 0 : std::min(capacity_, count_ - first);
+		}
+
+		Entity* GetEntities(std::size_t chunk)
+		{
+			return reinterpret_cast<Entity*>(chunks_[chunk]->bytes);
+		}
+
+		// The component's array in chunk; the archetype must have it.
+		template <typename T>
+		T* GetColumn(std::size_t chunk)
+		{
+			return std::launder(reinterpret_cast<T*>(
+				chunks_[chunk]->bytes + offsets_[GetComponentId<T>()]));
+		}
+
+		template <typename T>
+		T* Get(std::uint32_t row)
+		{
+			return GetColumn<T>(row / capacity_) + row % capacity_;
+		}
+
+		// Appends a row for entity, components left uninitialized.
+		std::uint32_t AddRow(Entity entity);
+		// Moves the last row into row and drops the last. Returns the
+		// entity moved, kNullEntity when row was the last.
+		Entity RemoveRow(std::uint32_t row);
+		// Copies the components both archetypes have from row of source
+		// into row of this one.
+		void CopyRow(std::uint32_t row, Archetype& source, std::uint32_t sourceRow);
+		// Room for count rows without allocating a chunk.
+		void Reserve(std::size_t count);
+
+	private:
+		std::byte* GetBytes(ComponentId id, std::uint32_t row);
+
+		ComponentMask mask_ = 0;
+		std::vector<ComponentId> components_;
+		// Byte offset of each component's array in a chunk.
+		std::array<std::uint32_t, kMaxComponentTypes> offsets_{};
+		std::array<std::uint32_t, kMaxComponentTypes> sizes_{};
+		std::size_t capacity_ = 0;
+		std::size_t count_ = 0;
+		std::vector<std::unique_ptr<Chunk>> chunks_;
+	};
+
+	// Entity-component container: entities are ids, their components live
+	// in archetype chunks (see Archetype). Adding or removing a component
+	// moves the entity to another archetype, so do it at load time or
+	// between systems, never while a query runs over the same components.
+	//
+	// Systems are queries: ForEach calls a function per entity having
+	// every listed component, ForEachChunk once per chunk with the arrays.
+	// Listing a component const says the system only reads it; systems
+	// writing disjoint components can run side by side (TaskGraph tasks),
+	// and ParallelForEach spreads one system over a JobSystem.
 	class Scene
 	{
 	public:
-		unsigned int textureID;
-		unsigned int vao;
-		unsigned int vbo;
+		Scene() = default;
+
+		Scene(const Scene&) = delete;
+		Scene& operator=(const Scene&) = delete;
+
+		template <typename... Components>
+		Entity CreateEntity(const Components&... components)
+		{
+			Archetype& archetype = GetArchetype((ComponentMask(0) | ... | GetComponentMask<Components>()));
+			const Entity entity = AllocateEntity();
+			const std::uint32_t row = archetype.AddRow(entity);
+			(new (archetype.Get<Components>(row)) Components(components), ...);
+			records_[entity.index].archetype = &archetype;
+			records_[entity.index].row = row;
+			return entity;
+		}
+
+		// Room for count more entities with exactly these components.
+		template <typename... Components>
+		void Reserve(std::size_t count)
+		{
+			Archetype& archetype = GetArchetype((ComponentMask(0) | ... | GetComponentMask<Components>()));
+			archetype.Reserve(archetype.GetCount() + count);
+			records_.reserve(records_.size() + count);
+		}
+
+		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const;
+		std::size_t GetEntityCount() const { return entityCount_; }
+		void Clear();
+
+		template <typename T>
+		bool HasComponent(Entity entity) const
+		{
+			return IsAlive(entity) && records_[entity.index].archetype->Has(GetComponentId<T>());
+		}
 
-		int width, height, nrChannels;
+		// nullptr when the entity is dead or has no T. Valid until the
+		// next structural change (entity or component added or removed).
+		template <typename T>
+		T* GetComponent(Entity entity)
+		{
+			if (!HasComponent<T>(entity)) return nullptr;
+			const Record& record = records_[entity.index];
+			return record.archetype->Get<T>(record.row);
+		}
 
-		Scene() {}
+		// Adds T, or overwrites the one the entity has.
+		template <typename T>
+		void AddComponent(Entity entity, const T& component)
+		{
+			if (!IsAlive(entity)) return;
+			if (T* existing = GetComponent<T>(entity))
+			{
+				*existing = component;
+				return;
+			}
+			Move(entity, records_[entity.index].archetype->GetMask() | GetComponentMask<T>());
+			const Record& record = records_[entity.index];
+			new (record.archetype->Get<T>(record.row)) T(component);
+		}
+
+		template <typename T>
+		void RemoveComponent(Entity entity)
+		{
+			if (!HasComponent<T>(entity)) return;
+			Move(entity, records_[entity.index].archetype->GetMask() & ~GetComponentMask<T>());
+		}
+
+		// func(Components&...) for every entity having all of them.
+		template <typename... Components, typename Function>
+		void ForEach(Function&& func)
+		{
+			ForEachChunk<Components...>([&func](std::size_t count, Components*... columns)
+				{
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						func(columns[i]...);
+					}
+				});
+		}
+
+		// func(count, Components*...) for every chunk holding entities
+		// with all of them: one contiguous array per component.
+		template <typename... Components, typename Function>
+		void ForEachChunk(Function&& func)
+		{
+			const ComponentMask mask = (ComponentMask(0) | ... | GetComponentMask<Components>());
+			for (Archetype* archetype : archetypeList_)
+			{
+				if ((archetype->GetMask() & mask) != mask) continue;
+				for (std::size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+				{
+					const std::size_t count = archetype->GetChunkSize(chunk);
+					if (count == 0) continue;
+					func(count, archetype->GetColumn<Components>(chunk)...);
+				}
+			}
+		}
+
+		// Same as ForEachChunk, with the entities first:
+		// func(count, const Entity*, Components*...).
+		template <typename... Components, typename Function>
+		void ForEachChunkWithEntities(Function&& func)
+		{
+			const ComponentMask mask = (ComponentMask(0) | ... | GetComponentMask<Components>());
+			for (Archetype* archetype : archetypeList_)
+			{
+				if ((archetype->GetMask() & mask) != mask) continue;
+				for (std::size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+				{
+					const std::size_t count = archetype->GetChunkSize(chunk);
+					if (count == 0) continue;
+					func(
+						count,
+						static_cast<const Entity*>(archetype->GetEntities(chunk)),
+						archetype->GetColumn<Components>(chunk)...);
+				}
+			}
+		}
+
+		// ForEach with the chunks spread over jobSystem, in the calling
+		// thread without one. func runs concurrently: it may only touch
+		// the entity it is given.
+		template <typename... Components, typename Function>
+		void ParallelForEach(JobSystem* jobSystem, Function&& func)
+		{
+			if (jobSystem == nullptr)
+			{
+				ForEach<Components...>(func);
+				return;
+			}
+			const ComponentMask mask = (ComponentMask(0) | ... | GetComponentMask<Components>());
+			CollectChunks(mask);
+			jobSystem->ParallelFor(
+				queryChunks_.size(),
+				kChunksPerJob,
+				[this, &func](std::size_t begin, std::size_t end)
+				{
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						Archetype& archetype = *queryChunks_[i].archetype;
+						const std::size_t chunk = queryChunks_[i].chunk;
+						const std::size_t count = archetype.GetChunkSize(chunk);
+						const auto run = [&func, count](Components*... columns)
+							{
+								for (std::size_t row = 0; row < count; ++row)
+								{
+									func(columns[row]...);
+								}
+							};
+						run(archetype.GetColumn<Components>(chunk)...);
+					}
+				});
+		}
+
+		std::size_t GetArchetypeCount() const { return archetypeList_.size(); }
+
+	private:
+		struct Record
+		{
+			Archetype* archetype = nullptr;
+			std::uint32_t row = 0;
+			std::uint32_t generation = 1;
+		};
+
+		struct ChunkRef
+		{
+			Archetype* archetype;
+			std::size_t chunk;
+		};
+
+		// 8 chunks, 128 KB, per job: enough work to pay for the job and
+		// still inside a per-core L2.
+		static constexpr std::size_t kChunksPerJob = 8;
+
+		Archetype& GetArchetype(ComponentMask mask);
+		Entity AllocateEntity();
+		// Moves the entity's row to the archetype of mask, keeping the
+		// components both have.
+		void Move(Entity entity, ComponentMask mask);
+		// Fills queryChunks_ with the non empty chunks matching mask.
+		void CollectChunks(ComponentMask mask);
+
+		std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes_;
+		// Creation order, for queries.
+		std::vector<Archetype*> archetypeList_;
+		std::vector<Record> records_;
+		std::vector<std::uint32_t> freeIndices_;
+		std::size_t entityCount_ = 0;
+		std::vector<ChunkRef> queryChunks_;
 	};
-}
\ No newline at end of file
+
+} // End namespace gl.
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include <glm/glm.hpp>
+
+#include "components.h"
+#include "mapped_file.h"
+
+namespace gl {
+
+	// Cooked scene: a JSON level description (see data/scenes) turned by
+	// CookScene into one relocatable blob that is used in place once
+	// mapped. Every pointer in it is stored as an offset from the start of
+	// the file, and a fixup table lists where they are; opening the file
+	// is a map plus one pass over that table.
+	//
+	// The structs below are the file layout: fixed size fields, pointers
+	// 64-bit, little endian, and Transform as this build lays it out. The
+	// cooked file is a cache of the JSON, rebuilt when the version or the
+	// source changes; it is not meant to move between builds.
+
+	constexpr std::uint32_t kSceneFileVersion = 1;
+	constexpr std::uint32_t kSceneFileNone = std::numeric_limits<std::uint32_t>::max();
+
+	enum SceneAssetFlags : std::uint32_t
+	{
+		kSceneAssetOccluder = 1,
+	};
+
+	struct SceneFileAsset
+	{
+		const char* name;
+		// Relative to the JSON file's directory.
+		const char* path;
+		std::uint32_t flags;
+		std::uint32_t padding;
+	};
+
+	struct SceneFileEntity
+	{
+		const char* name;
+		// Entities are sorted parents first: parent < own index.
+		std::uint32_t parent;
+		// Asset index, kSceneFileNone for an entity without a model.
+		std::uint32_t model;
+	};
+
+	// Model matrices of instanced copies of one asset, ready for a
+	// GL_ARRAY_BUFFER.
+	struct SceneFileInstances
+	{
+		const glm::mat4* matrices;
+		std::uint32_t model;
+		std::uint32_t count;
+	};
+
+	struct SceneFileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t size;
+		// Plain offsets: read before any fixup.
+		std::uint64_t fixupOffset;
+		std::uint64_t fixupCount;
+		const SceneFileAsset* assets;
+		const SceneFileEntity* entities;
+		// Local transforms, one per entity.
+		const Transform* transforms;
+		const SceneFileInstances* instances;
+		std::uint32_t assetCount;
+		std::uint32_t entityCount;
+		std::uint32_t instanceCount;
+		std::uint32_t padding;
+	};
+
+	// Parses source (JSON) and writes its cooked form to destination.
+	// Reports the first error and returns false on a malformed source.
+	bool CookScene(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+	// A cooked scene mapped in memory and fixed up.
+	class SceneFile
+	{
+	public:
+		// Maps the file, checks it and patches its pointers.
+		bool Open(const std::filesystem::path& path);
+		// The same on a copy of bytes (a packed scene, see vfs.h: the pack
+		// mapping is shared by every reader and cannot be patched).
+		bool Open(std::span<const std::byte> bytes, std::string_view name);
+		void Close();
+		bool IsOpen() const { return header_ != nullptr; }
+
+		const SceneFileHeader& GetHeader() const { return *header_; }
+		std::size_t GetSize() const { return size_; }
+
+	private:
+		bool Load(std::string_view name);
+		bool Fixup(std::string_view name);
+		bool Validate(std::string_view name) const;
+
+		MappedFile file_;
+		std::unique_ptr<std::byte[]> copy_;
+		std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+		const SceneFileHeader* header_ = nullptr;
+	};
+
+} // End namespace gl.
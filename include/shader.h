@@ -4,16 +4,21 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <string_view>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+#include "gl_object.h"
 
 namespace gl {
 
 	class Shader
 	{
 	public:
-		unsigned int id;
+		GlProgram id;
 		// constructor generates the shader on the fly
 		Shader(
 			const std::string& vertexPath,
@@ -23,36 +28,65 @@ namespace gl {
 		// activate the shader
 		void Use() const;
 
+		// Stages and programs that failed to compile or link since start,
+		// thrown or not by their owner. GL thread only.
+		static std::size_t GetBuildFailureCount();
+
 		// utility uniform functions
-		void SetBool(const std::string& name, bool value) const;
+		void SetBool(std::string_view name, bool value) const;
 
-		void SetInt(const std::string& name, int value) const;
+		void SetInt(std::string_view name, int value) const;
 
-		void SetFloat(const std::string& name, float value) const;
+		void SetFloat(std::string_view name, float value) const;
 
-		void SetVec2(const std::string& name, const glm::vec2& value) const;
+		void SetVec2(std::string_view name, const glm::vec2& value) const;
 
-		void SetVec2(const std::string& name, float x, float y) const;
+		void SetVec2(std::string_view name, float x, float y) const;
 
-		void SetVec3(const std::string& name, const glm::vec3& value) const;
+		void SetVec3(std::string_view name, const glm::vec3& value) const;
 
-		void SetVec3(const std::string& name, float x, float y, float z) const;
+		void SetVec3(std::string_view name, float x, float y, float z) const;
 
-		void SetVec4(const std::string& name, const glm::vec4& value) const;
+		void SetVec4(std::string_view name, const glm::vec4& value) const;
 
-		void SetVec4(const std::string& name, float x, float y, float z, float w);
+		void SetVec4(std::string_view name, float x, float y, float z, float w);
 
-		void SetMat2(const std::string& name, const glm::mat2& mat) const;
+		void SetMat2(std::string_view name, const glm::mat2& mat) const;
 
-		void SetMat3(const std::string& name, const glm::mat3& mat) const;
+		void SetMat3(std::string_view name, const glm::mat3& mat) const;
 
-		void SetMat4(const std::string& name, const glm::mat4& mat) const;
+		void SetMat4(std::string_view name, const glm::mat4& mat) const;
+
+	protected:
+		// used by derived programs that are built from other stages
+		Shader() = default;
+
+		// Reads path through the Vfs and compiles it as a stage of the
+		// given type, throwing when the file cannot be read.
+		GLuint CompileStage(GLenum stage, const std::string& path, const std::string& type);
 
-	private:
 		// utility function for checking shader compilation/linking errors.
 		void CheckCompileErrors(GLuint shader, std::string type);
 
+	private:
 		void IsError(const char* file, int line) const;
+		// Location of a uniform, asked from GL the first time only. Set*
+		// run every frame: no string is built on a hit.
+		GLint GetUniformLocation(std::string_view name) const;
+
+		struct NameHash
+		{
+			using is_transparent = void;
+			std::size_t operator()(std::string_view name) const
+			{
+				return std::hash<std::string_view>{}(name);
+			}
+		};
+
+		static std::size_t buildFailures_;
+
+		// GL thread only, like the Set* calls filling it.
+		mutable std::unordered_map<std::string, GLint, NameHash, std::equal_to<>> uniformLocations_;
 	};
 
 } // End namespace gl.
\ No newline at end of file
@@ -5,13 +5,14 @@
 #include <glm/glm.hpp>
 #include <iostream>
 
+#include "gl_object.h"
 #include "shader.h"
 
 namespace gl {
 	class ShadowMap {
 	public:
-		unsigned int depthMapFBO;
-		unsigned int depthMap;
+		GlFramebuffer depthMapFBO;
+		GlTexture depthMap;
 
 		// 1024 is resolution of depth map
 		const unsigned int SHADOW_WIDTH = 1024;
@@ -20,10 +21,10 @@ namespace gl {
 		ShadowMap()
 		{
 			// FRamebuffer object for rendering depth map
-			glGenFramebuffers(1, &depthMapFBO);
+			depthMapFBO = GlFramebuffer::Create("Shadow map");
 
 			// Create 2D texture that will be used as framebuffer's depth buffer
-			glGenTextures(1, &depthMap);
+			depthMap = GlTexture::Create("Shadow map");
 			glBindTexture(GL_TEXTURE_2D, depthMap);
 			glTexImage2D(
 				GL_TEXTURE_2D,
@@ -35,6 +36,7 @@ namespace gl {
 				GL_DEPTH_COMPONENT,
 				GL_FLOAT,
 				NULL);
+			depthMap.SetBytes(TextureBytes(SHADOW_WIDTH, SHADOW_HEIGHT, 4));
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace gl {
+
+	// Uniform grid over a set of points, rebuilt from scratch with a
+	// counting sort. Points of a cell are stored contiguously (index and
+	// position), so a query only touches the cells overlapping its sphere
+	// instead of scanning every point.
+	class SpatialGrid
+	{
+	public:
+		SpatialGrid() = default;
+		explicit SpatialGrid(float cellSize);
+
+		// Rebuilds the grid from SoA coordinates of count points. The grid
+		// covers their bounding box; the number of cells is capped at about
+		// twice the point count by growing the cells if needed.
+		void Build(
+			const float* x,
+			const float* y,
+			const float* z,
+			std::size_t count);
+
+		// Appends to out the indices of the points within radius of center,
+		// in no particular order. Returns how many were appended.
+		std::size_t QueryRadius(
+			const glm::vec3& center,
+			float radius,
+			std::vector<std::uint32_t>& out) const;
+
+		// Replaces out with the indices of the (at most) n points closest
+		// to center, nearest first.
+		void QueryNearest(
+			const glm::vec3& center,
+			std::size_t n,
+			std::vector<std::uint32_t>& out) const;
+
+		float GetCellSize() const { return cellSize_; }
+		std::size_t GetPointCount() const { return indices_.size(); }
+
+	private:
+		glm::ivec3 CellOf(const glm::vec3& position) const;
+		std::size_t CellIndex(const glm::ivec3& cell) const;
+		// Calls visit(slot) for every stored point of the cells in
+		// [minCell, maxCell], clamped to the grid.
+		template<typename Visitor>
+		void ForEachInCells(glm::ivec3 minCell, glm::ivec3 maxCell, Visitor visit) const;
+
+		float requestedCellSize_ = 2.0f;
+		float cellSize_ = 2.0f;
+		glm::vec3 origin_ = glm::vec3(0.0f);
+		glm::ivec3 dimensions_ = glm::ivec3(0);
+
+		// cellStart_[c] .. cellStart_[c + 1] are the slots of cell c.
+		std::vector<std::uint32_t> cellStart_;
+		// Per slot, sorted by cell.
+		std::vector<std::uint32_t> indices_;
+		std::vector<glm::vec3> positions_;
+		// Scratch of Build, kept so rebuilding every frame does not allocate.
+		std::vector<std::uint32_t> cellOfPoint_;
+		std::vector<std::uint32_t> cursor_;
+	};
+
+} // End namespace gl.
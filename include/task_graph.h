@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+
+namespace gl {
+
+	// Frame work expressed as tasks with dependencies, run on a JobSystem.
+	// Every task holds a counter of unfinished dependencies; the job that
+	// finishes a task decrements the counters of its successors and
+	// schedules the ones reaching zero, so independent branches run side by
+	// side without a barrier between them. Built once, run every frame.
+	class TaskGraph
+	{
+	public:
+		using TaskId = std::size_t;
+		using TaskFunction = std::function<void()>;
+
+		// Adds a task running after every task in dependencies. Dependencies
+		// must already be in the graph, which rules out cycles.
+		TaskId AddTask(
+			std::string name,
+			TaskFunction func,
+			const std::vector<TaskId>& dependencies = {});
+
+		// Runs every task once and returns when all are done. Tasks may use
+		// the job system themselves (ParallelFor, Run and Wait).
+		void Run(JobSystem& jobSystem);
+
+		void Clear();
+
+		std::size_t GetTaskCount() const { return tasks_.size(); }
+		const std::string& GetTaskName(TaskId id) const { return tasks_[id]->name; }
+		// Duration of the task in the last Run.
+		double GetTaskMilliseconds(TaskId id) const { return tasks_[id]->milliseconds; }
+		// Duration of the last Run, from first task start to last task end.
+		double GetMilliseconds() const { return milliseconds_; }
+
+	private:
+		struct Task
+		{
+			std::string name;
+			// name, interned for the profiler.
+			const char* profileName = nullptr;
+			TaskFunction func;
+			std::vector<TaskId> successors;
+			std::size_t dependencyCount = 0;
+			std::atomic<std::size_t> pending{ 0 };
+			double milliseconds = 0.0;
+		};
+
+		void Schedule(TaskId id);
+
+		std::vector<std::unique_ptr<Task>> tasks_;
+		double milliseconds_ = 0.0;
+
+		// Only set during Run.
+		JobSystem* jobSystem_ = nullptr;
+		JobCounter* counter_ = nullptr;
+	};
+
+} // End namespace gl.
@@ -1,14 +1,35 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <fstream>
 #include <glad/glad.h>
+
+#include "gl_object.h"
+
 namespace gl {
+	// Decoded pixels of an image file, the CPU half of loading a Texture:
+	// safe on any thread, the GL upload is left to the constructor.
+	struct TextureImage {
+		struct PixelsDeleter {
+			void operator()(unsigned char* pixels) const;
+		};
+
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		std::unique_ptr<unsigned char, PixelsDeleter> pixels;
+
+		// Flipped for GL; no pixels when the file cannot be read.
+		static TextureImage Load(const std::string& file_name);
+	};
+
 	class Texture {
 	public:
-		unsigned int id;
+		GlTexture id;
 
 		Texture() = default;
 		Texture(const std::string& file_name);
+		explicit Texture(const TextureImage& image);
 			
 		void Bind(unsigned int i = 0) const;
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "components.h"
+
+namespace gl {
+
+	// transpose(inverse(m)) of the upper 3x3 of an affine matrix, from its
+	// cofactors: what normals are multiplied by. No 4x4 inverse needed.
+	glm::mat3 ComputeNormalMatrix(const glm::mat4& model);
+
+	// Scene graph of transforms: every node has a local Transform relative
+	// to its parent, Update computes the world and normal matrices.
+	//
+	// The nodes are stored one array per field, sorted so parents come
+	// before their children; Update is then one forward pass. Changing a
+	// local transform only flags the node, and Update starts at the first
+	// flagged node and recomputes flagged nodes and the descendants of
+	// recomputed ones: nodes that do not move cost nothing, and a frame
+	// without changes returns right away.
+	class TransformHierarchy
+	{
+	public:
+		using NodeId = std::uint32_t;
+		static constexpr NodeId kNullNode = std::numeric_limits<NodeId>::max();
+
+		// The parent must exist; kNullNode makes a root.
+		NodeId CreateNode(const Transform& local = Transform{}, NodeId parent = kNullNode);
+		// Destroys the node and its whole subtree.
+		void DestroyNode(NodeId node);
+		bool IsAlive(NodeId node) const;
+		std::size_t GetNodeCount() const { return parents_.size(); }
+		void Clear();
+
+		// The node keeps its local transform, so it moves with its new
+		// parent. Fails when parent is inside the node's subtree.
+		bool SetParent(NodeId node, NodeId parent);
+		NodeId GetParent(NodeId node) const;
+
+		void SetLocal(NodeId node, const Transform& local);
+		const Transform& GetLocal(NodeId node) const;
+		// As of the last Update.
+		const glm::mat4& GetWorld(NodeId node) const;
+		const glm::mat3& GetNormalMatrix(NodeId node) const;
+
+		// Recomputes the moved nodes and their subtrees.
+		void Update();
+		// Nodes Update recomputed, to refresh what depends on them (tree
+		// proxies, instance buffers).
+		const std::vector<NodeId>& GetUpdatedNodes() const { return updated_; }
+
+	private:
+		static constexpr std::uint32_t kNoIndex = std::numeric_limits<std::uint32_t>::max();
+
+		std::uint32_t GetIndex(NodeId node) const { return indices_[node]; }
+		void MarkDirty(std::uint32_t index);
+		// Restores parents before children after SetParent broke it.
+		void Sort();
+
+		// Indexed by position in the sorted order.
+		std::vector<std::uint32_t> parents_;
+		std::vector<Transform> locals_;
+		std::vector<glm::mat4> worlds_;
+		std::vector<glm::mat3> normals_;
+		std::vector<std::uint8_t> dirty_;
+		std::vector<NodeId> ids_;
+
+		// Indexed by NodeId.
+		std::vector<std::uint32_t> indices_;
+		std::vector<NodeId> freeIds_;
+
+		std::vector<NodeId> updated_;
+		// Nothing before it is flagged; GetNodeCount() when nothing is.
+		std::size_t firstDirty_ = 0;
+		bool sorted_ = true;
+	};
+
+	// Links an entity to its node: the entity's Transform is the node's
+	// local transform.
+	struct TransformNode
+	{
+		TransformHierarchy::NodeId node = TransformHierarchy::kNullNode;
+	};
+
+	// Copies the Transform of the entities that move (the ones with a
+	// Velocity) to their node; static entities are not visited.
+	void SyncTransformNodes(Scene& scene, TransformHierarchy& hierarchy);
+
+} // End namespace gl.
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace gl {
+
+	// Every asset is read through the Vfs with a path relative to data/
+	// ("shaders/hello_scene/model.vert"). With a pack mounted, the pack
+	// answers first; anything it lacks, or everything without a pack, is
+	// read from the loose files under the loose root (../data by default,
+	// where the demos run from). Absolute paths always go to the loose
+	// files.
+	//
+	// A pack is data/ in one file, written by WritePack (tools/pack_data,
+	// the data_pack target): a header, a table of contents sorted by path,
+	// then the entries, each at a 4 KiB boundary. Entries that shrink
+	// enough are LZ4 compressed. At runtime the pack is mapped: a stored
+	// entry is read as a view of the mapping, without a copy; a compressed
+	// one is decompressed into a buffer of its own.
+
+	constexpr char kPackMagic[4] = { 'G', 'P', 'A', 'K' };
+	constexpr std::uint32_t kPackVersion = 1;
+	constexpr std::uint64_t kPackAlignment = 4096;
+
+	enum PackEntryFlags : std::uint32_t
+	{
+		kPackEntryLz4 = 1,
+	};
+
+	struct PackHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t size;
+		std::uint64_t entryOffset;
+		std::uint32_t entryCount;
+		std::uint32_t padding;
+	};
+
+	// Offsets from the start of the pack.
+	struct PackEntry
+	{
+		std::uint64_t offset;
+		// In the pack, and once decompressed.
+		std::uint64_t storedSize;
+		std::uint64_t size;
+		// Not null terminated, '/' separated.
+		std::uint32_t pathOffset;
+		std::uint32_t pathSize;
+		std::uint32_t flags;
+		std::uint32_t padding;
+	};
+
+	// Packs every file under directory into destination. compress false
+	// stores all the entries as they are.
+	bool WritePack(
+		const std::filesystem::path& directory,
+		const std::filesystem::path& destination,
+		bool compress = true);
+
+	// The bytes of one file, valid while the pack it may view stays
+	// mounted. Move only.
+	class VfsFile
+	{
+	public:
+		VfsFile() = default;
+		VfsFile(VfsFile&&) noexcept = default;
+		VfsFile& operator=(VfsFile&&) noexcept = default;
+
+		bool IsValid() const { return valid_; }
+		// A view of the mapped pack, no copy made.
+		bool IsMapped() const { return valid_ && owned_ == nullptr; }
+		std::span<const std::byte> GetBytes() const { return bytes_; }
+		std::string_view GetText() const
+		{
+			return { reinterpret_cast<const char*>(bytes_.data()), bytes_.size() };
+		}
+
+	private:
+		friend class Vfs;
+
+		std::span<const std::byte> bytes_;
+		std::unique_ptr<std::byte[]> owned_;
+		bool valid_ = false;
+	};
+
+	// Mount before anything is read and unmount once nothing is: reads are
+	// safe from any thread, changing what is mounted is not.
+	class Vfs
+	{
+	public:
+		static bool Mount(const std::filesystem::path& pack);
+		static void Unmount();
+		static bool IsMounted();
+		static void SetLooseRoot(const std::filesystem::path& directory);
+
+		// Reports the error and returns an invalid file when neither the
+		// pack nor the loose files have path.
+		static VfsFile Read(std::string_view path);
+		static bool IsPacked(std::string_view path);
+		// Where path is on disk when not packed.
+		static std::filesystem::path GetLoosePath(std::string_view path);
+		// '/' separated, without "." or "..": the form the pack stores.
+		static std::string Normalize(std::string_view path);
+	};
+
+} // End namespace gl.
@@ -9,6 +9,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "frame_capture.h"
 #include "framebuffer.h"
 #include "cubemaps.h"
 #include "engine.h"
@@ -27,6 +28,8 @@ namespace gl {
 		void Destroy() override;
 		void OnEvent(SDL_Event& event) override;
 		void DrawImGui() override;
+		Camera* GetCamera() override { return camera_.get(); }
+		CameraPath GetBenchmarkPath() const override { return CameraPath::Orbit(glm::vec3(0.0f), 30.0f, 5.0f); }
 
 	protected:
 		void SetModelMatrix(seconds dt);
@@ -55,6 +58,9 @@ namespace gl {
 		std::unique_ptr<Shader> skyboxShader_ = nullptr;
 		std::unique_ptr<Cubemaps> cubemaps_ = nullptr;
 
+		FrameCapture capture_;
+		bool captureRaw_ = false;
+
 		glm::mat4 model_ = glm::mat4(1.0f);
 		glm::mat4 view_ = glm::mat4(1.0f);
 		glm::mat4 inv_model_ = glm::mat4(1.0f);
@@ -82,20 +88,19 @@ namespace gl {
 		cubemaps_ = std::make_unique<Cubemaps>();
 
 
-		std::string path = "../";
-		model_obj_ = std::make_unique<Model>(path + "data/meshes/planet.obj");
+		model_obj_ = std::make_unique<Model>("meshes/planet.obj");
 
 		shaders_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/model.vert",
-			path + "data/shaders/hello_scene/model.frag");
+			"shaders/hello_scene/model.vert",
+			"shaders/hello_scene/model.frag");
 
 		framebufferShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/framebuffer.vert",
-			path + "data/shaders/hello_scene/framebuffer.frag");
+			"shaders/hello_scene/framebuffer.vert",
+			"shaders/hello_scene/framebuffer.frag");
 
 		skyboxShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/cubemaps.vert",
-			path + "data/shaders/hello_scene/cubemaps.frag");
+			"shaders/hello_scene/cubemaps.vert",
+			"shaders/hello_scene/cubemaps.frag");
 
 		glClearColor(0.82352941f, 0.63137255f, 0.81568627f, 1.0f);
 	}
@@ -162,6 +167,7 @@ namespace gl {
 		glm::mat4 view = glm::mat4(glm::mat3(camera_->GetViewMatrix()));
 		skyboxShader_->SetMat4("view", view);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
+		capture_.Capture(*framebuffer_);
 
 		// Framebuffer
 		framebuffer_->Unbind();
@@ -175,6 +181,14 @@ namespace gl {
 
 	void HelloModel::Destroy()
 	{
+		// While the context is current: the GL objects go with them.
+		capture_.Stop();
+		cubemaps_.reset();
+		skyboxShader_.reset();
+		framebufferShader_.reset();
+		framebuffer_.reset();
+		model_obj_.reset();
+		shaders_.reset();
 	}
 
 	void HelloModel::OnEvent(SDL_Event& event)
@@ -217,6 +231,33 @@ namespace gl {
 
 	void HelloModel::DrawImGui()
 	{
+		ImGui::Begin("Capture");
+		if (!capture_.IsCapturing())
+		{
+			ImGui::Checkbox("Raw stream", &captureRaw_);
+			if (ImGui::Button("Start capture"))
+			{
+				FrameCapture::Options options;
+				options.directory = "capture";
+				options.format = captureRaw_ ? CaptureFormat::Raw : CaptureFormat::Png;
+				capture_.Start(options);
+			}
+		}
+		else if (ImGui::Button("Stop capture"))
+		{
+			capture_.Stop();
+		}
+		ImGui::Text(
+			"%llu captured, %llu written, %llu dropped, %zu queued",
+			static_cast<unsigned long long>(capture_.GetCapturedCount()),
+			static_cast<unsigned long long>(capture_.GetWrittenCount()),
+			static_cast<unsigned long long>(capture_.GetDroppedCount()),
+			capture_.GetQueuedCount());
+		ImGui::Text(
+			"%.3f ms per capture, %llu stalls",
+			capture_.GetCaptureMilliseconds(),
+			static_cast<unsigned long long>(capture_.GetStallCount()));
+		ImGui::End();
 	}
 
 } // End namespace gl.
@@ -224,7 +265,7 @@ namespace gl {
 int main(int argc, char** argv)
 {
 	gl::HelloModel program;
-	gl::Engine engine(program);
+	gl::Engine engine(program, argc, argv);
 	engine.Run();
 	return EXIT_SUCCESS;
 }
@@ -3,15 +3,21 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "imgui.h"
+
 #include "framebuffer.h"
 #include "cubemaps.h"
+#include "frustum.h"
+#include "gpu_culler.h"
 #include "instancing.h"
+#include "occlusion_culler.h"
 #include "engine.h"
 #include "camera.h"
 #include "texture.h"
@@ -28,6 +34,8 @@ namespace gl {
 		void Destroy() override;
 		void OnEvent(SDL_Event& event) override;
 		void DrawImGui() override;
+		Camera* GetCamera() override { return camera_.get(); }
+		CameraPath GetBenchmarkPath() const override { return CameraPath::Orbit(glm::vec3(0.0f), 30.0f, 5.0f); }
 
 	protected:
 		void SetModelMatrix(seconds dt);
@@ -47,6 +55,15 @@ namespace gl {
 
 		float time_ = 0.0f;
 		float delta_time_ = 0.0f;
+		unsigned int asteroidCount_ = 100000;
+		float gpuValidationError_ = 0.0f;
+		bool gpuCullingEnabled_ = true;
+		GpuCullValidation gpuCullValidation_;
+		float queryRadius_ = 5.0f;
+		// Seconds until the next proximity query in SimulationMode::Cpu.
+		float queryCooldown_ = 0.0f;
+		std::size_t nearbyCount_ = 0;
+		std::vector<std::uint32_t> nearbyAsteroids_;
 
 		std::unique_ptr<Camera> camera_ = nullptr;
 		std::unique_ptr<Shader> shaders_ = nullptr;
@@ -57,8 +74,12 @@ namespace gl {
 		std::unique_ptr<Shader> framebufferShader_ = nullptr;
 		std::unique_ptr<Shader> skyboxShader_ = nullptr;
 		std::unique_ptr<Cubemaps> cubemaps_ = nullptr;
+		std::unique_ptr<GpuCuller> gpuCuller_ = nullptr;
 		std::unique_ptr<Instancing> instancing_ = nullptr;
+		std::unique_ptr<OcclusionCuller> occlusionCuller_ = nullptr;
+		bool occlusionEnabled_ = true;
 		std::unique_ptr<Shader> instancingShader_ = nullptr;
+		std::unique_ptr<Shader> instancingCompactShader_ = nullptr;
 
 		glm::mat4 model_ = glm::mat4(1.0f);
 		glm::mat4 view_ = glm::mat4(1.0f);
@@ -81,31 +102,42 @@ namespace gl {
 
 	void HelloModel::Init()
 	{
-		std::string path = "../";
 		glEnable(GL_DEPTH_TEST);
 		camera_ = std::make_unique<Camera>(glm::vec3(.0f, .0f, 30.0f));
-		framebuffer_ = std::make_unique<Framebuffer>();
+		// Sampleable depth: the GPU culler builds its Hi-Z pyramid from it.
+		framebuffer_ = std::make_unique<Framebuffer>(true);
 		cubemaps_ = std::make_unique<Cubemaps>();
-		instancing_ = std::make_unique<Instancing>(path + "data/meshes/rock.obj");
-
-
-		planet = std::make_unique<Model>(path + "data/meshes/planet.obj");
+		instancing_ = std::make_unique<Instancing>(
+			"meshes/rock.obj",
+			asteroidCount_,
+			GetJobSystem());
+		instancing_->InitGpuSimulation(
+			"shaders/hello_scene/asteroid_orbit.comp");
+		gpuCuller_ = std::make_unique<GpuCuller>(
+			"shaders/hello_scene/", 1024, 720);
+
+		planet = std::make_unique<Model>("meshes/planet.obj", true);
+		occlusionCuller_ = std::make_unique<OcclusionCuller>(256, 128, GetJobSystem());
 
 		shaders_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_model/model.vert",
-			path + "data/shaders/hello_model/model.frag");
+			"shaders/hello_scene/model.vert",
+			"shaders/hello_scene/model.frag");
 
 		framebufferShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_framebuffer/framebuffer.vert",
-			path + "data/shaders/hello_framebuffer/framebuffer.frag");
+			"shaders/hello_scene/framebuffer.vert",
+			"shaders/hello_scene/framebuffer.frag");
 
 		skyboxShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/cubemaps.vert",
-			path + "data/shaders/hello_scene/cubemaps.frag");
+			"shaders/hello_scene/cubemaps.vert",
+			"shaders/hello_scene/cubemaps.frag");
 
 		instancingShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/instancing.vert",
-			path + "data/shaders/hello_scene/instancing.frag");
+			"shaders/hello_scene/instancing.vert",
+			"shaders/hello_scene/instancing.frag");
+
+		instancingCompactShader_ = std::make_unique<Shader>(
+			"shaders/hello_scene/instancing_compact.vert",
+			"shaders/hello_scene/instancing.frag");
 
 		glClearColor(0.82352941f, 0.63137255f, 0.81568627f, 1.0f);
 	}
@@ -138,10 +170,13 @@ namespace gl {
 		shaders_->SetMat4("inv_model", inv_model_);
 		shaders_->SetVec3("camera_position", camera_->position);
 
-		instancingShader_->Use();
-		instancingShader_->SetMat4("view", view_);
-		instancingShader_->SetMat4("projection", projection_);
-		instancingShader_->SetVec3("camera_position", camera_->position);
+		for (const auto* shader : { instancingShader_.get(), instancingCompactShader_.get() })
+		{
+			shader->Use();
+			shader->SetMat4("view", view_);
+			shader->SetMat4("projection", projection_);
+			shader->SetVec3("camera_position", camera_->position);
+		}
 	}
 
 	void HelloModel::Update(seconds dt)
@@ -179,6 +214,11 @@ namespace gl {
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 
 		framebuffer_->Unbind();
+		if (gpuCullingEnabled_ && instancing_->GetSimulationMode() == SimulationMode::Gpu)
+		{
+			// The planet depth occludes the belt in the culling shader.
+			gpuCuller_->BuildHiZ(framebuffer_->GetDepthBuffer(), projection_ * view_);
+		}
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		framebufferShader_->Use();
 		framebufferShader_->SetInt("screenTexture", 0);
@@ -187,14 +227,42 @@ namespace gl {
 		framebuffer_->Draw();
 
 		// Instancing
-		instancingShader_->Use();
+		Shader& instancingShader =
+			instancing_->GetInstanceFormat() == InstanceFormat::Matrix ?
+			*instancingShader_ :
+			*instancingCompactShader_;
+		instancingShader.Use();
 		glm::mat4 model = glm::mat4(1.0f);
-		instancingShader_->SetMat4("model", model);
-		instancing_->Update(dt, *instancingShader_);
+		instancingShader.SetMat4("model", model);
+		instancing_->SetFrustum(Frustum(projection_ * view_));
+		if (occlusionEnabled_)
+		{
+			// The planet hides the part of the belt behind it.
+			occlusionCuller_->BeginFrame(projection_ * view_);
+			occlusionCuller_->AddOccluder(planet->GetOccluderMesh(), model_);
+			occlusionCuller_->Rasterize();
+		}
+		instancing_->SetOcclusionCuller(occlusionEnabled_ ? occlusionCuller_.get() : nullptr);
+		instancing_->SetGpuCuller(gpuCullingEnabled_ ? gpuCuller_.get() : nullptr);
+		instancing_->Update(dt, instancingShader);
 	}
 
 	void HelloModel::Destroy()
 	{
+		// While the context is current: the GL objects go with them.
+		instancingCompactShader_.reset();
+		instancingShader_.reset();
+		occlusionCuller_.reset();
+		instancing_.reset();
+		gpuCuller_.reset();
+		cubemaps_.reset();
+		skyboxShader_.reset();
+		framebufferShader_.reset();
+		framebuffer_.reset();
+		rock.reset();
+		planet.reset();
+		model_obj_.reset();
+		shaders_.reset();
 	}
 
 	void HelloModel::OnEvent(SDL_Event& event)
@@ -237,6 +305,105 @@ namespace gl {
 
 	void HelloModel::DrawImGui()
 	{
+		ImGui::Begin("Instancing");
+		const char* modes[] = { "CPU (SoA kernels)", "GPU (compute shader)" };
+		int mode = static_cast<int>(instancing_->GetSimulationMode());
+		if (ImGui::Combo("Simulation", &mode, modes, 2))
+		{
+			instancing_->SetSimulationMode(static_cast<SimulationMode>(mode));
+		}
+		if (instancing_->GetSimulationMode() == SimulationMode::Gpu)
+		{
+			if (ImGui::Button("Validate against CPU"))
+			{
+				gpuValidationError_ = instancing_->ValidateGpuSimulation();
+			}
+			ImGui::SameLine();
+			ImGui::Text("max error: %g", gpuValidationError_);
+			ImGui::Checkbox("GPU culling", &gpuCullingEnabled_);
+			if (gpuCullingEnabled_)
+			{
+				bool hiZ = gpuCuller_->IsHiZEnabled();
+				if (ImGui::Checkbox("Hi-Z occlusion", &hiZ))
+				{
+					gpuCuller_->SetHiZEnabled(hiZ);
+				}
+				if (ImGui::Button("Validate culling"))
+				{
+					gpuCullValidation_ = gpuCuller_->Validate();
+				}
+				ImGui::Text(
+					"GPU visible: %zu, CPU visible: %zu",
+					gpuCullValidation_.gpuVisible,
+					gpuCullValidation_.cpuVisible);
+				ImGui::Text(
+					"Mismatches: %zu, corrupt records: %zu",
+					gpuCullValidation_.mismatches,
+					gpuCullValidation_.corruptRecords);
+			}
+		}
+		else
+		{
+			ImGui::Checkbox("Frustum culling", &instancing_->cullingEnabled_);
+			if (instancing_->cullingEnabled_)
+			{
+				ImGui::Checkbox("Occlusion culling", &occlusionEnabled_);
+			}
+		}
+		const char* formats[] = { "mat4 (64 B)", "compact (24 B)" };
+		int format = static_cast<int>(instancing_->GetInstanceFormat());
+		if (ImGui::Combo("Instance format", &format, formats, 2))
+		{
+			instancing_->SetInstanceFormat(static_cast<InstanceFormat>(format));
+		}
+		ImGui::Text(
+			"Visible: %zu / %zu",
+			instancing_->GetVisibleCount(),
+			instancing_->state_.Size());
+		if (occlusionEnabled_)
+		{
+			ImGui::Text("Occluded: %zu", instancing_->GetOccludedCount());
+			ImGui::Text(
+				"Occluder raster: %.3f ms (%zu triangles)",
+				occlusionCuller_->GetRasterMilliseconds(),
+				occlusionCuller_->GetRasterizedTriangleCount());
+		}
+		ImGui::Text(
+			"Instance upload: %.2f MB / frame",
+			static_cast<float>(instancing_->GetUploadedBytes()) / (1024.0f * 1024.0f));
+
+		// Proximity queries go through the spatial grid, not a full scan.
+		// They need the CPU positions: with the CPU simulation they are
+		// refreshed a few times a second, with the GPU one only on demand,
+		// as each query then advances the CPU copy and rebuilds the grid.
+		ImGui::SliderFloat("Query radius", &queryRadius_, 0.5f, 20.0f);
+		bool query = false;
+		if (instancing_->GetSimulationMode() == SimulationMode::Gpu)
+		{
+			query = ImGui::Button("Query around the camera");
+		}
+		else
+		{
+			queryCooldown_ -= ImGui::GetIO().DeltaTime;
+			query = queryCooldown_ <= 0.0f;
+		}
+		if (query)
+		{
+			queryCooldown_ = 0.25f;
+			nearbyAsteroids_.clear();
+			nearbyCount_ = instancing_->QueryRadius(camera_->position, queryRadius_, nearbyAsteroids_);
+			instancing_->QueryNearest(camera_->position, 1, nearbyAsteroids_);
+		}
+		ImGui::Text("Asteroids within radius of the camera: %zu", nearbyCount_);
+		if (!nearbyAsteroids_.empty())
+		{
+			const glm::vec3 nearest = instancing_->GetPosition(nearbyAsteroids_[0]);
+			ImGui::Text(
+				"Nearest: #%u at %.1f units",
+				nearbyAsteroids_[0],
+				glm::length(nearest - camera_->position));
+		}
+		ImGui::End();
 	}
 
 } // End namespace gl.
@@ -244,7 +411,7 @@ namespace gl {
 int main(int argc, char** argv)
 {
 	gl::HelloModel program;
-	gl::Engine engine(program);
+	gl::Engine engine(program, argc, argv);
 	engine.Run();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
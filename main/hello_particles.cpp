@@ -0,0 +1,260 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <chrono>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "imgui.h"
+
+#include "components.h"
+#include "engine.h"
+#include "framebuffer.h"
+#include "gpu_particles.h"
+#include "particle.h"
+#include "scene.h"
+#include "texture.h"
+#include "shader.h"
+
+namespace gl {
+
+	class HelloParticles : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		enum class Backend
+		{
+			Cpu,
+			Gpu
+		};
+
+		// Draws the obstacles into the depth buffer the GPU particles
+		// collide with: scissored clears, no geometry needed.
+		void DrawObstacles() const;
+
+		float time_ = 0.0f;
+		float updateMilliseconds_ = 0.0f;
+		float drawMilliseconds_ = 0.0f;
+		int newParticles_ = 17000;
+		float particleScale_ = 4.0f;
+		Backend backend_ = Backend::Cpu;
+		bool obstaclesEnabled_ = true;
+		GpuParticleValidation gpuValidation_;
+
+		// x, y, width, height in window pixels (origin bottom left).
+		std::array<glm::ivec4, 3> obstacles_ = {
+			glm::ivec4(200, 120, 160, 40),
+			glm::ivec4(620, 500, 40, 160),
+			glm::ivec4(440, 330, 140, 60) };
+
+		Scene scene_;
+		Entity emitter_;
+		std::unique_ptr<ParticleGenerator> particles_ = nullptr;
+		std::unique_ptr<GpuParticleSystem> gpuParticles_ = nullptr;
+		std::unique_ptr<Framebuffer> framebuffer_ = nullptr;
+		std::unique_ptr<Shader> framebufferShader_ = nullptr;
+
+		glm::mat4 projection_ = glm::mat4(1.0f);
+	};
+
+	void HelloParticles::Init()
+	{
+		emitter_ = scene_.CreateEntity(Transform{}, Velocity{}, Emitter{});
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		// One program and texture for both systems.
+		auto shader = std::make_shared<Shader>(
+			"shaders/hello_particles/particle.vert",
+			"shaders/hello_particles/particle.frag");
+		auto texture = std::make_shared<Texture>("textures/texture_smily.png");
+		// 17k particles per frame living one second: about a million alive.
+		particles_ = std::make_unique<ParticleGenerator>(
+			shader, texture, 1000000, GetJobSystem());
+		gpuParticles_ = std::make_unique<GpuParticleSystem>(
+			"shaders/hello_particles/", shader, texture, 1000000);
+
+		framebuffer_ = std::make_unique<Framebuffer>(true);
+		framebufferShader_ = std::make_unique<Shader>(
+			"shaders/hello_scene/framebuffer.vert",
+			"shaders/hello_scene/framebuffer.frag");
+
+		projection_ = glm::ortho(0.0f, 1024.0f, 720.0f, 0.0f, -1.0f, 1.0f);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	void HelloParticles::Update(seconds dt)
+	{
+		time_ += dt.count();
+		// Circle around the center of the window, particles trail behind.
+		const glm::vec2 center(512.0f, 360.0f);
+		Transform& transform = *scene_.GetComponent<Transform>(emitter_);
+		Velocity& velocity = *scene_.GetComponent<Velocity>(emitter_);
+		Emitter& emitter = *scene_.GetComponent<Emitter>(emitter_);
+		const glm::vec2 previous(transform.position);
+		const glm::vec2 position = center + 250.0f * glm::vec2(std::cos(time_), std::sin(time_));
+		transform.position = glm::vec3(position, 0.0f);
+		velocity.linear = glm::vec3((position - previous) / std::max(dt.count(), 1e-4f) * 10.0f, 0.0f);
+		emitter.particlesPerFrame = static_cast<std::uint32_t>(newParticles_);
+		const glm::vec2 origin = position + emitter.offset;
+		const glm::vec2 particleVelocity = glm::vec2(velocity.linear) * emitter.inheritVelocity;
+
+		framebuffer_->Bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClearDepthf(1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (obstaclesEnabled_)
+		{
+			DrawObstacles();
+		}
+
+		// GPU timings only cover the submission, the work is asynchronous.
+		const auto updateStart = std::chrono::steady_clock::now();
+		if (backend_ == Backend::Cpu)
+		{
+			particles_->Update(dt.count(), origin, particleVelocity, emitter.particlesPerFrame);
+		}
+		else
+		{
+			gpuParticles_->SetCollisionDepth(
+				obstaclesEnabled_ ? framebuffer_->GetDepthBuffer() : 0,
+				projection_);
+			gpuParticles_->Update(dt.count(), origin, particleVelocity, emitter.particlesPerFrame);
+		}
+		const auto drawStart = std::chrono::steady_clock::now();
+
+		Shader& shader = backend_ == Backend::Cpu ?
+			particles_->GetShader() :
+			gpuParticles_->GetShader();
+		shader.Use();
+		shader.SetMat4("projection", projection_);
+		shader.SetFloat("scale", particleScale_);
+		if (backend_ == Backend::Cpu)
+		{
+			particles_->Draw();
+		}
+		else
+		{
+			gpuParticles_->Draw();
+		}
+		const auto drawEnd = std::chrono::steady_clock::now();
+
+		framebuffer_->Unbind();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		framebufferShader_->Use();
+		framebufferShader_->SetInt("screenTexture", 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, framebuffer_->GetColorBuffer());
+		framebuffer_->Draw();
+
+		using milliseconds = std::chrono::duration<float, std::milli>;
+		updateMilliseconds_ = milliseconds(drawStart - updateStart).count();
+		drawMilliseconds_ = milliseconds(drawEnd - drawStart).count();
+	}
+
+	void HelloParticles::DrawObstacles() const
+	{
+		// In front of the z = 0 particle plane: window depth 0.45 < 0.5.
+		glEnable(GL_SCISSOR_TEST);
+		glClearColor(0.3f, 0.3f, 0.35f, 1.0f);
+		glClearDepthf(0.45f);
+		for (const auto& obstacle : obstacles_)
+		{
+			glScissor(obstacle.x, obstacle.y, obstacle.z, obstacle.w);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+		glDisable(GL_SCISSOR_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClearDepthf(1.0f);
+	}
+
+	void HelloParticles::Destroy()
+	{
+		// While the context is current: the GL objects go with them.
+		framebufferShader_.reset();
+		framebuffer_.reset();
+		gpuParticles_.reset();
+		particles_.reset();
+	}
+
+	void HelloParticles::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED)
+		{
+			glViewport(0, 0, event.window.data1, event.window.data2);
+		}
+		if (event.type == SDL_KEYDOWN)
+		{
+			if (event.key.keysym.sym == SDLK_ESCAPE)
+				exit(0);
+		}
+	}
+
+	void HelloParticles::DrawImGui()
+	{
+		ImGui::Begin("Particles");
+		const char* backends[] = { "CPU (SoA)", "GPU (compute shader)" };
+		int backend = static_cast<int>(backend_);
+		if (ImGui::Combo("Backend", &backend, backends, 2))
+		{
+			backend_ = static_cast<Backend>(backend);
+		}
+		const char* blends[] = { "Additive", "Alpha, sorted back to front" };
+		int blend = static_cast<int>(particles_->GetBlendMode());
+		if (ImGui::Combo("Blending", &blend, blends, 2))
+		{
+			particles_->SetBlendMode(static_cast<ParticleBlend>(blend));
+			gpuParticles_->SetBlendMode(static_cast<ParticleBlend>(blend));
+		}
+		ImGui::SliderInt("New per frame", &newParticles_, 0, 50000);
+		ImGui::SliderFloat("Scale", &particleScale_, 1.0f, 16.0f);
+		ImGui::Checkbox("Obstacles (GPU collisions)", &obstaclesEnabled_);
+		if (backend_ == Backend::Cpu)
+		{
+			ImGui::Text(
+				"Alive: %zu / %zu",
+				particles_->GetLiveCount(),
+				particles_->GetCapacity());
+		}
+		else
+		{
+			if (ImGui::Button("Validate GPU lists"))
+			{
+				gpuValidation_ = gpuParticles_->Validate();
+			}
+			ImGui::Text(
+				"Alive: %zu, dead: %zu, draw count %s",
+				gpuValidation_.alive,
+				gpuValidation_.dead,
+				gpuValidation_.drawCountMatches ? "ok" : "wrong");
+			ImGui::Text(
+				"Lost: %zu, duplicated: %zu, expired: %zu, bad instances: %zu",
+				gpuValidation_.lostSlots,
+				gpuValidation_.duplicateSlots,
+				gpuValidation_.expiredAlive,
+				gpuValidation_.badInstances);
+			ImGui::Text("Sort errors: %zu", gpuValidation_.sortErrors);
+		}
+		ImGui::Text("Update: %.3f ms", updateMilliseconds_);
+		ImGui::Text("Upload + draw: %.3f ms", drawMilliseconds_);
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloParticles program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
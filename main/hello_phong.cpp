@@ -11,6 +11,7 @@
 
 #include "engine.h"
 #include "camera.h"
+#include "gl_object.h"
 #include "texture.h"
 #include "shader.h"
 
@@ -33,9 +34,9 @@ namespace gl {
 		void SetUniformMatrix() const;
 
 	protected:
-		unsigned int VAO_; // move to mesh.h
-		unsigned int VBO_; // move to mesh.h
-		unsigned int EBO_; // move to mesh.h
+		GlVertexArray VAO_; // move to mesh.h
+		GlBuffer VBO_; // move to mesh.h
+		GlBuffer EBO_; // move to mesh.h
 		unsigned int vertex_shader_;
 		unsigned int fragment_shader_;
 		unsigned int program_;
@@ -85,11 +86,11 @@ namespace gl {
 		camera_ = std::make_unique<Camera>(glm::vec3(.0f, .0f, 2.0f));
 
 		// VAO binding should be before VAO.
-		glGenVertexArrays(1, &VAO_);
+		VAO_ = GlVertexArray::Create("Phong cube");
 		glBindVertexArray(VAO_);
 
 		// EBO.
-		glGenBuffers(1, &EBO_);
+		EBO_ = GlBuffer::Create("Phong cube indices");
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
 		glBufferData(
 			GL_ELEMENT_ARRAY_BUFFER,
@@ -99,7 +100,7 @@ namespace gl {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 		// VBO.
-		glGenBuffers(1, &VBO_);
+		VBO_ = GlBuffer::Create("Phong cube vertices");
 		glBindBuffer(GL_ARRAY_BUFFER, VBO_);
 		glBufferData(
 			GL_ARRAY_BUFFER,
@@ -136,15 +137,14 @@ namespace gl {
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		std::string path = "../";
 		texture_diffuse_ = std::make_unique<Texture>(
-			path + "data/textures/WoodFloorColor.jpg");
+			"textures/WoodFloorColor.jpg");
 		texture_specular_ = std::make_unique<Texture>(
-			path + "data/textures/WoodFloorRoughness.jpg");
+			"textures/WoodFloorRoughness.jpg");
 
 		shaders_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_phong/phong.vert",
-			path + "data/shaders/hello_phong/phong.frag");
+			"shaders/hello_phong/phong.vert",
+			"shaders/hello_phong/phong.frag");
 
 		// Bind uniform to program.
 		shaders_->Use();
@@ -201,6 +201,13 @@ namespace gl {
 
 	void HelloTransform::Destroy()
 	{
+		// While the context is current: the GL objects go with them.
+		shaders_.reset();
+		texture_specular_.reset();
+		texture_diffuse_.reset();
+		EBO_.Reset();
+		VBO_.Reset();
+		VAO_.Reset();
 	}
 
 	void HelloTransform::OnEvent(SDL_Event& event)
@@ -3,21 +3,33 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 
+#include "imgui.h"
+
+#include "dynamic_aabb_tree.h"
+#include "frustum.h"
+#include "occlusion_culler.h"
+#include "profiler.h"
+#include "task_graph.h"
 #include "framebuffer.h"
 #include "cubemaps.h"
 #include "engine.h"
 #include "camera.h"
 #include "texture.h"
 #include "shader.h"
+#include "level.h"
 #include "model.h"
+#include "scene.h"
+#include "transform_hierarchy.h"
 
 namespace gl {
 	class HelloModel : public Program
@@ -25,15 +37,23 @@ namespace gl {
 	public:
 		void Init() override;
 		void Update(seconds dt) override;
+		bool SupportsRenderThread() const override { return true; }
+		void Simulate(seconds dt, FramePacket& packet) override;
+		void Render(const FramePacket& packet) override;
+		bool SupportsFixedTimestep() const override { return true; }
+		void FixedUpdate(seconds step) override;
 		void Destroy() override;
 		void OnEvent(SDL_Event& event) override;
 		void DrawImGui() override;
+		Camera* GetCamera() override { return camera_.get(); }
+		CameraPath GetBenchmarkPath() const override { return CameraPath::Orbit(glm::vec3(0.0f, 90.0f, 0.0f), 110.0f, 30.0f); }
 
 	protected:
 		void SetViewMatrix(seconds dt);
 		void SetProjectionMatrix();
 		void IsError(const std::string& file, int line) const;
-		void SetUniformMatrix() const;
+		void SetUniformMatrix(const FramePacket& packet) const;
+		void BuildFrameGraph();
 
 	protected:
 		unsigned int vertex_shader_;
@@ -46,10 +66,15 @@ namespace gl {
 
 		float time_ = 0.0f;
 		float delta_time_ = 0.0f;
+		const float cameraSpeed_ = 1.0f;
+		// Camera positions of the last two fixed steps.
+		glm::vec3 previousCameraPosition_ = glm::vec3(0.0f);
+		glm::vec3 currentCameraPosition_ = glm::vec3(0.0f);
 
 		std::unique_ptr<Camera> camera_ = nullptr;
 		std::unique_ptr<Shader> shaders_ = nullptr;
-		std::unique_ptr<Model> model_obj_ = nullptr;
+		// Owned by level_.
+		Model* model_obj_ = nullptr;
 		std::unique_ptr<Framebuffer> framebuffer_ = nullptr;
 		std::unique_ptr<Shader> framebufferShader_ = nullptr;
 		std::unique_ptr<Shader> skyboxShader_ = nullptr;
@@ -60,6 +85,26 @@ namespace gl {
 		glm::mat4 model_ = glm::mat4(1.0f);
 		glm::mat4 view_ = glm::mat4(1.0f);
 		glm::mat4 projection_ = glm::mat4(1.0f);
+		glm::mat4 viewProjection_ = glm::mat4(1.0f);
+
+		// data/scenes/hello_scene.json: eight mountains under one terrain
+		// root. They never move: after Init, transforms_.Update finds
+		// nothing to recompute.
+		Scene scene_;
+		TransformHierarchy transforms_;
+		Level level_;
+		std::vector<TransformHierarchy::NodeId> mountainNodes_;
+		std::vector<Aabb> mountainBounds_;
+		DynamicAabbTree mountainTree_;
+		std::vector<std::uint32_t> visibleMountains_;
+		// Visible and not occluded, filled by the frame graph.
+		std::vector<std::uint32_t> drawnMountains_;
+		std::unique_ptr<OcclusionCuller> occlusionCuller_ = nullptr;
+		TaskGraph frameGraph_;
+		// Frame recorded and drawn by Update without the render thread.
+		FramePacket packet_;
+		bool occlusionEnabled_ = true;
+		std::size_t occludedMountains_ = 0;
 	};
 
 	void HelloModel::IsError(const std::string& file, int line) const
@@ -79,36 +124,96 @@ namespace gl {
 	{
 		glEnable(GL_DEPTH_TEST);
 		camera_ = std::make_unique<Camera>(glm::vec3(50.0f, 90.0f, 50.0f));
+		previousCameraPosition_ = camera_->position;
+		currentCameraPosition_ = camera_->position;
 		framebuffer_ = std::make_unique<Framebuffer>();
 		cubemaps_ = std::make_unique<Cubemaps>();
 
 
-		std::string path = "../";
-		model_obj_ = std::make_unique<Model>(path + "data/meshes/mountain.obj");
+		if (!level_.Load("scenes/hello_scene.json", *GetJobSystem(), scene_, transforms_))
+		{
+			throw std::runtime_error("Cannot load level: hello_scene.json");
+		}
+		model_obj_ = &level_.GetModel(0);
+		// Every entity with a model is a mountain.
+		for (const Entity entity : level_.GetEntities())
+		{
+			if (!scene_.HasComponent<ModelInstance>(entity)) continue;
+			mountainNodes_.push_back(scene_.GetComponent<TransformNode>(entity)->node);
+		}
+		occlusionCuller_ = std::make_unique<OcclusionCuller>(256, 128, GetJobSystem());
+		transforms_.Update();
+		mountainBounds_.resize(mountainNodes_.size());
+		for (std::size_t i = 0; i < mountainNodes_.size(); ++i)
+		{
+			mountainBounds_[i] = model_obj_->GetBounds().Transform(transforms_.GetWorld(mountainNodes_[i]));
+			mountainTree_.CreateProxy(
+				mountainBounds_[i],
+				static_cast<std::uint32_t>(i));
+		}
+		BuildFrameGraph();
 
 		shaders_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/model.vert",
-			path + "data/shaders/hello_scene/model.frag");
+			"shaders/hello_scene/model.vert",
+			"shaders/hello_scene/model.frag");
 
 		framebufferShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/framebuffer.vert",
-			path + "data/shaders/hello_scene/framebuffer.frag");
+			"shaders/hello_scene/framebuffer.vert",
+			"shaders/hello_scene/framebuffer.frag");
 
 		skyboxShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/cubemaps.vert",
-			path + "data/shaders/hello_scene/cubemaps.frag");
+			"shaders/hello_scene/cubemaps.vert",
+			"shaders/hello_scene/cubemaps.frag");
 
 		dirLightShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/dirlight.vert",
-			path + "data/shaders/hello_scene/dirlight.frag");
+			"shaders/hello_scene/dirlight.vert",
+			"shaders/hello_scene/dirlight.frag");
 
 		normalMapShader_ = std::make_unique<Shader>(
-			path + "data/shaders/hello_scene/normalmap.vert",
-			path + "data/shaders/hello_scene/normalmap.frag");
+			"shaders/hello_scene/normalmap.vert",
+			"shaders/hello_scene/normalmap.frag");
 
 		glClearColor(0.82352941f, 0.63137255f, 0.81568627f, 1.0f);
 	}
 
+	void HelloModel::BuildFrameGraph()
+	{
+		// The frustum query and the occluder raster do not depend on each
+		// other and run side by side; every mountain goes to the raster,
+		// the ones off screen are rejected at triangle setup. GL calls stay
+		// on the main thread, after the graph.
+		const auto frustumQuery = frameGraph_.AddTask("frustum query", [this]()
+			{
+				visibleMountains_.clear();
+				mountainTree_.QueryFrustum(Frustum(viewProjection_), visibleMountains_);
+			});
+		const auto occluderRaster = frameGraph_.AddTask("occluder raster", [this]()
+			{
+				if (!occlusionEnabled_) return;
+				occlusionCuller_->BeginFrame(viewProjection_);
+				for (const auto node : mountainNodes_)
+				{
+					occlusionCuller_->AddOccluder(
+						model_obj_->GetOccluderMesh(),
+						transforms_.GetWorld(node));
+				}
+				occlusionCuller_->Rasterize();
+			});
+		frameGraph_.AddTask("occlusion test", [this]()
+			{
+				drawnMountains_.clear();
+				for (const auto mountain : visibleMountains_)
+				{
+					if (occlusionEnabled_ && !occlusionCuller_->IsVisible(mountainBounds_[mountain]))
+					{
+						continue;
+					}
+					drawnMountains_.push_back(mountain);
+				}
+				occludedMountains_ = visibleMountains_.size() - drawnMountains_.size();
+			}, { frustumQuery, occluderRaster });
+	}
+
 	void HelloModel::SetViewMatrix(seconds dt)
 	{
 		view_ = camera_->GetViewMatrix();
@@ -122,60 +227,91 @@ namespace gl {
 			100.f);
 	}
 
-	void HelloModel::SetUniformMatrix() const
+	void HelloModel::SetUniformMatrix(const FramePacket& packet) const
 	{
 		normalMapShader_->Use();
-		normalMapShader_->SetMat4("view", view_);
-		normalMapShader_->SetMat4("projection", projection_);
-		normalMapShader_->SetVec3("camera_position", camera_->position);
-		normalMapShader_->SetVec3("viewPos", camera_->position);
+		normalMapShader_->SetMat4("view", packet.view);
+		normalMapShader_->SetMat4("projection", packet.projection);
+		normalMapShader_->SetVec3("camera_position", packet.cameraPosition);
+		normalMapShader_->SetVec3("viewPos", packet.cameraPosition);
 		normalMapShader_->SetVec3("lightPos",  -0.2f, -1.0f, -0.3f);
 	}
 
 	void HelloModel::Update(seconds dt)
+	{
+		packet_.Clear();
+		Simulate(dt, packet_);
+		Render(packet_);
+	}
+
+	void HelloModel::Simulate(seconds dt, FramePacket& packet)
 	{
 		delta_time_ = dt.count();
-		framebuffer_->Bind();
 
-		float speed = 1.0f;
-		camera_->position += glm::normalize(-camera_->front) * delta_time_ * speed;
+		if (IsFixedTimestep())
+		{
+			camera_->position = glm::mix(
+				previousCameraPosition_,
+				currentCameraPosition_,
+				GetInterpolationAlpha());
+		}
+		else
+		{
+			camera_->position += glm::normalize(-camera_->front) * delta_time_ * cameraSpeed_;
+			previousCameraPosition_ = camera_->position;
+			currentCameraPosition_ = camera_->position;
+		}
 		SetViewMatrix(dt);
 		SetProjectionMatrix();
-		SetUniformMatrix();
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		transforms_.Update();
 
-		model_obj_->SetModelMatrix(glm::vec3(0, 90, 0));
-		model_obj_->Update(*normalMapShader_);
+		// Only the mountains whose box touches the frustum and that the
+		// simplified mountains do not occlude are drawn.
+		viewProjection_ = projection_ * view_;
+		frameGraph_.Run(*GetJobSystem());
 
-		model_obj_->SetModelMatrix(glm::vec3(80, 90, 0));
-		model_obj_->Update(*normalMapShader_);
-
-		model_obj_->SetModelMatrix(glm::vec3(40, 90, 0));
-		model_obj_->Update(*normalMapShader_);
-
-		model_obj_->SetModelMatrix(glm::vec3(10, 90, 80));
-		model_obj_->Update(*normalMapShader_);
-
-		model_obj_->SetModelMatrix(glm::vec3(80, 90, 80));
-		model_obj_->Update(*normalMapShader_);
-
-		model_obj_->SetModelMatrix(glm::vec3(-80, 90, 0));
-		model_obj_->Update(*normalMapShader_);
+		packet.view = view_;
+		packet.projection = projection_;
+		packet.cameraPosition = camera_->position;
+		for (const auto mountain : drawnMountains_)
+		{
+			DrawItem draw;
+			draw.model = transforms_.GetWorld(mountainNodes_[mountain]);
+			draw.normal = transforms_.GetNormalMatrix(mountainNodes_[mountain]);
+			packet.draws.push_back(draw);
+		}
+	}
 
-		model_obj_->SetModelMatrix(glm::vec3(-10, 90, -80));
-		model_obj_->Update(*normalMapShader_);
+	void HelloModel::FixedUpdate(seconds step)
+	{
+		previousCameraPosition_ = currentCameraPosition_;
+		currentCameraPosition_ += glm::normalize(-camera_->front) * step.count() * cameraSpeed_;
+	}
 
-		model_obj_->SetModelMatrix(glm::vec3(-80, 90, -80));
-		model_obj_->Update(*normalMapShader_);
+	void HelloModel::Render(const FramePacket& packet)
+	{
+		framebuffer_->Bind();
+		SetUniformMatrix(packet);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Every draw is a mountain.
+		{
+			GPR5300_PROFILE_GPU_ZONE("Mountains");
+			for (const auto& draw : packet.draws)
+			{
+				model_obj_->SetModelMatrix(draw.model, draw.normal);
+				model_obj_->Update(*normalMapShader_);
+			}
+		}
 
 		// Skybox
+		GPR5300_PROFILE_GPU_ZONE("Skybox and post");
 		glDepthFunc(GL_LEQUAL);
 		cubemaps_->Bind();
 		skyboxShader_->Use();
 		skyboxShader_->SetInt("skybox", 0);
-		skyboxShader_->SetMat4("projection", glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.f));
-		glm::mat4 view = glm::mat4(glm::mat3(camera_->GetViewMatrix()));
+		skyboxShader_->SetMat4("projection", packet.projection);
+		glm::mat4 view = glm::mat4(glm::mat3(packet.view));
 		skyboxShader_->SetMat4("view", view);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 
@@ -187,11 +323,21 @@ namespace gl {
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, framebuffer_->GetColorBuffer());
 		framebuffer_->Draw();
-		
 	}
 
 	void HelloModel::Destroy()
 	{
+		// While the context is current: the GL objects go with them.
+		normalMapShader_.reset();
+		dirLightShader_.reset();
+		occlusionCuller_.reset();
+		cubemaps_.reset();
+		skyboxShader_.reset();
+		framebufferShader_.reset();
+		framebuffer_.reset();
+		model_obj_ = nullptr;
+		level_.Clear();
+		shaders_.reset();
 	}
 
 	void HelloModel::OnEvent(SDL_Event& event)
@@ -200,6 +346,37 @@ namespace gl {
 
 	void HelloModel::DrawImGui()
 	{
+		ImGui::Begin("Scene");
+		ImGui::Checkbox("Occlusion culling", &occlusionEnabled_);
+		ImGui::Text(
+			"Mountains drawn: %zu / %zu",
+			drawnMountains_.size(),
+			mountainNodes_.size());
+		ImGui::Text("Occluded: %zu", occludedMountains_);
+		if (occlusionEnabled_)
+		{
+			ImGui::Text(
+				"Occluder raster: %.3f ms (%zu triangles)",
+				occlusionCuller_->GetRasterMilliseconds(),
+				occlusionCuller_->GetRasterizedTriangleCount());
+		}
+		const auto& loadTimes = level_.GetLoadTimes();
+		ImGui::Text(
+			"Level load: %.2f ms (cook %.2f, map %.2f, entities %.2f, models %.2f)",
+			loadTimes.totalMilliseconds,
+			loadTimes.cookMilliseconds,
+			loadTimes.mapMilliseconds,
+			loadTimes.entityMilliseconds,
+			loadTimes.assetMilliseconds);
+		ImGui::Text("Frame graph: %.3f ms", frameGraph_.GetMilliseconds());
+		for (std::size_t task = 0; task < frameGraph_.GetTaskCount(); ++task)
+		{
+			ImGui::Text(
+				"  %s: %.3f ms",
+				frameGraph_.GetTaskName(task).c_str(),
+				frameGraph_.GetTaskMilliseconds(task));
+		}
+		ImGui::End();
 	}
 
 } // End namespace gl.
@@ -207,7 +384,7 @@ namespace gl {
 int main(int argc, char** argv)
 {
 	gl::HelloModel program;
-	gl::Engine engine(program);
+	gl::Engine engine(program, argc, argv);
 	engine.Run();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "aabb.h"
+
+#include <cmath>
+
+namespace gl {
+
+	Aabb Aabb::Transform(const glm::mat4& model) const
+	{
+		const glm::vec3 center = GetCenter();
+		const glm::vec3 extents = GetExtents();
+		const glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+		glm::vec3 worldExtents(0.0f);
+		for (int row = 0; row < 3; ++row)
+		{
+			worldExtents[row] =
+				std::abs(model[0][row]) * extents.x +
+				std::abs(model[1][row]) * extents.y +
+				std::abs(model[2][row]) * extents.z;
+		}
+		return { worldCenter - worldExtents, worldCenter + worldExtents };
+	}
+
+} // End namespace gl.
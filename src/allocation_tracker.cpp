@@ -0,0 +1,273 @@
+#include "allocation_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace gl {
+
+	namespace {
+
+		std::atomic<bool> frameOpen{ false };
+		std::atomic<std::size_t> frameCount{ 0 };
+		std::atomic<std::size_t> frameBytes{ 0 };
+		thread_local int ignoreDepth = 0;
+
+		// Main thread.
+		std::size_t lastFrameCount = 0;
+		std::size_t lastFrameBytes = 0;
+		std::uint64_t framesWithAllocations = 0;
+		bool report = false;
+
+#if defined(GPR5300_ALLOCATION_TRACKING)
+		void Count(std::size_t size)
+		{
+			if (!frameOpen.load(std::memory_order_relaxed) || ignoreDepth > 0) return;
+			frameCount.fetch_add(1, std::memory_order_relaxed);
+			frameBytes.fetch_add(size, std::memory_order_relaxed);
+			AllocationTracker::OnFrameAllocation(size);
+		}
+
+		void* RawAllocate(std::size_t size, std::size_t alignment)
+		{
+			if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			{
+				return std::malloc(size);
+			}
+#if defined(_WIN32)
+			return _aligned_malloc(size, alignment);
+#else
+			void* pointer = nullptr;
+			return posix_memalign(&pointer, alignment, size) == 0 ? pointer : nullptr;
+#endif
+		}
+
+		void RawFree(void* pointer, std::size_t alignment)
+		{
+#if defined(_WIN32)
+			if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			{
+				_aligned_free(pointer);
+				return;
+			}
+#endif
+			std::free(pointer);
+		}
+
+		// What the standard asks of operator new: retry through the new
+		// handler, nullptr once there is none.
+		void* Allocate(std::size_t size, std::size_t alignment)
+		{
+			Count(size);
+			if (size == 0) size = 1;
+			while (true)
+			{
+				void* pointer = RawAllocate(size, alignment);
+				if (pointer != nullptr) return pointer;
+				const std::new_handler handler = std::get_new_handler();
+				if (handler == nullptr) return nullptr;
+				handler();
+			}
+		}
+
+		void* AllocateOrThrow(std::size_t size, std::size_t alignment)
+		{
+			void* pointer = Allocate(size, alignment);
+			if (pointer == nullptr) throw std::bad_alloc();
+			return pointer;
+		}
+
+		void* AllocateNoThrow(std::size_t size, std::size_t alignment) noexcept
+		{
+			try
+			{
+				return Allocate(size, alignment);
+			}
+			catch (...)
+			{
+				return nullptr;
+			}
+		}
+#endif
+
+	} // namespace
+
+	void AllocationTracker::BeginFrame()
+	{
+		frameCount.store(0, std::memory_order_relaxed);
+		frameBytes.store(0, std::memory_order_relaxed);
+		frameOpen.store(true, std::memory_order_relaxed);
+	}
+
+	void AllocationTracker::EndFrame()
+	{
+		frameOpen.store(false, std::memory_order_relaxed);
+		lastFrameCount = frameCount.load(std::memory_order_relaxed);
+		lastFrameBytes = frameBytes.load(std::memory_order_relaxed);
+		if (lastFrameCount == 0) return;
+		++framesWithAllocations;
+		if (report)
+		{
+			std::cerr << "[Error] " << lastFrameCount << " heap allocations ("
+				<< lastFrameBytes << " bytes) during the frame\n";
+		}
+	}
+
+	std::size_t AllocationTracker::GetLastFrameCount()
+	{
+		return lastFrameCount;
+	}
+
+	std::size_t AllocationTracker::GetLastFrameBytes()
+	{
+		return lastFrameBytes;
+	}
+
+	std::uint64_t AllocationTracker::GetFramesWithAllocations()
+	{
+		return framesWithAllocations;
+	}
+
+	void AllocationTracker::SetReport(bool enabled)
+	{
+		report = enabled;
+	}
+
+	bool AllocationTracker::GetReport()
+	{
+		return report;
+	}
+
+#if defined(_MSC_VER)
+	__declspec(noinline)
+#else
+	__attribute__((noinline))
+#endif
+	void AllocationTracker::OnFrameAllocation(std::size_t size)
+	{
+		// Out of line so a breakpoint here stops on every allocation.
+		static_cast<void>(size);
+	}
+
+	AllocationTracker::IgnoreScope::IgnoreScope()
+	{
+		++ignoreDepth;
+	}
+
+	AllocationTracker::IgnoreScope::~IgnoreScope()
+	{
+		--ignoreDepth;
+	}
+
+} // End namespace gl.
+
+#if defined(GPR5300_ALLOCATION_TRACKING)
+
+// Every replaceable form, so no allocation goes around the count. The
+// aligned forms must free with the matching function on Windows.
+
+void* operator new(std::size_t size)
+{
+	return gl::AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size)
+{
+	return gl::AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return gl::AllocateNoThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return gl::AllocateNoThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return gl::AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return gl::AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return gl::AllocateNoThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return gl::AllocateNoThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	gl::RawFree(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	gl::RawFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+#endif
@@ -0,0 +1,296 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string_view>
+
+#include "frame_pacing.h"
+
+namespace gl {
+
+	namespace {
+
+		bool ParseNumber(const char* text, double& value)
+		{
+			char* end = nullptr;
+			value = std::strtod(text, &end);
+			return end != text && *end == '\0' && value >= 0.0;
+		}
+
+		void WriteDistribution(std::ostream& out, const BenchmarkDistribution& d)
+		{
+			out << "{\"min\": " << d.min
+				<< ", \"mean\": " << d.mean
+				<< ", \"p50\": " << d.p50
+				<< ", \"p90\": " << d.p90
+				<< ", \"p95\": " << d.p95
+				<< ", \"p99\": " << d.p99
+				<< ", \"max\": " << d.max << "}";
+		}
+
+		std::string Escape(std::string_view text)
+		{
+			std::string escaped;
+			for (const char c : text)
+			{
+				if (c == '"' || c == '\\') escaped += '\\';
+				if (static_cast<unsigned char>(c) < 0x20) continue;
+				escaped += c;
+			}
+			return escaped;
+		}
+
+	} // namespace
+
+	BenchmarkOptions ParseBenchmarkOptions(int argc, char** argv)
+	{
+		BenchmarkOptions options;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			double value = 0.0;
+			if (arg == "--benchmark")
+			{
+				options.enabled = true;
+			}
+			else if (arg == "--frames" && hasValue && ParseNumber(argv[i + 1], value))
+			{
+				options.frames = std::max<std::size_t>(static_cast<std::size_t>(value), 1);
+				++i;
+			}
+			else if (arg == "--warmup" && hasValue && ParseNumber(argv[i + 1], value))
+			{
+				options.warmupFrames = static_cast<std::size_t>(value);
+				++i;
+			}
+			else if (arg == "--dt" && hasValue && ParseNumber(argv[i + 1], value) && value > 0.0)
+			{
+				options.dt = static_cast<float>(value);
+				++i;
+			}
+			else if (arg == "--output" && hasValue)
+			{
+				options.output = argv[++i];
+			}
+			else if (arg == "--capture" && hasValue)
+			{
+				options.captureDirectory = argv[++i];
+			}
+			else if (arg == "--raw")
+			{
+				options.captureRaw = true;
+			}
+			else
+			{
+				std::cerr << "[Error] Unknown or incomplete argument: " << arg << "\n";
+			}
+		}
+		options.name = argc > 0 ?
+			std::filesystem::path(argv[0]).stem().string() :
+			std::string("benchmark");
+		if (options.enabled && options.output.empty())
+		{
+			options.output = options.name + "_benchmark.json";
+		}
+		return options;
+	}
+
+	void CameraPath::AddKeyframe(float t, const Pose& pose)
+	{
+		const auto it = std::upper_bound(
+			keyframes_.begin(),
+			keyframes_.end(),
+			t,
+			[](float value, const Keyframe& keyframe) { return value < keyframe.t; });
+		keyframes_.insert(it, { t, pose });
+	}
+
+	CameraPath::Pose CameraPath::Evaluate(float t) const
+	{
+		if (keyframes_.empty()) return { glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+		if (t <= keyframes_.front().t) return keyframes_.front().pose;
+		if (t >= keyframes_.back().t) return keyframes_.back().pose;
+		const auto next = std::upper_bound(
+			keyframes_.begin(),
+			keyframes_.end(),
+			t,
+			[](float value, const Keyframe& keyframe) { return value < keyframe.t; });
+		const auto previous = next - 1;
+		const float span = next->t - previous->t;
+		const float alpha = span > 0.0f ? (t - previous->t) / span : 0.0f;
+		return {
+			glm::mix(previous->pose.position, next->pose.position, alpha),
+			glm::mix(previous->pose.target, next->pose.target, alpha) };
+	}
+
+	CameraPath CameraPath::Orbit(
+		const glm::vec3& center,
+		float radius,
+		float height,
+		std::size_t keyframeCount)
+	{
+		CameraPath path;
+		keyframeCount = std::max<std::size_t>(keyframeCount, 2);
+		for (std::size_t i = 0; i <= keyframeCount; ++i)
+		{
+			const float t = static_cast<float>(i) / static_cast<float>(keyframeCount);
+			const float angle = t * 2.0f * 3.14159265f;
+			path.AddKeyframe(t, {
+				center + glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius),
+				center });
+		}
+		return path;
+	}
+
+	BenchmarkDistribution BenchmarkDistribution::FromSamples(std::vector<float> samples)
+	{
+		BenchmarkDistribution distribution;
+		if (samples.empty()) return distribution;
+		FrameTimeHistory history(samples.size());
+		for (const float sample : samples)
+		{
+			history.Add(sample);
+		}
+		distribution.min = *std::min_element(samples.begin(), samples.end());
+		distribution.mean = std::accumulate(samples.begin(), samples.end(), 0.0f) /
+			static_cast<float>(samples.size());
+		distribution.p50 = history.GetPercentile(0.5f);
+		distribution.p90 = history.GetPercentile(0.9f);
+		distribution.p95 = history.GetPercentile(0.95f);
+		distribution.p99 = history.GetPercentile(0.99f);
+		distribution.max = history.GetMaximum();
+		return distribution;
+	}
+
+	void BenchmarkRecorder::AddFrame(
+		float cpuMilliseconds,
+		float gpuMilliseconds,
+		float frameMilliseconds,
+		float captureMilliseconds,
+		const GlCallCounts& calls)
+	{
+		cpuMilliseconds_.push_back(cpuMilliseconds);
+		gpuMilliseconds_.push_back(gpuMilliseconds);
+		frameMilliseconds_.push_back(frameMilliseconds);
+		if (captureMilliseconds >= 0.0f) captureMilliseconds_.push_back(captureMilliseconds);
+		calls_.push_back(calls);
+	}
+
+	std::string BenchmarkRecorder::ToJson(const BenchmarkOptions& options) const
+	{
+		std::vector<float> gpu;
+		for (const float sample : gpuMilliseconds_)
+		{
+			if (sample >= 0.0f) gpu.push_back(sample);
+		}
+		// Per frame samples and totals of every counter.
+		std::array<std::vector<float>, kGlStatCount> samples;
+		std::array<std::uint64_t, kGlStatCount> totals{};
+		for (const auto& calls : calls_)
+		{
+			for (std::size_t i = 0; i < kGlStatCount; ++i)
+			{
+				samples[i].push_back(static_cast<float>(calls.values[i]));
+				totals[i] += calls.values[i];
+			}
+		}
+		const auto total = [&totals](GlStat stat) { return totals[static_cast<std::size_t>(stat)]; };
+		const auto perFrame = [&samples](GlStat stat)
+			{
+				return BenchmarkDistribution::FromSamples(std::move(samples[static_cast<std::size_t>(stat)]));
+			};
+
+		std::ostringstream out;
+		out << "{\n";
+		out << "  \"program\": \"" << Escape(name_) << "\",\n";
+		out << "  \"renderer\": \"" << Escape(renderer_) << "\",\n";
+		out << "  \"frames\": " << cpuMilliseconds_.size() << ",\n";
+		out << "  \"warmup_frames\": " << options.warmupFrames << ",\n";
+		out << "  \"dt\": " << options.dt << ",\n";
+		out << "  \"load_ms\": {\"context\": " << contextMilliseconds_
+			<< ", \"program\": " << programMilliseconds_ << "},\n";
+		out << "  \"cpu_ms\": ";
+		WriteDistribution(out, BenchmarkDistribution::FromSamples(cpuMilliseconds_));
+		out << ",\n";
+		out << "  \"gpu_source\": \"" << gpuSource_ << "\",\n";
+		out << "  \"gpu_ms\": ";
+		if (gpu.empty())
+		{
+			out << "null";
+		}
+		else
+		{
+			WriteDistribution(out, BenchmarkDistribution::FromSamples(std::move(gpu)));
+		}
+		out << ",\n";
+		const auto frame = BenchmarkDistribution::FromSamples(frameMilliseconds_);
+		out << "  \"frame_ms\": ";
+		WriteDistribution(out, frame);
+		out << ",\n";
+		// GL thread cost of the capture, against the whole frame.
+		out << "  \"capture\": ";
+		if (captureMilliseconds_.empty())
+		{
+			out << "null";
+		}
+		else
+		{
+			const auto capture = BenchmarkDistribution::FromSamples(captureMilliseconds_);
+			out << "{\"ms\": ";
+			WriteDistribution(out, capture);
+			out << ", \"frame_share\": " << (frame.mean > 0.0f ? capture.mean / frame.mean : 0.0f)
+				<< ", \"stalls\": " << captureStalls_
+				<< ", \"dropped\": " << captureDropped_ << "}";
+		}
+		out << ",\n";
+		out << "  \"draw_calls\": {\"total\": " << total(GlStat::Draws)
+			<< ", \"instanced\": " << total(GlStat::InstancedDraws)
+			<< ", \"per_frame\": ";
+		WriteDistribution(out, perFrame(GlStat::Draws));
+		out << "},\n";
+		out << "  \"dispatches\": {\"total\": " << total(GlStat::Dispatches) << ", \"per_frame\": ";
+		WriteDistribution(out, perFrame(GlStat::Dispatches));
+		out << "},\n";
+		// State changes, uniforms and uploaded bytes, see GlStat.
+		out << "  \"gl_calls\": {";
+		for (std::size_t i = static_cast<std::size_t>(GlStat::ProgramBinds); i < kGlStatCount; ++i)
+		{
+			const auto stat = static_cast<GlStat>(i);
+			out << (stat == GlStat::ProgramBinds ? "\n" : ",\n")
+				<< "    \"" << GlCallCounter::GetName(stat) << "\": {\"total\": " << total(stat)
+				<< ", \"per_frame\": ";
+			WriteDistribution(out, perFrame(stat));
+			out << "}";
+		}
+		out << "\n  },\n";
+		out << "  \"cpu_frame_ms\": [";
+		for (std::size_t i = 0; i < cpuMilliseconds_.size(); ++i)
+		{
+			out << (i == 0 ? "" : ", ") << cpuMilliseconds_[i];
+		}
+		out << "]\n";
+		out << "}\n";
+		return out.str();
+	}
+
+	bool BenchmarkRecorder::Write(const BenchmarkOptions& options) const
+	{
+		std::ofstream file(options.output);
+		if (!file)
+		{
+			std::cerr << "[Error] Could not write the benchmark to " << options.output << "\n";
+			return false;
+		}
+		file << ToJson(options);
+		return static_cast<bool>(file);
+	}
+
+} // End namespace gl.
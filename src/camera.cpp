@@ -95,6 +95,19 @@ namespace gl
 			Zoom = 45.0f;
 	}
 
+	// turns the camera towards target, keeping pitch within the same
+	// bounds as the mouse
+
+	void Camera::LookAt(const glm::vec3& target)
+	{
+		const glm::vec3 direction = target - position;
+		if (glm::length(direction) <= 0.0f) return;
+		const glm::vec3 unit = glm::normalize(direction);
+		yaw = glm::degrees(atan2(unit.z, unit.x));
+		pitch = glm::clamp(glm::degrees(asin(unit.y)), -89.0f, 89.0f);
+		updateCameraVectors();
+	}
+
 	// calculates the front vector from the Camera's (updated) Euler Angles
 
 	void Camera::updateCameraVectors()
@@ -0,0 +1,33 @@
+#include "components.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "scene.h"
+
+namespace gl {
+
+	glm::mat4 Transform::ToMatrix() const
+	{
+		glm::mat4 matrix = glm::mat4_cast(rotation);
+		matrix[0] *= scale.x;
+		matrix[1] *= scale.y;
+		matrix[2] *= scale.z;
+		matrix[3] = glm::vec4(position, 1.0f);
+		return matrix;
+	}
+
+	void IntegrateVelocities(Scene& scene, float dt, JobSystem* jobSystem)
+	{
+		scene.ParallelForEach<Transform, const Velocity>(
+			jobSystem,
+			[dt](Transform& transform, const Velocity& velocity)
+			{
+				transform.position += velocity.linear * dt;
+				// First order: q' = q + dt / 2 * (0, w) * q, renormalized.
+				// Exact enough for a frame's worth of rotation.
+				const glm::quat spin(0.0f, velocity.angular * (0.5f * dt));
+				transform.rotation = glm::normalize(transform.rotation + spin * transform.rotation);
+			});
+	}
+
+} // End namespace gl.
@@ -0,0 +1,23 @@
+#include "compute_shader.h"
+
+namespace gl
+{
+	ComputeShader::ComputeShader(const std::string& computePath)
+	{
+		unsigned int compute = CompileStage(GL_COMPUTE_SHADER, computePath, "COMPUTE");
+		id = GlProgram(glCreateProgram(), "Compute shader");
+		glAttachShader(id, compute);
+		glLinkProgram(id);
+		CheckCompileErrors(id, "PROGRAM");
+		glDeleteShader(compute);
+	}
+
+	void ComputeShader::Dispatch(
+		unsigned int groupsX,
+		unsigned int groupsY,
+		unsigned int groupsZ) const
+	{
+		Use();
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+	}
+}
@@ -1,5 +1,7 @@
 #include "cubemaps.h"
 
+#include "vfs.h"
+
 namespace gl {
 	Cubemaps::Cubemaps() {
 		// Skybox
@@ -50,15 +52,16 @@ namespace gl {
 		};
 
 		// Generate vao skybox
-		glGenVertexArrays(1, &vao);
+		vao = GlVertexArray::Create("Skybox cube");
 		glBindVertexArray(vao);
 
 		// Generate vbo skybox
-		glGenBuffers(1, &vbo);
+		vbo = GlBuffer::Create("Skybox cube");
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
 		// Transfer data into gpu
 		glBufferData(GL_ARRAY_BUFFER, sizeof(skybox_vertices), &skybox_vertices, GL_STATIC_DRAW);
+		vbo.SetBytes(sizeof(skybox_vertices));
 
 		// Location in skybox.vert
 		glEnableVertexAttribArray(0);
@@ -69,23 +72,32 @@ namespace gl {
 		// Saying we're not using vao anymore
 		glBindVertexArray(0);
 
-		std::string path = "../";
 		std::vector<std::string> faces{
-			path + "data/textures/Skybox/right.jpg",
-			path + "data/textures/Skybox/left.jpg",
-			path + "data/textures/Skybox/top.jpg",
-			path + "data/textures/Skybox/bottom.jpg",
-			path + "data/textures/Skybox/front.jpg",
-			path + "data/textures/Skybox/back.jpg"
+			"textures/Skybox/right.jpg",
+			"textures/Skybox/left.jpg",
+			"textures/Skybox/top.jpg",
+			"textures/Skybox/bottom.jpg",
+			"textures/Skybox/front.jpg",
+			"textures/Skybox/back.jpg"
 		};
 
 		//Texture skybox
-		glGenTextures(1, &textureID);
+		textureID = GlTexture::Create("Skybox");
 		glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
+		std::size_t bytes = 0;
 		for (unsigned int i = 0; i < faces.size(); i++)
 		{
-			unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+			const VfsFile file = Vfs::Read(faces[i]);
+			unsigned char* data = file.IsValid() ?
+				stbi_load_from_memory(
+					reinterpret_cast<const stbi_uc*>(file.GetBytes().data()),
+					static_cast<int>(file.GetBytes().size()),
+					&width,
+					&height,
+					&nrChannels,
+					0) :
+				nullptr;
 			if (data)
 			{
 				glTexImage2D(
@@ -98,6 +110,7 @@ namespace gl {
 					GL_RGB,
 					GL_UNSIGNED_BYTE,
 					data);
+				bytes += TextureBytes(width, height, 3);
 				stbi_image_free(data);
 			}
 			else
@@ -111,6 +124,7 @@ namespace gl {
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		textureID.SetBytes(bytes);
 	}
 
 	void Cubemaps::Bind(unsigned int i) const
@@ -0,0 +1,457 @@
+#include "dynamic_aabb_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace gl {
+
+	namespace {
+
+		// The new fat box is stretched by this many displacements.
+		constexpr float kDisplacementMultiplier = 2.0f;
+		// A fat box this many margins larger than needed is refitted too, so
+		// a proxy that stopped moving gets a tight box back.
+		constexpr float kOversizeMargins = 4.0f;
+		// Traversal stacks, one per thread and kept from one query to the
+		// next: queries run every frame and must not allocate. No query
+		// calls out while traversing, so they never nest.
+		thread_local std::vector<int> traversalStack;
+		thread_local std::vector<std::pair<int, unsigned int>> frustumStack;
+
+		float SquaredDistance(const Aabb& box, const glm::vec3& point)
+		{
+			const glm::vec3 closest = glm::clamp(point, box.min, box.max);
+			const glm::vec3 delta = closest - point;
+			return glm::dot(delta, delta);
+		}
+
+		// Slab test of the segment against the box.
+		bool IntersectsSegment(
+			const Aabb& box,
+			const glm::vec3& origin,
+			const glm::vec3& inverseDirection,
+			float maxDistance)
+		{
+			float tMin = 0.0f;
+			float tMax = maxDistance;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+				float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+				// 0 * inf gives NaN when the origin lies on a slab of a ray
+				// parallel to it; treat it as inside that slab.
+				if (std::isnan(t1)) t1 = -std::numeric_limits<float>::infinity();
+				if (std::isnan(t2)) t2 = std::numeric_limits<float>::infinity();
+				tMin = std::max(tMin, std::min(t1, t2));
+				tMax = std::min(tMax, std::max(t1, t2));
+				if (tMin > tMax) return false;
+			}
+			return true;
+		}
+
+	} // namespace
+
+	DynamicAabbTree::DynamicAabbTree(float margin) :
+		margin_(margin)
+	{
+	}
+
+	int DynamicAabbTree::AllocateNode()
+	{
+		if (freeList_ == kNullNode)
+		{
+			nodes_.emplace_back();
+			freeList_ = static_cast<int>(nodes_.size()) - 1;
+			nodes_[freeList_].parent = kNullNode;
+		}
+		const int node = freeList_;
+		freeList_ = nodes_[node].parent;
+		nodes_[node] = Node{};
+		nodes_[node].height = 0;
+		return node;
+	}
+
+	void DynamicAabbTree::FreeNode(int node)
+	{
+		nodes_[node].parent = freeList_;
+		nodes_[node].height = -1;
+		freeList_ = node;
+	}
+
+	int DynamicAabbTree::CreateProxy(const Aabb& box, std::uint32_t userData)
+	{
+		const int proxy = AllocateNode();
+		nodes_[proxy].box = { box.min - glm::vec3(margin_), box.max + glm::vec3(margin_) };
+		nodes_[proxy].userData = userData;
+		InsertLeaf(proxy);
+		++proxyCount_;
+		return proxy;
+	}
+
+	void DynamicAabbTree::DestroyProxy(int proxy)
+	{
+		assert(nodes_[proxy].IsLeaf());
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		--proxyCount_;
+	}
+
+	bool DynamicAabbTree::MoveProxy(
+		int proxy,
+		const Aabb& box,
+		const glm::vec3& displacement)
+	{
+		assert(nodes_[proxy].IsLeaf());
+		const glm::vec3 stretch = displacement * kDisplacementMultiplier;
+		const glm::vec3 stretchMin = glm::min(stretch, glm::vec3(0.0f));
+		const glm::vec3 stretchMax = glm::max(stretch, glm::vec3(0.0f));
+		const Aabb& fat = nodes_[proxy].box;
+		if (fat.Contains(box))
+		{
+			const Aabb oversize = {
+				box.min - glm::vec3(kOversizeMargins * margin_) + stretchMin,
+				box.max + glm::vec3(kOversizeMargins * margin_) + stretchMax };
+			if (oversize.Contains(fat)) return false;
+		}
+
+		RemoveLeaf(proxy);
+		nodes_[proxy].box = {
+			box.min - glm::vec3(margin_) + stretchMin,
+			box.max + glm::vec3(margin_) + stretchMax };
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	std::uint32_t DynamicAabbTree::GetUserData(int proxy) const
+	{
+		return nodes_[proxy].userData;
+	}
+
+	const Aabb& DynamicAabbTree::GetFatAabb(int proxy) const
+	{
+		return nodes_[proxy].box;
+	}
+
+	std::size_t DynamicAabbTree::GetProxyCount() const
+	{
+		return proxyCount_;
+	}
+
+	int DynamicAabbTree::GetHeight() const
+	{
+		return root_ == kNullNode ? -1 : nodes_[root_].height;
+	}
+
+	void DynamicAabbTree::Clear()
+	{
+		nodes_.clear();
+		root_ = kNullNode;
+		freeList_ = kNullNode;
+		proxyCount_ = 0;
+	}
+
+	void DynamicAabbTree::InsertLeaf(int leaf)
+	{
+		if (root_ == kNullNode)
+		{
+			root_ = leaf;
+			nodes_[leaf].parent = kNullNode;
+			return;
+		}
+
+		// Walk down to the sibling with the lowest cost: the area of the new
+		// parent plus the area growth pushed onto the ancestors.
+		const Aabb leafBox = nodes_[leaf].box;
+		int index = root_;
+		while (!nodes_[index].IsLeaf())
+		{
+			const Node& node = nodes_[index];
+			const float area = node.box.GetPerimeter();
+			const float combinedArea = Aabb::Union(node.box, leafBox).GetPerimeter();
+			const float cost = 2.0f * combinedArea;
+			const float inheritanceCost = 2.0f * (combinedArea - area);
+
+			const auto descendCost = [&](int child)
+			{
+				const Node& childNode = nodes_[child];
+				const float unionArea = Aabb::Union(leafBox, childNode.box).GetPerimeter();
+				if (childNode.IsLeaf())
+				{
+					return unionArea + inheritanceCost;
+				}
+				return unionArea - childNode.box.GetPerimeter() + inheritanceCost;
+			};
+			const float cost1 = descendCost(node.child1);
+			const float cost2 = descendCost(node.child2);
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+		const int sibling = index;
+
+		const int oldParent = nodes_[sibling].parent;
+		const int newParent = AllocateNode();
+		nodes_[newParent].parent = oldParent;
+		nodes_[newParent].box = Aabb::Union(leafBox, nodes_[sibling].box);
+		nodes_[newParent].height = nodes_[sibling].height + 1;
+		nodes_[newParent].child1 = sibling;
+		nodes_[newParent].child2 = leaf;
+		nodes_[sibling].parent = newParent;
+		nodes_[leaf].parent = newParent;
+		if (oldParent == kNullNode)
+		{
+			root_ = newParent;
+		}
+		else if (nodes_[oldParent].child1 == sibling)
+		{
+			nodes_[oldParent].child1 = newParent;
+		}
+		else
+		{
+			nodes_[oldParent].child2 = newParent;
+		}
+
+		for (index = nodes_[leaf].parent; index != kNullNode; index = nodes_[index].parent)
+		{
+			index = Balance(index);
+			UpdateNode(index);
+		}
+	}
+
+	void DynamicAabbTree::RemoveLeaf(int leaf)
+	{
+		if (leaf == root_)
+		{
+			root_ = kNullNode;
+			return;
+		}
+
+		const int parent = nodes_[leaf].parent;
+		const int grandParent = nodes_[parent].parent;
+		const int sibling = nodes_[parent].child1 == leaf ?
+			nodes_[parent].child2 :
+			nodes_[parent].child1;
+		FreeNode(parent);
+		nodes_[sibling].parent = grandParent;
+		if (grandParent == kNullNode)
+		{
+			root_ = sibling;
+			return;
+		}
+		if (nodes_[grandParent].child1 == parent)
+		{
+			nodes_[grandParent].child1 = sibling;
+		}
+		else
+		{
+			nodes_[grandParent].child2 = sibling;
+		}
+		for (int index = grandParent; index != kNullNode; index = nodes_[index].parent)
+		{
+			index = Balance(index);
+			UpdateNode(index);
+		}
+	}
+
+	void DynamicAabbTree::UpdateNode(int node)
+	{
+		Node& n = nodes_[node];
+		const Node& child1 = nodes_[n.child1];
+		const Node& child2 = nodes_[n.child2];
+		n.box = Aabb::Union(child1.box, child2.box);
+		n.height = 1 + std::max(child1.height, child2.height);
+	}
+
+	int DynamicAabbTree::Balance(int iA)
+	{
+		Node& a = nodes_[iA];
+		if (a.IsLeaf() || a.height < 2) return iA;
+
+		const int iB = a.child1;
+		const int iC = a.child2;
+		Node& b = nodes_[iB];
+		Node& c = nodes_[iC];
+		const int balance = c.height - b.height;
+
+		// Rotate the heavier child up, a takes its lighter grandchild.
+		const auto rotate = [&](int iUp, Node& up, int iOther, bool upWasChild2)
+		{
+			const int iF = up.child1;
+			const int iG = up.child2;
+			Node& f = nodes_[iF];
+			Node& g = nodes_[iG];
+
+			up.child1 = iA;
+			up.parent = a.parent;
+			a.parent = iUp;
+			if (up.parent == kNullNode)
+			{
+				root_ = iUp;
+			}
+			else if (nodes_[up.parent].child1 == iA)
+			{
+				nodes_[up.parent].child1 = iUp;
+			}
+			else
+			{
+				nodes_[up.parent].child2 = iUp;
+			}
+
+			// Keep the taller grandchild under up, give the other one to a.
+			const int iKeep = f.height > g.height ? iF : iG;
+			const int iGive = f.height > g.height ? iG : iF;
+			up.child2 = iKeep;
+			if (upWasChild2)
+			{
+				a.child2 = iGive;
+			}
+			else
+			{
+				a.child1 = iGive;
+			}
+			nodes_[iGive].parent = iA;
+			const Node& other = nodes_[iOther];
+			a.box = Aabb::Union(other.box, nodes_[iGive].box);
+			a.height = 1 + std::max(other.height, nodes_[iGive].height);
+			up.box = Aabb::Union(a.box, nodes_[iKeep].box);
+			up.height = 1 + std::max(a.height, nodes_[iKeep].height);
+			return iUp;
+		};
+
+		if (balance > 1) return rotate(iC, c, iB, true);
+		if (balance < -1) return rotate(iB, b, iC, false);
+		return iA;
+	}
+
+	void DynamicAabbTree::QueryAabb(const Aabb& box, std::vector<std::uint32_t>& out) const
+	{
+		if (root_ == kNullNode) return;
+		auto& stack = traversalStack;
+		stack.clear();
+		stack.push_back(root_);
+		while (!stack.empty())
+		{
+			const Node& node = nodes_[stack.back()];
+			stack.pop_back();
+			if (!node.box.Overlaps(box)) continue;
+			if (node.IsLeaf())
+			{
+				out.push_back(node.userData);
+				continue;
+			}
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	void DynamicAabbTree::QueryFrustum(
+		const Frustum& frustum,
+		std::vector<std::uint32_t>& out) const
+	{
+		if (root_ == kNullNode) return;
+		constexpr unsigned int kAllPlanes = (1u << 6) - 1;
+		auto& stack = frustumStack;
+		stack.clear();
+		stack.emplace_back(root_, kAllPlanes);
+		while (!stack.empty())
+		{
+			const auto [index, planeMask] = stack.back();
+			stack.pop_back();
+			const Node& node = nodes_[index];
+
+			// Bit p stays set while the box straddles plane p, an empty mask
+			// means the node is inside every plane.
+			unsigned int mask = planeMask;
+			if (mask != 0)
+			{
+				const glm::vec3 center = node.box.GetCenter();
+				const glm::vec3 extents = node.box.GetExtents();
+				bool outside = false;
+				for (unsigned int p = 0; p < 6; ++p)
+				{
+					if ((planeMask & (1u << p)) == 0) continue;
+					const glm::vec4& plane = frustum.planes[p];
+					const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+					const float radius =
+						extents.x * std::abs(plane.x) +
+						extents.y * std::abs(plane.y) +
+						extents.z * std::abs(plane.z);
+					if (distance < -radius)
+					{
+						outside = true;
+						break;
+					}
+					if (distance >= radius)
+					{
+						mask &= ~(1u << p);
+					}
+				}
+				if (outside) continue;
+			}
+			if (node.IsLeaf())
+			{
+				out.push_back(node.userData);
+				continue;
+			}
+			stack.emplace_back(node.child1, mask);
+			stack.emplace_back(node.child2, mask);
+		}
+	}
+
+	void DynamicAabbTree::QuerySphere(
+		const glm::vec3& center,
+		float radius,
+		std::vector<std::uint32_t>& out) const
+	{
+		if (root_ == kNullNode) return;
+		const float radiusSquared = radius * radius;
+		auto& stack = traversalStack;
+		stack.clear();
+		stack.push_back(root_);
+		while (!stack.empty())
+		{
+			const Node& node = nodes_[stack.back()];
+			stack.pop_back();
+			if (SquaredDistance(node.box, center) > radiusSquared) continue;
+			if (node.IsLeaf())
+			{
+				out.push_back(node.userData);
+				continue;
+			}
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	void DynamicAabbTree::QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		std::vector<std::uint32_t>& out) const
+	{
+		if (root_ == kNullNode) return;
+		const glm::vec3 inverseDirection(
+			1.0f / direction.x,
+			1.0f / direction.y,
+			1.0f / direction.z);
+		auto& stack = traversalStack;
+		stack.clear();
+		stack.push_back(root_);
+		while (!stack.empty())
+		{
+			const Node& node = nodes_[stack.back()];
+			stack.pop_back();
+			if (!IntersectsSegment(node.box, origin, inverseDirection, maxDistance)) continue;
+			if (node.IsLeaf())
+			{
+				out.push_back(node.userData);
+				continue;
+			}
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+} // End namespace gl.
@@ -1,10 +1,24 @@
 #include <engine.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <string_view>
 #include <glad/glad.h>
 
+#include "allocation_tracker.h"
+#include "camera.h"
+#include "frame_capture.h"
+#include "gl_object.h"
+#include "gl_timer_query.h"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl.h"
+#include "profiler.h"
+#include "shader.h"
+#include "vfs.h"
 
 namespace gl {
 
@@ -12,14 +26,44 @@ namespace gl {
 	{
 	}
 
-	void Engine::Init()
+	Engine::Engine(Program& program, int argc, char** argv) :
+		program_(program),
+		benchmark_(ParseBenchmarkOptions(argc, argv))
 	{
-		SDL_Init(SDL_INIT_VIDEO);
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--loose") looseData_ = true;
+		}
+	}
+
+	void Engine::MountData()
+	{
+		if (looseData_ || Vfs::IsMounted()) return;
+		char* basePath = SDL_GetBasePath();
+		if (basePath == nullptr) return;
+		// Ends with a separator: its parent_path is the directory itself.
+		const std::filesystem::path directory = std::filesystem::path(basePath).parent_path();
+		SDL_free(basePath);
+		for (const auto& pack : { directory / "data.pack", directory.parent_path() / "data.pack" })
+		{
+			std::error_code error;
+			if (std::filesystem::is_regular_file(pack, error))
+			{
+				Vfs::Mount(pack);
+				return;
+			}
+		}
+	}
+
+	bool Engine::OpenWindow()
+	{
+		if (SDL_Init(SDL_INIT_VIDEO) != 0) return false;
 		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
 		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
 		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
-		SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+		// Software renderers (llvmpipe) are fine for benchmarks.
+		SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, benchmark_.enabled ? 0 : 1);
 
 
 		// Turn on double buffering with a 24bit Z buffer.
@@ -38,23 +82,64 @@ namespace gl {
 			SDL_WINDOWPOS_UNDEFINED,
 			static_cast<int>(windowSize_.x),
 			static_cast<int>(windowSize_.y),
-			SDL_WINDOW_OPENGL);
+			SDL_WINDOW_OPENGL | (benchmark_.enabled ? SDL_WINDOW_HIDDEN : 0));
 
 		// Check that everything worked out okay
-		if (window_ == nullptr)
+		if (window_ == nullptr) return false;
+		glRenderContext_ = SDL_GL_CreateContext(window_);
+		if (glRenderContext_ == nullptr)
 		{
-			std::cerr << "[Error] Unable to create window\n";
-			return;
+			SDL_DestroyWindow(window_);
+			window_ = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	bool Engine::Init()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		// Benchmarks run without a display when SDL has its offscreen
+		// driver (2.0.22+): EGL pbuffers, on llvmpipe when there is no GPU.
+		// SDL_VIDEODRIVER in the environment still wins.
+		const bool offscreen = benchmark_.enabled && std::getenv("SDL_VIDEODRIVER") == nullptr;
+		if (offscreen)
+		{
+			SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+		}
+		bool opened = OpenWindow();
+		if (!opened && offscreen)
+		{
+			std::cerr << "[Error] No offscreen video driver, using a hidden window\n";
+			SDL_Quit();
+			SDL_SetHint(SDL_HINT_VIDEODRIVER, "");
+			opened = OpenWindow();
+		}
+		if (!opened)
+		{
+			std::cerr << "[Error] Unable to create window: " << SDL_GetError() << "\n";
+			SDL_Quit();
+			return false;
 		}
-		glRenderContext_ = SDL_GL_CreateContext(window_);
 		SDL_GL_MakeCurrent(window_, glRenderContext_);
-		SDL_GL_SetSwapInterval(1);
+		if (benchmark_.enabled)
+		{
+			pacing_ = FramePacing::Uncapped;
+			swapInterval_ = 0;
+		}
+		appliedSwapInterval_ = swapInterval_;
+		SDL_GL_SetSwapInterval(appliedSwapInterval_);
 
 		if (!gladLoadGLES2Loader((GLADloadproc)SDL_GL_GetProcAddress))
 		{
-			std::cerr << "Failed to initialize OpenGL context\n";
-			assert(false);
+			std::cerr << "[Error] Failed to load the OpenGL functions\n";
+			SDL_GL_DeleteContext(glRenderContext_);
+			SDL_DestroyWindow(window_);
+			window_ = nullptr;
+			SDL_Quit();
+			return false;
 		}
+		GlTimerQuery::Load();
 		IMGUI_CHECKVERSION();
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO();
@@ -69,7 +154,16 @@ namespace gl {
 		ImGui_ImplSDL2_InitForOpenGL(window_, glRenderContext_);
 		ImGui_ImplOpenGL3_Init("#version 300 es");
 
+		GPR5300_PROFILE_THREAD("Main");
+		MountData();
+		program_.SetJobSystem(&jobSystem_);
+		const auto programStart = std::chrono::steady_clock::now();
 		program_.Init();
+		const auto end = std::chrono::steady_clock::now();
+		benchmarkRecorder_.SetLoadMilliseconds(
+			std::chrono::duration<float, std::milli>(programStart - start).count(),
+			std::chrono::duration<float, std::milli>(end - programStart).count());
+		return true;
 	}
 
 
@@ -78,33 +172,54 @@ namespace gl {
 	{
 		try
 		{
-			Init();
+			if (!Init())
+			{
+				// Nothing ran: run_benchmarks must not take that for a pass.
+				if (benchmark_.enabled)
+				{
+					std::cerr << "[Error] Benchmark aborted, no OpenGL context\n";
+					std::exit(EXIT_FAILURE);
+				}
+				return;
+			}
+			if (benchmark_.enabled)
+			{
+				const bool completed = RunBenchmark();
+				Destroy();
+				// run_benchmarks must see the failure.
+				if (!completed) std::exit(EXIT_FAILURE);
+				return;
+			}
 			bool isOpen = true;
-			std::chrono::time_point<std::chrono::system_clock> clock =
-				std::chrono::system_clock::now();
+			// steady_clock: system_clock follows wall time adjustments and
+			// can go backwards.
+			auto clock = std::chrono::steady_clock::now();
 			while (isOpen)
 			{
-				const auto start = std::chrono::system_clock::now();
+#if defined(GPR5300_PROFILER)
+				Profiler::Get().EndFrame();
+#endif
+				limiter_.Wait();
+				const auto start = std::chrono::steady_clock::now();
 				const auto dt = std::chrono::duration_cast<seconds>(start - clock);
 				deltaTime_ = dt.count();
-				float totalTime;
-				float maxTime = 15.0f;
-				totalTime += deltaTime_;
 				clock = start;
-				SDL_Event event;
-
-				if (totalTime > maxTime)
+				frameTimes_.Add(deltaTime_ * 1000.0f);
+				if (GlCallCounter::IsInstalled())
 				{
-					isOpen = false;
+					// The last frame the GL thread finished.
+					const GlCallCounts calls = GlCallCounter::GetLastFrame();
+					for (std::size_t i = 0; i < kGlStatCount; ++i)
+					{
+						const float scale = GlCallCounter::IsBytes(static_cast<GlStat>(i)) ? 1.0f / 1024.0f : 1.0f;
+						glCallHistory_[i].Add(static_cast<float>(calls.values[i]) * scale);
+					}
 				}
+				SDL_Event event;
 
+				GPR5300_PROFILE_ZONE("Frame");
 				while (SDL_PollEvent(&event))
 				{
-					if (totalTime > maxTime)
-					{
-						isOpen = false;
-					}
-
 					ImGui_ImplSDL2_ProcessEvent(&event);
 					if (event.type == SDL_QUIT)
 					{
@@ -120,28 +235,389 @@ namespace gl {
 					}
 					program_.OnEvent(event);
 				}
-				// Start the Dear ImGui frame
-				ImGui_ImplOpenGL3_NewFrame();
-				ImGui_ImplSDL2_NewFrame(window_);
-				ImGui::NewFrame();
-				DrawImGui();
-				ImGui::Render();
-				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				program_.Update(dt);
-				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-				SDL_GL_SwapWindow(window_);
+				if (renderThreadEnabled_ != renderThread_.IsRunning())
+				{
+					if (renderThreadEnabled_)
+					{
+						StartRenderThread();
+					}
+					else
+					{
+						StopRenderThread();
+					}
+				}
+
+				// Start the Dear ImGui frame. The GL backend only creates its
+				// objects there, which the first (single threaded) frame did.
+				if (!renderThread_.IsRunning())
+				{
+					ImGui_ImplOpenGL3_NewFrame();
+				}
+				{
+					GPR5300_PROFILE_ZONE("ImGui");
+					ImGui_ImplSDL2_NewFrame(window_);
+					ImGui::NewFrame();
+					DrawImGui();
+					ImGui::Render();
+				}
+#if defined(GPR5300_ALLOCATION_TRACKING)
+				// ImGui and the events are left out: the frame is what the
+				// program does.
+				AllocationTracker::BeginFrame();
+#endif
+
+				StepFixed(dt);
+				const auto frameStart = std::chrono::steady_clock::now();
+				if (renderThread_.IsRunning())
+				{
+					// Frame N + 1 simulates here while frame N renders.
+					FramePacket& packet = renderThread_.BeginFrame();
+					packet.dt = dt.count();
+					{
+						GPR5300_PROFILE_ZONE("Simulate");
+						program_.Simulate(dt, packet);
+					}
+					CaptureImGui(packet.slot);
+					renderThread_.SubmitFrame();
+					renderThreadStats_.Add(
+						deltaTime_ * 1000.0f,
+						renderThread_.GetLatencyMilliseconds());
+				}
+				else
+				{
+					SetSwapInterval();
+					ApplyGlCallCounter();
+#if defined(GPR5300_PROFILER)
+					Profiler::Get().BeginGpuFrame();
+#endif
+					{
+						GPR5300_PROFILE_ZONE("Update");
+						GPR5300_PROFILE_GPU_ZONE("Update");
+						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+						program_.Update(dt);
+					}
+					{
+						GPR5300_PROFILE_ZONE("ImGui render");
+						GPR5300_PROFILE_GPU_ZONE("ImGui");
+						ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+					}
+#if defined(GPR5300_PROFILER)
+					Profiler::Get().EndGpuFrame();
+#endif
+					{
+						GPR5300_PROFILE_ZONE("Swap");
+						SDL_GL_SwapWindow(window_);
+					}
+					GlObjectRegistry::Get().EndFrame();
+					GlCallCounter::EndFrame();
+					singleThreadStats_.Add(
+						deltaTime_ * 1000.0f,
+						std::chrono::duration<float, std::milli>(
+							std::chrono::steady_clock::now() - frameStart).count());
+				}
+#if defined(GPR5300_ALLOCATION_TRACKING)
+				AllocationTracker::EndFrame();
+#endif
 			}
+			StopRenderThread();
 
 			Destroy();
 		}
 		catch (std::exception& ex)
 		{
 			std::cerr << ex.what() << std::endl;
+			if (benchmark_.enabled) std::exit(EXIT_FAILURE);
 		}
 	}
+	bool Engine::RunBenchmark()
+	{
+		// A program that did not build draws nothing: such frames are not
+		// worth timing.
+		const auto buildFailed = []()
+			{
+				if (Shader::GetBuildFailureCount() == 0) return false;
+				std::cerr << "[Error] Benchmark aborted: " << Shader::GetBuildFailureCount()
+					<< " shader programs failed to build\n";
+				return true;
+			};
+		if (buildFailed()) return false;
+
+		Camera* camera = program_.GetCamera();
+		const CameraPath path = program_.GetBenchmarkPath();
+		const seconds dt(benchmark_.dt);
+		const std::size_t frameCount = benchmark_.warmupFrames + benchmark_.frames;
+
+		// Every frame ends with glFinish so frames do not overlap and the
+		// GPU time belongs to its frame. Timestamp queries when the context
+		// has them (see GlTimerQuery), otherwise the time glFinish waits (on
+		// llvmpipe that is the rasterization), reported as such.
+		const bool timerQueries = GlTimerQuery::IsAvailable();
+		GLuint queries[2] = { 0, 0 };
+		if (timerQueries)
+		{
+			glGenQueries(2, queries);
+		}
+		benchmarkRecorder_.SetGpuSource(timerQueries ? "timer_query" : "finish");
+		const auto* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		benchmarkRecorder_.SetName(benchmark_.name);
+		benchmarkRecorder_.SetRenderer(renderer != nullptr ? renderer : "");
+		GlCallCounter::Install();
+		// Offline: every frame is kept, however long the encoder takes.
+		FrameCapture capture;
+		if (!benchmark_.captureDirectory.empty())
+		{
+			FrameCapture::Options options;
+			options.directory = benchmark_.captureDirectory;
+			options.format = benchmark_.captureRaw ? CaptureFormat::Raw : CaptureFormat::Png;
+			options.width = static_cast<int>(windowSize_.x);
+			options.height = static_cast<int>(windowSize_.y);
+			options.waitForEncoder = true;
+			capture.Start(options);
+		}
+
+		bool aborted = false;
+		for (std::size_t frame = 0; frame < frameCount && !aborted; ++frame)
+		{
+			// Events are drained but not forwarded: input must not change
+			// what is drawn.
+			bool quit = false;
+			SDL_Event event;
+			while (SDL_PollEvent(&event))
+			{
+				if (event.type == SDL_QUIT) quit = true;
+			}
+			if (quit) break;
+
+			if (camera != nullptr && !path.IsEmpty())
+			{
+				const float t = frameCount > 1 ?
+					static_cast<float>(frame) / static_cast<float>(frameCount - 1) :
+					0.0f;
+				const CameraPath::Pose pose = path.Evaluate(t);
+				camera->position = pose.position;
+				camera->LookAt(pose.target);
+			}
+
+			GlCallCounter::Reset();
+			const auto start = std::chrono::steady_clock::now();
+			if (timerQueries)
+			{
+				GlTimerQuery::QueryCounter(queries[0]);
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			program_.SetFixedTimestep(false, 0.0f);
+			program_.Update(dt);
+			// Programs built on the way, after Init.
+			aborted = buildFailed();
+			if (timerQueries)
+			{
+				GlTimerQuery::QueryCounter(queries[1]);
+			}
+			const auto submitted = std::chrono::steady_clock::now();
+			glFinish();
+			float gpuMilliseconds = std::chrono::duration<float, std::milli>(
+				std::chrono::steady_clock::now() - submitted).count();
+			if (timerQueries)
+			{
+				const std::uint64_t begin = GlTimerQuery::GetResult(queries[0]);
+				const std::uint64_t end = GlTimerQuery::GetResult(queries[1]);
+				gpuMilliseconds = static_cast<float>(end - begin) / 1.0e6f;
+			}
+			const GlCallCounts calls = GlCallCounter::Get();
+			// After the CPU and GPU measurements, so the capture is not in
+			// them; frame_ms and capture report what it costs.
+			float captureMilliseconds = -1.0f;
+			if (frame >= benchmark_.warmupFrames && capture.IsCapturing())
+			{
+				capture.Capture();
+				captureMilliseconds = capture.GetCaptureMilliseconds();
+			}
+			SDL_GL_SwapWindow(window_);
+			GlObjectRegistry::Get().EndFrame();
+			const auto frameEnd = std::chrono::steady_clock::now();
+
+			if (frame >= benchmark_.warmupFrames && !aborted)
+			{
+				benchmarkRecorder_.AddFrame(
+					std::chrono::duration<float, std::milli>(submitted - start).count(),
+					gpuMilliseconds,
+					std::chrono::duration<float, std::milli>(frameEnd - start).count(),
+					captureMilliseconds,
+					calls);
+			}
+		}
+
+		GlCallCounter::Uninstall();
+		if (capture.IsCapturing())
+		{
+			capture.Stop();
+			benchmarkRecorder_.SetCaptureCounts(capture.GetStallCount(), capture.GetDroppedCount());
+			std::cout << "Benchmark: " << capture.GetWrittenCount() << " frames captured to "
+				<< benchmark_.captureDirectory << "\n";
+		}
+		if (timerQueries)
+		{
+			glDeleteQueries(2, queries);
+		}
+		if (aborted) return false;
+		if (!benchmarkRecorder_.Write(benchmark_)) return false;
+		std::cout << "Benchmark: " << benchmarkRecorder_.GetFrameCount()
+			<< " frames written to " << benchmark_.output << "\n";
+		return true;
+	}
+
+	void Engine::StartRenderThread()
+	{
+		// The context moves to the render thread until StopRenderThread.
+		SDL_GL_MakeCurrent(window_, nullptr);
+		renderThread_.Start(
+			[this](FramePacket& packet) { RenderFrame(packet); },
+			[this]()
+			{
+				GPR5300_PROFILE_THREAD("Render");
+				SDL_GL_MakeCurrent(window_, glRenderContext_);
+			},
+			[this]() { SDL_GL_MakeCurrent(window_, nullptr); });
+	}
+
+	void Engine::StopRenderThread()
+	{
+		if (!renderThread_.IsRunning()) return;
+		renderThread_.Stop();
+		SDL_GL_MakeCurrent(window_, glRenderContext_);
+	}
+
+	void Engine::RenderFrame(FramePacket& packet)
+	{
+		SetSwapInterval();
+		ApplyGlCallCounter();
+#if defined(GPR5300_PROFILER)
+		Profiler::Get().BeginGpuFrame();
+#endif
+		{
+			GPR5300_PROFILE_ZONE("Render");
+			GPR5300_PROFILE_GPU_ZONE("Render");
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			program_.Render(packet);
+		}
+		{
+			GPR5300_PROFILE_ZONE("ImGui render");
+			GPR5300_PROFILE_GPU_ZONE("ImGui");
+			ImGui_ImplOpenGL3_RenderDrawData(&imguiCaptures_[packet.slot].drawData);
+		}
+#if defined(GPR5300_PROFILER)
+		Profiler::Get().EndGpuFrame();
+#endif
+		{
+			GPR5300_PROFILE_ZONE("Swap");
+			SDL_GL_SwapWindow(window_);
+		}
+		GlObjectRegistry::Get().EndFrame();
+		GlCallCounter::EndFrame();
+	}
+
+	void Engine::CaptureImGui(std::size_t slot)
+	{
+		auto& capture = imguiCaptures_[slot];
+		for (auto* list : capture.lists)
+		{
+			IM_DELETE(list);
+		}
+		capture.lists.clear();
+		const ImDrawData* drawData = ImGui::GetDrawData();
+		capture.drawData = *drawData;
+		for (int i = 0; i < drawData->CmdListsCount; ++i)
+		{
+			capture.lists.push_back(drawData->CmdLists[i]->CloneOutput());
+		}
+		capture.drawData.CmdLists = capture.lists.data();
+	}
+
+	void Engine::ReleaseImGuiCaptures()
+	{
+		for (auto& capture : imguiCaptures_)
+		{
+			for (auto* list : capture.lists)
+			{
+				IM_DELETE(list);
+			}
+			capture.lists.clear();
+		}
+	}
+
+	void Engine::StepFixed(seconds dt)
+	{
+		const bool fixed = fixedTimestepEnabled_ && program_.SupportsFixedTimestep();
+		if (!fixed)
+		{
+			accumulator_ = seconds(0.0f);
+			program_.SetFixedTimestep(false, 0.0f);
+			return;
+		}
+		const seconds step(1.0f / fixedRate_);
+		accumulator_ += dt;
+		int steps = 0;
+		while (accumulator_ >= step && steps < maxSteps_)
+		{
+			program_.FixedUpdate(step);
+			accumulator_ -= step;
+			++steps;
+		}
+		// A hitch longer than maxSteps_ steps is not worth replaying (the
+		// steps would make the next frame late too): drop it.
+		if (accumulator_ >= step)
+		{
+			droppedSteps_ += static_cast<std::size_t>(accumulator_ / step);
+			accumulator_ = seconds(std::fmod(accumulator_.count(), step.count()));
+		}
+		program_.SetFixedTimestep(true, accumulator_ / step);
+	}
+
+	void Engine::SetSwapInterval()
+	{
+		const int interval = swapInterval_.load(std::memory_order_relaxed);
+		if (interval == appliedSwapInterval_) return;
+		// Adaptive vsync is an extension, fall back to plain vsync.
+		if (SDL_GL_SetSwapInterval(interval) != 0 && interval == -1)
+		{
+			SDL_GL_SetSwapInterval(1);
+		}
+		appliedSwapInterval_ = interval;
+	}
+
+	void Engine::ApplyGlCallCounter()
+	{
+		const bool enabled = glCallCounting_.load(std::memory_order_relaxed);
+		if (enabled == GlCallCounter::IsInstalled()) return;
+		if (enabled)
+		{
+			GlCallCounter::Install();
+			GlCallCounter::Reset();
+		}
+		else
+		{
+			GlCallCounter::Uninstall();
+		}
+	}
+
+	void Engine::FrameStats::Add(float frame, float latency)
+	{
+		constexpr float kWeight = 0.05f;
+		frameMilliseconds += (frame - frameMilliseconds) * kWeight;
+		latencyMilliseconds += (latency - latencyMilliseconds) * kWeight;
+	}
+
 	void Engine::Destroy()
 	{
 		program_.Destroy();
+#if defined(GPR5300_PROFILER)
+		Profiler::Get().ReleaseGpuQueries();
+#endif
+		auto& glObjects = GlObjectRegistry::Get();
+		glObjects.Flush();
+		glObjects.ReportLeaks();
+		Vfs::Unmount();
+		ReleaseImGuiCaptures();
 		ImGui_ImplOpenGL3_Shutdown();
 		// Delete our OpengL context
 		SDL_GL_DeleteContext(glRenderContext_);
@@ -156,8 +632,127 @@ namespace gl {
 	{
 		ImGui::Begin("Engine");
 		ImGui::Text("FPS: %f", 1.0f / deltaTime_);
+		DrawFrameTimingImGui();
+		DrawGlCallsImGui();
+		if (program_.SupportsRenderThread())
+		{
+			ImGui::Checkbox("Render thread", &renderThreadEnabled_);
+			ImGui::Text(
+				"Single thread: %.2f ms / frame, latency %.2f ms",
+				singleThreadStats_.frameMilliseconds,
+				singleThreadStats_.latencyMilliseconds);
+			ImGui::Text(
+				"Render thread: %.2f ms / frame, latency %.2f ms",
+				renderThreadStats_.frameMilliseconds,
+				renderThreadStats_.latencyMilliseconds);
+			if (renderThread_.IsRunning())
+			{
+				ImGui::Text(
+					"  render %.2f ms, simulation waited %.2f ms",
+					renderThread_.GetRenderMilliseconds(),
+					renderThread_.GetWaitMilliseconds());
+			}
+		}
+#if defined(GPR5300_ALLOCATION_TRACKING)
+		ImGui::Text(
+			"Heap allocations: %zu last frame (%zu bytes), %llu frames allocated",
+			AllocationTracker::GetLastFrameCount(),
+			AllocationTracker::GetLastFrameBytes(),
+			static_cast<unsigned long long>(AllocationTracker::GetFramesWithAllocations()));
+		bool reportAllocations = AllocationTracker::GetReport();
+		if (ImGui::Checkbox("Report allocating frames", &reportAllocations))
+		{
+			AllocationTracker::SetReport(reportAllocations);
+		}
+#endif
 		ImGui::End();
 		program_.DrawImGui();
+		GlObjectRegistry::Get().DrawImGui();
+#if defined(GPR5300_PROFILER)
+		Profiler::Get().DrawImGui();
+#endif
+	}
+
+	void Engine::DrawFrameTimingImGui()
+	{
+		const char* pacingNames[] = { "Vsync", "Adaptive vsync", "Uncapped" };
+		int pacing = static_cast<int>(pacing_);
+		if (ImGui::Combo("Frame pacing", &pacing, pacingNames, 3))
+		{
+			pacing_ = static_cast<FramePacing>(pacing);
+			const int intervals[] = { 1, -1, 0 };
+			swapInterval_ = intervals[pacing];
+			limiter_.SetTargetFps(pacing_ == FramePacing::Uncapped ? targetFps_ : 0.0f);
+			frameTimes_.Clear();
+		}
+		if (pacing_ == FramePacing::Uncapped &&
+			ImGui::SliderFloat("Frame limit (0 = off)", &targetFps_, 0.0f, 480.0f, "%.0f fps"))
+		{
+			limiter_.SetTargetFps(targetFps_);
+			frameTimes_.Clear();
+		}
+		ImGui::PlotLines(
+			"Frame time",
+			frameTimes_.GetSamples().data(),
+			static_cast<int>(frameTimes_.GetSamples().size()),
+			static_cast<int>(frameTimes_.GetOffset()),
+			nullptr,
+			0.0f,
+			50.0f,
+			ImVec2(0.0f, 60.0f));
+		ImGui::Text(
+			"p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms",
+			frameTimes_.GetPercentile(0.5f),
+			frameTimes_.GetPercentile(0.9f),
+			frameTimes_.GetPercentile(0.99f),
+			frameTimes_.GetMaximum());
+
+		if (program_.SupportsFixedTimestep())
+		{
+			ImGui::Checkbox("Fixed timestep", &fixedTimestepEnabled_);
+			if (fixedTimestepEnabled_)
+			{
+				ImGui::SliderFloat("Simulation rate", &fixedRate_, 10.0f, 240.0f, "%.0f Hz");
+				ImGui::SliderInt("Max steps per frame", &maxSteps_, 1, 10);
+				ImGui::Text("Dropped steps: %zu", droppedSteps_);
+			}
+		}
+	}
+
+	void Engine::DrawGlCallsImGui()
+	{
+		bool counting = glCallCounting_.load(std::memory_order_relaxed);
+		if (ImGui::Checkbox("Count GL calls", &counting))
+		{
+			glCallCounting_ = counting;
+			for (auto& history : glCallHistory_)
+			{
+				history.Clear();
+			}
+		}
+		if (!counting || !ImGui::CollapsingHeader("GL calls")) return;
+		for (std::size_t i = 0; i < kGlStatCount; ++i)
+		{
+			const auto& history = glCallHistory_[i];
+			const auto& samples = history.GetSamples();
+			const std::size_t last = (history.GetOffset() + samples.size() - 1) % samples.size();
+			char overlay[32];
+			std::snprintf(
+				overlay,
+				sizeof(overlay),
+				"%.0f, max %.0f",
+				history.GetCount() > 0 ? samples[last] : 0.0f,
+				history.GetMaximum());
+			ImGui::PlotLines(
+				GlCallCounter::GetLabel(static_cast<GlStat>(i)),
+				samples.data(),
+				static_cast<int>(samples.size()),
+				static_cast<int>(history.GetOffset()),
+				overlay,
+				0.0f,
+				FLT_MAX,
+				ImVec2(0.0f, 40.0f));
+		}
 	}
 
 } // End namespace gl.
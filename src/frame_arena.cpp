@@ -0,0 +1,70 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace gl {
+
+	namespace {
+
+		// alignment is a power of two.
+		std::size_t AlignUp(std::uintptr_t address, std::size_t alignment)
+		{
+			return (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+		}
+
+	} // namespace
+
+	FrameArena::FrameArena(std::size_t capacity) :
+		buffer_(std::make_unique<std::byte[]>(capacity)),
+		capacity_(capacity)
+	{
+	}
+
+	void* FrameArena::Allocate(std::size_t size, std::size_t alignment)
+	{
+		const auto base = reinterpret_cast<std::uintptr_t>(buffer_.get());
+		std::size_t offset = offset_.load(std::memory_order_relaxed);
+		while (true)
+		{
+			const std::size_t begin = AlignUp(base + offset, alignment) - base;
+			if (begin > capacity_ || size > capacity_ - begin)
+			{
+				return AllocateOverflow(size, alignment);
+			}
+			if (offset_.compare_exchange_weak(offset, begin + size, std::memory_order_relaxed))
+			{
+				return buffer_.get() + begin;
+			}
+		}
+	}
+
+	void* FrameArena::AllocateOverflow(std::size_t size, std::size_t alignment)
+	{
+		const std::size_t blockSize = size + alignment - 1;
+		auto block = std::make_unique<std::byte[]>(blockSize);
+		const auto address = reinterpret_cast<std::uintptr_t>(block.get());
+		void* result = block.get() + (AlignUp(address, alignment) - address);
+		overflowBytes_.fetch_add(blockSize, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock(overflowMutex_);
+		overflowBlocks_.push_back(std::move(block));
+		return result;
+	}
+
+	void FrameArena::Reset()
+	{
+		const std::size_t used = offset_.load(std::memory_order_relaxed);
+		const std::size_t overflow = overflowBytes_.load(std::memory_order_relaxed);
+		highWater_ = std::max(highWater_, used + overflow);
+		if (overflow > 0)
+		{
+			// Room for the frame that did not fit, with some slack.
+			overflowBlocks_.clear();
+			capacity_ = std::max(2 * capacity_, used + overflow + used / 2);
+			buffer_ = std::make_unique<std::byte[]>(capacity_);
+		}
+		offset_.store(0, std::memory_order_relaxed);
+		overflowBytes_.store(0, std::memory_order_relaxed);
+	}
+
+} // End namespace gl.
@@ -0,0 +1,231 @@
+#include "frame_capture.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "framebuffer.h"
+
+namespace gl {
+
+	FrameCapture::~FrameCapture()
+	{
+		Stop();
+	}
+
+	bool FrameCapture::Start(const Options& options)
+	{
+		Stop();
+		std::error_code error;
+		std::filesystem::create_directories(options.directory, error);
+		if (error)
+		{
+			std::cerr << "[Error] Could not create the capture directory "
+				<< options.directory << ": " << error.message() << "\n";
+			return false;
+		}
+		options_ = options;
+		frameBytes_ = static_cast<std::size_t>(options.width) *
+			static_cast<std::size_t>(options.height) * 4;
+		for (auto& slot : slots_)
+		{
+			slot.buffer = GlBuffer::Create("Frame capture");
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes_, nullptr, GL_STREAM_READ);
+			slot.buffer.SetBytes(frameBytes_);
+			slot.fence = nullptr;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		nextSlot_ = 0;
+		captured_ = 0;
+		dropped_ = 0;
+		stalls_ = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			queue_.clear();
+			written_ = 0;
+			stopping_ = false;
+		}
+		encoder_ = std::thread(&FrameCapture::EncoderLoop, this);
+		capturing_ = true;
+		return true;
+	}
+
+	void FrameCapture::Stop()
+	{
+		if (!capturing_) return;
+		// Oldest first, so the files stay in order.
+		for (std::size_t i = 0; i < kRingSize; ++i)
+		{
+			Slot& slot = slots_[(nextSlot_ + i) % kRingSize];
+			if (slot.fence != nullptr) Resolve(slot);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		condition_.notify_all();
+		encoder_.join();
+		for (auto& slot : slots_)
+		{
+			slot.buffer.Reset();
+		}
+		freeBuffers_.clear();
+		capturing_ = false;
+	}
+
+	void FrameCapture::Capture(GLuint framebuffer)
+	{
+		if (!capturing_) return;
+		const auto start = std::chrono::steady_clock::now();
+		// The slot was filled kRingSize captures ago.
+		Slot& slot = slots_[nextSlot_];
+		if (slot.fence != nullptr) Resolve(slot);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		// Into the pack buffer: returns once the read is queued.
+		glReadPixels(0, 0, options_.width, options_.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.frame = captured_++;
+		nextSlot_ = (nextSlot_ + 1) % kRingSize;
+
+		captureMilliseconds_ = std::chrono::duration<float, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	void FrameCapture::Capture(const Framebuffer& framebuffer)
+	{
+		Capture(framebuffer.fbo.Get());
+	}
+
+	void FrameCapture::Resolve(Slot& slot)
+	{
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			++stalls_;
+			constexpr GLuint64 kTimeout = 1'000'000'000;
+			status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kTimeout);
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			std::cerr << "[Error] Frame " << slot.frame << " capture did not complete\n";
+			++dropped_;
+			return;
+		}
+
+		std::vector<std::uint8_t> pixels;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (queue_.size() >= options_.maxQueuedFrames)
+			{
+				if (!options_.waitForEncoder)
+				{
+					++dropped_;
+					return;
+				}
+				condition_.wait(lock, [this]() { return queue_.size() < options_.maxQueuedFrames; });
+			}
+			if (!freeBuffers_.empty())
+			{
+				pixels = std::move(freeBuffers_.back());
+				freeBuffers_.pop_back();
+			}
+		}
+		pixels.resize(frameBytes_);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes_, GL_MAP_READ_BIT);
+		if (mapped == nullptr)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			std::cerr << "[Error] Could not map the capture of frame " << slot.frame << "\n";
+			++dropped_;
+			return;
+		}
+		std::memcpy(pixels.data(), mapped, frameBytes_);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			queue_.push_back({ slot.frame, std::move(pixels) });
+		}
+		condition_.notify_all();
+	}
+
+	void FrameCapture::EncoderLoop()
+	{
+		std::FILE* raw = nullptr;
+		if (options_.format == CaptureFormat::Raw)
+		{
+			const auto path = std::filesystem::path(options_.directory) / "capture.rgba";
+			raw = std::fopen(path.string().c_str(), "wb");
+			if (raw == nullptr)
+			{
+				std::cerr << "[Error] Could not open " << path.string() << "\n";
+			}
+		}
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true)
+		{
+			condition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+			// Stop comes after the last frame: drain the queue first.
+			if (queue_.empty()) break;
+			EncodedFrame frame = std::move(queue_.front());
+			queue_.pop_front();
+			lock.unlock();
+			Write(frame, raw);
+			lock.lock();
+			++written_;
+			freeBuffers_.push_back(std::move(frame.pixels));
+			condition_.notify_all();
+		}
+		lock.unlock();
+		if (raw != nullptr) std::fclose(raw);
+	}
+
+	bool FrameCapture::Write(const EncodedFrame& frame, std::FILE* raw) const
+	{
+		if (options_.format == CaptureFormat::Raw)
+		{
+			return raw != nullptr &&
+				std::fwrite(frame.pixels.data(), 1, frame.pixels.size(), raw) == frame.pixels.size();
+		}
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(frame.index));
+		const auto path = std::filesystem::path(options_.directory) / name;
+		// GL rows go bottom up: start from the last one, negative stride.
+		const int stride = options_.width * 4;
+		const auto* top = frame.pixels.data() + static_cast<std::size_t>(options_.height - 1) * stride;
+		if (stbi_write_png(path.string().c_str(), options_.width, options_.height, 4, top, -stride) == 0)
+		{
+			std::cerr << "[Error] Could not write " << path.string() << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	std::uint64_t FrameCapture::GetWrittenCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return written_;
+	}
+
+	std::size_t FrameCapture::GetQueuedCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return queue_.size();
+	}
+
+} // End namespace gl.
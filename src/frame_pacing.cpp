@@ -0,0 +1,77 @@
+#include "frame_pacing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace gl {
+
+	void FrameLimiter::SetTargetFps(float fps)
+	{
+		targetFps_ = std::max(fps, 0.0f);
+		period_ = targetFps_ > 0.0f ?
+			std::chrono::duration_cast<clock::duration>(
+				std::chrono::duration<double>(1.0 / targetFps_)) :
+			clock::duration::zero();
+		deadline_ = clock::time_point::min();
+	}
+
+	void FrameLimiter::Wait()
+	{
+		if (period_ == clock::duration::zero()) return;
+		const auto now = clock::now();
+		// Start over after a hitch rather than rushing frames to catch up.
+		if (deadline_ == clock::time_point::min() || now - deadline_ > period_)
+		{
+			deadline_ = now;
+			return;
+		}
+		deadline_ += period_;
+		if (deadline_ - now > spinMargin_)
+		{
+			std::this_thread::sleep_until(deadline_ - spinMargin_);
+		}
+		while (clock::now() < deadline_)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	FrameTimeHistory::FrameTimeHistory(std::size_t capacity) :
+		samples_(std::max<std::size_t>(capacity, 1), 0.0f)
+	{
+	}
+
+	void FrameTimeHistory::Add(float milliseconds)
+	{
+		samples_[next_] = milliseconds;
+		next_ = (next_ + 1) % samples_.size();
+		count_ = std::min(count_ + 1, samples_.size());
+	}
+
+	void FrameTimeHistory::Clear()
+	{
+		std::fill(samples_.begin(), samples_.end(), 0.0f);
+		next_ = 0;
+		count_ = 0;
+	}
+
+	float FrameTimeHistory::GetPercentile(float p) const
+	{
+		if (count_ == 0) return 0.0f;
+		// Until the ring is full the samples are [0, count_).
+		sorted_.assign(samples_.begin(), samples_.begin() + count_);
+		const auto rank = static_cast<std::size_t>(
+			std::ceil(std::clamp(p, 0.0f, 1.0f) * static_cast<float>(count_)));
+		const std::size_t index = rank == 0 ? 0 : rank - 1;
+		std::nth_element(sorted_.begin(), sorted_.begin() + index, sorted_.end());
+		return sorted_[index];
+	}
+
+	float FrameTimeHistory::GetMaximum() const
+	{
+		if (count_ == 0) return 0.0f;
+		return *std::max_element(samples_.begin(), samples_.begin() + count_);
+	}
+
+} // End namespace gl.
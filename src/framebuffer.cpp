@@ -2,7 +2,7 @@
 
 namespace gl
 {
-	Framebuffer::Framebuffer()
+	Framebuffer::Framebuffer(bool sampleableDepth)
 	{
 		float quadVertices[24] = { // vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
 								   // positions   // texCoords
@@ -15,10 +15,10 @@ namespace gl
 			1.0f,  1.0f,  1.0f, 1.0f
 		};
 
-		glGenFramebuffers(1, &fbo);
+		fbo = GlFramebuffer::Create("Framebuffer");
 		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 
-		glGenTextures(1, &texColorBuffer);
+		texColorBuffer = GlTexture::Create("Framebuffer color");
 		glBindTexture(GL_TEXTURE_2D, texColorBuffer);
 		glTexImage2D(
 			GL_TEXTURE_2D,
@@ -30,6 +30,7 @@ namespace gl
 			GL_RGB,
 			GL_UNSIGNED_BYTE,
 			NULL);
+		texColorBuffer.SetBytes(TextureBytes(1024, 720, 3));
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glFramebufferTexture2D(
@@ -39,15 +40,43 @@ namespace gl
 			texColorBuffer,
 			0);
 
-		// RBO renderbuffer object
-		glGenRenderbuffers(1, &rbo);
-		glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1024, 720);
-		glFramebufferRenderbuffer(
-			GL_FRAMEBUFFER,
-			GL_DEPTH_STENCIL_ATTACHMENT,
-			GL_RENDERBUFFER,
-			rbo);
+		if (sampleableDepth)
+		{
+			depthTexture = GlTexture::Create("Framebuffer depth");
+			glBindTexture(GL_TEXTURE_2D, depthTexture);
+			glTexImage2D(
+				GL_TEXTURE_2D,
+				0,
+				GL_DEPTH24_STENCIL8,
+				1024,
+				720,
+				0,
+				GL_DEPTH_STENCIL,
+				GL_UNSIGNED_INT_24_8,
+				NULL);
+			depthTexture.SetBytes(TextureBytes(1024, 720, 4));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glFramebufferTexture2D(
+				GL_FRAMEBUFFER,
+				GL_DEPTH_STENCIL_ATTACHMENT,
+				GL_TEXTURE_2D,
+				depthTexture,
+				0);
+		}
+		else
+		{
+			// RBO renderbuffer object
+			rbo = GlRenderbuffer::Create("Framebuffer depth");
+			glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1024, 720);
+			rbo.SetBytes(TextureBytes(1024, 720, 4));
+			glFramebufferRenderbuffer(
+				GL_FRAMEBUFFER,
+				GL_DEPTH_STENCIL_ATTACHMENT,
+				GL_RENDERBUFFER,
+				rbo);
+		}
 
 		// rbo error
 		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
@@ -55,17 +84,18 @@ namespace gl
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// QuadVAO
-		glGenVertexArrays(1, &quadVAO);
+		quadVAO = GlVertexArray::Create("Framebuffer quad");
 		glBindVertexArray(quadVAO);
 
 		// QuadVBO
-		glGenBuffers(1, &quadVBO);
+		quadVBO = GlBuffer::Create("Framebuffer quad");
 		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 		glBufferData(
 			GL_ARRAY_BUFFER,
 			sizeof(quadVertices),
 			&quadVertices,
 			GL_STATIC_DRAW);
+		quadVBO.SetBytes(sizeof(quadVertices));
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(
 			0,
@@ -107,4 +137,9 @@ namespace gl
 	{
 		return texColorBuffer;
 	}
+
+	unsigned int Framebuffer::GetDepthBuffer() const
+	{
+		return depthTexture;
+	}
 }
\ No newline at end of file
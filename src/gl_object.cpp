@@ -0,0 +1,263 @@
+#include "gl_object.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "imgui.h"
+
+namespace gl {
+
+	namespace {
+
+		float ToMebibytes(std::size_t bytes)
+		{
+			return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+		}
+
+	} // namespace
+
+	GlObjectRegistry& GlObjectRegistry::Get()
+	{
+		static GlObjectRegistry registry;
+		return registry;
+	}
+
+	void GlObjectRegistry::Add(GlObjectType type, GLuint name, const char* site)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		objects_[Key(type, name)] = { site, 0 };
+		++usage_[static_cast<std::size_t>(type)].count;
+	}
+
+	void GlObjectRegistry::SetBytes(GlObjectType type, GLuint name, std::size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const auto it = objects_.find(Key(type, name));
+		if (it == objects_.end()) return;
+		auto& usage = usage_[static_cast<std::size_t>(type)];
+		usage.bytes = usage.bytes - it->second.bytes + bytes;
+		it->second.bytes = bytes;
+	}
+
+	void GlObjectRegistry::Release(GlObjectType type, GLuint name)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const auto it = objects_.find(Key(type, name));
+		if (it != objects_.end())
+		{
+			auto& usage = usage_[static_cast<std::size_t>(type)];
+			--usage.count;
+			usage.bytes -= it->second.bytes;
+			objects_.erase(it);
+		}
+		released_.push_back({ type, name });
+	}
+
+	void GlObjectRegistry::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!released_.empty())
+		{
+			fenced_.push_back({
+				glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+				std::move(released_) });
+			released_.clear();
+		}
+		// Fences signal in order: stop at the first one still pending.
+		std::size_t done = 0;
+		for (; done < fenced_.size(); ++done)
+		{
+			const GLenum status = glClientWaitSync(fenced_[done].fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+			glDeleteSync(fenced_[done].fence);
+			Delete(fenced_[done].deletions);
+		}
+		fenced_.erase(fenced_.begin(), fenced_.begin() + done);
+	}
+
+	void GlObjectRegistry::Flush()
+	{
+		glFinish();
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (const auto& batch : fenced_)
+		{
+			glDeleteSync(batch.fence);
+			Delete(batch.deletions);
+		}
+		fenced_.clear();
+		Delete(released_);
+		released_.clear();
+	}
+
+	void GlObjectRegistry::Delete(const std::vector<Deletion>& deletions)
+	{
+		for (const auto& deletion : deletions)
+		{
+			switch (deletion.type)
+			{
+			case GlObjectType::Buffer:
+				glDeleteBuffers(1, &deletion.name);
+				break;
+			case GlObjectType::VertexArray:
+				glDeleteVertexArrays(1, &deletion.name);
+				break;
+			case GlObjectType::Texture:
+				glDeleteTextures(1, &deletion.name);
+				break;
+			case GlObjectType::Framebuffer:
+				glDeleteFramebuffers(1, &deletion.name);
+				break;
+			case GlObjectType::Renderbuffer:
+				glDeleteRenderbuffers(1, &deletion.name);
+				break;
+			case GlObjectType::Program:
+				glDeleteProgram(deletion.name);
+				break;
+			case GlObjectType::Count:
+				break;
+			}
+		}
+	}
+
+	GlObjectRegistry::Usage GlObjectRegistry::GetUsage(GlObjectType type) const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return usage_[static_cast<std::size_t>(type)];
+	}
+
+	GlObjectRegistry::Usage GlObjectRegistry::GetTotal() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		Usage total;
+		for (const auto& usage : usage_)
+		{
+			total.count += usage.count;
+			total.bytes += usage.bytes;
+		}
+		return total;
+	}
+
+	std::size_t GlObjectRegistry::GetPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::size_t pending = released_.size();
+		for (const auto& batch : fenced_)
+		{
+			pending += batch.deletions.size();
+		}
+		return pending;
+	}
+
+	std::map<std::string_view, GlObjectRegistry::Usage> GlObjectRegistry::GetSites() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::map<std::string_view, Usage> sites;
+		for (const auto& [key, object] : objects_)
+		{
+			auto& usage = sites[object.site];
+			++usage.count;
+			usage.bytes += object.bytes;
+		}
+		return sites;
+	}
+
+	bool GlObjectRegistry::ReportLeaks() const
+	{
+		const auto sites = GetSites();
+		if (sites.empty()) return true;
+		std::cerr << "[Error] GL objects still alive:\n";
+		for (const auto& [site, usage] : sites)
+		{
+			std::cerr << "  " << site << ": " << usage.count << " ("
+				<< usage.bytes << " bytes)\n";
+		}
+		return false;
+	}
+
+	void GlObjectRegistry::DrawImGui()
+	{
+		ImGui::Begin("GPU memory");
+		const Usage total = GetTotal();
+		ImGui::Text(
+			"%zu objects, %.2f MiB, %zu waiting for deletion",
+			total.count,
+			ToMebibytes(total.bytes),
+			GetPendingCount());
+		if (ImGui::BeginTable("Types", 3, ImGuiTableFlags_Borders))
+		{
+			ImGui::TableSetupColumn("Type");
+			ImGui::TableSetupColumn("Objects");
+			ImGui::TableSetupColumn("MiB");
+			ImGui::TableHeadersRow();
+			for (std::size_t i = 0; i < usage_.size(); ++i)
+			{
+				const auto type = static_cast<GlObjectType>(i);
+				const Usage usage = GetUsage(type);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(GetTypeName(type));
+				ImGui::TableNextColumn();
+				ImGui::Text("%zu", usage.count);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", ToMebibytes(usage.bytes));
+			}
+			ImGui::EndTable();
+		}
+
+		// Largest sites first.
+		const auto sites = GetSites();
+		std::vector<std::pair<std::string_view, Usage>> sorted(sites.begin(), sites.end());
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b)
+			{
+				return a.second.bytes > b.second.bytes;
+			});
+		if (ImGui::BeginTable("Sites", 3, ImGuiTableFlags_Borders))
+		{
+			ImGui::TableSetupColumn("Site");
+			ImGui::TableSetupColumn("Objects");
+			ImGui::TableSetupColumn("MiB");
+			ImGui::TableHeadersRow();
+			for (const auto& [site, usage] : sorted)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(site.data(), site.data() + site.size());
+				ImGui::TableNextColumn();
+				ImGui::Text("%zu", usage.count);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", ToMebibytes(usage.bytes));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+
+	const char* GlObjectRegistry::GetTypeName(GlObjectType type)
+	{
+		switch (type)
+		{
+		case GlObjectType::Buffer: return "Buffers";
+		case GlObjectType::VertexArray: return "Vertex arrays";
+		case GlObjectType::Texture: return "Textures";
+		case GlObjectType::Framebuffer: return "Framebuffers";
+		case GlObjectType::Renderbuffer: return "Renderbuffers";
+		case GlObjectType::Program: return "Programs";
+		case GlObjectType::Count: break;
+		}
+		return "";
+	}
+
+	std::size_t TextureBytes(int width, int height, std::size_t texelBytes, bool mipmapped)
+	{
+		std::size_t bytes = 0;
+		while (true)
+		{
+			bytes += static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * texelBytes;
+			if (!mipmapped || (width == 1 && height == 1)) break;
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+		return bytes;
+	}
+
+} // End namespace gl.
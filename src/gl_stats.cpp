@@ -0,0 +1,412 @@
+#include "gl_stats.h"
+
+#include <atomic>
+#include <type_traits>
+
+#include <glad/glad.h>
+
+namespace gl {
+
+	namespace {
+
+		std::array<std::atomic<std::uint64_t>, kGlStatCount> counts{};
+		std::array<std::atomic<std::uint64_t>, kGlStatCount> lastFrame{};
+		std::atomic<bool> installed{ false };
+
+		void Add(GlStat stat, std::uint64_t value)
+		{
+			counts[static_cast<std::size_t>(stat)].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		// The loaded function behind glad's pointer Glad, and the wrappers
+		// calling it: Count adds one to each of Stats, Measure first hands
+		// the arguments to Counter.
+		template <auto& Glad, typename Function = std::remove_reference_t<decltype(Glad)>>
+		struct Hook;
+
+		template <auto& Glad, typename Result, typename... Args>
+		struct Hook<Glad, Result(APIENTRY*)(Args...)>
+		{
+			static inline Result(APIENTRY* loaded)(Args...) = nullptr;
+
+			template <GlStat... Stats>
+			static Result APIENTRY Count(Args... args)
+			{
+				(Add(Stats, 1), ...);
+				return loaded(args...);
+			}
+
+			template <auto Counter>
+			static Result APIENTRY Measure(Args... args)
+			{
+				Counter(args...);
+				return loaded(args...);
+			}
+		};
+
+		// Only wraps functions the driver has: a null pointer stays null,
+		// so the callers' own checks still work.
+		template <auto& Glad>
+		void Wrap(std::remove_reference_t<decltype(Glad)> wrapper)
+		{
+			Hook<Glad>::loaded = Glad;
+			if (Glad != nullptr) Glad = wrapper;
+		}
+
+		template <auto& Glad, GlStat... Stats>
+		void WrapCount()
+		{
+			Wrap<Glad>(&Hook<Glad>::template Count<Stats...>);
+		}
+
+		template <auto& Glad, auto Counter>
+		void WrapMeasure()
+		{
+			Wrap<Glad>(&Hook<Glad>::template Measure<Counter>);
+		}
+
+		template <auto& Glad>
+		void Unwrap()
+		{
+			Glad = Hook<Glad>::loaded;
+		}
+
+		// Tightly packed: the unpack alignment and row length are not
+		// looked at.
+		std::uint64_t PixelBytes(GLenum format, GLenum type)
+		{
+			switch (type)
+			{
+			case GL_UNSIGNED_SHORT_5_6_5:
+			case GL_UNSIGNED_SHORT_4_4_4_4:
+			case GL_UNSIGNED_SHORT_5_5_5_1:
+				return 2;
+			case GL_UNSIGNED_INT_2_10_10_10_REV:
+			case GL_UNSIGNED_INT_10F_11F_11F_REV:
+			case GL_UNSIGNED_INT_5_9_9_9_REV:
+			case GL_UNSIGNED_INT_24_8:
+				return 4;
+			case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+				return 8;
+			default:
+				break;
+			}
+			std::uint64_t componentBytes = 1;
+			switch (type)
+			{
+			case GL_SHORT:
+			case GL_UNSIGNED_SHORT:
+			case GL_HALF_FLOAT:
+				componentBytes = 2;
+				break;
+			case GL_INT:
+			case GL_UNSIGNED_INT:
+			case GL_FLOAT:
+				componentBytes = 4;
+				break;
+			default:
+				break;
+			}
+			std::uint64_t components = 1;
+			switch (format)
+			{
+			case GL_RG:
+			case GL_RG_INTEGER:
+			case GL_LUMINANCE_ALPHA:
+				components = 2;
+				break;
+			case GL_RGB:
+			case GL_RGB_INTEGER:
+				components = 3;
+				break;
+			case GL_RGBA:
+			case GL_RGBA_INTEGER:
+				components = 4;
+				break;
+			default:
+				break;
+			}
+			return components * componentBytes;
+		}
+
+		std::uint64_t ImageBytes(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type)
+		{
+			if (width <= 0 || height <= 0 || depth <= 0) return 0;
+			return static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) *
+				static_cast<std::uint64_t>(depth) * PixelBytes(format, type);
+		}
+
+		void BufferData(GLenum, GLsizeiptr size, const void* data, GLenum)
+		{
+			if (data != nullptr && size > 0) Add(GlStat::BufferBytes, static_cast<std::uint64_t>(size));
+		}
+
+		void BufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*)
+		{
+			if (size > 0) Add(GlStat::BufferBytes, static_cast<std::uint64_t>(size));
+		}
+
+		// The whole range: what is actually written is not known.
+		void MapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield access)
+		{
+			if ((access & GL_MAP_WRITE_BIT) != 0 && length > 0)
+			{
+				Add(GlStat::BufferBytes, static_cast<std::uint64_t>(length));
+			}
+		}
+
+		// Pixels come from client memory only without a pixel unpack
+		// buffer bound; with one, pixels is an offset into it.
+		bool FromClientMemory(const void* pixels)
+		{
+			if (pixels == nullptr) return false;
+			GLint unpackBuffer = 0;
+			glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+			return unpackBuffer == 0;
+		}
+
+		void TexImage2D(
+			GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint,
+			GLenum format, GLenum type, const void* pixels)
+		{
+			if (FromClientMemory(pixels)) Add(GlStat::TextureBytes, ImageBytes(width, height, 1, format, type));
+		}
+
+		void TexSubImage2D(
+			GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height,
+			GLenum format, GLenum type, const void* pixels)
+		{
+			if (FromClientMemory(pixels)) Add(GlStat::TextureBytes, ImageBytes(width, height, 1, format, type));
+		}
+
+		void TexImage3D(
+			GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint,
+			GLenum format, GLenum type, const void* pixels)
+		{
+			if (FromClientMemory(pixels)) Add(GlStat::TextureBytes, ImageBytes(width, height, depth, format, type));
+		}
+
+		void TexSubImage3D(
+			GLenum, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth,
+			GLenum format, GLenum type, const void* pixels)
+		{
+			if (FromClientMemory(pixels)) Add(GlStat::TextureBytes, ImageBytes(width, height, depth, format, type));
+		}
+
+		void CompressedTexImage2D(
+			GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei size, const void* data)
+		{
+			if (size > 0 && FromClientMemory(data)) Add(GlStat::TextureBytes, static_cast<std::uint64_t>(size));
+		}
+
+		void CompressedTexSubImage2D(
+			GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei size, const void* data)
+		{
+			if (size > 0 && FromClientMemory(data)) Add(GlStat::TextureBytes, static_cast<std::uint64_t>(size));
+		}
+
+		// Every wrapped function, Install and Uninstall in one list.
+		template <bool Install>
+		void Hooks()
+		{
+			constexpr auto draw = GlStat::Draws;
+			constexpr auto instanced = GlStat::InstancedDraws;
+			constexpr auto dispatch = GlStat::Dispatches;
+			constexpr auto program = GlStat::ProgramBinds;
+			constexpr auto vertexArray = GlStat::VertexArrayBinds;
+			constexpr auto buffer = GlStat::BufferBinds;
+			constexpr auto texture = GlStat::TextureBinds;
+			constexpr auto framebuffer = GlStat::FramebufferBinds;
+			constexpr auto state = GlStat::RenderState;
+			constexpr auto uniform = GlStat::UniformUploads;
+#define GPR5300_GL_COUNT(function, ...) \
+			if constexpr (Install) WrapCount<glad_##function, __VA_ARGS__>(); else Unwrap<glad_##function>()
+#define GPR5300_GL_MEASURE(function, counter) \
+			if constexpr (Install) WrapMeasure<glad_##function, &counter>(); else Unwrap<glad_##function>()
+
+			GPR5300_GL_COUNT(glDrawArrays, draw);
+			GPR5300_GL_COUNT(glDrawElements, draw);
+			GPR5300_GL_COUNT(glDrawArraysInstanced, draw, instanced);
+			GPR5300_GL_COUNT(glDrawElementsInstanced, draw, instanced);
+			GPR5300_GL_COUNT(glDrawArraysIndirect, draw, instanced);
+			GPR5300_GL_COUNT(glDrawElementsIndirect, draw, instanced);
+			GPR5300_GL_COUNT(glDispatchCompute, dispatch);
+			GPR5300_GL_COUNT(glDispatchComputeIndirect, dispatch);
+
+			GPR5300_GL_COUNT(glUseProgram, program);
+			GPR5300_GL_COUNT(glBindVertexArray, vertexArray);
+			GPR5300_GL_COUNT(glBindBuffer, buffer);
+			GPR5300_GL_COUNT(glBindBufferBase, buffer);
+			GPR5300_GL_COUNT(glBindBufferRange, buffer);
+			GPR5300_GL_COUNT(glActiveTexture, texture);
+			GPR5300_GL_COUNT(glBindTexture, texture);
+			GPR5300_GL_COUNT(glBindImageTexture, texture);
+			GPR5300_GL_COUNT(glBindFramebuffer, framebuffer);
+
+			GPR5300_GL_COUNT(glEnable, state);
+			GPR5300_GL_COUNT(glDisable, state);
+			GPR5300_GL_COUNT(glBlendFunc, state);
+			GPR5300_GL_COUNT(glBlendFuncSeparate, state);
+			GPR5300_GL_COUNT(glBlendEquation, state);
+			GPR5300_GL_COUNT(glDepthFunc, state);
+			GPR5300_GL_COUNT(glDepthMask, state);
+			GPR5300_GL_COUNT(glColorMask, state);
+			GPR5300_GL_COUNT(glCullFace, state);
+			GPR5300_GL_COUNT(glFrontFace, state);
+			GPR5300_GL_COUNT(glPolygonOffset, state);
+			GPR5300_GL_COUNT(glViewport, state);
+			GPR5300_GL_COUNT(glScissor, state);
+
+			GPR5300_GL_COUNT(glUniform1f, uniform);
+			GPR5300_GL_COUNT(glUniform2f, uniform);
+			GPR5300_GL_COUNT(glUniform3f, uniform);
+			GPR5300_GL_COUNT(glUniform4f, uniform);
+			GPR5300_GL_COUNT(glUniform1i, uniform);
+			GPR5300_GL_COUNT(glUniform2i, uniform);
+			GPR5300_GL_COUNT(glUniform3i, uniform);
+			GPR5300_GL_COUNT(glUniform4i, uniform);
+			GPR5300_GL_COUNT(glUniform1ui, uniform);
+			GPR5300_GL_COUNT(glUniform2ui, uniform);
+			GPR5300_GL_COUNT(glUniform3ui, uniform);
+			GPR5300_GL_COUNT(glUniform4ui, uniform);
+			GPR5300_GL_COUNT(glUniform1fv, uniform);
+			GPR5300_GL_COUNT(glUniform2fv, uniform);
+			GPR5300_GL_COUNT(glUniform3fv, uniform);
+			GPR5300_GL_COUNT(glUniform4fv, uniform);
+			GPR5300_GL_COUNT(glUniform1iv, uniform);
+			GPR5300_GL_COUNT(glUniform2iv, uniform);
+			GPR5300_GL_COUNT(glUniform3iv, uniform);
+			GPR5300_GL_COUNT(glUniform4iv, uniform);
+			GPR5300_GL_COUNT(glUniform1uiv, uniform);
+			GPR5300_GL_COUNT(glUniform2uiv, uniform);
+			GPR5300_GL_COUNT(glUniform3uiv, uniform);
+			GPR5300_GL_COUNT(glUniform4uiv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix2fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix3fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix4fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix2x3fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix3x2fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix2x4fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix4x2fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix3x4fv, uniform);
+			GPR5300_GL_COUNT(glUniformMatrix4x3fv, uniform);
+
+			GPR5300_GL_MEASURE(glBufferData, BufferData);
+			GPR5300_GL_MEASURE(glBufferSubData, BufferSubData);
+			GPR5300_GL_MEASURE(glMapBufferRange, MapBufferRange);
+			GPR5300_GL_MEASURE(glTexImage2D, TexImage2D);
+			GPR5300_GL_MEASURE(glTexSubImage2D, TexSubImage2D);
+			GPR5300_GL_MEASURE(glTexImage3D, TexImage3D);
+			GPR5300_GL_MEASURE(glTexSubImage3D, TexSubImage3D);
+			GPR5300_GL_MEASURE(glCompressedTexImage2D, CompressedTexImage2D);
+			GPR5300_GL_MEASURE(glCompressedTexSubImage2D, CompressedTexSubImage2D);
+
+#undef GPR5300_GL_COUNT
+#undef GPR5300_GL_MEASURE
+		}
+
+	} // namespace
+
+	void GlCallCounter::Install()
+	{
+		if (installed.load(std::memory_order_relaxed)) return;
+		Hooks<true>();
+		installed.store(true, std::memory_order_relaxed);
+	}
+
+	void GlCallCounter::Uninstall()
+	{
+		if (!installed.load(std::memory_order_relaxed)) return;
+		Hooks<false>();
+		installed.store(false, std::memory_order_relaxed);
+	}
+
+	bool GlCallCounter::IsInstalled()
+	{
+		return installed.load(std::memory_order_relaxed);
+	}
+
+	GlCallCounts GlCallCounter::Get()
+	{
+		GlCallCounts result;
+		for (std::size_t i = 0; i < kGlStatCount; ++i)
+		{
+			result.values[i] = counts[i].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	void GlCallCounter::Reset()
+	{
+		for (auto& count : counts)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void GlCallCounter::EndFrame()
+	{
+		for (std::size_t i = 0; i < kGlStatCount; ++i)
+		{
+			lastFrame[i].store(counts[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	GlCallCounts GlCallCounter::GetLastFrame()
+	{
+		GlCallCounts result;
+		for (std::size_t i = 0; i < kGlStatCount; ++i)
+		{
+			result.values[i] = lastFrame[i].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	const char* GlCallCounter::GetName(GlStat stat)
+	{
+		switch (stat)
+		{
+		case GlStat::Draws: return "draws";
+		case GlStat::InstancedDraws: return "instanced_draws";
+		case GlStat::Dispatches: return "dispatches";
+		case GlStat::ProgramBinds: return "program_binds";
+		case GlStat::VertexArrayBinds: return "vertex_array_binds";
+		case GlStat::BufferBinds: return "buffer_binds";
+		case GlStat::TextureBinds: return "texture_binds";
+		case GlStat::FramebufferBinds: return "framebuffer_binds";
+		case GlStat::RenderState: return "render_state";
+		case GlStat::UniformUploads: return "uniform_uploads";
+		case GlStat::BufferBytes: return "buffer_bytes";
+		case GlStat::TextureBytes: return "texture_bytes";
+		case GlStat::Count: break;
+		}
+		return "";
+	}
+
+	const char* GlCallCounter::GetLabel(GlStat stat)
+	{
+		switch (stat)
+		{
+		case GlStat::Draws: return "Draws";
+		case GlStat::InstancedDraws: return "Instanced draws";
+		case GlStat::Dispatches: return "Dispatches";
+		case GlStat::ProgramBinds: return "Program binds";
+		case GlStat::VertexArrayBinds: return "Vertex array binds";
+		case GlStat::BufferBinds: return "Buffer binds";
+		case GlStat::TextureBinds: return "Texture binds";
+		case GlStat::FramebufferBinds: return "Framebuffer binds";
+		case GlStat::RenderState: return "Render state";
+		case GlStat::UniformUploads: return "Uniform uploads";
+		case GlStat::BufferBytes: return "Buffer upload (KiB)";
+		case GlStat::TextureBytes: return "Texture upload (KiB)";
+		case GlStat::Count: break;
+		}
+		return "";
+	}
+
+	bool GlCallCounter::IsBytes(GlStat stat)
+	{
+		return stat == GlStat::BufferBytes || stat == GlStat::TextureBytes;
+	}
+
+} // End namespace gl.
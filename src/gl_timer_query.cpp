@@ -0,0 +1,90 @@
+#include "gl_timer_query.h"
+
+#include <glad/glad.h>
+
+#include "SDL.h"
+
+namespace gl {
+
+	namespace {
+
+		struct TimerQueryFunctions
+		{
+			PFNGLQUERYCOUNTEREXTPROC queryCounter = nullptr;
+			PFNGLGETQUERYOBJECTUI64VEXTPROC getQueryObjectui64v = nullptr;
+			bool es = false;
+		};
+
+		TimerQueryFunctions& GetFunctions()
+		{
+			static TimerQueryFunctions functions;
+			return functions;
+		}
+
+	} // namespace
+
+	bool GlTimerQuery::Load()
+	{
+		TimerQueryFunctions& functions = GetFunctions();
+		functions = {};
+		int profile = 0;
+		SDL_GL_GetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, &profile);
+		functions.es = profile == SDL_GL_CONTEXT_PROFILE_ES;
+		if (functions.es)
+		{
+			if (GLAD_GL_EXT_disjoint_timer_query)
+			{
+				functions.queryCounter = glad_glQueryCounterEXT;
+				functions.getQueryObjectui64v = glad_glGetQueryObjectui64vEXT;
+			}
+		}
+		else
+		{
+			GLint major = 0;
+			GLint minor = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major);
+			glGetIntegerv(GL_MINOR_VERSION, &minor);
+			if (major * 10 + minor >= 33 || SDL_GL_ExtensionSupported("GL_ARB_timer_query"))
+			{
+				// Same signatures as the EXT functions.
+				functions.queryCounter = reinterpret_cast<PFNGLQUERYCOUNTEREXTPROC>(
+					SDL_GL_GetProcAddress("glQueryCounter"));
+				functions.getQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+					SDL_GL_GetProcAddress("glGetQueryObjectui64v"));
+			}
+		}
+		if (functions.queryCounter == nullptr || functions.getQueryObjectui64v == nullptr)
+		{
+			functions.queryCounter = nullptr;
+			functions.getQueryObjectui64v = nullptr;
+		}
+		return IsAvailable();
+	}
+
+	bool GlTimerQuery::IsAvailable()
+	{
+		return GetFunctions().queryCounter != nullptr;
+	}
+
+	void GlTimerQuery::QueryCounter(unsigned int query)
+	{
+		// GL_TIMESTAMP and GL_TIMESTAMP_EXT are the same enum.
+		GetFunctions().queryCounter(query, GL_TIMESTAMP_EXT);
+	}
+
+	std::uint64_t GlTimerQuery::GetResult(unsigned int query)
+	{
+		GLuint64 result = 0;
+		GetFunctions().getQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+		return result;
+	}
+
+	bool GlTimerQuery::IsDisjoint()
+	{
+		if (!GetFunctions().es) return false;
+		GLint disjoint = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+		return disjoint != 0;
+	}
+
+} // End namespace gl.
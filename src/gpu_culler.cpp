@@ -0,0 +1,307 @@
+#include "gpu_culler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "profiler.h"
+
+namespace gl {
+
+	namespace {
+
+		constexpr unsigned int kCullGroupSize = 256;
+		constexpr unsigned int kHiZGroupSize = 8;
+
+		std::uint64_t HashRecord(const std::uint32_t* words, std::size_t count)
+		{
+			std::uint64_t hash = 1469598103934665603ull;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				hash = (hash ^ words[i]) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+	} // namespace
+
+	GpuCuller::GpuCuller(
+		const std::string& shaderFolder,
+		unsigned int width,
+		unsigned int height) :
+		width_(width),
+		height_(height)
+	{
+		copyShader_ = std::make_unique<ComputeShader>(shaderFolder + "hiz_copy.comp");
+		downsampleShader_ = std::make_unique<ComputeShader>(shaderFolder + "hiz_downsample.comp");
+		cullShader_ = std::make_unique<ComputeShader>(shaderFolder + "gpu_cull.comp");
+
+		levelCount_ = 1 + static_cast<int>(std::floor(std::log2(static_cast<float>(std::max(width_, height_)))));
+		hiZTexture_ = GlTexture::Create("Hi-Z pyramid");
+		glBindTexture(GL_TEXTURE_2D, hiZTexture_);
+		glTexStorage2D(GL_TEXTURE_2D, levelCount_, GL_R32F, width_, height_);
+		hiZTexture_.SetBytes(TextureBytes(static_cast<int>(width_), static_cast<int>(height_), sizeof(float), true));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		const DrawElementsIndirectCommand command{ 0, 0, 0, 0, 0 };
+		commandBuffer_ = GlBuffer::Create("GPU cull command");
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), &command, GL_DYNAMIC_DRAW);
+		commandBuffer_.SetBytes(sizeof(command));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		readFramebuffer_ = GlFramebuffer::Create("Hi-Z readback");
+	}
+
+	void GpuCuller::BuildHiZ(unsigned int depthTexture, const glm::mat4& viewProjection)
+	{
+		GPR5300_PROFILE_GPU_ZONE("Hi-Z build");
+		hiZViewProjection_ = viewProjection;
+		hiZBuilt_ = true;
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+		copyShader_->Use();
+		copyShader_->SetInt("depthTexture", 0);
+		glBindImageTexture(0, hiZTexture_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		copyShader_->Dispatch(
+			(width_ + kHiZGroupSize - 1) / kHiZGroupSize,
+			(height_ + kHiZGroupSize - 1) / kHiZGroupSize);
+
+		unsigned int width = width_;
+		unsigned int height = height_;
+		for (int level = 1; level < levelCount_; ++level)
+		{
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+			glBindImageTexture(0, hiZTexture_, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, hiZTexture_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			downsampleShader_->Dispatch(
+				(width + kHiZGroupSize - 1) / kHiZGroupSize,
+				(height + kHiZGroupSize - 1) / kHiZGroupSize);
+		}
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	void GpuCuller::Cull(
+		unsigned int boundsBuffer,
+		unsigned int sourceBuffer,
+		unsigned int destinationBuffer,
+		std::size_t objectCount,
+		std::size_t strideBytes,
+		const Frustum& frustum,
+		unsigned int indexCount)
+	{
+		GPR5300_PROFILE_GPU_ZONE("GPU cull");
+		boundsBuffer_ = boundsBuffer;
+		sourceBuffer_ = sourceBuffer;
+		destinationBuffer_ = destinationBuffer;
+		objectCount_ = objectCount;
+		strideBytes_ = strideBytes;
+		frustum_ = frustum;
+
+		// Reset the instance count, the shader atomically counts from 0.
+		const DrawElementsIndirectCommand command{ indexCount, 0, 0, 0, 0 };
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer_);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(command), &command);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		cullShader_->Use();
+		cullShader_->SetInt("objectCount", static_cast<int>(objectCount));
+		cullShader_->SetInt("strideWords", static_cast<int>(strideBytes / sizeof(std::uint32_t)));
+		// Names spelled out: building them would allocate every frame.
+		static constexpr const char* kPlaneNames[6] = {
+			"frustumPlanes[0]", "frustumPlanes[1]", "frustumPlanes[2]",
+			"frustumPlanes[3]", "frustumPlanes[4]", "frustumPlanes[5]" };
+		for (int i = 0; i < 6; ++i)
+		{
+			cullShader_->SetVec4(kPlaneNames[i], frustum_.planes[i]);
+		}
+		const bool useHiZ = hiZEnabled_ && hiZBuilt_;
+		cullShader_->SetBool("hiZEnabled", useHiZ);
+		cullShader_->SetInt("hiZ", 0);
+		cullShader_->SetInt("hiZLevels", levelCount_);
+		cullShader_->SetVec2("hiZSize", glm::vec2(static_cast<float>(width_), static_cast<float>(height_)));
+		cullShader_->SetMat4("hiZViewProjection", hiZViewProjection_);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hiZTexture_);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, boundsBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sourceBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, destinationBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, commandBuffer_);
+		cullShader_->Dispatch(static_cast<unsigned int>((objectCount + kCullGroupSize - 1) / kCullGroupSize));
+		for (unsigned int binding = 0; binding < 4; ++binding)
+		{
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+		}
+		// The command is read by the draw, the records as vertex attributes.
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+	}
+
+	void GpuCuller::Draw() const
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+		// Core since 4.0 / ES 3.1; the multi draw entry point is an ES
+		// extension glad leaves null on the desktop context.
+		glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	std::vector<float> GpuCuller::ReadHiZLevel(int level) const
+	{
+		const unsigned int width = std::max(1u, width_ >> level);
+		const unsigned int height = std::max(1u, height_ >> level);
+		std::vector<float> texels(static_cast<std::size_t>(width) * height);
+		glBindFramebuffer(GL_FRAMEBUFFER, readFramebuffer_);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hiZTexture_, level);
+		glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, texels.data());
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return texels;
+	}
+
+	bool GpuCuller::IsVisibleReference(
+		const glm::vec4& sphere,
+		const std::vector<std::vector<float>>& hiZ) const
+	{
+		const glm::vec3 center(sphere);
+		const float radius = sphere.w;
+		if (!frustum_.IntersectsSphere(center, radius)) return false;
+		if (hiZ.empty()) return true;
+
+		const glm::vec2 size(static_cast<float>(width_), static_cast<float>(height_));
+		glm::vec2 low(1.0e30f);
+		glm::vec2 high(-1.0e30f);
+		float nearest = 1.0f;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 offset(
+				(corner & 1) ? radius : -radius,
+				(corner & 2) ? radius : -radius,
+				(corner & 4) ? radius : -radius);
+			const glm::vec4 clip = hiZViewProjection_ * glm::vec4(center + offset, 1.0f);
+			if (clip.w <= 1.0e-3f) return true;
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			const glm::vec2 pixel = (glm::vec2(ndc.x, ndc.y) * 0.5f + glm::vec2(0.5f)) * size;
+			low = glm::min(low, pixel);
+			high = glm::max(high, pixel);
+			nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+		}
+		if (high.x < 0.0f || high.y < 0.0f || low.x >= size.x || low.y >= size.y) return true;
+		low = glm::clamp(low, glm::vec2(0.0f), size - glm::vec2(1.0f));
+		high = glm::clamp(high, glm::vec2(0.0f), size - glm::vec2(1.0f));
+
+		int beginX = static_cast<int>(low.x);
+		int beginY = static_cast<int>(low.y);
+		int endX = static_cast<int>(high.x);
+		int endY = static_cast<int>(high.y);
+		int level = 0;
+		while (level + 1 < levelCount_ && (endX - beginX > 1 || endY - beginY > 1))
+		{
+			++level;
+			beginX >>= 1;
+			beginY >>= 1;
+			endX >>= 1;
+			endY >>= 1;
+		}
+		const int levelWidth = static_cast<int>(std::max(1u, width_ >> level));
+		const int levelHeight = static_cast<int>(std::max(1u, height_ >> level));
+		beginX = std::min(beginX, levelWidth - 1);
+		beginY = std::min(beginY, levelHeight - 1);
+		endX = std::min(endX, levelWidth - 1);
+		endY = std::min(endY, levelHeight - 1);
+		float farthest = 0.0f;
+		for (int y = beginY; y <= endY; ++y)
+		{
+			for (int x = beginX; x <= endX; ++x)
+			{
+				farthest = std::max(farthest, hiZ[level][static_cast<std::size_t>(y) * levelWidth + x]);
+			}
+		}
+		return nearest <= farthest;
+	}
+
+	GpuCullValidation GpuCuller::Validate()
+	{
+		GpuCullValidation result;
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+		DrawElementsIndirectCommand command{};
+		glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer_);
+		if (const void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, sizeof(command), GL_MAP_READ_BIT))
+		{
+			std::memcpy(&command, mapped, sizeof(command));
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+		}
+		result.gpuVisible = command.instanceCount;
+
+		const auto readBuffer = [](unsigned int buffer, std::size_t size)
+		{
+			std::vector<std::uint32_t> words(size / sizeof(std::uint32_t));
+			if (size == 0) return words;
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			if (const void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, GL_MAP_READ_BIT))
+			{
+				std::memcpy(words.data(), mapped, size);
+				glUnmapBuffer(GL_COPY_READ_BUFFER);
+			}
+			return words;
+		};
+		const std::size_t strideWords = strideBytes_ / sizeof(std::uint32_t);
+		const auto boundsWords = readBuffer(boundsBuffer_, objectCount_ * sizeof(glm::vec4));
+		const auto source = readBuffer(sourceBuffer_, objectCount_ * strideBytes_);
+		const auto destination = readBuffer(destinationBuffer_, result.gpuVisible * strideBytes_);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		std::vector<std::vector<float>> hiZ;
+		if (hiZEnabled_ && hiZBuilt_)
+		{
+			for (int level = 0; level < levelCount_; ++level)
+			{
+				hiZ.push_back(ReadHiZLevel(level));
+			}
+		}
+
+		// Which source object each packed record came from.
+		std::unordered_map<std::uint64_t, std::size_t> sourceIndex;
+		for (std::size_t i = 0; i < objectCount_; ++i)
+		{
+			sourceIndex.emplace(HashRecord(&source[i * strideWords], strideWords), i);
+		}
+		std::vector<bool> gpuVisible(objectCount_, false);
+		for (std::size_t slot = 0; slot < result.gpuVisible; ++slot)
+		{
+			const std::uint32_t* record = &destination[slot * strideWords];
+			const auto it = sourceIndex.find(HashRecord(record, strideWords));
+			if (it == sourceIndex.end() ||
+				std::memcmp(record, &source[it->second * strideWords], strideBytes_) != 0)
+			{
+				++result.corruptRecords;
+				continue;
+			}
+			gpuVisible[it->second] = true;
+		}
+
+		for (std::size_t i = 0; i < objectCount_; ++i)
+		{
+			const std::uint32_t* words = &boundsWords[i * 4];
+			const glm::vec4 sphere(
+				std::bit_cast<float>(words[0]),
+				std::bit_cast<float>(words[1]),
+				std::bit_cast<float>(words[2]),
+				std::bit_cast<float>(words[3]));
+			const bool cpuVisible = IsVisibleReference(sphere, hiZ);
+			result.cpuVisible += cpuVisible ? 1 : 0;
+			result.mismatches += cpuVisible != gpuVisible[i] ? 1 : 0;
+		}
+		return result;
+	}
+
+} // End namespace gl.
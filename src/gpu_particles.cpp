@@ -0,0 +1,340 @@
+#include "gpu_particles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "profiler.h"
+
+namespace gl {
+
+	namespace {
+
+		constexpr unsigned int kEmitGroupSize = 64;
+		constexpr unsigned int kSortGroupSize = 256;
+		// Elements sorted in shared memory by one work group.
+		constexpr unsigned int kSortBlockSize = 512;
+		// Like ParticleGenerator, particles live in the z = 0 plane.
+		constexpr float kParticleDepth = 0.0f;
+		// Window depth behind a surface within which a particle still
+		// bounces; further back it is considered to pass behind it.
+		constexpr float kCollisionThickness = 0.25f;
+
+		// Copies the first size bytes of buffer into out (GL_COPY_READ_BUFFER).
+		bool ReadBuffer(unsigned int buffer, std::size_t size, void* out)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			const void* data = glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, GL_MAP_READ_BIT);
+			if (data != nullptr)
+			{
+				std::memcpy(out, data, size);
+				glUnmapBuffer(GL_COPY_READ_BUFFER);
+			}
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			return data != nullptr;
+		}
+
+	} // namespace
+
+	GpuParticleSystem::GpuParticleSystem(
+		const std::string& shaderFolder,
+		std::shared_ptr<Shader> shader,
+		std::shared_ptr<Texture> texture,
+		unsigned int amount) :
+		capacity_(amount),
+		sortSize_(kSortBlockSize),
+		shader_(std::move(shader)),
+		texture_(std::move(texture))
+	{
+		emitShader_ = std::make_unique<ComputeShader>(shaderFolder + "particle_emit.comp");
+		argsShader_ = std::make_unique<ComputeShader>(shaderFolder + "particle_args.comp");
+		simulateShader_ = std::make_unique<ComputeShader>(shaderFolder + "particle_simulate.comp");
+		sortShader_ = std::make_unique<ComputeShader>(shaderFolder + "particle_sort.comp");
+		while (sortSize_ < capacity_)
+		{
+			sortSize_ *= 2;
+		}
+		Init();
+	}
+
+	void GpuParticleSystem::Init()
+	{
+		particleBuffer_ = GlBuffer::Create("GPU particles");
+		deadBuffer_ = GlBuffer::Create("GPU particle dead list");
+		aliveBuffer_ = GlBuffer::Create("GPU particle alive lists");
+		counterBuffer_ = GlBuffer::Create("GPU particle counters");
+		instanceBuffer_ = GlBuffer::Create("GPU particle instances");
+		sortBuffer_ = GlBuffer::Create("GPU particle sort keys");
+		sortedInstanceBuffer_ = GlBuffer::Create("GPU particle sorted instances");
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer_);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity_ * sizeof(GpuParticle), nullptr, GL_DYNAMIC_COPY);
+		particleBuffer_.SetBytes(capacity_ * sizeof(GpuParticle));
+
+		// Every slot starts dead.
+		std::vector<std::uint32_t> deadList(capacity_);
+		std::iota(deadList.begin(), deadList.end(), 0u);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, deadBuffer_);
+		glBufferData(
+			GL_SHADER_STORAGE_BUFFER,
+			capacity_ * sizeof(std::uint32_t),
+			deadList.data(),
+			GL_DYNAMIC_COPY);
+		deadBuffer_.SetBytes(capacity_ * sizeof(std::uint32_t));
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, aliveBuffer_);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * capacity_ * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_COPY);
+		aliveBuffer_.SetBytes(2 * capacity_ * sizeof(std::uint32_t));
+
+		GpuParticleCounters counters{};
+		counters.deadCount = static_cast<std::int32_t>(capacity_);
+		counters.dispatch[1] = counters.dispatch[2] = 1;
+		counters.draw[0] = 6;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer_);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counters), &counters, GL_DYNAMIC_COPY);
+		counterBuffer_.SetBytes(sizeof(counters));
+
+		// (key, slot) pairs.
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, sortBuffer_);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sortSize_ * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_COPY);
+		sortBuffer_.SetBytes(sortSize_ * sizeof(glm::uvec2));
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		for (const GlBuffer* buffer : { &instanceBuffer_, &sortedInstanceBuffer_ })
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, *buffer);
+			glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(ParticleInstance), nullptr, GL_DYNAMIC_COPY);
+			buffer->SetBytes(capacity_ * sizeof(ParticleInstance));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		CreateParticleVertexArray(instanceBuffer_, VAO_, quadVBO_);
+		CreateParticleVertexArray(sortedInstanceBuffer_, sortedVAO_, sortedQuadVBO_);
+	}
+
+	void GpuParticleSystem::BindBuffers() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, deadBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, aliveBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, counterBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, instanceBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, sortBuffer_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, sortedInstanceBuffer_);
+	}
+
+	void GpuParticleSystem::UnbindBuffers() const
+	{
+		for (unsigned int binding = 0; binding < 7; ++binding)
+		{
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+		}
+	}
+
+	void GpuParticleSystem::SetCollisionDepth(unsigned int depthTexture, const glm::mat4& viewProjection)
+	{
+		depthTexture_ = depthTexture;
+		viewProjection_ = viewProjection;
+	}
+
+	void GpuParticleSystem::Update(float dt, glm::vec2 origin, glm::vec2 velocity, unsigned int newParticles)
+	{
+		GPR5300_PROFILE_GPU_ZONE("GPU particles");
+		const int capacity = static_cast<int>(capacity_);
+		BindBuffers();
+
+		//add new particles
+		if (newParticles > 0)
+		{
+			emitShader_->Use();
+			emitShader_->SetInt("emitCount", static_cast<int>(newParticles));
+			emitShader_->SetInt("seed", static_cast<int>(random_.NextUint() >> 1));
+			emitShader_->SetVec2("origin", origin);
+			emitShader_->SetVec2("velocity", velocity);
+			emitShader_->SetInt("current", current_);
+			emitShader_->SetInt("capacity", capacity);
+			emitShader_->Dispatch((newParticles + kEmitGroupSize - 1) / kEmitGroupSize);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+
+		argsShader_->Use();
+		argsShader_->SetInt("stage", 0);
+		argsShader_->SetInt("current", current_);
+		argsShader_->Dispatch(1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+		//update all particles
+		simulateShader_->Use();
+		simulateShader_->SetInt("current", current_);
+		simulateShader_->SetInt("capacity", capacity);
+		simulateShader_->SetFloat("dt", dt);
+		simulateShader_->SetBool("writeSortKeys", blend_ == ParticleBlend::AlphaSorted);
+		simulateShader_->SetBool("collisionEnabled", depthTexture_ != 0);
+		simulateShader_->SetInt("sceneDepth", 0);
+		simulateShader_->SetMat4("viewProjection", viewProjection_);
+		simulateShader_->SetMat4("inverseViewProjection", glm::inverse(viewProjection_));
+		simulateShader_->SetFloat("particleDepth", kParticleDepth);
+		simulateShader_->SetFloat("collisionThickness", kCollisionThickness);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthTexture_);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counterBuffer_);
+		glDispatchComputeIndirect(offsetof(GpuParticleCounters, dispatch));
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		argsShader_->Use();
+		argsShader_->SetInt("stage", 1);
+		argsShader_->SetInt("current", current_);
+		argsShader_->Dispatch(1);
+
+		if (blend_ == ParticleBlend::AlphaSorted)
+		{
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			SortBackToFront(1 - current_);
+		}
+
+		UnbindBuffers();
+		// The draw reads the command and the instance records.
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+		current_ = 1 - current_;
+	}
+
+	void GpuParticleSystem::SortBackToFront(int list)
+	{
+		const int sortSize = static_cast<int>(sortSize_);
+		const unsigned int blockGroups = static_cast<unsigned int>(sortSize_ / kSortBlockSize);
+		const unsigned int pairGroups = static_cast<unsigned int>(sortSize_ / 2 / kSortGroupSize);
+		sortShader_->Use();
+		sortShader_->SetInt("sortSize", sortSize);
+		sortShader_->SetInt("list", list);
+
+		sortShader_->SetInt("mode", 0);
+		sortShader_->Dispatch(static_cast<unsigned int>(sortSize_ / kSortGroupSize));
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		sortShader_->SetInt("mode", 1);
+		sortShader_->Dispatch(blockGroups);
+		for (int k = 2 * kSortBlockSize; k <= sortSize; k *= 2)
+		{
+			sortShader_->SetInt("k", k);
+			sortShader_->SetInt("mode", 2);
+			for (int j = k / 2; j >= static_cast<int>(kSortBlockSize); j /= 2)
+			{
+				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+				sortShader_->SetInt("j", j);
+				sortShader_->Dispatch(pairGroups);
+			}
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			sortShader_->SetInt("mode", 3);
+			sortShader_->Dispatch(blockGroups);
+		}
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		sortShader_->SetInt("mode", 4);
+		sortShader_->Dispatch(static_cast<unsigned int>((capacity_ + kSortGroupSize - 1) / kSortGroupSize));
+	}
+
+	//render all particles
+	void GpuParticleSystem::Draw()
+	{
+		const bool sorted = blend_ == ParticleBlend::AlphaSorted;
+		// additive blending gives a 'glow' effect, sorted particles are
+		// blended over each other
+		glBlendFunc(GL_SRC_ALPHA, sorted ? GL_ONE_MINUS_SRC_ALPHA : GL_ONE);
+		shader_->Use();
+		texture_->Bind(0);
+		shader_->SetInt("sprite", 0);
+		glBindVertexArray(sorted ? sortedVAO_ : VAO_);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, counterBuffer_);
+		glDrawArraysIndirect(
+			GL_TRIANGLES,
+			reinterpret_cast<const void*>(offsetof(GpuParticleCounters, draw)));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+		// don't forget to reset to default blending mode
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	GpuParticleValidation GpuParticleSystem::Validate()
+	{
+		GpuParticleValidation result;
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		GpuParticleCounters counters{};
+		std::vector<GpuParticle> particles(capacity_);
+		std::vector<std::uint32_t> deadList(capacity_);
+		std::vector<std::uint32_t> aliveList(2 * capacity_);
+		std::vector<ParticleInstance> instances(capacity_);
+		std::vector<glm::uvec2> sortKeys(sortSize_);
+		std::vector<ParticleInstance> sortedInstances(capacity_);
+		if (!ReadBuffer(counterBuffer_, sizeof(counters), &counters) ||
+			!ReadBuffer(sortBuffer_, sortKeys.size() * sizeof(glm::uvec2), sortKeys.data()) ||
+			!ReadBuffer(
+				sortedInstanceBuffer_,
+				sortedInstances.size() * sizeof(ParticleInstance),
+				sortedInstances.data()) ||
+			!ReadBuffer(particleBuffer_, particles.size() * sizeof(GpuParticle), particles.data()) ||
+			!ReadBuffer(deadBuffer_, deadList.size() * sizeof(std::uint32_t), deadList.data()) ||
+			!ReadBuffer(aliveBuffer_, aliveList.size() * sizeof(std::uint32_t), aliveList.data()) ||
+			!ReadBuffer(instanceBuffer_, instances.size() * sizeof(ParticleInstance), instances.data()))
+		{
+			std::cerr << "[Error] Unable to read the particle buffers back\n";
+			return result;
+		}
+
+		// After Update the survivors are in the list current_ now points to.
+		const std::size_t alive = static_cast<std::size_t>(std::clamp(
+			counters.aliveCount[current_], 0, static_cast<std::int32_t>(capacity_)));
+		const std::size_t dead = static_cast<std::size_t>(std::clamp(
+			counters.deadCount, 0, static_cast<std::int32_t>(capacity_)));
+		result.alive = alive;
+		result.dead = dead;
+		result.drawCountMatches = counters.draw[1] == alive;
+
+		std::vector<std::uint8_t> seen(capacity_, 0);
+		auto visit = [&](std::uint32_t slot)
+			{
+				if (slot >= capacity_) return;
+				if (seen[slot]++ > 0) result.duplicateSlots++;
+			};
+		for (std::size_t i = 0; i < dead; ++i)
+		{
+			visit(deadList[i]);
+		}
+		const std::uint32_t* current = aliveList.data() + current_ * capacity_;
+		for (std::size_t i = 0; i < alive; ++i)
+		{
+			const std::uint32_t slot = current[i];
+			visit(slot);
+			if (slot >= capacity_) continue;
+			const GpuParticle& particle = particles[slot];
+			if (particle.life <= 0.0f) result.expiredAlive++;
+
+			const auto alpha = static_cast<std::uint32_t>(std::clamp(particle.alpha, 0.0f, 1.0f) * 255.0f);
+			const ParticleInstance& instance = instances[i];
+			if (instance.position != particle.position ||
+				instance.color != (particle.color | (alpha << 24)))
+			{
+				result.badInstances++;
+			}
+		}
+		result.lostSlots = static_cast<std::size_t>(std::count(seen.begin(), seen.end(), 0));
+
+		if (blend_ == ParticleBlend::AlphaSorted)
+		{
+			for (std::size_t i = 0; i < alive; ++i)
+			{
+				const std::uint32_t slot = sortKeys[i].y;
+				if (i + 1 < alive && sortKeys[i].x > sortKeys[i + 1].x) result.sortErrors++;
+				if (slot >= capacity_ ||
+					sortedInstances[i].position != instances[slot].position ||
+					sortedInstances[i].color != instances[slot].color)
+				{
+					result.sortErrors++;
+				}
+			}
+		}
+		return result;
+	}
+
+} // End namespace gl.
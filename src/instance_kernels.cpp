@@ -0,0 +1,658 @@
+#include "instance_kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gl {
+
+	void InstanceSoA::Resize(std::size_t count)
+	{
+		for (auto* array : {
+			&positionX, &positionY, &positionZ,
+			&axisX, &axisY, &axisZ, &angle,
+			&scale,
+			&orbitRadius, &orbitHeight, &orbitSpeed, &orbitPhase, &spinSpeed })
+		{
+			array->resize(count, 0.0f);
+		}
+	}
+
+	namespace {
+
+		// Writes T * R(axis, angle) * S for one instance, column-major.
+		void WriteTransform(
+			float px, float py, float pz,
+			float ax, float ay, float az,
+			float angle, float scale,
+			float* out)
+		{
+			const float s = std::sin(angle);
+			const float c = std::cos(angle);
+			const float t = 1.0f - c;
+			out[0] = (c + t * ax * ax) * scale;
+			out[1] = (t * ax * ay + s * az) * scale;
+			out[2] = (t * ax * az - s * ay) * scale;
+			out[3] = 0.0f;
+			out[4] = (t * ax * ay - s * az) * scale;
+			out[5] = (c + t * ay * ay) * scale;
+			out[6] = (t * ay * az + s * ax) * scale;
+			out[7] = 0.0f;
+			out[8] = (t * ax * az + s * ay) * scale;
+			out[9] = (t * ay * az - s * ax) * scale;
+			out[10] = (c + t * az * az) * scale;
+			out[11] = 0.0f;
+			out[12] = px;
+			out[13] = py;
+			out[14] = pz;
+			out[15] = 1.0f;
+		}
+
+		// 2 pi split in two, the high part exact in a few bits, so that
+		// turns * kTwoPiHigh is exact and the reduction loses nothing.
+		constexpr float kTwoPiHigh = 6.28125f;
+		constexpr float kTwoPiLow = 1.9353071795864769e-3f;
+		constexpr float kInverseTwoPi = 0.159154943091895f;
+
+		// phase + speed * time brought back to [-pi, pi]. Time grows for as
+		// long as the program runs and SinCos8 is only accurate for
+		// |x| < 8192; the scalar path wraps too so both agree.
+		float WrapPhase(float phase, float speed, float time)
+		{
+			const float x = std::fma(speed, time, phase);
+			const float turns = std::nearbyint(x * kInverseTwoPi);
+			return std::fma(-turns, kTwoPiLow, std::fma(-turns, kTwoPiHigh, x));
+		}
+
+		void AdvanceScalar(
+			InstanceSoA& state,
+			std::size_t i,
+			float time,
+			const glm::vec3& center)
+		{
+			const float orbit = WrapPhase(state.orbitPhase[i], state.orbitSpeed[i], time);
+			state.positionX[i] = center.x + state.orbitRadius[i] * std::cos(orbit);
+			state.positionY[i] = center.y + state.orbitHeight[i];
+			state.positionZ[i] = center.z + state.orbitRadius[i] * std::sin(orbit);
+			state.angle[i] = WrapPhase(state.orbitPhase[i], state.spinSpeed[i], time);
+		}
+
+		void WriteScalar(const InstanceSoA& state, std::size_t i, float* out)
+		{
+			WriteTransform(
+				state.positionX[i], state.positionY[i], state.positionZ[i],
+				state.axisX[i], state.axisY[i], state.axisZ[i],
+				state.angle[i], state.scale[i],
+				out);
+		}
+
+		std::int16_t ToSnorm16(float value)
+		{
+			return static_cast<std::int16_t>(std::lround(
+				std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		void WriteCompactScalar(const InstanceSoA& state, std::size_t i, CompactInstance& out)
+		{
+			const float halfAngle = 0.5f * state.angle[i];
+			const float s = std::sin(halfAngle);
+			out.positionScale = glm::vec4(
+				state.positionX[i], state.positionY[i], state.positionZ[i], state.scale[i]);
+			out.rotation[0] = ToSnorm16(state.axisX[i] * s);
+			out.rotation[1] = ToSnorm16(state.axisY[i] * s);
+			out.rotation[2] = ToSnorm16(state.axisZ[i] * s);
+			out.rotation[3] = ToSnorm16(std::cos(halfAngle));
+		}
+
+		bool IsVisibleScalar(
+			const InstanceSoA& state,
+			std::size_t i,
+			const Frustum& frustum,
+			float boundsRadius)
+		{
+			return frustum.IntersectsSphere(
+				glm::vec3(state.positionX[i], state.positionY[i], state.positionZ[i]),
+				state.scale[i] * boundsRadius);
+		}
+
+#if defined(__AVX2__)
+
+		// Cephes style sin/cos of 8 floats at once (range reduction by pi/4,
+		// minimax polynomials), accurate to a few ulp for |x| < 8192:
+		// phases go through WrapPhase8 first.
+		void SinCos8(__m256 x, __m256& sinOut, __m256& cosOut)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			const __m256 fourOverPi = _mm256_set1_ps(1.27323954473516f);
+			const __m256 dp1 = _mm256_set1_ps(-0.78515625f);
+			const __m256 dp2 = _mm256_set1_ps(-2.4187564849853515625e-4f);
+			const __m256 dp3 = _mm256_set1_ps(-3.77489497744594108e-8f);
+
+			__m256 signSin = _mm256_and_ps(x, signMask);
+			x = _mm256_andnot_ps(signMask, x);
+
+			__m256i quadrant = _mm256_cvttps_epi32(_mm256_mul_ps(x, fourOverPi));
+			quadrant = _mm256_add_epi32(quadrant, _mm256_set1_epi32(1));
+			quadrant = _mm256_and_si256(quadrant, _mm256_set1_epi32(~1));
+			const __m256 y = _mm256_cvtepi32_ps(quadrant);
+
+			const __m256 swapSignSin = _mm256_castsi256_ps(_mm256_slli_epi32(
+				_mm256_and_si256(quadrant, _mm256_set1_epi32(4)), 29));
+			const __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+				_mm256_and_si256(quadrant, _mm256_set1_epi32(2)),
+				_mm256_setzero_si256()));
+			const __m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(
+				_mm256_andnot_si256(
+					_mm256_sub_epi32(quadrant, _mm256_set1_epi32(2)),
+					_mm256_set1_epi32(4)),
+				29));
+			signSin = _mm256_xor_ps(signSin, swapSignSin);
+
+			x = _mm256_fmadd_ps(y, dp1, x);
+			x = _mm256_fmadd_ps(y, dp2, x);
+			x = _mm256_fmadd_ps(y, dp3, x);
+			const __m256 z = _mm256_mul_ps(x, x);
+
+			__m256 cosPoly = _mm256_set1_ps(2.443315711809948e-5f);
+			cosPoly = _mm256_fmadd_ps(cosPoly, z, _mm256_set1_ps(-1.388731625493765e-3f));
+			cosPoly = _mm256_fmadd_ps(cosPoly, z, _mm256_set1_ps(4.166664568298827e-2f));
+			cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+			cosPoly = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, cosPoly);
+			cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+			__m256 sinPoly = _mm256_set1_ps(-1.9515295891e-4f);
+			sinPoly = _mm256_fmadd_ps(sinPoly, z, _mm256_set1_ps(8.3321608736e-3f));
+			sinPoly = _mm256_fmadd_ps(sinPoly, z, _mm256_set1_ps(-1.6666654611e-1f));
+			sinPoly = _mm256_fmadd_ps(_mm256_mul_ps(sinPoly, z), x, x);
+
+			sinOut = _mm256_xor_ps(
+				_mm256_blendv_ps(cosPoly, sinPoly, polyMask), signSin);
+			cosOut = _mm256_xor_ps(
+				_mm256_blendv_ps(sinPoly, cosPoly, polyMask), signCos);
+		}
+
+		// Turns 8 registers of "component k for 8 instances" into 8
+		// registers of "8 components of instance i".
+		void Transpose8(__m256 r[8])
+		{
+			const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+			const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+			const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+			const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+			const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+			const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+			const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+			const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+			const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+			const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+			r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+			r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+			r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+			r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+			r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+			r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+			r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+			r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+		}
+
+		template <bool Stream>
+		void Store8(float* out, __m256 value)
+		{
+			if constexpr (Stream)
+			{
+				_mm256_stream_ps(out, value);
+			}
+			else
+			{
+				_mm256_storeu_ps(out, value);
+			}
+		}
+
+		struct Advanced8
+		{
+			__m256 px, py, pz, angle;
+		};
+
+		// The 8 wide WrapPhase.
+		__m256 WrapPhase8(__m256 phase, __m256 speed, __m256 time)
+		{
+			const __m256 x = _mm256_fmadd_ps(speed, time, phase);
+			const __m256 turns = _mm256_round_ps(
+				_mm256_mul_ps(x, _mm256_set1_ps(kInverseTwoPi)),
+				_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			return _mm256_fnmadd_ps(
+				turns,
+				_mm256_set1_ps(kTwoPiLow),
+				_mm256_fnmadd_ps(turns, _mm256_set1_ps(kTwoPiHigh), x));
+		}
+
+		Advanced8 Advance8(
+			InstanceSoA& state,
+			std::size_t i,
+			__m256 time,
+			__m256 centerX,
+			__m256 centerY,
+			__m256 centerZ)
+		{
+			const __m256 phase = _mm256_loadu_ps(&state.orbitPhase[i]);
+			const __m256 orbit = WrapPhase8(phase, _mm256_loadu_ps(&state.orbitSpeed[i]), time);
+			__m256 orbitSin, orbitCos;
+			SinCos8(orbit, orbitSin, orbitCos);
+			const __m256 radius = _mm256_loadu_ps(&state.orbitRadius[i]);
+			Advanced8 result;
+			result.px = _mm256_fmadd_ps(radius, orbitCos, centerX);
+			result.py = _mm256_add_ps(_mm256_loadu_ps(&state.orbitHeight[i]), centerY);
+			result.pz = _mm256_fmadd_ps(radius, orbitSin, centerZ);
+			result.angle = WrapPhase8(phase, _mm256_loadu_ps(&state.spinSpeed[i]), time);
+			_mm256_storeu_ps(&state.positionX[i], result.px);
+			_mm256_storeu_ps(&state.positionY[i], result.py);
+			_mm256_storeu_ps(&state.positionZ[i], result.pz);
+			_mm256_storeu_ps(&state.angle[i], result.angle);
+			return result;
+		}
+
+		// Builds T * R * S for 8 instances and stores 8 consecutive
+		// column-major matrices at out.
+		template <bool Stream>
+		void BuildAndStore8(
+			__m256 px, __m256 py, __m256 pz,
+			__m256 ax, __m256 ay, __m256 az,
+			__m256 angle, __m256 scale,
+			float* out)
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 one = _mm256_set1_ps(1.0f);
+			__m256 s, c;
+			SinCos8(angle, s, c);
+			const __m256 t = _mm256_sub_ps(one, c);
+
+			const __m256 txy = _mm256_mul_ps(_mm256_mul_ps(t, ax), ay);
+			const __m256 txz = _mm256_mul_ps(_mm256_mul_ps(t, ax), az);
+			const __m256 tyz = _mm256_mul_ps(_mm256_mul_ps(t, ay), az);
+			const __m256 sx = _mm256_mul_ps(s, ax);
+			const __m256 sy = _mm256_mul_ps(s, ay);
+			const __m256 sz = _mm256_mul_ps(s, az);
+
+			__m256 low[8] = {
+				_mm256_mul_ps(_mm256_fmadd_ps(_mm256_mul_ps(t, ax), ax, c), scale),
+				_mm256_mul_ps(_mm256_add_ps(txy, sz), scale),
+				_mm256_mul_ps(_mm256_sub_ps(txz, sy), scale),
+				zero,
+				_mm256_mul_ps(_mm256_sub_ps(txy, sz), scale),
+				_mm256_mul_ps(_mm256_fmadd_ps(_mm256_mul_ps(t, ay), ay, c), scale),
+				_mm256_mul_ps(_mm256_add_ps(tyz, sx), scale),
+				zero,
+			};
+			__m256 high[8] = {
+				_mm256_mul_ps(_mm256_add_ps(txz, sy), scale),
+				_mm256_mul_ps(_mm256_sub_ps(tyz, sx), scale),
+				_mm256_mul_ps(_mm256_fmadd_ps(_mm256_mul_ps(t, az), az, c), scale),
+				zero,
+				px,
+				py,
+				pz,
+				one,
+			};
+			Transpose8(low);
+			Transpose8(high);
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				Store8<Stream>(out, low[lane]);
+				Store8<Stream>(out + 8, high[lane]);
+				out += 16;
+			}
+		}
+
+		// Processes [begin, end) with end - begin a multiple of 8.
+		template <bool Stream>
+		void UpdateAvx2(
+			InstanceSoA& state,
+			std::size_t begin,
+			std::size_t end,
+			float time,
+			const glm::vec3& center,
+			float* out)
+		{
+			const __m256 timeV = _mm256_set1_ps(time);
+			const __m256 centerX = _mm256_set1_ps(center.x);
+			const __m256 centerY = _mm256_set1_ps(center.y);
+			const __m256 centerZ = _mm256_set1_ps(center.z);
+
+			for (std::size_t i = begin; i < end; i += 8)
+			{
+				const Advanced8 advanced = Advance8(state, i, timeV, centerX, centerY, centerZ);
+				BuildAndStore8<Stream>(
+					advanced.px, advanced.py, advanced.pz,
+					_mm256_loadu_ps(&state.axisX[i]),
+					_mm256_loadu_ps(&state.axisY[i]),
+					_mm256_loadu_ps(&state.axisZ[i]),
+					advanced.angle,
+					_mm256_loadu_ps(&state.scale[i]),
+					out);
+				out += 8 * 16;
+			}
+		}
+
+		// Quantizes the quaternions of 8 instances in registers and stores
+		// the 8 records one by one (24 byte records do not map to lanes).
+		void StoreCompact8(
+			__m256 px, __m256 py, __m256 pz,
+			__m256 ax, __m256 ay, __m256 az,
+			__m256 angle, __m256 scale,
+			CompactInstance* out)
+		{
+			__m256 s, c;
+			SinCos8(_mm256_mul_ps(angle, _mm256_set1_ps(0.5f)), s, c);
+			const __m256 quantize = _mm256_set1_ps(32767.0f);
+			alignas(32) float position[4][8];
+			alignas(32) std::int32_t rotation[4][8];
+			_mm256_store_ps(position[0], px);
+			_mm256_store_ps(position[1], py);
+			_mm256_store_ps(position[2], pz);
+			_mm256_store_ps(position[3], scale);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rotation[0]),
+				_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_mul_ps(ax, s), quantize)));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rotation[1]),
+				_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_mul_ps(ay, s), quantize)));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rotation[2]),
+				_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_mul_ps(az, s), quantize)));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rotation[3]),
+				_mm256_cvtps_epi32(_mm256_mul_ps(c, quantize)));
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				CompactInstance& instance = out[lane];
+				instance.positionScale = glm::vec4(
+					position[0][lane], position[1][lane], position[2][lane], position[3][lane]);
+				for (int k = 0; k < 4; ++k)
+				{
+					instance.rotation[k] = static_cast<std::int16_t>(rotation[k][lane]);
+				}
+			}
+		}
+
+		// permutevar8x32 indices that move the set lanes of an 8 bit mask
+		// to the front, in order.
+		constexpr auto kCompactTable = []()
+		{
+			std::array<std::array<std::int32_t, 8>, 256> table{};
+			for (int mask = 0; mask < 256; ++mask)
+			{
+				int count = 0;
+				for (int lane = 0; lane < 8; ++lane)
+				{
+					if (mask & (1 << lane)) table[mask][count++] = lane;
+				}
+			}
+			return table;
+		}();
+
+		template <bool Stream>
+		void WriteAvx2(
+			const InstanceSoA& state,
+			const std::uint32_t* indices,
+			std::size_t count,
+			float* out)
+		{
+			for (std::size_t i = 0; i + 8 <= count; i += 8)
+			{
+				const __m256i index = _mm256_loadu_si256(
+					reinterpret_cast<const __m256i*>(indices + i));
+				BuildAndStore8<Stream>(
+					_mm256_i32gather_ps(state.positionX.data(), index, 4),
+					_mm256_i32gather_ps(state.positionY.data(), index, 4),
+					_mm256_i32gather_ps(state.positionZ.data(), index, 4),
+					_mm256_i32gather_ps(state.axisX.data(), index, 4),
+					_mm256_i32gather_ps(state.axisY.data(), index, 4),
+					_mm256_i32gather_ps(state.axisZ.data(), index, 4),
+					_mm256_i32gather_ps(state.angle.data(), index, 4),
+					_mm256_i32gather_ps(state.scale.data(), index, 4),
+					out);
+				out += 8 * 16;
+			}
+		}
+
+#endif
+
+	} // namespace
+
+	void UpdateInstanceTransforms(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center,
+		glm::mat4* out)
+	{
+		float* dst = &(*out)[0][0];
+#if defined(__AVX2__)
+		const std::size_t simdEnd = begin + (end - begin) / 8 * 8;
+		if (reinterpret_cast<std::uintptr_t>(dst) % 32 == 0)
+		{
+			// Matrices are not read back by the CPU, bypass the caches.
+			UpdateAvx2<true>(state, begin, simdEnd, time, center, dst);
+			_mm_sfence();
+		}
+		else
+		{
+			UpdateAvx2<false>(state, begin, simdEnd, time, center, dst);
+		}
+		dst += (simdEnd - begin) * 16;
+		begin = simdEnd;
+#endif
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			AdvanceScalar(state, i, time, center);
+			WriteScalar(state, i, dst);
+			dst += 16;
+		}
+	}
+
+	void AdvanceInstances(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center)
+	{
+#if defined(__AVX2__)
+		const __m256 timeV = _mm256_set1_ps(time);
+		const __m256 centerX = _mm256_set1_ps(center.x);
+		const __m256 centerY = _mm256_set1_ps(center.y);
+		const __m256 centerZ = _mm256_set1_ps(center.z);
+		for (; begin + 8 <= end; begin += 8)
+		{
+			Advance8(state, begin, timeV, centerX, centerY, centerZ);
+		}
+#endif
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			AdvanceScalar(state, i, time, center);
+		}
+	}
+
+	std::size_t CullInstances(
+		const InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		const Frustum& frustum,
+		float boundsRadius,
+		std::uint32_t* visibleOut)
+	{
+		std::size_t visible = 0;
+#if defined(__AVX2__)
+		__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+			planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+			planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+			planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+		}
+		const __m256 boundsRadiusV = _mm256_set1_ps(boundsRadius);
+		const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (; begin + 8 <= end; begin += 8)
+		{
+			const __m256 px = _mm256_loadu_ps(&state.positionX[begin]);
+			const __m256 py = _mm256_loadu_ps(&state.positionY[begin]);
+			const __m256 pz = _mm256_loadu_ps(&state.positionZ[begin]);
+			const __m256 negativeRadius = _mm256_sub_ps(
+				_mm256_setzero_ps(),
+				_mm256_mul_ps(_mm256_loadu_ps(&state.scale[begin]), boundsRadiusV));
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p)
+			{
+				__m256 distance = _mm256_fmadd_ps(px, planeX[p], planeW[p]);
+				distance = _mm256_fmadd_ps(py, planeY[p], distance);
+				distance = _mm256_fmadd_ps(pz, planeZ[p], distance);
+				inside = _mm256_and_ps(
+					inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+			}
+			const int mask = _mm256_movemask_ps(inside);
+			if (mask == 0) continue;
+			// Left-pack the visible lanes. Writing 8 entries is safe: at most
+			// begin - firstBegin entries were written so far.
+			const __m256i indices = _mm256_add_epi32(
+				_mm256_set1_epi32(static_cast<int>(begin)), laneOffsets);
+			const __m256i permutation = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(kCompactTable[mask].data()));
+			_mm256_storeu_si256(
+				reinterpret_cast<__m256i*>(visibleOut + visible),
+				_mm256_permutevar8x32_epi32(indices, permutation));
+			visible += _mm_popcnt_u32(static_cast<unsigned int>(mask));
+		}
+#endif
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			if (IsVisibleScalar(state, i, frustum, boundsRadius))
+			{
+				visibleOut[visible++] = static_cast<std::uint32_t>(i);
+			}
+		}
+		return visible;
+	}
+
+	void WriteInstanceTransforms(
+		const InstanceSoA& state,
+		const std::uint32_t* indices,
+		std::size_t count,
+		glm::mat4* out)
+	{
+		float* dst = &(*out)[0][0];
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		const std::size_t simdCount = count / 8 * 8;
+		if (reinterpret_cast<std::uintptr_t>(dst) % 32 == 0)
+		{
+			WriteAvx2<true>(state, indices, simdCount, dst);
+			_mm_sfence();
+		}
+		else
+		{
+			WriteAvx2<false>(state, indices, simdCount, dst);
+		}
+		dst += simdCount * 16;
+		i = simdCount;
+#endif
+		for (; i < count; ++i)
+		{
+			WriteScalar(state, indices[i], dst);
+			dst += 16;
+		}
+	}
+
+	void UpdateCompactInstances(
+		InstanceSoA& state,
+		std::size_t begin,
+		std::size_t end,
+		float time,
+		const glm::vec3& center,
+		CompactInstance* out)
+	{
+#if defined(__AVX2__)
+		const __m256 timeV = _mm256_set1_ps(time);
+		const __m256 centerX = _mm256_set1_ps(center.x);
+		const __m256 centerY = _mm256_set1_ps(center.y);
+		const __m256 centerZ = _mm256_set1_ps(center.z);
+		for (; begin + 8 <= end; begin += 8)
+		{
+			const Advanced8 advanced = Advance8(state, begin, timeV, centerX, centerY, centerZ);
+			StoreCompact8(
+				advanced.px, advanced.py, advanced.pz,
+				_mm256_loadu_ps(&state.axisX[begin]),
+				_mm256_loadu_ps(&state.axisY[begin]),
+				_mm256_loadu_ps(&state.axisZ[begin]),
+				advanced.angle,
+				_mm256_loadu_ps(&state.scale[begin]),
+				out);
+			out += 8;
+		}
+#endif
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			AdvanceScalar(state, i, time, center);
+			WriteCompactScalar(state, i, *out++);
+		}
+	}
+
+	void WriteCompactInstances(
+		const InstanceSoA& state,
+		const std::uint32_t* indices,
+		std::size_t count,
+		CompactInstance* out)
+	{
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i index = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(indices + i));
+			StoreCompact8(
+				_mm256_i32gather_ps(state.positionX.data(), index, 4),
+				_mm256_i32gather_ps(state.positionY.data(), index, 4),
+				_mm256_i32gather_ps(state.positionZ.data(), index, 4),
+				_mm256_i32gather_ps(state.axisX.data(), index, 4),
+				_mm256_i32gather_ps(state.axisY.data(), index, 4),
+				_mm256_i32gather_ps(state.axisZ.data(), index, 4),
+				_mm256_i32gather_ps(state.angle.data(), index, 4),
+				_mm256_i32gather_ps(state.scale.data(), index, 4),
+				out);
+			out += 8;
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			WriteCompactScalar(state, indices[i], *out++);
+		}
+	}
+
+	glm::mat4 ComputeInstanceTransform(
+		const InstanceSoA& state,
+		std::size_t i,
+		float time,
+		const glm::vec3& center)
+	{
+		const float orbit = WrapPhase(state.orbitPhase[i], state.orbitSpeed[i], time);
+		glm::mat4 result;
+		WriteTransform(
+			center.x + state.orbitRadius[i] * std::cos(orbit),
+			center.y + state.orbitHeight[i],
+			center.z + state.orbitRadius[i] * std::sin(orbit),
+			state.axisX[i], state.axisY[i], state.axisZ[i],
+			WrapPhase(state.orbitPhase[i], state.spinSpeed[i], time),
+			state.scale[i],
+			&result[0][0]);
+		return result;
+	}
+
+} // End namespace gl.
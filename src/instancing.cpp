@@ -0,0 +1,645 @@
+#include "instancing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include "profiler.h"
+
+namespace gl {
+	Instancing::Instancing(
+		const std::string& filepath,
+		unsigned int nbAsteroid,
+		JobSystem* jobSystem) :
+		nbAsteroid_(nbAsteroid),
+		jobSystem_(jobSystem)
+	{
+		GenerateField();
+
+		model_ = std::make_unique<Model>(filepath);
+		const auto& asteroidMesh = model_->Model::GetMesh(0);
+		boundsRadius_ = glm::length(asteroidMesh.bounds_center_) + asteroidMesh.bounds_radius_;
+
+		// VBO instancing
+		instanceVBO_ = GlBuffer::Create("Asteroid instances");
+		SetupInstanceAttributes();
+	}
+
+	void Instancing::SetupInstanceAttributes()
+	{
+		glBindVertexArray(model_->meshes[0].GetVAO());
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+		// Location 3 is the mesh tangent, instance data uses 4 to 7.
+		if (instanceFormat_ == InstanceFormat::Matrix)
+		{
+			for (unsigned int column = 0; column < 4; ++column)
+			{
+				glEnableVertexAttribArray(4 + column);
+				glVertexAttribPointer(
+					4 + column,
+					4,
+					GL_FLOAT,
+					GL_FALSE,
+					sizeof(glm::mat4),
+					(void*)(column * sizeof(glm::vec4)));
+				glVertexAttribDivisor(4 + column, 1);
+			}
+		}
+		else
+		{
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(
+				4,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				sizeof(CompactInstance),
+				(void*)offsetof(CompactInstance, positionScale));
+			glVertexAttribDivisor(4, 1);
+			glEnableVertexAttribArray(5);
+			glVertexAttribPointer(
+				5,
+				4,
+				GL_SHORT,
+				GL_TRUE,
+				sizeof(CompactInstance),
+				(void*)offsetof(CompactInstance, rotation));
+			glVertexAttribDivisor(5, 1);
+			glDisableVertexAttribArray(6);
+			glDisableVertexAttribArray(7);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	void Instancing::SetInstanceFormat(InstanceFormat format)
+	{
+		if (format == instanceFormat_) return;
+		instanceFormat_ = format;
+		SetupInstanceAttributes();
+	}
+
+	InstanceFormat Instancing::GetInstanceFormat() const
+	{
+		return instanceFormat_;
+	}
+
+	std::size_t Instancing::GetInstanceStride() const
+	{
+		return instanceFormat_ == InstanceFormat::Matrix ?
+			sizeof(glm::mat4) :
+			sizeof(CompactInstance);
+	}
+
+	std::size_t Instancing::GetUploadedBytes() const
+	{
+		if (simulationMode_ == SimulationMode::Gpu) return 0;
+		return visibleCount_ * GetInstanceStride();
+	}
+
+	void Instancing::InitGpuSimulation(const std::string& computePath)
+	{
+		orbitShader_ = std::make_unique<ComputeShader>(computePath);
+
+		// Matches OrbitParams in asteroid_orbit.comp (std430).
+		const std::size_t count = state_.Size();
+		std::vector<glm::vec4> params(count * 3);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			params[i * 3 + 0] = glm::vec4(
+				state_.orbitRadius[i], state_.orbitHeight[i],
+				state_.orbitSpeed[i], state_.orbitPhase[i]);
+			params[i * 3 + 1] = glm::vec4(
+				state_.axisX[i], state_.axisY[i], state_.axisZ[i],
+				state_.spinSpeed[i]);
+			params[i * 3 + 2] = glm::vec4(state_.scale[i], 0.0f, 0.0f, 0.0f);
+		}
+		orbitSSBO_ = GlBuffer::Create("Asteroid orbits");
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, orbitSSBO_);
+		glBufferData(
+			GL_SHADER_STORAGE_BUFFER,
+			params.size() * sizeof(glm::vec4),
+			params.data(),
+			GL_STATIC_DRAW);
+		orbitSSBO_.SetBytes(params.size() * sizeof(glm::vec4));
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void Instancing::SetSimulationMode(SimulationMode mode)
+	{
+		if (mode == SimulationMode::Gpu && orbitShader_ == nullptr)
+		{
+			std::cerr << "[Error] InitGpuSimulation must be called before using the GPU mode\n";
+			return;
+		}
+		simulationMode_ = mode;
+	}
+
+	SimulationMode Instancing::GetSimulationMode() const
+	{
+		return simulationMode_;
+	}
+
+	float Instancing::ValidateGpuSimulation()
+	{
+		if (simulationMode_ != SimulationMode::Gpu) return 0.0f;
+		const std::size_t count = state_.Size();
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		// With GPU culling the full simulated field is in the source buffer.
+		const unsigned int buffer = gpuCuller_ != nullptr ? gpuSourceBuffer_ : instanceVBO_;
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		const void* instances = glMapBufferRange(
+			GL_COPY_READ_BUFFER, 0, count * GetInstanceStride(), GL_MAP_READ_BIT);
+		if (instances == nullptr)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			return -1.0f;
+		}
+
+		// The CPU reference advances a copy so state_ stays untouched.
+		InstanceSoA reference = state_;
+		std::vector<std::uint32_t> indices(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			indices[i] = static_cast<std::uint32_t>(i);
+		}
+		AdvanceInstances(reference, 0, count, time_, transVec_);
+		float maxError = 0.0f;
+		if (instanceFormat_ == InstanceFormat::Matrix)
+		{
+			std::vector<glm::mat4> expected(count);
+			WriteInstanceTransforms(reference, indices.data(), count, expected.data());
+			const auto* actual = static_cast<const glm::mat4*>(instances);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					for (int row = 0; row < 4; ++row)
+					{
+						maxError = std::max(
+							maxError,
+							std::abs(actual[i][column][row] - expected[i][column][row]));
+					}
+				}
+			}
+		}
+		else
+		{
+			std::vector<CompactInstance> expected(count);
+			WriteCompactInstances(reference, indices.data(), count, expected.data());
+			const auto* actual = static_cast<const CompactInstance*>(instances);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				for (int k = 0; k < 4; ++k)
+				{
+					maxError = std::max(
+						maxError,
+						std::abs(actual[i].positionScale[k] - expected[i].positionScale[k]));
+					maxError = std::max(
+						maxError,
+						std::abs(actual[i].rotation[k] - expected[i].rotation[k]) / 32767.0f);
+				}
+			}
+		}
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		return maxError;
+	}
+
+	void Instancing::SimulateOnGpu()
+	{
+		GPR5300_PROFILE_GPU_ZONE("Asteroid simulation");
+		const std::size_t count = state_.Size();
+		const std::size_t stride = GetInstanceStride();
+		ReserveInstanceBuffer(count, GL_DYNAMIC_COPY);
+		if (gpuCuller_ != nullptr && gpuSourceCapacity_ < count * stride)
+		{
+			// Sized for the mat4 format so switching formats never regrows.
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuSourceBuffer_);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+			gpuSourceBuffer_.SetBytes(count * sizeof(glm::mat4));
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuBoundsBuffer_);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::vec4), nullptr, GL_DYNAMIC_COPY);
+			gpuBoundsBuffer_.SetBytes(count * sizeof(glm::vec4));
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			gpuSourceCapacity_ = count * sizeof(glm::mat4);
+		}
+
+		orbitShader_->Use();
+		orbitShader_->SetInt("instanceCount", static_cast<int>(count));
+		orbitShader_->SetFloat("time", time_);
+		orbitShader_->SetVec3("center", transVec_);
+		orbitShader_->SetBool("compactFormat", instanceFormat_ == InstanceFormat::Compact);
+		orbitShader_->SetBool("writeBounds", gpuCuller_ != nullptr);
+		orbitShader_->SetFloat("boundsRadius", boundsRadius_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, orbitSSBO_);
+		glBindBufferBase(
+			GL_SHADER_STORAGE_BUFFER,
+			1,
+			gpuCuller_ != nullptr ? gpuSourceBuffer_ : instanceVBO_);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gpuBoundsBuffer_);
+		orbitShader_->Dispatch(static_cast<unsigned int>((count + 255) / 256));
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+		visibleCount_ = count;
+		if (gpuCuller_ == nullptr)
+		{
+			// The draw reads the results as vertex attributes.
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+			return;
+		}
+
+		// The culler reads the records and bounds as storage buffers.
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		gpuCuller_->Cull(
+			gpuBoundsBuffer_,
+			gpuSourceBuffer_,
+			instanceVBO_,
+			count,
+			stride,
+			frustum_,
+			model_->meshes[0].nb_vertices_);
+	}
+
+	void Instancing::SetGpuCuller(GpuCuller* culler)
+	{
+		gpuCuller_ = culler;
+		if (gpuCuller_ != nullptr && gpuSourceBuffer_ == 0)
+		{
+			gpuSourceBuffer_ = GlBuffer::Create("Asteroid culling source");
+			gpuBoundsBuffer_ = GlBuffer::Create("Asteroid culling bounds");
+		}
+	}
+
+	GpuCuller* Instancing::GetGpuCuller() const
+	{
+		return gpuCuller_;
+	}
+
+	void Instancing::ReserveInstanceBuffer(std::size_t count, GLenum usage)
+	{
+		const std::size_t size = count * GetInstanceStride();
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+		if (instanceCapacity_ < size)
+		{
+			glBufferData(GL_ARRAY_BUFFER, size, nullptr, usage);
+			instanceVBO_.SetBytes(size);
+			instanceCapacity_ = size;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	glm::mat4 Instancing::GetModelMatrix(unsigned int i) const
+	{
+		return ComputeInstanceTransform(state_, i, time_, transVec_);
+	}
+
+	glm::vec3 Instancing::GetPosition(unsigned int i) const
+	{
+		return glm::vec3(state_.positionX[i], state_.positionY[i], state_.positionZ[i]);
+	}
+
+	void Instancing::GetPositions(
+		std::span<const std::uint32_t> indices,
+		std::span<glm::vec3> out) const
+	{
+		const std::size_t count = std::min(indices.size(), out.size());
+		for (std::size_t k = 0; k < count; ++k)
+		{
+			const std::uint32_t i = indices[k];
+			out[k] = glm::vec3(state_.positionX[i], state_.positionY[i], state_.positionZ[i]);
+		}
+	}
+
+	void Instancing::GetPositions(std::size_t first, std::span<glm::vec3> out) const
+	{
+		const std::size_t count = std::min(out.size(), state_.Size() - std::min(first, state_.Size()));
+		const float* x = state_.positionX.data() + first;
+		const float* y = state_.positionY.data() + first;
+		const float* z = state_.positionZ.data() + first;
+		for (std::size_t k = 0; k < count; ++k)
+		{
+			out[k] = glm::vec3(x[k], y[k], z[k]);
+		}
+	}
+
+	std::size_t Instancing::QueryRadius(
+		const glm::vec3& center,
+		float radius,
+		std::vector<std::uint32_t>& out)
+	{
+		UpdateSpatialGrid();
+		return spatialGrid_.QueryRadius(center, radius, out);
+	}
+
+	void Instancing::QueryNearest(
+		const glm::vec3& center,
+		std::size_t n,
+		std::vector<std::uint32_t>& out)
+	{
+		UpdateSpatialGrid();
+		spatialGrid_.QueryNearest(center, n, out);
+	}
+
+	Aabb Instancing::GetInstanceBounds(std::size_t i) const
+	{
+		return Aabb::FromSphere(
+			glm::vec3(state_.positionX[i], state_.positionY[i], state_.positionZ[i]),
+			state_.scale[i] * boundsRadius_);
+	}
+
+	void Instancing::RegisterInstances(DynamicAabbTree* tree)
+	{
+		if (tree_ != nullptr)
+		{
+			for (const int proxy : treeProxies_)
+			{
+				tree_->DestroyProxy(proxy);
+			}
+			treeProxies_.clear();
+		}
+		tree_ = tree;
+		if (tree_ == nullptr) return;
+		treeProxies_.resize(state_.Size());
+		for (std::size_t i = 0; i < state_.Size(); ++i)
+		{
+			treeProxies_[i] = tree_->CreateProxy(
+				GetInstanceBounds(i),
+				static_cast<std::uint32_t>(i));
+		}
+	}
+
+	void Instancing::RefitTreeProxies(float dt)
+	{
+		if (tree_ == nullptr) return;
+		for (std::size_t i = 0; i < treeProxies_.size(); ++i)
+		{
+			// Tangential velocity of the orbit predicts the next move.
+			const float orbit = state_.orbitPhase[i] + state_.orbitSpeed[i] * time_;
+			const float speed = state_.orbitRadius[i] * state_.orbitSpeed[i];
+			const glm::vec3 displacement =
+				glm::vec3(-std::sin(orbit), 0.0f, std::cos(orbit)) * (speed * dt);
+			tree_->MoveProxy(treeProxies_[i], GetInstanceBounds(i), displacement);
+		}
+	}
+
+	void Instancing::UpdateSpatialGrid()
+	{
+		if (positionTime_ != time_)
+		{
+			// GPU mode does not touch state_, catch the positions up here.
+			ForEachChunk(state_.Size(), [&](std::size_t begin, std::size_t end)
+				{
+					AdvanceInstances(state_, begin, end, time_, transVec_);
+				});
+			positionTime_ = time_;
+		}
+		if (gridTime_ == time_ && spatialGrid_.GetPointCount() == state_.Size()) return;
+		spatialGrid_.Build(
+			state_.positionX.data(),
+			state_.positionY.data(),
+			state_.positionZ.data(),
+			state_.Size());
+		gridTime_ = time_;
+	}
+
+	void Instancing::GenerateField()
+	{
+		std::mt19937 generator(5300);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+
+		state_.Resize(nbAsteroid_);
+		for (unsigned int i = 0; i < nbAsteroid_; i++)
+		{
+			glm::vec3 axis;
+			do
+			{
+				axis = glm::vec3(signedUnit(generator), signedUnit(generator), signedUnit(generator));
+			} while (glm::dot(axis, axis) < 0.01f || glm::dot(axis, axis) > 1.0f);
+			axis = glm::normalize(axis);
+			state_.axisX[i] = axis.x;
+			state_.axisY[i] = axis.y;
+			state_.axisZ[i] = axis.z;
+			state_.scale[i] = 0.05f + 0.2f * unit(generator);
+			state_.orbitRadius[i] = orbitRadius_ + thicknessAsteroidX_ * signedUnit(generator) * 0.5f;
+			state_.orbitHeight[i] = thicknessAsteroidY_ * signedUnit(generator) * 0.5f;
+			// Kepler-like: inner rocks go faster.
+			state_.orbitSpeed[i] = 2.0f / std::sqrt(state_.orbitRadius[i]) * (0.9f + 0.2f * unit(generator));
+			state_.orbitPhase[i] = 6.2831853f * unit(generator);
+			state_.spinSpeed[i] = signedUnit(generator);
+			// State at time 0.
+			state_.positionX[i] = transVec_.x + state_.orbitRadius[i] * std::cos(state_.orbitPhase[i]);
+			state_.positionY[i] = transVec_.y + state_.orbitHeight[i];
+			state_.positionZ[i] = transVec_.z + state_.orbitRadius[i] * std::sin(state_.orbitPhase[i]);
+			state_.angle[i] = state_.orbitPhase[i];
+		}
+	}
+
+	void Instancing::SetFrustum(const Frustum& frustum)
+	{
+		frustum_ = frustum;
+	}
+
+	std::size_t Instancing::GetVisibleCount() const
+	{
+		return visibleCount_;
+	}
+
+	void Instancing::SetOcclusionCuller(const OcclusionCuller* culler)
+	{
+		occlusionCuller_ = culler;
+	}
+
+	std::size_t Instancing::GetOccludedCount() const
+	{
+		return occludedCount_;
+	}
+
+	void* Instancing::MapInstanceBuffer(std::size_t count)
+	{
+		const std::size_t size = count * GetInstanceStride();
+		ReserveInstanceBuffer(count, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+		void* instances = glMapBufferRange(
+			GL_ARRAY_BUFFER,
+			0,
+			size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (instances == nullptr)
+		{
+			std::cerr << "[Error] Unable to map instance buffer\n";
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		return instances;
+	}
+
+	void Instancing::ForEachChunk(std::size_t count, const JobSystem::RangeFunction& func)
+	{
+		if (jobSystem_ != nullptr)
+		{
+			jobSystem_->ParallelFor(count, kInstanceChunkSize, func);
+			return;
+		}
+		for (std::size_t begin = 0; begin < count; begin += kInstanceChunkSize)
+		{
+			func(begin, std::min(begin + kInstanceChunkSize, count));
+		}
+	}
+
+	void Instancing::UploadInstances()
+	{
+		const std::size_t count = state_.Size();
+		void* instances = MapInstanceBuffer(count);
+		if (instances == nullptr) return;
+
+		auto* matrices = static_cast<glm::mat4*>(instances);
+		auto* compact = static_cast<CompactInstance*>(instances);
+		ForEachChunk(count, [&](std::size_t begin, std::size_t end)
+			{
+				if (instanceFormat_ == InstanceFormat::Matrix)
+				{
+					UpdateInstanceTransforms(state_, begin, end, time_, transVec_, matrices + begin);
+				}
+				else
+				{
+					UpdateCompactInstances(state_, begin, end, time_, transVec_, compact + begin);
+				}
+			});
+		visibleCount_ = count;
+		positionTime_ = time_;
+
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void Instancing::UploadVisibleInstances()
+	{
+		const std::size_t count = state_.Size();
+		const std::size_t chunkCount = (count + kInstanceChunkSize - 1) / kInstanceChunkSize;
+		visibleIndices_.resize(count);
+		chunkVisible_.resize(chunkCount + 1);
+		chunkOccluded_.assign(chunkCount, 0);
+
+		// Advance and cull each chunk into its own slice of visibleIndices_.
+		ForEachChunk(count, [&](std::size_t begin, std::size_t end)
+			{
+				const std::size_t chunk = begin / kInstanceChunkSize;
+				AdvanceInstances(state_, begin, end, time_, transVec_);
+				std::uint32_t* indices = &visibleIndices_[begin];
+				std::size_t visible = CullInstances(
+					state_, begin, end, frustum_, boundsRadius_, indices);
+				if (occlusionCuller_ != nullptr)
+				{
+					// Compacts the survivors in place.
+					std::size_t kept = 0;
+					for (std::size_t k = 0; k < visible; ++k)
+					{
+						const std::uint32_t i = indices[k];
+						const bool isVisible = occlusionCuller_->IsSphereVisible(
+							glm::vec3(state_.positionX[i], state_.positionY[i], state_.positionZ[i]),
+							state_.scale[i] * boundsRadius_);
+						if (isVisible) indices[kept++] = i;
+					}
+					chunkOccluded_[chunk] = visible - kept;
+					visible = kept;
+				}
+				chunkVisible_[chunk] = visible;
+			});
+		positionTime_ = time_;
+		occludedCount_ = 0;
+		for (const std::size_t occluded : chunkOccluded_)
+		{
+			occludedCount_ += occluded;
+		}
+
+		// Exclusive prefix sum gives each chunk its offset in the buffer.
+		std::size_t total = 0;
+		for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			const std::size_t chunkCountVisible = chunkVisible_[chunk];
+			chunkVisible_[chunk] = total;
+			total += chunkCountVisible;
+		}
+		chunkVisible_[chunkCount] = total;
+		visibleCount_ = total;
+		if (total == 0) return;
+
+		void* instances = MapInstanceBuffer(total);
+		if (instances == nullptr) return;
+		auto* matrices = static_cast<glm::mat4*>(instances);
+		auto* compact = static_cast<CompactInstance*>(instances);
+		ForEachChunk(count, [&](std::size_t begin, std::size_t)
+			{
+				const std::size_t chunk = begin / kInstanceChunkSize;
+				const std::size_t offset = chunkVisible_[chunk];
+				const std::size_t visible = chunkVisible_[chunk + 1] - offset;
+				if (instanceFormat_ == InstanceFormat::Matrix)
+				{
+					WriteInstanceTransforms(
+						state_, &visibleIndices_[begin], visible, matrices + offset);
+				}
+				else
+				{
+					WriteCompactInstances(
+						state_, &visibleIndices_[begin], visible, compact + offset);
+				}
+			});
+
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void Instancing::Update(std::chrono::duration<float, std::ratio <1, 1>> dt, Shader& shader)
+	{
+		GPR5300_PROFILE_ZONE("Instancing");
+		// Update asteroids model matrix
+		time_ += dt.count();
+		if (state_.Size() == 0) return;
+		occludedCount_ = 0;
+		if (simulationMode_ == SimulationMode::Gpu)
+		{
+			SimulateOnGpu();
+		}
+		else if (cullingEnabled_)
+		{
+			UploadVisibleInstances();
+		}
+		else
+		{
+			UploadInstances();
+		}
+		if (simulationMode_ == SimulationMode::Cpu)
+		{
+			RefitTreeProxies(dt.count());
+		}
+		if (visibleCount_ == 0) return;
+
+		shader.Use();
+		shader.SetInt("TexDiffuse", 0);
+		shader.SetInt("TexNormal", 1);
+		const Mesh& mesh = model_->meshes[0];
+		mesh.Bind();
+		const auto& material = model_->materials[mesh.material_index];
+		material.color.Bind(0);
+		material.specular.Bind(1);
+		shader.SetFloat("specular_pow", material.specular_pow);
+		shader.SetVec3("specular_vec", material.specular_vec);
+		if (simulationMode_ == SimulationMode::Gpu && gpuCuller_ != nullptr)
+		{
+			gpuCuller_->Draw();
+		}
+		else
+		{
+			glDrawElementsInstanced(GL_TRIANGLES,
+				mesh.nb_vertices_,
+				GL_UNSIGNED_INT,
+				0,
+				static_cast<GLsizei>(visibleCount_));
+		}
+		glBindVertexArray(0);
+	}
+}
@@ -0,0 +1,238 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <string>
+
+#include "profiler.h"
+
+namespace gl {
+
+	namespace {
+
+		// Identifies the worker running on this thread, so Run and Wait use
+		// its own deque. Threads that are not workers of the JobSystem (the
+		// main thread, another JobSystem's workers) share queue 0.
+		thread_local const JobSystem* currentOwner = nullptr;
+		thread_local unsigned int currentQueueIndex = 0;
+
+	} // namespace
+
+	JobSystem::JobSystem(unsigned int workerCount)
+	{
+		queues_.reserve(workerCount + 1);
+		for (unsigned int i = 0; i < workerCount + 1; ++i)
+		{
+			queues_.push_back(std::make_unique<WorkQueue>());
+		}
+		workers_.reserve(workerCount);
+		for (unsigned int i = 0; i < workerCount; ++i)
+		{
+			workers_.emplace_back([this, i]() { WorkerLoop(i + 1); });
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+			stop_ = true;
+		}
+		wakeCondition_.notify_all();
+		for (auto& worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	void JobSystem::Run(Job job, JobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending_.fetch_add(1, std::memory_order_relaxed);
+		}
+		// Counted before it is visible, so a thief never decrements below
+		// zero; a worker that sees the count early just looks again.
+		queuedTasks_.fetch_add(1);
+		{
+			auto& queue = *queues_[GetQueueIndex()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.PushBack({ std::move(job), counter });
+		}
+		// Pairs with the sleepingWorkers_ increment in WorkerLoop: either the
+		// worker sees queuedTasks_ or we see it sleeping and wake it.
+		if (sleepingWorkers_.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+			wakeCondition_.notify_one();
+		}
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		const unsigned int queueIndex = GetQueueIndex();
+		while (!counter.IsDone())
+		{
+			if (!TryRunOne(queueIndex))
+			{
+				// The last jobs of the group are running elsewhere.
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(
+		std::size_t count,
+		std::size_t chunkSize,
+		const RangeFunction& func)
+	{
+		if (count == 0) return;
+		chunkSize = std::max<std::size_t>(chunkSize, 1);
+		const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+		if (workers_.empty() || chunkCount == 1)
+		{
+			for (std::size_t begin = 0; begin < count; begin += chunkSize)
+			{
+				func(begin, std::min(begin + chunkSize, count));
+			}
+			return;
+		}
+
+		// Chunks are handed out from a shared index rather than queued one
+		// by one: the helper jobs only bring idle threads in, whoever gets
+		// there first takes the next chunk.
+		std::atomic<std::size_t> nextChunk{ 0 };
+		const auto runChunks = [&]()
+			{
+				while (true)
+				{
+					const std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+					if (chunk >= chunkCount) return;
+					const std::size_t begin = chunk * chunkSize;
+					func(begin, std::min(begin + chunkSize, count));
+				}
+			};
+
+		JobCounter counter;
+		const std::size_t helperCount = std::min(workers_.size(), chunkCount - 1);
+		for (std::size_t i = 0; i < helperCount; ++i)
+		{
+			// One reference: small enough for std::function to hold inline.
+			Run([&runChunks]() { runChunks(); }, &counter);
+		}
+		runChunks();
+		Wait(counter);
+	}
+
+	unsigned int JobSystem::GetThreadCount() const
+	{
+		return static_cast<unsigned int>(workers_.size()) + 1;
+	}
+
+	unsigned int JobSystem::DefaultWorkerCount()
+	{
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	void JobSystem::WorkerLoop(unsigned int queueIndex)
+	{
+		currentOwner = this;
+		currentQueueIndex = queueIndex;
+		GPR5300_PROFILE_THREAD("Worker " + std::to_string(queueIndex));
+		while (!stop_.load(std::memory_order_relaxed))
+		{
+			if (TryRunOne(queueIndex)) continue;
+
+			std::unique_lock<std::mutex> lock(sleepMutex_);
+			sleepingWorkers_.fetch_add(1);
+			wakeCondition_.wait(lock, [this]()
+				{
+					return stop_.load() || queuedTasks_.load() > 0;
+				});
+			sleepingWorkers_.fetch_sub(1);
+		}
+	}
+
+	unsigned int JobSystem::GetQueueIndex() const
+	{
+		return currentOwner == this ? currentQueueIndex : 0;
+	}
+
+	bool JobSystem::TryRunOne(unsigned int queueIndex)
+	{
+		Task task;
+		if (!PopBack(queueIndex, task) && !Steal(queueIndex, task))
+		{
+			return false;
+		}
+		Execute(task);
+		return true;
+	}
+
+	bool JobSystem::PopBack(unsigned int queueIndex, Task& task)
+	{
+		auto& queue = *queues_[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.size == 0) return false;
+		task = queue.PopBack();
+		queuedTasks_.fetch_sub(1);
+		return true;
+	}
+
+	bool JobSystem::Steal(unsigned int thiefIndex, Task& task)
+	{
+		const auto queueCount = static_cast<unsigned int>(queues_.size());
+		for (unsigned int offset = 1; offset < queueCount; ++offset)
+		{
+			auto& queue = *queues_[(thiefIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.size == 0) continue;
+			task = queue.PopFront();
+			queuedTasks_.fetch_sub(1);
+			stealCount_.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	void JobSystem::WorkQueue::PushBack(Task task)
+	{
+		if (size == ring.size())
+		{
+			// Unwrap into a ring twice as large, oldest task first.
+			std::vector<Task> larger(std::max<std::size_t>(2 * ring.size(), 64));
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				larger[i] = std::move(ring[(front + i) % ring.size()]);
+			}
+			ring = std::move(larger);
+			front = 0;
+		}
+		ring[(front + size) % ring.size()] = std::move(task);
+		++size;
+	}
+
+	JobSystem::Task JobSystem::WorkQueue::PopBack()
+	{
+		--size;
+		return std::move(ring[(front + size) % ring.size()]);
+	}
+
+	JobSystem::Task JobSystem::WorkQueue::PopFront()
+	{
+		Task task = std::move(ring[front]);
+		front = (front + 1) % ring.size();
+		--size;
+		return task;
+	}
+
+	void JobSystem::Execute(Task& task)
+	{
+		task.job();
+		if (task.counter != nullptr)
+		{
+			task.counter->pending_.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+} // End namespace gl.
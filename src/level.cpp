@@ -0,0 +1,182 @@
+#include "level.h"
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "job_system.h"
+#include "model.h"
+#include "vfs.h"
+
+namespace gl {
+
+	namespace {
+
+		using Clock = std::chrono::steady_clock;
+
+		float MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		}
+
+		// One model job: in and out.
+		struct AssetLoad
+		{
+			std::string path;
+			bool occluder = false;
+			std::optional<ModelData> data;
+			std::string error;
+		};
+
+		bool IsStale(const std::filesystem::path& source, const std::filesystem::path& cooked)
+		{
+			std::error_code error;
+			const auto cookedTime = std::filesystem::last_write_time(cooked, error);
+			if (error) return true;
+			const auto sourceTime = std::filesystem::last_write_time(source, error);
+			return !error && sourceTime > cookedTime;
+		}
+
+	} // namespace
+
+	Level::Level() = default;
+
+	Level::~Level() = default;
+
+	bool Level::Load(
+		std::string_view source,
+		JobSystem& jobSystem,
+		Scene& scene,
+		TransformHierarchy& transforms)
+	{
+		Clear();
+		loadTimes_ = {};
+		const auto start = Clock::now();
+
+		const std::filesystem::path name = Vfs::Normalize(source);
+		const std::filesystem::path directory = name.parent_path();
+		const std::string cooked = std::filesystem::path(name).replace_extension(".scene").generic_string();
+		if (Vfs::IsPacked(cooked))
+		{
+			// Cooked when packed (tools/pack_data.cpp).
+			const VfsFile file = Vfs::Read(cooked);
+			if (!file.IsValid() || !file_.Open(file.GetBytes(), cooked)) return false;
+			loadTimes_.mapMilliseconds = MillisecondsSince(start);
+		}
+		else
+		{
+			const auto looseSource = Vfs::GetLoosePath(source);
+			const auto looseCooked = Vfs::GetLoosePath(cooked);
+			if (IsStale(looseSource, looseCooked))
+			{
+				if (!CookScene(looseSource, looseCooked)) return false;
+				loadTimes_.cookMilliseconds = MillisecondsSince(start);
+			}
+			const auto mapStart = Clock::now();
+			if (!file_.Open(looseCooked)) return false;
+			loadTimes_.mapMilliseconds = MillisecondsSince(mapStart);
+		}
+		const SceneFileHeader& header = file_.GetHeader();
+
+		// The CPU halves of the models first, so they run while the
+		// entities are made.
+		const auto assetStart = Clock::now();
+		std::vector<AssetLoad> loads(header.assetCount);
+		JobCounter counter;
+		for (std::uint32_t i = 0; i < header.assetCount; ++i)
+		{
+			AssetLoad& load = loads[i];
+			load.path = Vfs::Normalize((directory / header.assets[i].path).generic_string());
+			load.occluder = (header.assets[i].flags & kSceneAssetOccluder) != 0;
+			jobSystem.Run([&load]()
+				{
+					try
+					{
+						load.data = Model::Load(load.path, load.occluder);
+					}
+					catch (const std::exception& error)
+					{
+						load.error = error.what();
+					}
+				}, &counter);
+		}
+
+		const auto entityStart = Clock::now();
+		std::vector<TransformHierarchy::NodeId> nodes(header.entityCount);
+		entities_.reserve(header.entityCount);
+		for (std::uint32_t i = 0; i < header.entityCount; ++i)
+		{
+			const SceneFileEntity& entry = header.entities[i];
+			const Transform& local = header.transforms[i];
+			nodes[i] = transforms.CreateNode(
+				local,
+				entry.parent == kSceneFileNone ? TransformHierarchy::kNullNode : nodes[entry.parent]);
+			entities_.push_back(entry.model == kSceneFileNone ?
+				scene.CreateEntity(local, TransformNode{ nodes[i] }) :
+				scene.CreateEntity(local, TransformNode{ nodes[i] }, ModelInstance{ entry.model }));
+		}
+		loadTimes_.entityMilliseconds = MillisecondsSince(entityStart);
+
+		jobSystem.Wait(counter);
+		bool loaded = true;
+		for (auto& load : loads)
+		{
+			if (!load.data)
+			{
+				std::cerr << "[Error] Could not load " << load.path << ": " << load.error << "\n";
+				loaded = false;
+				continue;
+			}
+			models_.push_back(std::make_unique<Model>(std::move(*load.data)));
+		}
+		if (!loaded)
+		{
+			for (std::uint32_t i = 0; i < header.entityCount; ++i)
+			{
+				scene.DestroyEntity(entities_[i]);
+				// Roots take their subtrees with them.
+				if (header.entities[i].parent == kSceneFileNone) transforms.DestroyNode(nodes[i]);
+			}
+			Clear();
+			return false;
+		}
+		// Straight from the mapped file.
+		for (std::uint32_t i = 0; i < header.instanceCount; ++i)
+		{
+			const SceneFileInstances& entry = header.instances[i];
+			LevelInstances& instances = instances_.emplace_back();
+			instances.model = entry.model;
+			instances.count = entry.count;
+			instances.buffer = GlBuffer::Create("Level instances");
+			const auto bytes = static_cast<GLsizeiptr>(entry.count * sizeof(glm::mat4));
+			glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+			glBufferData(GL_ARRAY_BUFFER, bytes, entry.matrices, GL_STATIC_DRAW);
+			instances.buffer.SetBytes(static_cast<std::size_t>(bytes));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		loadTimes_.assetMilliseconds = MillisecondsSince(assetStart);
+		loadTimes_.totalMilliseconds = MillisecondsSince(start);
+		return true;
+	}
+
+	void Level::Clear()
+	{
+		instances_.clear();
+		models_.clear();
+		entities_.clear();
+		file_.Close();
+	}
+
+	Entity Level::FindEntity(std::string_view name) const
+	{
+		if (!file_.IsOpen()) return kNullEntity;
+		const SceneFileHeader& header = file_.GetHeader();
+		for (std::uint32_t i = 0; i < header.entityCount; ++i)
+		{
+			if (name == header.entities[i].name) return entities_[i];
+		}
+		return kNullEntity;
+	}
+
+} // End namespace gl.
@@ -0,0 +1,138 @@
+#include "mapped_file.h"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gl {
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+			mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+		HANDLE file = CreateFileW(
+			path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			std::cerr << "[Error] Could not open " << path.string() << "\n";
+			return false;
+		}
+		LARGE_INTEGER size{};
+		GetFileSizeEx(file, &size);
+		if (size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			std::cerr << "[Error] " << path.string() << " is empty\n";
+			return false;
+		}
+		// The view keeps the file open: both handles can go.
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+		{
+			std::cerr << "[Error] Could not map " << path.string() << "\n";
+			return false;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			std::cerr << "[Error] Could not map " << path.string() << "\n";
+			return false;
+		}
+		data_ = static_cast<std::byte*>(view);
+		size_ = static_cast<std::size_t>(size.QuadPart);
+		mapping_ = mapping;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data_ == nullptr) return;
+		UnmapViewOfFile(data_);
+		CloseHandle(mapping_);
+		data_ = nullptr;
+		size_ = 0;
+		mapping_ = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			std::cerr << "[Error] Could not open " << path.string() << "\n";
+			return false;
+		}
+		struct stat status {};
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			std::cerr << "[Error] " << path.string() << " is empty or unreadable\n";
+			return false;
+		}
+		const auto size = static_cast<std::size_t>(status.st_size);
+		void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		// The mapping keeps the file open.
+		close(file);
+		if (data == MAP_FAILED)
+		{
+			std::cerr << "[Error] Could not map " << path.string() << "\n";
+			return false;
+		}
+		data_ = static_cast<std::byte*>(data);
+		size_ = size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data_ == nullptr) return;
+		munmap(data_, size_);
+		data_ = nullptr;
+		size_ = 0;
+	}
+#endif
+
+} // End namespace gl.
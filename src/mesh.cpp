@@ -1,32 +1,57 @@
 #include "mesh.h"
 
+#include <algorithm>
+
 namespace gl
 {
     Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices, const unsigned int material_id) :
         material_index(material_id),
         nb_vertices_(static_cast<unsigned int>(indices.size()))
     {
+        // Bounding sphere around the center of the AABB.
+        if (!vertices.empty())
+        {
+            glm::vec3 min_position = vertices[0].position;
+            glm::vec3 max_position = vertices[0].position;
+            for (const auto& vertex : vertices)
+            {
+                min_position = glm::min(min_position, vertex.position);
+                max_position = glm::max(max_position, vertex.position);
+            }
+            bounds_min_ = min_position;
+            bounds_max_ = max_position;
+            bounds_center_ = (min_position + max_position) * 0.5f;
+            for (const auto& vertex : vertices)
+            {
+                bounds_radius_ = std::max(
+                    bounds_radius_,
+                    glm::length(vertex.position - bounds_center_));
+            }
+        }
+
         // VAO binding should be before VAO.
-        glGenVertexArrays(1, &vao_);
+        vao_ = GlVertexArray::Create("Mesh vertex array");
         glBindVertexArray(vao_);
 
         // EBO.
-        glGenBuffers(1, &ebo_);
+        ebo_ = GlBuffer::Create("Mesh indices");
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
         glBufferData(
             GL_ELEMENT_ARRAY_BUFFER,
             indices.size() * sizeof(float),
             indices.data(),
             GL_STATIC_DRAW);
+        ebo_.SetBytes(indices.size() * sizeof(float));
 
         // VBO.
-        glGenBuffers(1, &vbo_);
+        vbo_ = GlBuffer::Create("Mesh vertices");
         glBindBuffer(GL_ARRAY_BUFFER, vbo_);
         glBufferData(
             GL_ARRAY_BUFFER,
             vertices.size() * sizeof(Vertex),
             vertices.data(),
             GL_STATIC_DRAW);
+        vbo_.SetBytes(vertices.size() * sizeof(Vertex));
 
         GLintptr vertex_normal_offset = 3 * sizeof(float);
         GLintptr vertex_tex_offset = 6 * sizeof(float);
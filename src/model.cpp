@@ -1,30 +1,153 @@
 #include "model.h"
 
 #include "shader.h"
+#include "transform_hierarchy.h"
+#include "vfs.h"
+#include <algorithm>
+#include <filesystem>
+#include <istream>
+#include <streambuf>
+#include <string_view>
 #include <glm/ext/matrix_transform.hpp>
 
 namespace gl {
-	Model::Model(const std::string& filename)
+	namespace {
+		// Grid cells per axis used to simplify occluders.
+		constexpr unsigned int kOccluderResolution = 16;
+
+		// The material library an obj names ("mtllib file"), empty when
+		// it names none.
+		std::string FindMaterialLibrary(std::string_view obj)
+		{
+			constexpr std::string_view kWhitespace = " \t\r";
+			while (!obj.empty())
+			{
+				const std::size_t end = std::min(obj.find('\n'), obj.size());
+				std::string_view line = obj.substr(0, end);
+				obj.remove_prefix(std::min(end + 1, obj.size()));
+				line.remove_prefix(std::min(line.find_first_not_of(kWhitespace), line.size()));
+				if (!line.starts_with("mtllib ")) continue;
+				line.remove_prefix(std::string_view("mtllib ").size());
+				line.remove_prefix(std::min(line.find_first_not_of(kWhitespace), line.size()));
+				line = line.substr(0, line.find_last_not_of(kWhitespace) + 1);
+				return std::string(line);
+			}
+			return {};
+		}
+
+		// A read only std::istream source over text, which stays where it
+		// is: tinyobj parses streams, and this one is the mapped pack.
+		class TextStreamBuffer : public std::streambuf
+		{
+		public:
+			explicit TextStreamBuffer(std::string_view text)
+			{
+				// The get area is never written through.
+				char* begin = const_cast<char*>(text.data());
+				setg(begin, begin, begin + text.size());
+			}
+		};
+	}
+
+	Model::Model(const std::string& filename, bool occluder) :
+		Model(Load(filename, occluder))
 	{
-		tinyobj::ObjReader reader;
-		if (!reader.ParseFromFile(filename))
+	}
+
+	Model::Model(ModelData data) :
+		_occluder(data.occluder),
+		_occluder_mesh(std::move(data.occluder_mesh))
+	{
+		for (const auto& material : data.materials)
+		{
+			Material mat{};
+			mat.color = Texture(material.color);
+			mat.normal = Texture(material.normal);
+			mat.specular_pow = material.specular_pow;
+			mat.specular_vec = material.specular_vec;
+			materials.push_back(std::move(mat));
+		}
+		for (const auto& mesh : data.meshes)
+		{
+			meshes.emplace_back(mesh.vertices, mesh.indices, mesh.material_id);
+		}
+	}
+
+	ModelData Model::Load(const std::string& filename, bool occluder)
+	{
+		// Through the Vfs: tinyobj parses the obj and the material library
+		// it names, next to it, in place. Stored pack entries are views of
+		// the mapping, so nothing is copied before the parse.
+		const VfsFile obj = Vfs::Read(filename);
+		if (!obj.IsValid())
 		{
 			throw std::runtime_error("Cannot load file: " + filename);
 		}
-		auto& attrib = reader.GetAttrib();
-		auto& shapes = reader.GetShapes();
-		auto& materials = reader.GetMaterials();
+		VfsFile mtl;
+		const std::string library = FindMaterialLibrary(obj.GetText());
+		if (!library.empty())
+		{
+			mtl = Vfs::Read(
+				(std::filesystem::path(filename).parent_path() / library).generic_string());
+		}
+		TextStreamBuffer objBuffer(obj.GetText());
+		std::istream objStream(&objBuffer);
+		TextStreamBuffer mtlBuffer(mtl.GetText());
+		std::istream mtlStream(&mtlBuffer);
+		tinyobj::MaterialStreamReader materialReader(mtlStream);
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning;
+		std::string error;
+		if (!tinyobj::LoadObj(
+			&attrib,
+			&shapes,
+			&materials,
+			&warning,
+			&error,
+			&objStream,
+			mtl.IsValid() ? &materialReader : nullptr))
+		{
+			throw std::runtime_error("Cannot load file: " + filename + " " + error);
+		}
+		ModelData data;
+		data.occluder = occluder;
 		for (const auto& material : materials)
 		{
-			ParseMaterial(material);
+			data.materials.push_back(ParseMaterial(material));
 		}
 		for (const auto& shape : shapes)
 		{
-			ParseMesh(shape, attrib);
+			auto& mesh = data.meshes.emplace_back();
+			BuildVertices(shape, attrib, mesh.vertices, mesh.indices);
+			mesh.material_id = shape.mesh.material_ids[0];
 		}
+		if (occluder)
+		{
+			// Shared obj positions, so clustering can merge across faces.
+			std::vector<glm::vec3> positions(attrib.vertices.size() / 3);
+			for (std::size_t i = 0; i < positions.size(); ++i)
+			{
+				positions[i] = glm::vec3(
+					attrib.vertices[3 * i + 0],
+					attrib.vertices[3 * i + 1],
+					attrib.vertices[3 * i + 2]);
+			}
+			std::vector<std::uint32_t> indices;
+			for (const auto& shape : shapes)
+			{
+				for (const auto& index : shape.mesh.indices)
+				{
+					indices.push_back(static_cast<std::uint32_t>(index.vertex_index));
+				}
+			}
+			data.occluder_mesh = SimplifyOccluder(positions, indices, kOccluderResolution);
+		}
+		return data;
 	}
 
-	Mesh Model::GetMesh(unsigned i)
+	const Mesh& Model::GetMesh(unsigned i) const
 	{
 		return meshes[i];
 	}
@@ -60,25 +183,71 @@ namespace gl {
 	{
 		_model = glm::mat4(1.0f);
 		_model = glm::translate(_model, position);
-		_inv_model = glm::transpose(glm::inverse(_model));
+		_inv_model = glm::mat4(ComputeNormalMatrix(_model));
+	}
+
+	void Model::SetModelMatrix(const glm::mat4& model)
+	{
+		_model = model;
+		_inv_model = glm::mat4(ComputeNormalMatrix(_model));
+	}
+
+	void Model::SetModelMatrix(const glm::mat4& model, const glm::mat3& normal)
+	{
+		_model = model;
+		_inv_model = glm::mat4(normal);
+	}
+
+	Aabb Model::GetBounds() const
+	{
+		if (meshes.empty()) return Aabb{};
+		Aabb bounds{ meshes[0].bounds_min_, meshes[0].bounds_max_ };
+		for (const auto& mesh : meshes)
+		{
+			bounds = Aabb::Union(bounds, Aabb{ mesh.bounds_min_, mesh.bounds_max_ });
+		}
+		return bounds;
+	}
+
+	Aabb Model::GetWorldBounds() const
+	{
+		return GetBounds().Transform(_model);
+	}
+
+	bool Model::IsOccluder() const
+	{
+		return _occluder;
+	}
+
+	const OccluderMesh& Model::GetOccluderMesh() const
+	{
+		return _occluder_mesh;
+	}
+
+	const glm::mat4& Model::GetModelMatrix() const
+	{
+		return _model;
 	}
 
-	void Model::ParseMaterial(const tinyobj::material_t& material)
+	ModelData::MaterialData Model::ParseMaterial(const tinyobj::material_t& material)
 	{
-		Material mat{};
-		std::string path = "../data/textures/";
-		mat.color = Texture(path + material.diffuse_texname);
-		mat.normal = Texture(path + material.bump_texname);
+		ModelData::MaterialData mat;
+		std::string path = "textures/";
+		mat.color = TextureImage::Load(path + material.diffuse_texname);
+		mat.normal = TextureImage::Load(path + material.bump_texname);
 		mat.specular_pow = material.shininess;
 		mat.specular_vec = glm::vec3(material.specular[0], material.specular[1], material.specular[2]);
-		materials.push_back(mat);
+		return mat;
 	}
 
-	void Model::ParseMesh(const tinyobj::shape_t& shape, const tinyobj::attrib_t& attrib)
+	void Model::BuildVertices(
+		const tinyobj::shape_t& shape,
+		const tinyobj::attrib_t& attrib,
+		std::vector<Vertex>& vertices,
+		std::vector<std::uint32_t>& indices)
 	{
-		unsigned int material_id = 0;
-		std::vector<Vertex> vertices;
-		std::vector<std::uint32_t> indices;
+		vertices.clear();
+		indices.clear();
 		int index_offset = 0;
 		for (std::size_t f = 0; f < shape.mesh.num_face_vertices.size(); ++f)
 		{
@@ -140,9 +309,6 @@ namespace gl {
 
 			index_offset += fv;
 		}
-		material_id = shape.mesh.material_ids[0];
 		assert(index_offset == indices.size());
-		// give textures / load texture
-		meshes.emplace_back(vertices, indices, material_id);
 	}
 }
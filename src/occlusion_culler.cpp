@@ -0,0 +1,363 @@
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gl {
+
+	namespace {
+
+		// Vertices closer than this (clip w) are behind the camera for our
+		// purpose. Occluder triangles touching it are dropped, which only
+		// makes the culling less aggressive.
+		constexpr float kNearW = 1e-3f;
+		// Rows rasterized by one job.
+		constexpr std::size_t kBandHeight = 16;
+
+		// Edge function of a -> b: positive on the left side.
+		glm::vec3 MakeEdge(const glm::vec2& a, const glm::vec2& b)
+		{
+			const float edgeA = a.y - b.y;
+			const float edgeB = b.x - a.x;
+			return glm::vec3(edgeA, edgeB, -(edgeA * a.x + edgeB * a.y));
+		}
+
+	} // namespace
+
+	OccluderMesh SimplifyOccluder(
+		const std::vector<glm::vec3>& positions,
+		const std::vector<std::uint32_t>& indices,
+		unsigned int resolution)
+	{
+		OccluderMesh simplified;
+		if (positions.empty() || resolution == 0) return simplified;
+
+		glm::vec3 minimum = positions[0];
+		glm::vec3 maximum = positions[0];
+		for (const auto& position : positions)
+		{
+			minimum = glm::min(minimum, position);
+			maximum = glm::max(maximum, position);
+		}
+		const glm::vec3 cellSize = glm::max(
+			(maximum - minimum) / static_cast<float>(resolution),
+			glm::vec3(1e-6f));
+
+		// The first vertex of each cell represents it.
+		std::unordered_map<std::uint64_t, std::uint32_t> cells;
+		std::vector<std::uint32_t> remap(positions.size());
+		for (std::size_t i = 0; i < positions.size(); ++i)
+		{
+			const glm::vec3 cell = glm::min(
+				glm::floor((positions[i] - minimum) / cellSize),
+				glm::vec3(static_cast<float>(resolution - 1)));
+			const std::uint64_t key =
+				(static_cast<std::uint64_t>(cell.x) << 42) |
+				(static_cast<std::uint64_t>(cell.y) << 21) |
+				static_cast<std::uint64_t>(cell.z);
+			const auto [it, inserted] = cells.emplace(
+				key,
+				static_cast<std::uint32_t>(simplified.positions.size()));
+			if (inserted)
+			{
+				simplified.positions.push_back(positions[i]);
+			}
+			remap[i] = it->second;
+		}
+		for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const std::uint32_t a = remap[indices[i]];
+			const std::uint32_t b = remap[indices[i + 1]];
+			const std::uint32_t c = remap[indices[i + 2]];
+			if (a == b || b == c || c == a) continue;
+			simplified.indices.insert(simplified.indices.end(), { a, b, c });
+		}
+		return simplified;
+	}
+
+	OcclusionCuller::OcclusionCuller(
+		unsigned int width,
+		unsigned int height,
+		JobSystem* jobSystem) :
+		// Rows are processed 8 pixels at a time.
+		width_(std::max(8u, (width + 7) & ~7u)),
+		height_(std::max(1u, height)),
+		jobSystem_(jobSystem)
+	{
+		glm::uvec2 size(width_, height_);
+		for (;;)
+		{
+			levelSizes_.push_back(size);
+			levels_.emplace_back(static_cast<std::size_t>(size.x) * size.y, 0.0f);
+			if (size.x == 1 && size.y == 1) break;
+			size = glm::uvec2(std::max(1u, size.x / 2), std::max(1u, size.y / 2));
+		}
+	}
+
+	void OcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+	{
+		viewProjection_ = viewProjection;
+		occluders_.clear();
+	}
+
+	void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const glm::mat4& model)
+	{
+		occluders_.push_back({ &mesh, model });
+	}
+
+	void OcclusionCuller::Rasterize()
+	{
+		GPR5300_PROFILE_ZONE("Occluder raster");
+		const auto start = std::chrono::steady_clock::now();
+		std::fill(levels_[0].begin(), levels_[0].end(), 0.0f);
+		SetupTriangles();
+		if (jobSystem_ != nullptr)
+		{
+			jobSystem_->ParallelFor(
+				height_,
+				kBandHeight,
+				[this](std::size_t begin, std::size_t end) { RasterizeRows(begin, end); });
+		}
+		else
+		{
+			RasterizeRows(0, height_);
+		}
+		BuildHierarchy();
+		rasterMilliseconds_ = std::chrono::duration<float, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	void OcclusionCuller::SetupTriangles()
+	{
+		triangles_.clear();
+		const glm::vec2 screen(static_cast<float>(width_), static_cast<float>(height_));
+		for (const auto& occluder : occluders_)
+		{
+			const glm::mat4 modelViewProjection = viewProjection_ * occluder.model;
+			const auto& positions = occluder.mesh->positions;
+			clipPositions_.resize(positions.size());
+			for (std::size_t i = 0; i < positions.size(); ++i)
+			{
+				clipPositions_[i] = modelViewProjection * glm::vec4(positions[i], 1.0f);
+			}
+
+			const auto& indices = occluder.mesh->indices;
+			for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				std::array<glm::vec2, 3> pixel;
+				std::array<float, 3> inverseW;
+				bool behind = false;
+				for (int v = 0; v < 3; ++v)
+				{
+					const glm::vec4& clip = clipPositions_[indices[i + v]];
+					if (clip.w < kNearW)
+					{
+						behind = true;
+						break;
+					}
+					inverseW[v] = 1.0f / clip.w;
+					pixel[v] = (glm::vec2(clip.x, clip.y) * inverseW[v] * 0.5f + glm::vec2(0.5f)) * screen;
+				}
+				if (behind) continue;
+
+				float area =
+					(pixel[1].x - pixel[0].x) * (pixel[2].y - pixel[0].y) -
+					(pixel[2].x - pixel[0].x) * (pixel[1].y - pixel[0].y);
+				if (std::abs(area) < 1e-8f) continue;
+				// Occluders are two sided: make every triangle counter clockwise.
+				if (area < 0.0f)
+				{
+					std::swap(pixel[1], pixel[2]);
+					std::swap(inverseW[1], inverseW[2]);
+					area = -area;
+				}
+
+				Triangle triangle;
+				// Pixel centers (x + 0.5, y + 0.5) inside the bounds.
+				const glm::vec2 low = glm::min(glm::min(pixel[0], pixel[1]), pixel[2]);
+				const glm::vec2 high = glm::max(glm::max(pixel[0], pixel[1]), pixel[2]);
+				triangle.minX = std::max(0, static_cast<int>(std::ceil(low.x - 0.5f)));
+				triangle.minY = std::max(0, static_cast<int>(std::ceil(low.y - 0.5f)));
+				triangle.maxX = std::min(static_cast<int>(width_) - 1, static_cast<int>(std::floor(high.x - 0.5f)));
+				triangle.maxY = std::min(static_cast<int>(height_) - 1, static_cast<int>(std::floor(high.y - 0.5f)));
+				if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;
+
+				// Edge i is opposite to vertex i, so e_i / area is its
+				// barycentric weight.
+				const glm::vec3 edge0 = MakeEdge(pixel[1], pixel[2]);
+				const glm::vec3 edge1 = MakeEdge(pixel[2], pixel[0]);
+				const glm::vec3 edge2 = MakeEdge(pixel[0], pixel[1]);
+				triangle.edgeA = glm::vec3(edge0.x, edge1.x, edge2.x);
+				triangle.edgeB = glm::vec3(edge0.y, edge1.y, edge2.y);
+				triangle.edgeC = glm::vec3(edge0.z, edge1.z, edge2.z);
+				const glm::vec3 depth = glm::vec3(inverseW[0], inverseW[1], inverseW[2]) / area;
+				triangle.depthA = glm::dot(triangle.edgeA, depth);
+				triangle.depthB = glm::dot(triangle.edgeB, depth);
+				triangle.depthC = glm::dot(triangle.edgeC, depth);
+				triangles_.push_back(triangle);
+			}
+		}
+	}
+
+	void OcclusionCuller::RasterizeRows(std::size_t rowBegin, std::size_t rowEnd)
+	{
+		float* depth = levels_[0].data();
+		for (const auto& triangle : triangles_)
+		{
+			const int minY = std::max(triangle.minY, static_cast<int>(rowBegin));
+			const int maxY = std::min(triangle.maxY, static_cast<int>(rowEnd) - 1);
+			if (minY > maxY) continue;
+			// Start on a multiple of 8 so every step stays inside the row.
+			const int minX = triangle.minX & ~7;
+
+			for (int y = minY; y <= maxY; ++y)
+			{
+				const float centerY = static_cast<float>(y) + 0.5f;
+				float* row = depth + static_cast<std::size_t>(y) * width_;
+				int x = minX;
+#if defined(__AVX2__)
+				const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+				const __m256 step0 = _mm256_set1_ps(triangle.edgeA.x);
+				const __m256 step1 = _mm256_set1_ps(triangle.edgeA.y);
+				const __m256 step2 = _mm256_set1_ps(triangle.edgeA.z);
+				const __m256 stepDepth = _mm256_set1_ps(triangle.depthA);
+				const __m256 zero = _mm256_setzero_ps();
+				for (; x <= triangle.maxX; x += 8)
+				{
+					const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), offsets);
+					const __m256 e0 = _mm256_fmadd_ps(step0, centerX, _mm256_set1_ps(triangle.edgeB.x * centerY + triangle.edgeC.x));
+					const __m256 e1 = _mm256_fmadd_ps(step1, centerX, _mm256_set1_ps(triangle.edgeB.y * centerY + triangle.edgeC.y));
+					const __m256 e2 = _mm256_fmadd_ps(step2, centerX, _mm256_set1_ps(triangle.edgeB.z * centerY + triangle.edgeC.z));
+					// Inside when no edge function is negative.
+					const __m256 inside = _mm256_cmp_ps(
+						_mm256_min_ps(e0, _mm256_min_ps(e1, e2)), zero, _CMP_GE_OQ);
+					if (_mm256_movemask_ps(inside) == 0) continue;
+					const __m256 z = _mm256_fmadd_ps(
+						stepDepth,
+						centerX,
+						_mm256_set1_ps(triangle.depthB * centerY + triangle.depthC));
+					const __m256 current = _mm256_loadu_ps(row + x);
+					_mm256_storeu_ps(
+						row + x,
+						_mm256_blendv_ps(current, _mm256_max_ps(current, z), inside));
+				}
+#else
+				for (; x <= triangle.maxX; ++x)
+				{
+					const float centerX = static_cast<float>(x) + 0.5f;
+					const glm::vec3 e = triangle.edgeA * centerX + triangle.edgeB * centerY + triangle.edgeC;
+					if (e.x < 0.0f || e.y < 0.0f || e.z < 0.0f) continue;
+					const float z = triangle.depthA * centerX + triangle.depthB * centerY + triangle.depthC;
+					row[x] = std::max(row[x], z);
+				}
+#endif
+			}
+		}
+	}
+
+	void OcclusionCuller::BuildHierarchy()
+	{
+		for (std::size_t level = 1; level < levels_.size(); ++level)
+		{
+			const glm::uvec2 source = levelSizes_[level - 1];
+			const glm::uvec2 size = levelSizes_[level];
+			const std::vector<float>& fine = levels_[level - 1];
+			std::vector<float>& coarse = levels_[level];
+			for (unsigned int y = 0; y < size.y; ++y)
+			{
+				// Odd sizes fold their last row/column into the last texel.
+				const unsigned int y0 = y * 2;
+				const unsigned int y1 = (y + 1 == size.y) ? source.y : std::min(source.y, y0 + 2);
+				for (unsigned int x = 0; x < size.x; ++x)
+				{
+					const unsigned int x0 = x * 2;
+					const unsigned int x1 = (x + 1 == size.x) ? source.x : std::min(source.x, x0 + 2);
+					float farthest = fine[static_cast<std::size_t>(y0) * source.x + x0];
+					for (unsigned int sy = y0; sy < y1; ++sy)
+					{
+						for (unsigned int sx = x0; sx < x1; ++sx)
+						{
+							farthest = std::min(farthest, fine[static_cast<std::size_t>(sy) * source.x + sx]);
+						}
+					}
+					coarse[static_cast<std::size_t>(y) * size.x + x] = farthest;
+				}
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsVisible(const Aabb& box) const
+	{
+		const glm::vec2 screen(static_cast<float>(width_), static_cast<float>(height_));
+		glm::vec2 low(std::numeric_limits<float>::max());
+		glm::vec2 high(std::numeric_limits<float>::lowest());
+		float nearest = 0.0f;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 position(
+				(corner & 1) ? box.max.x : box.min.x,
+				(corner & 2) ? box.max.y : box.min.y,
+				(corner & 4) ? box.max.z : box.min.z);
+			const glm::vec4 clip = viewProjection_ * glm::vec4(position, 1.0f);
+			if (clip.w < kNearW) return true;
+			const float inverseW = 1.0f / clip.w;
+			const glm::vec2 pixel = (glm::vec2(clip.x, clip.y) * inverseW * 0.5f + glm::vec2(0.5f)) * screen;
+			low = glm::min(low, pixel);
+			high = glm::max(high, pixel);
+			nearest = std::max(nearest, inverseW);
+		}
+		if (high.x < 0.0f || high.y < 0.0f || low.x >= screen.x || low.y >= screen.y)
+		{
+			return true;
+		}
+
+		// Every pixel the rectangle touches.
+		int x0 = std::max(0, static_cast<int>(std::floor(low.x)));
+		int y0 = std::max(0, static_cast<int>(std::floor(low.y)));
+		int x1 = std::min(static_cast<int>(width_) - 1, static_cast<int>(std::floor(high.x)));
+		int y1 = std::min(static_cast<int>(height_) - 1, static_cast<int>(std::floor(high.y)));
+
+		// Coarsest level where the rectangle spans at most 2x2 texels.
+		std::size_t level = 0;
+		while (level + 1 < levels_.size() && ((x1 - x0) > 1 || (y1 - y0) > 1))
+		{
+			++level;
+			x0 >>= 1;
+			y0 >>= 1;
+			x1 >>= 1;
+			y1 >>= 1;
+		}
+		const glm::uvec2 size = levelSizes_[level];
+		// Odd sizes fold their last pixels into the last texel.
+		x0 = std::min(x0, static_cast<int>(size.x) - 1);
+		y0 = std::min(y0, static_cast<int>(size.y) - 1);
+		x1 = std::min(x1, static_cast<int>(size.x) - 1);
+		y1 = std::min(y1, static_cast<int>(size.y) - 1);
+		const std::vector<float>& depth = levels_[level];
+		for (int y = y0; y <= y1; ++y)
+		{
+			for (int x = x0; x <= x1; ++x)
+			{
+				// The box comes in front of the farthest occluder here.
+				if (nearest >= depth[static_cast<std::size_t>(y) * size.x + x]) return true;
+			}
+		}
+		return false;
+	}
+
+	bool OcclusionCuller::IsSphereVisible(const glm::vec3& center, float radius) const
+	{
+		return IsVisible(Aabb::FromSphere(center, radius));
+	}
+
+} // End namespace gl.
@@ -1,43 +1,326 @@
 #include "particle.h"
 
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace gl
 {
-	//Ask
-	/*ParticleGenerator::ParticleGenerator(Shader shader, Texture texture, unsigned int amount) :
-		shader(shader), texture(texture), amount(amount)
+	void ParticleSoA::Reserve(std::size_t capacity)
 	{
-		this->Init();
-	}*/
+		for (auto* array : { &positionX, &positionY, &velocityX, &velocityY, &alpha, &life })
+		{
+			array->resize(capacity, 0.0f);
+		}
+		color.resize(capacity, 0);
+		count = std::min(count, capacity);
+	}
 
-	void ParticleGenerator::Update(float dt, GameObject& object, unsigned int newParticles, glm::vec2 offset)
+	void AdvanceParticles(ParticleSoA& particles, std::size_t begin, std::size_t end, float dt)
 	{
-		//add new particles
-		for (unsigned int i = 0; i < newParticles; i++)
-		{
-			// FirstUnusedParticles tries to find the first particle
-			//that is dead and returns its index to the caller
-			int unusedParticle = this->FirstUnusedParticle();
-			this->RespawnParticle(this->particles[unusedParticle], object, offset);
+		float* positionX = particles.positionX.data();
+		float* positionY = particles.positionY.data();
+		const float* velocityX = particles.velocityX.data();
+		const float* velocityY = particles.velocityY.data();
+		float* alpha = particles.alpha.data();
+		float* life = particles.life.data();
+		const float fade = dt * 2.5f;
 
+		std::size_t i = begin;
+#if defined(__AVX2__)
+		const __m256 dt8 = _mm256_set1_ps(dt);
+		const __m256 fade8 = _mm256_set1_ps(fade);
+		for (; i + 8 <= end; i += 8)
+		{
+			_mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), dt8));
+			_mm256_storeu_ps(alpha + i, _mm256_sub_ps(_mm256_loadu_ps(alpha + i), fade8));
+			_mm256_storeu_ps(positionX + i, _mm256_fnmadd_ps(
+				_mm256_loadu_ps(velocityX + i), dt8, _mm256_loadu_ps(positionX + i)));
+			_mm256_storeu_ps(positionY + i, _mm256_fnmadd_ps(
+				_mm256_loadu_ps(velocityY + i), dt8, _mm256_loadu_ps(positionY + i)));
 		}
+#endif
+		for (; i < end; ++i)
+		{
+			life[i] -= dt;
+			alpha[i] -= fade;
+			positionX[i] -= velocityX[i] * dt;
+			positionY[i] -= velocityY[i] * dt;
+		}
+	}
 
-		//update all particles
-		for (unsigned int i = 0; i < this->amount; i++)
+	std::size_t RemoveDeadParticles(ParticleSoA& particles)
+	{
+		const std::size_t before = particles.count;
+		std::size_t count = before;
+		std::size_t i = 0;
+		while (i < count)
 		{
-			Particle& p = this->particles[i];
-			p.life -= dt; // reduce particle life
-			if (p.life > 0.0f)
+#if defined(__AVX2__)
+			// Skip runs of 8 live particles without touching the other arrays.
+			const __m256 zero = _mm256_setzero_ps();
+			while (i + 8 <= count &&
+				_mm256_movemask_ps(_mm256_cmp_ps(
+					_mm256_loadu_ps(particles.life.data() + i), zero, _CMP_LE_OQ)) == 0)
 			{
-				// particle is alive : update
-				p.position -= p.velocity * dt;
-				p.color.a -= dt * 2.5f;
+				i += 8;
 			}
+			if (i >= count) break;
+#endif
+			if (particles.life[i] > 0.0f)
+			{
+				++i;
+				continue;
+			}
+			// Move the last live particle into the hole; it is tested on
+			// the next iteration.
+			--count;
+			particles.positionX[i] = particles.positionX[count];
+			particles.positionY[i] = particles.positionY[count];
+			particles.velocityX[i] = particles.velocityX[count];
+			particles.velocityY[i] = particles.velocityY[count];
+			particles.alpha[i] = particles.alpha[count];
+			particles.life[i] = particles.life[count];
+			particles.color[i] = particles.color[count];
+		}
+		particles.count = count;
+		return before - count;
+	}
+
+	std::size_t EmitParticles(
+		ParticleSoA& particles,
+		std::size_t amount,
+		glm::vec2 origin,
+		glm::vec2 velocity,
+		FastRandom& random)
+	{
+		const std::size_t begin = particles.count;
+		const std::size_t end = std::min(begin + amount, particles.Capacity());
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const float offset = random.NextFloat(-5.0f, 5.0f);
+			const float grey = std::min(0.5f + random.NextFloat(), 1.0f);
+			const auto channel = static_cast<std::uint32_t>(grey * 255.0f);
+			particles.positionX[i] = origin.x + offset;
+			particles.positionY[i] = origin.y + offset;
+			particles.velocityX[i] = velocity.x;
+			particles.velocityY[i] = velocity.y;
+			particles.alpha[i] = 1.0f;
+			particles.life[i] = 1.0f;
+			particles.color[i] = channel | (channel << 8) | (channel << 16);
+		}
+		particles.count = end;
+		return end - begin;
+	}
+
+	void WriteParticleInstances(
+		const ParticleSoA& particles,
+		std::size_t begin,
+		std::size_t end,
+		ParticleInstance* out)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const float alpha = std::clamp(particles.alpha[i], 0.0f, 1.0f);
+			ParticleInstance& instance = out[i - begin];
+			instance.position = glm::vec2(particles.positionX[i], particles.positionY[i]);
+			instance.color =
+				particles.color[i] | (static_cast<std::uint32_t>(alpha * 255.0f) << 24);
+		}
+	}
+
+	void WriteSortedParticleInstances(
+		const ParticleSoA& particles,
+		const std::uint32_t* order,
+		std::size_t begin,
+		std::size_t end,
+		ParticleInstance* out)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const std::uint32_t index = order[i];
+			const float alpha = std::clamp(particles.alpha[index], 0.0f, 1.0f);
+			ParticleInstance& instance = out[i - begin];
+			instance.position = glm::vec2(particles.positionX[index], particles.positionY[index]);
+			instance.color =
+				particles.color[index] | (static_cast<std::uint32_t>(alpha * 255.0f) << 24);
+		}
+	}
+
+	void WriteParticleSortKeys(
+		const ParticleSoA& particles,
+		std::size_t begin,
+		std::size_t end,
+		std::uint32_t* keys)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			keys[i] = FloatToSortableKey(particles.life[i]);
 		}
 	}
 
+	void CreateParticleVertexArray(GLuint instanceBuffer, GlVertexArray& vao, GlBuffer& quadBuffer)
+	{
+		// xy position, zw texture coordinates.
+		const float quad[] = {
+			0.0f, 1.0f, 0.0f, 1.0f,
+			1.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 0.0f,
+
+			0.0f, 1.0f, 0.0f, 1.0f,
+			1.0f, 1.0f, 1.0f, 1.0f,
+			1.0f, 0.0f, 1.0f, 0.0f
+		};
+		vao = GlVertexArray::Create("Particle quad");
+		quadBuffer = GlBuffer::Create("Particle quad");
+		glBindVertexArray(vao);
+
+		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+		quadBuffer.SetBytes(sizeof(quad));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(
+			1, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance),
+			(void*)offsetof(ParticleInstance, position));
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(
+			2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleInstance),
+			(void*)offsetof(ParticleInstance, color));
+		glVertexAttribDivisor(2, 1);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	ParticleGenerator::ParticleGenerator(
+		std::shared_ptr<Shader> shader,
+		std::shared_ptr<Texture> texture,
+		unsigned int amount,
+		JobSystem* jobSystem) :
+		jobSystem_(jobSystem),
+		sorter_(jobSystem),
+		shader_(std::move(shader)),
+		texture_(std::move(texture))
+	{
+		particles_.Reserve(amount);
+		Init();
+	}
+
+	void ParticleGenerator::Init()
+	{
+		instanceVBO_ = GlBuffer::Create("Particle instances");
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			particles_.Capacity() * sizeof(ParticleInstance),
+			nullptr,
+			GL_STREAM_DRAW);
+		instanceVBO_.SetBytes(particles_.Capacity() * sizeof(ParticleInstance));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		CreateParticleVertexArray(instanceVBO_, VAO_, quadVBO_);
+	}
+
+	void ParticleGenerator::ForEachChunk(std::size_t count, const JobSystem::RangeFunction& func)
+	{
+		if (jobSystem_ != nullptr)
+		{
+			jobSystem_->ParallelFor(count, kParticleChunkSize, func);
+			return;
+		}
+		for (std::size_t begin = 0; begin < count; begin += kParticleChunkSize)
+		{
+			func(begin, std::min(begin + kParticleChunkSize, count));
+		}
+	}
+
+	void ParticleGenerator::Update(float dt, glm::vec2 origin, glm::vec2 velocity, unsigned int newParticles)
+	{
+		GPR5300_PROFILE_ZONE("Particle update");
+		//update all particles
+		ForEachChunk(particles_.count, [&](std::size_t begin, std::size_t end)
+			{
+				AdvanceParticles(particles_, begin, end, dt);
+			});
+		RemoveDeadParticles(particles_);
+
+		//add new particles
+		EmitParticles(
+			particles_,
+			newParticles,
+			origin,
+			velocity,
+			random_);
+	}
+
 	//render all particles
 	void ParticleGenerator::Draw()
 	{
+		GPR5300_PROFILE_ZONE("Particle draw");
+		const std::size_t count = particles_.count;
+		if (count == 0) return;
+
+		const bool sorted = blend_ == ParticleBlend::AlphaSorted;
+		if (sorted)
+		{
+			sortKeys_.resize(count);
+			ForEachChunk(count, [&](std::size_t begin, std::size_t end)
+				{
+					WriteParticleSortKeys(particles_, begin, end, sortKeys_.data());
+				});
+			sorter_.SortIndices(sortKeys_, sortOrder_);
+		}
+
+		// Invalidating the whole buffer lets the driver hand out fresh
+		// storage instead of waiting for last frame's draw.
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+		void* mapped = glMapBufferRange(
+			GL_ARRAY_BUFFER,
+			0,
+			count * sizeof(ParticleInstance),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped == nullptr)
+		{
+			std::cerr << "[Error] Unable to map particle buffer\n";
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return;
+		}
+		auto* instances = static_cast<ParticleInstance*>(mapped);
+		ForEachChunk(count, [&](std::size_t begin, std::size_t end)
+			{
+				if (sorted)
+				{
+					WriteSortedParticleInstances(
+						particles_, sortOrder_.data(), begin, end, instances + begin);
+				}
+				else
+				{
+					WriteParticleInstances(particles_, begin, end, instances + begin);
+				}
+			});
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+		// additive blending gives a 'glow' effect, sorted particles are
+		// blended over each other
+		glBlendFunc(GL_SRC_ALPHA, sorted ? GL_ONE_MINUS_SRC_ALPHA : GL_ONE);
+		shader_->Use();
+		texture_->Bind(0);
+		shader_->SetInt("sprite", 0);
+		glBindVertexArray(VAO_);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(count));
+		glBindVertexArray(0);
+		// don't forget to reset to default blending mode
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,486 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <glad/glad.h>
+
+#include "allocation_tracker.h"
+#include "gl_timer_query.h"
+#include "imgui.h"
+
+namespace gl {
+
+	namespace {
+
+		thread_local void* currentThreadProfile = nullptr;
+
+		double ToMilliseconds(std::uint64_t nanoseconds)
+		{
+			return static_cast<double>(nanoseconds) / 1e6;
+		}
+
+		// Stable color per zone name.
+		ImU32 ZoneColor(const char* name)
+		{
+			std::uint32_t hash = 2166136261u;
+			for (const char* c = name; *c != '\0'; ++c)
+			{
+				hash = (hash ^ static_cast<std::uint8_t>(*c)) * 16777619u;
+			}
+			return IM_COL32(
+				80 + (hash & 0x7F),
+				80 + ((hash >> 8) & 0x7F),
+				80 + ((hash >> 16) & 0x7F),
+				255);
+		}
+
+	} // namespace
+
+	Profiler& Profiler::Get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	Profiler::Profiler() :
+		epoch_(std::chrono::steady_clock::now())
+	{
+	}
+
+	std::uint64_t Profiler::Now() const
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch_).count());
+	}
+
+	Profiler::ThreadProfile& Profiler::GetThreadProfile()
+	{
+		if (currentThreadProfile == nullptr)
+		{
+			auto profile = std::make_unique<ThreadProfile>();
+			std::lock_guard<std::mutex> lock(mutex_);
+			profile->id = static_cast<std::uint32_t>(threads_.size());
+			profile->name = "Thread " + std::to_string(profile->id);
+			currentThreadProfile = profile.get();
+			threads_.push_back(std::move(profile));
+		}
+		return *static_cast<ThreadProfile*>(currentThreadProfile);
+	}
+
+	void Profiler::SetThreadName(std::string name)
+	{
+		ThreadProfile& profile = GetThreadProfile();
+		std::lock_guard<std::mutex> lock(mutex_);
+		profile.name = std::move(name);
+	}
+
+	const char* Profiler::Intern(std::string_view name)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return internedNames_.emplace(name).first->c_str();
+	}
+
+	void Profiler::BeginZone()
+	{
+		++GetThreadProfile().depth;
+	}
+
+	void Profiler::EndZone(const char* name, std::uint64_t start)
+	{
+		ThreadProfile& profile = GetThreadProfile();
+		--profile.depth;
+		const std::uint64_t head = profile.head.load(std::memory_order_relaxed);
+		if (head - profile.tail.load(std::memory_order_acquire) == kEventsPerThread)
+		{
+			// Nobody drained the ring (no EndFrame): lose the newest zones.
+			profile.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		profile.events[head % kEventsPerThread] = { name, start, Now(), profile.depth, profile.id };
+		profile.head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::EndFrame()
+	{
+		Frame frame;
+		frame.start = frameStart_;
+		frame.end = Now();
+		frameStart_ = frame.end;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto& profile : threads_)
+			{
+				std::uint64_t tail = profile->tail.load(std::memory_order_relaxed);
+				const std::uint64_t head = profile->head.load(std::memory_order_acquire);
+				for (; tail != head; ++tail)
+				{
+					frame.events.push_back(profile->events[tail % kEventsPerThread]);
+				}
+				profile->tail.store(tail, std::memory_order_release);
+			}
+		}
+		if (paused_) return;
+
+		AddStats(frame.events, false);
+		frames_.push_back(std::move(frame));
+		if (frames_.size() > kFrameHistory)
+		{
+			frames_.pop_front();
+		}
+	}
+
+	void Profiler::AddStats(const std::vector<ProfileEvent>& events, bool gpu)
+	{
+		std::unordered_map<std::string_view, double> totals;
+		for (const auto& event : events)
+		{
+			totals[event.name] += ToMilliseconds(event.end - event.start);
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (const auto& [name, total] : totals)
+		{
+			auto& stats = zoneStats_[std::string(name)];
+			stats.gpu = gpu;
+			stats.milliseconds.Add(static_cast<float>(total));
+		}
+	}
+
+	void Profiler::BeginGpuFrame()
+	{
+		if (!GlTimerQuery::IsAvailable()) return;
+		// The oldest frame in the ring, recorded kGpuLatency - 1 frames ago.
+		GpuFrame& frame = gpuFrames_[gpuFrameIndex_];
+		if (frame.pending)
+		{
+			CollectGpuFrame(frame);
+		}
+		frame.usedQueries = 0;
+		frame.zones.clear();
+		frame.open.clear();
+		gpuFrameOpen_ = true;
+	}
+
+	void Profiler::EndGpuFrame()
+	{
+		if (!gpuFrameOpen_) return;
+		GpuFrame& frame = gpuFrames_[gpuFrameIndex_];
+		frame.pending = !frame.zones.empty();
+		gpuFrameIndex_ = (gpuFrameIndex_ + 1) % kGpuLatency;
+		gpuFrameOpen_ = false;
+	}
+
+	void Profiler::BeginGpuZone(const char* name)
+	{
+		if (!gpuFrameOpen_) return;
+		GpuFrame& frame = gpuFrames_[gpuFrameIndex_];
+		if (frame.usedQueries == frame.queries.size())
+		{
+			unsigned int query = 0;
+			glGenQueries(1, &query);
+			frame.queries.push_back(query);
+		}
+		const std::size_t startQuery = frame.usedQueries++;
+		GlTimerQuery::QueryCounter(frame.queries[startQuery]);
+		frame.open.push_back(frame.zones.size());
+		frame.zones.push_back({
+			name,
+			static_cast<std::uint32_t>(frame.open.size() - 1),
+			startQuery,
+			SIZE_MAX });
+	}
+
+	void Profiler::EndGpuZone()
+	{
+		if (!gpuFrameOpen_) return;
+		GpuFrame& frame = gpuFrames_[gpuFrameIndex_];
+		if (frame.open.empty()) return;
+		if (frame.usedQueries == frame.queries.size())
+		{
+			unsigned int query = 0;
+			glGenQueries(1, &query);
+			frame.queries.push_back(query);
+		}
+		const std::size_t endQuery = frame.usedQueries++;
+		GlTimerQuery::QueryCounter(frame.queries[endQuery]);
+		frame.zones[frame.open.back()].endQuery = endQuery;
+		frame.open.pop_back();
+	}
+
+	void Profiler::CollectGpuFrame(GpuFrame& frame)
+	{
+		// Runs inside the frame, but it is tooling.
+		const AllocationTracker::IgnoreScope ignoreAllocations;
+		frame.pending = false;
+		// Queries complete in order: if the last one is not there yet, the
+		// GPU is more than kGpuLatency frames behind. Skip the frame
+		// rather than wait for it.
+		GLuint available = 0;
+		glGetQueryObjectuiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		const bool disjoint = GlTimerQuery::IsDisjoint();
+		if (available == 0 || disjoint || paused_) return;
+
+		std::vector<GLuint64> timestamps(frame.usedQueries);
+		for (std::size_t i = 0; i < frame.usedQueries; ++i)
+		{
+			timestamps[i] = GlTimerQuery::GetResult(frame.queries[i]);
+		}
+		const GLuint64 base = *std::min_element(timestamps.begin(), timestamps.end());
+		std::vector<ProfileEvent> events;
+		for (const auto& zone : frame.zones)
+		{
+			if (zone.endQuery == SIZE_MAX) continue;
+			events.push_back({
+				zone.name,
+				timestamps[zone.startQuery] - base,
+				timestamps[zone.endQuery] - base,
+				zone.depth,
+				kGpuThread });
+		}
+		AddStats(events, true);
+		std::lock_guard<std::mutex> lock(mutex_);
+		lastGpuEvents_ = std::move(events);
+	}
+
+	void Profiler::ReleaseGpuQueries()
+	{
+		for (auto& frame : gpuFrames_)
+		{
+			if (!frame.queries.empty())
+			{
+				glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+			}
+			frame = GpuFrame();
+		}
+		gpuFrameOpen_ = false;
+	}
+
+	void Profiler::DrawImGui()
+	{
+		ImGui::Begin("Profiler");
+		bool paused = paused_;
+		if (ImGui::Checkbox("Pause", &paused))
+		{
+			paused_ = paused;
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export Chrome trace"))
+		{
+			exportStatus_ = ExportChromeTrace("profile.json") ?
+				"Wrote profile.json" :
+				"[Error] Could not write profile.json";
+		}
+		if (!exportStatus_.empty())
+		{
+			ImGui::SameLine();
+			ImGui::TextUnformatted(exportStatus_.c_str());
+		}
+		if (frames_.empty())
+		{
+			ImGui::End();
+			return;
+		}
+
+		const int lastFrame = static_cast<int>(frames_.size()) - 1;
+		selectedFrame_ = std::min(selectedFrame_, lastFrame);
+		ImGui::SliderInt("Frames ago", &selectedFrame_, 0, lastFrame);
+		std::vector<ProfileEvent> gpuEvents;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			gpuEvents = lastGpuEvents_;
+		}
+		DrawTimeline(frames_[lastFrame - selectedFrame_], gpuEvents);
+
+		if (ImGui::BeginTable("Zones", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Last ms");
+			ImGui::TableSetupColumn("p50");
+			ImGui::TableSetupColumn("p95");
+			ImGui::TableSetupColumn("p99");
+			ImGui::TableHeadersRow();
+			std::lock_guard<std::mutex> lock(mutex_);
+			std::vector<const std::pair<const std::string, ProfileZoneStats>*> zones;
+			for (const auto& zone : zoneStats_)
+			{
+				zones.push_back(&zone);
+			}
+			std::sort(zones.begin(), zones.end(), [](const auto* a, const auto* b)
+				{
+					return a->first < b->first;
+				});
+			for (const auto* zone : zones)
+			{
+				const FrameTimeHistory& history = zone->second.milliseconds;
+				const auto& samples = history.GetSamples();
+				const float last = samples[(history.GetOffset() + samples.size() - 1) % samples.size()];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s%s", zone->second.gpu ? "[GPU] " : "", zone->first.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", last);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", history.GetPercentile(0.5f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", history.GetPercentile(0.95f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", history.GetPercentile(0.99f));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+
+	void Profiler::DrawTimeline(const Frame& frame, const std::vector<ProfileEvent>& gpuEvents)
+	{
+		constexpr float kLabelWidth = 90.0f;
+		const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+		const double frameNanoseconds = static_cast<double>(std::max<std::uint64_t>(frame.end - frame.start, 1));
+		ImGui::Text("Frame: %.3f ms", ToMilliseconds(frame.end - frame.start));
+
+		// One track per thread that recorded zones in the frame, nested
+		// zones stacked below their parent (flame chart), then the GPU.
+		struct Track
+		{
+			std::uint32_t thread;
+			std::string name;
+			std::uint32_t depth = 0;
+		};
+		std::vector<Track> tracks;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (const auto& profile : threads_)
+			{
+				tracks.push_back({ profile->id, profile->name });
+			}
+		}
+		std::vector<bool> used(tracks.size(), false);
+		for (const auto& event : frame.events)
+		{
+			used[event.thread] = true;
+			tracks[event.thread].depth = std::max(tracks[event.thread].depth, event.depth);
+		}
+		Track gpuTrack{ kGpuThread, "GPU", 0 };
+		for (const auto& event : gpuEvents)
+		{
+			gpuTrack.depth = std::max(gpuTrack.depth, event.depth);
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float width = std::max(ImGui::GetContentRegionAvail().x - kLabelWidth, 50.0f);
+		const ImU32 textColor = IM_COL32(255, 255, 255, 255);
+		float y = origin.y;
+		const auto drawTrack = [&](const Track& track, const std::vector<ProfileEvent>& events, std::uint64_t base)
+			{
+				drawList->AddText(ImVec2(origin.x, y), textColor, track.name.c_str());
+				for (const auto& event : events)
+				{
+					if (event.thread != track.thread) continue;
+					const float x0 = origin.x + kLabelWidth +
+						static_cast<float>((static_cast<double>(event.start) - static_cast<double>(base)) / frameNanoseconds) * width;
+					const float x1 = std::max(x0 + 1.0f, origin.x + kLabelWidth +
+						static_cast<float>((static_cast<double>(event.end) - static_cast<double>(base)) / frameNanoseconds) * width);
+					const float top = y + static_cast<float>(event.depth) * rowHeight;
+					const ImVec2 min(x0, top);
+					const ImVec2 max(x1, top + rowHeight - 1.0f);
+					drawList->AddRectFilled(min, max, ZoneColor(event.name));
+					if (x1 - x0 > 30.0f)
+					{
+						drawList->PushClipRect(min, max, true);
+						drawList->AddText(ImVec2(x0 + 2.0f, top + 2.0f), textColor, event.name);
+						drawList->PopClipRect();
+					}
+					if (ImGui::IsMouseHoveringRect(min, max))
+					{
+						ImGui::SetTooltip("%s: %.3f ms", event.name, ToMilliseconds(event.end - event.start));
+					}
+				}
+				y += static_cast<float>(track.depth + 1) * rowHeight + 4.0f;
+			};
+		for (std::size_t i = 0; i < tracks.size(); ++i)
+		{
+			if (used[i]) drawTrack(tracks[i], frame.events, frame.start);
+		}
+		// The GPU clock is not the CPU one: its zones start at the first
+		// query of their frame, on the same scale.
+		if (!gpuEvents.empty()) drawTrack(gpuTrack, gpuEvents, 0);
+		ImGui::Dummy(ImVec2(width + kLabelWidth, y - origin.y));
+	}
+
+	bool Profiler::ExportChromeTrace(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file) return false;
+
+		const auto escape = [](std::string_view text)
+			{
+				std::string escaped;
+				for (const char c : text)
+				{
+					if (c == '"' || c == '\\') escaped.push_back('\\');
+					escaped.push_back(c);
+				}
+				return escaped;
+			};
+
+		// Times in microseconds. GPU zones of the last read back frame are
+		// put on a track of their own, aligned on the newest frame.
+		file << "{\"traceEvents\":[\n";
+		bool first = true;
+		const auto separator = [&]() -> const char*
+			{
+				const char* text = first ? "" : ",\n";
+				first = false;
+				return text;
+			};
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (const auto& profile : threads_)
+			{
+				file << separator()
+					<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << profile->id
+					<< ",\"args\":{\"name\":\"" << escape(profile->name) << "\"}}";
+			}
+		}
+		file << separator()
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << kGpuThread
+			<< ",\"args\":{\"name\":\"GPU\"}}";
+		file << separator()
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << kFrameThread
+			<< ",\"args\":{\"name\":\"Frames\"}}";
+		for (const auto& frame : frames_)
+		{
+			file << separator()
+				<< "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":" << kFrameThread << ",\"ts\":"
+				<< static_cast<double>(frame.start) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(frame.end - frame.start) / 1000.0 << "}";
+			for (const auto& event : frame.events)
+			{
+				file << separator()
+					<< "{\"name\":\"" << escape(event.name)
+					<< "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+					<< ",\"ts\":" << static_cast<double>(event.start) / 1000.0
+					<< ",\"dur\":" << static_cast<double>(event.end - event.start) / 1000.0 << "}";
+			}
+		}
+		std::vector<ProfileEvent> gpuEvents;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			gpuEvents = lastGpuEvents_;
+		}
+		const std::uint64_t gpuBase = frames_.empty() ? 0 : frames_.back().start;
+		for (const auto& event : gpuEvents)
+		{
+			file << separator()
+				<< "{\"name\":\"" << escape(event.name)
+				<< "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << kGpuThread
+				<< ",\"ts\":" << static_cast<double>(gpuBase + event.start) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(event.end - event.start) / 1000.0 << "}";
+		}
+		file << "\n]}\n";
+		return static_cast<bool>(file);
+	}
+
+} // End namespace gl.
@@ -0,0 +1,106 @@
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "profiler.h"
+
+namespace gl {
+
+	RadixSorter::RadixSorter(JobSystem* jobSystem) :
+		jobSystem_(jobSystem)
+	{
+	}
+
+	void RadixSorter::ForEachBlock(std::size_t count, const JobSystem::RangeFunction& func)
+	{
+		if (jobSystem_ != nullptr)
+		{
+			jobSystem_->ParallelFor(count, kBlockSize, func);
+			return;
+		}
+		for (std::size_t begin = 0; begin < count; begin += kBlockSize)
+		{
+			func(begin, std::min(begin + kBlockSize, count));
+		}
+	}
+
+	void RadixSorter::SortIndices(std::span<const std::uint32_t> keys, std::vector<std::uint32_t>& order)
+	{
+		GPR5300_PROFILE_ZONE("Radix sort");
+		const std::size_t count = keys.size();
+		order.resize(count);
+		if (count == 0) return;
+
+		const std::size_t blockCount = (count + kBlockSize - 1) / kBlockSize;
+		histograms_.resize(blockCount);
+		for (auto& buffer : keys_) buffer.resize(count);
+		for (auto& buffer : indices_) buffer.resize(count);
+
+		// The first pass reads the caller's keys and an implicit identity
+		// permutation; the last one writes straight to order.
+		const std::uint32_t* sourceKeys = keys.data();
+		const std::uint32_t* sourceIndices = nullptr;
+		int target = 0;
+		for (unsigned int shift = 0; shift < 32; shift += 8)
+		{
+			ForEachBlock(count, [&](std::size_t begin, std::size_t end)
+				{
+					auto& histogram = histograms_[begin / kBlockSize];
+					histogram.fill(0);
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						histogram[(sourceKeys[i] >> shift) & 0xFF]++;
+					}
+				});
+
+			// Turn the counts into the first output position of every
+			// (digit, block) pair: digits in order, blocks in order within
+			// a digit, which keeps the pass stable.
+			std::size_t offset = 0;
+			bool trivial = false;
+			for (std::size_t digit = 0; digit < kRadix; ++digit)
+			{
+				std::size_t digitCount = 0;
+				for (auto& histogram : histograms_)
+				{
+					const std::uint32_t inBlock = histogram[digit];
+					histogram[digit] = static_cast<std::uint32_t>(offset + digitCount);
+					digitCount += inBlock;
+				}
+				trivial = trivial || digitCount == count;
+				offset += digitCount;
+			}
+			const bool lastPass = shift == 24;
+			if (trivial && !(lastPass && sourceIndices == nullptr))
+			{
+				// Every key has this digit: the pass would be a copy.
+				if (lastPass)
+				{
+					std::copy(sourceIndices, sourceIndices + count, order.begin());
+				}
+				continue;
+			}
+
+			std::uint32_t* targetKeys = keys_[target].data();
+			std::uint32_t* targetIndices = lastPass ? order.data() : indices_[target].data();
+			ForEachBlock(count, [&](std::size_t begin, std::size_t end)
+				{
+					auto& position = histograms_[begin / kBlockSize];
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						const std::uint32_t key = sourceKeys[i];
+						const std::uint32_t slot = position[(key >> shift) & 0xFF]++;
+						targetKeys[slot] = key;
+						targetIndices[slot] = sourceIndices != nullptr ?
+							sourceIndices[i] :
+							static_cast<std::uint32_t>(i);
+					}
+				});
+			sourceKeys = targetKeys;
+			sourceIndices = targetIndices;
+			target = 1 - target;
+		}
+	}
+
+} // End namespace gl.
@@ -0,0 +1,107 @@
+#include "render_thread.h"
+
+#include "profiler.h"
+
+namespace gl {
+
+	namespace {
+
+		float MillisecondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<float, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+
+	} // namespace
+
+	RenderThread::~RenderThread()
+	{
+		Stop();
+	}
+
+	void RenderThread::Start(
+		RenderFunction render,
+		ThreadFunction onStart,
+		ThreadFunction onExit)
+	{
+		if (IsRunning()) return;
+		stop_ = false;
+		filled_ = { false, false };
+		writeSlot_ = 0;
+		thread_ = std::thread(
+			&RenderThread::ThreadLoop,
+			this,
+			std::move(render),
+			std::move(onStart),
+			std::move(onExit));
+	}
+
+	void RenderThread::Stop()
+	{
+		if (!IsRunning()) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		condition_.notify_all();
+		thread_.join();
+	}
+
+	FramePacket& RenderThread::BeginFrame()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		{
+			GPR5300_PROFILE_ZONE("Wait for render");
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return !filled_[writeSlot_]; });
+		}
+		waitMilliseconds_ = MillisecondsSince(start);
+
+		FramePacket& packet = packets_[writeSlot_];
+		packet.Clear();
+		packet.frameIndex = frameIndex_++;
+		packet.slot = writeSlot_;
+		packet.simulationStart = std::chrono::steady_clock::now();
+		return packet;
+	}
+
+	void RenderThread::SubmitFrame()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			filled_[writeSlot_] = true;
+		}
+		condition_.notify_all();
+		writeSlot_ = 1 - writeSlot_;
+	}
+
+	void RenderThread::ThreadLoop(RenderFunction render, ThreadFunction onStart, ThreadFunction onExit)
+	{
+		if (onStart) onStart();
+		std::size_t readSlot = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				condition_.wait(lock, [&]() { return stop_ || filled_[readSlot]; });
+				if (!filled_[readSlot]) break;
+			}
+
+			// The packet is ours until filled_ goes back to false.
+			FramePacket& packet = packets_[readSlot];
+			const auto start = std::chrono::steady_clock::now();
+			render(packet);
+			renderMilliseconds_.store(MillisecondsSince(start), std::memory_order_relaxed);
+			latencyMilliseconds_.store(MillisecondsSince(packet.simulationStart), std::memory_order_relaxed);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				filled_[readSlot] = false;
+			}
+			condition_.notify_all();
+			readSlot = 1 - readSlot;
+		}
+		if (onExit) onExit();
+	}
+
+} // End namespace gl.
@@ -0,0 +1,233 @@
+#include "scene.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace gl {
+
+	namespace {
+
+		struct ComponentInfo
+		{
+			std::size_t size;
+			std::size_t alignment;
+		};
+
+		std::mutex componentMutex;
+		std::vector<ComponentInfo> componentInfos;
+
+		ComponentInfo GetComponentInfo(ComponentId id)
+		{
+			std::lock_guard<std::mutex> lock(componentMutex);
+			return componentInfos[id];
+		}
+
+		// Arrays start on a cache line: no line is shared by two of them.
+		constexpr std::size_t kColumnAlignment = 64;
+
+		std::size_t AlignUp(std::size_t offset, std::size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+	} // namespace
+
+	ComponentId RegisterComponentType(std::size_t size, std::size_t alignment)
+	{
+		std::lock_guard<std::mutex> lock(componentMutex);
+		if (componentInfos.size() == kMaxComponentTypes)
+		{
+			std::cerr << "[Error] More than " << kMaxComponentTypes << " component types\n";
+			std::abort();
+		}
+		if (alignment > kColumnAlignment)
+		{
+			std::cerr << "[Error] Component alignment above " << kColumnAlignment << " bytes\n";
+			std::abort();
+		}
+		componentInfos.push_back({ size, alignment });
+		return static_cast<ComponentId>(componentInfos.size() - 1);
+	}
+
+	Archetype::Archetype(ComponentMask mask) : mask_(mask)
+	{
+		std::size_t rowBytes = sizeof(Entity);
+		for (ComponentId id = 0; id < kMaxComponentTypes; ++id)
+		{
+			if (!Has(id)) continue;
+			components_.push_back(id);
+			sizes_[id] = static_cast<std::uint32_t>(GetComponentInfo(id).size);
+			rowBytes += sizes_[id];
+		}
+		// As many rows as fit once every array is aligned.
+		const auto layout = [this](std::size_t capacity)
+			{
+				std::size_t offset = AlignUp(capacity * sizeof(Entity), kColumnAlignment);
+				for (const ComponentId id : components_)
+				{
+					offsets_[id] = static_cast<std::uint32_t>(offset);
+					offset = AlignUp(offset + capacity * sizes_[id], kColumnAlignment);
+				}
+				return offset;
+			};
+		capacity_ = kChunkBytes / rowBytes;
+		while (capacity_ > 1 && layout(capacity_) > kChunkBytes)
+		{
+			--capacity_;
+		}
+		if (layout(capacity_) > kChunkBytes)
+		{
+			std::cerr << "[Error] Components too large for a " << kChunkBytes << " byte chunk\n";
+			std::abort();
+		}
+	}
+
+	std::uint32_t Archetype::AddRow(Entity entity)
+	{
+		if (count_ == chunks_.size() * capacity_)
+		{
+			chunks_.push_back(std::make_unique_for_overwrite<Chunk>());
+		}
+		const auto row = static_cast<std::uint32_t>(count_++);
+		GetEntities(row / capacity_)[row % capacity_] = entity;
+		return row;
+	}
+
+	Entity Archetype::RemoveRow(std::uint32_t row)
+	{
+		const auto last = static_cast<std::uint32_t>(count_ - 1);
+		Entity moved = kNullEntity;
+		if (row != last)
+		{
+			moved = GetEntities(last / capacity_)[last % capacity_];
+			GetEntities(row / capacity_)[row % capacity_] = moved;
+			for (const ComponentId id : components_)
+			{
+				std::memcpy(GetBytes(id, row), GetBytes(id, last), sizes_[id]);
+			}
+		}
+		--count_;
+		// Keep one spare chunk: an entity moving back and forth across a
+		// chunk boundary would otherwise allocate every time.
+		if (chunks_.size() * capacity_ >= count_ + 2 * capacity_)
+		{
+			chunks_.pop_back();
+		}
+		return moved;
+	}
+
+	void Archetype::CopyRow(std::uint32_t row, Archetype& source, std::uint32_t sourceRow)
+	{
+		for (const ComponentId id : components_)
+		{
+			if (!source.Has(id)) continue;
+			std::memcpy(GetBytes(id, row), source.GetBytes(id, sourceRow), sizes_[id]);
+		}
+	}
+
+	void Archetype::Reserve(std::size_t count)
+	{
+		const std::size_t chunkCount = (count + capacity_ - 1) / capacity_;
+		chunks_.reserve(chunkCount);
+		while (chunks_.size() < chunkCount)
+		{
+			chunks_.push_back(std::make_unique_for_overwrite<Chunk>());
+		}
+	}
+
+	std::byte* Archetype::GetBytes(ComponentId id, std::uint32_t row)
+	{
+		return chunks_[row / capacity_]->bytes + offsets_[id] +
+			static_cast<std::size_t>(row % capacity_) * sizes_[id];
+	}
+
+	void Scene::DestroyEntity(Entity entity)
+	{
+		if (!IsAlive(entity)) return;
+		Record& record = records_[entity.index];
+		const Entity moved = record.archetype->RemoveRow(record.row);
+		if (moved != kNullEntity)
+		{
+			records_[moved.index].row = record.row;
+		}
+		record.archetype = nullptr;
+		++record.generation;
+		freeIndices_.push_back(entity.index);
+		--entityCount_;
+	}
+
+	bool Scene::IsAlive(Entity entity) const
+	{
+		return entity.index < records_.size() &&
+			records_[entity.index].generation == entity.generation &&
+			records_[entity.index].archetype != nullptr;
+	}
+
+	void Scene::Clear()
+	{
+		archetypes_.clear();
+		archetypeList_.clear();
+		records_.clear();
+		freeIndices_.clear();
+		entityCount_ = 0;
+	}
+
+	Archetype& Scene::GetArchetype(ComponentMask mask)
+	{
+		auto& archetype = archetypes_[mask];
+		if (archetype == nullptr)
+		{
+			archetype = std::make_unique<Archetype>(mask);
+			archetypeList_.push_back(archetype.get());
+		}
+		return *archetype;
+	}
+
+	Entity Scene::AllocateEntity()
+	{
+		++entityCount_;
+		if (!freeIndices_.empty())
+		{
+			const std::uint32_t index = freeIndices_.back();
+			freeIndices_.pop_back();
+			return { index, records_[index].generation };
+		}
+		records_.emplace_back();
+		return { static_cast<std::uint32_t>(records_.size() - 1), records_.back().generation };
+	}
+
+	void Scene::Move(Entity entity, ComponentMask mask)
+	{
+		Record& record = records_[entity.index];
+		Archetype& source = *record.archetype;
+		Archetype& destination = GetArchetype(mask);
+		const std::uint32_t row = destination.AddRow(entity);
+		destination.CopyRow(row, source, record.row);
+		const Entity moved = source.RemoveRow(record.row);
+		if (moved != kNullEntity)
+		{
+			records_[moved.index].row = record.row;
+		}
+		record.archetype = &destination;
+		record.row = row;
+	}
+
+	void Scene::CollectChunks(ComponentMask mask)
+	{
+		queryChunks_.clear();
+		for (Archetype* archetype : archetypeList_)
+		{
+			if ((archetype->GetMask() & mask) != mask) continue;
+			for (std::size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+			{
+				if (archetype->GetChunkSize(chunk) > 0)
+				{
+					queryChunks_.push_back({ archetype, chunk });
+				}
+			}
+		}
+	}
+
+} // End namespace gl.
@@ -0,0 +1,449 @@
+#include "scene_file.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+#include <nlohmann/json.hpp>
+
+namespace gl {
+
+	static_assert(sizeof(void*) == 8, "cooked scenes store 64-bit pointers");
+	static_assert(std::is_trivially_copyable_v<Transform>);
+	static_assert(std::is_standard_layout_v<SceneFileHeader>);
+
+	namespace {
+
+		constexpr char kSceneFileMagic[4] = { 'G', 'S', 'C', 'N' };
+
+		using Json = nlohmann::json;
+
+		glm::vec3 ReadVec3(const Json& object, const char* key, glm::vec3 fallback)
+		{
+			const auto it = object.find(key);
+			if (it == object.end()) return fallback;
+			if (it->is_number()) return glm::vec3(it->get<float>());
+			if (!it->is_array() || it->size() != 3)
+			{
+				throw std::runtime_error(std::string(key) + " is neither a number nor 3 numbers");
+			}
+			return glm::vec3((*it)[0].get<float>(), (*it)[1].get<float>(), (*it)[2].get<float>());
+		}
+
+		// position, rotation (Euler angles in degrees, XYZ) and scale.
+		Transform ReadTransform(const Json& object)
+		{
+			Transform transform;
+			transform.position = ReadVec3(object, "position", glm::vec3(0.0f));
+			transform.rotation = glm::quat(glm::radians(ReadVec3(object, "rotation", glm::vec3(0.0f))));
+			transform.scale = ReadVec3(object, "scale", glm::vec3(1.0f));
+			return transform;
+		}
+
+		std::uint32_t FindName(
+			const std::unordered_map<std::string, std::uint32_t>& names,
+			const std::string& name,
+			const char* what)
+		{
+			const auto it = names.find(name);
+			if (it == names.end())
+			{
+				throw std::runtime_error(std::string("unknown ") + what + " \"" + name + "\"");
+			}
+			return it->second;
+		}
+
+		// Builds the file in memory: arrays are appended aligned, and every
+		// pointer slot holds its target's offset and goes in the fixup table.
+		class BlobWriter
+		{
+		public:
+			std::uint64_t Allocate(std::size_t size, std::size_t alignment)
+			{
+				const std::size_t offset = (bytes_.size() + alignment - 1) / alignment * alignment;
+				bytes_.resize(offset + size);
+				return offset;
+			}
+
+			template <typename T>
+			std::uint64_t Write(const T* values, std::size_t count)
+			{
+				const std::uint64_t offset = Allocate(sizeof(T) * count, alignof(T));
+				if (count > 0) std::memcpy(bytes_.data() + offset, values, sizeof(T) * count);
+				return offset;
+			}
+
+			std::uint64_t WriteString(const std::string& value)
+			{
+				const std::uint64_t offset = Allocate(value.size() + 1, 1);
+				std::memcpy(bytes_.data() + offset, value.data(), value.size());
+				return offset;
+			}
+
+			template <typename T>
+			void Put(std::uint64_t offset, const T& value)
+			{
+				std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+			}
+
+			void Point(std::uint64_t slot, std::uint64_t target)
+			{
+				Put(slot, target);
+				fixups_.push_back(slot);
+			}
+
+			const std::vector<std::uint64_t>& GetFixups() const { return fixups_; }
+			const std::vector<std::byte>& GetBytes() const { return bytes_; }
+
+		private:
+			std::vector<std::byte> bytes_;
+			std::vector<std::uint64_t> fixups_;
+		};
+
+		struct SourceEntity
+		{
+			std::string name;
+			std::string parent;
+			std::string model;
+			Transform transform;
+		};
+
+		// Entities by depth, keeping the file order among equals: a parent
+		// always lands before its children.
+		std::vector<SourceEntity> SortParentsFirst(std::vector<SourceEntity> entities)
+		{
+			std::unordered_map<std::string, std::uint32_t> names;
+			for (std::uint32_t i = 0; i < entities.size(); ++i)
+			{
+				if (entities[i].name.empty()) continue;
+				if (!names.emplace(entities[i].name, i).second)
+				{
+					throw std::runtime_error("two entities named \"" + entities[i].name + "\"");
+				}
+			}
+			std::vector<std::size_t> depths(entities.size(), 0);
+			for (std::size_t i = 0; i < entities.size(); ++i)
+			{
+				for (std::string parent = entities[i].parent; !parent.empty();
+					parent = entities[FindName(names, parent, "parent")].parent)
+				{
+					if (++depths[i] > entities.size())
+					{
+						throw std::runtime_error("entity \"" + entities[i].name + "\" is its own ancestor");
+					}
+				}
+			}
+			std::vector<std::size_t> order(entities.size());
+			for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&depths](std::size_t a, std::size_t b)
+				{
+					return depths[a] < depths[b];
+				});
+			std::vector<SourceEntity> sorted;
+			sorted.reserve(entities.size());
+			for (const std::size_t i : order)
+			{
+				sorted.push_back(std::move(entities[i]));
+			}
+			return sorted;
+		}
+
+		std::vector<std::byte> Cook(const Json& source)
+		{
+			// Assets.
+			std::vector<SceneFileAsset> assets;
+			std::vector<std::string> assetNames;
+			std::vector<std::string> assetPaths;
+			std::unordered_map<std::string, std::uint32_t> assetIndices;
+			for (const Json& asset : source.value("assets", Json::array()))
+			{
+				const auto name = asset.at("name").get<std::string>();
+				if (!assetIndices.emplace(name, static_cast<std::uint32_t>(assets.size())).second)
+				{
+					throw std::runtime_error("two assets named \"" + name + "\"");
+				}
+				assetNames.push_back(name);
+				assetPaths.push_back(asset.at("path").get<std::string>());
+				SceneFileAsset entry{};
+				entry.flags = asset.value("occluder", false) ?
+					static_cast<std::uint32_t>(kSceneAssetOccluder) : std::uint32_t{ 0 };
+				assets.push_back(entry);
+			}
+
+			// Entities, parents first.
+			std::vector<SourceEntity> sources;
+			for (const Json& entity : source.value("entities", Json::array()))
+			{
+				SourceEntity& entry = sources.emplace_back();
+				entry.name = entity.value("name", std::string());
+				entry.parent = entity.value("parent", std::string());
+				entry.model = entity.value("model", std::string());
+				entry.transform = ReadTransform(entity);
+			}
+			sources = SortParentsFirst(std::move(sources));
+			std::unordered_map<std::string, std::uint32_t> entityIndices;
+			std::vector<SceneFileEntity> entities;
+			std::vector<Transform> transforms;
+			for (const SourceEntity& entity : sources)
+			{
+				if (!entity.name.empty())
+				{
+					entityIndices.emplace(entity.name, static_cast<std::uint32_t>(entities.size()));
+				}
+				SceneFileEntity entry{};
+				entry.parent = entity.parent.empty() ? kSceneFileNone : FindName(entityIndices, entity.parent, "parent");
+				entry.model = entity.model.empty() ? kSceneFileNone : FindName(assetIndices, entity.model, "model");
+				entities.push_back(entry);
+				transforms.push_back(entity.transform);
+			}
+
+			// Instances, baked into model matrices.
+			std::vector<SceneFileInstances> instances;
+			std::vector<std::vector<glm::mat4>> matrices;
+			for (const Json& group : source.value("instances", Json::array()))
+			{
+				SceneFileInstances entry{};
+				entry.model = FindName(assetIndices, group.at("model").get<std::string>(), "model");
+				auto& groupMatrices = matrices.emplace_back();
+				for (const Json& instance : group.at("transforms"))
+				{
+					groupMatrices.push_back(ReadTransform(instance).ToMatrix());
+				}
+				entry.count = static_cast<std::uint32_t>(groupMatrices.size());
+				instances.push_back(entry);
+			}
+
+			BlobWriter writer;
+			SceneFileHeader header{};
+			std::memcpy(header.magic, kSceneFileMagic, sizeof(header.magic));
+			header.version = kSceneFileVersion;
+			header.assetCount = static_cast<std::uint32_t>(assets.size());
+			header.entityCount = static_cast<std::uint32_t>(entities.size());
+			header.instanceCount = static_cast<std::uint32_t>(instances.size());
+			const std::uint64_t headerOffset = writer.Write(&header, 1);
+
+			const std::uint64_t assetsOffset = writer.Write(assets.data(), assets.size());
+			const std::uint64_t entitiesOffset = writer.Write(entities.data(), entities.size());
+			const std::uint64_t transformsOffset = writer.Write(transforms.data(), transforms.size());
+			const std::uint64_t instancesOffset = writer.Write(instances.data(), instances.size());
+			writer.Point(headerOffset + offsetof(SceneFileHeader, assets), assetsOffset);
+			writer.Point(headerOffset + offsetof(SceneFileHeader, entities), entitiesOffset);
+			writer.Point(headerOffset + offsetof(SceneFileHeader, transforms), transformsOffset);
+			writer.Point(headerOffset + offsetof(SceneFileHeader, instances), instancesOffset);
+
+			// Bulk data, then strings: the matrices stay 16 byte aligned.
+			for (std::size_t i = 0; i < instances.size(); ++i)
+			{
+				const std::uint64_t slot = instancesOffset + i * sizeof(SceneFileInstances);
+				writer.Point(
+					slot + offsetof(SceneFileInstances, matrices),
+					writer.Write(matrices[i].data(), matrices[i].size()));
+			}
+			for (std::size_t i = 0; i < assets.size(); ++i)
+			{
+				const std::uint64_t slot = assetsOffset + i * sizeof(SceneFileAsset);
+				writer.Point(slot + offsetof(SceneFileAsset, name), writer.WriteString(assetNames[i]));
+				writer.Point(slot + offsetof(SceneFileAsset, path), writer.WriteString(assetPaths[i]));
+			}
+			for (std::size_t i = 0; i < entities.size(); ++i)
+			{
+				const std::uint64_t slot = entitiesOffset + i * sizeof(SceneFileEntity);
+				writer.Point(slot + offsetof(SceneFileEntity, name), writer.WriteString(sources[i].name));
+			}
+
+			const std::vector<std::uint64_t> fixups = writer.GetFixups();
+			const std::uint64_t fixupOffset = writer.Write(fixups.data(), fixups.size());
+			writer.Put(headerOffset + offsetof(SceneFileHeader, fixupOffset), fixupOffset);
+			writer.Put(headerOffset + offsetof(SceneFileHeader, fixupCount), static_cast<std::uint64_t>(fixups.size()));
+			writer.Put(headerOffset + offsetof(SceneFileHeader, size), static_cast<std::uint64_t>(writer.GetBytes().size()));
+			return writer.GetBytes();
+		}
+
+	} // namespace
+
+	bool CookScene(const std::filesystem::path& source, const std::filesystem::path& destination)
+	{
+		std::vector<std::byte> bytes;
+		try
+		{
+			std::ifstream input(source);
+			if (!input)
+			{
+				std::cerr << "[Error] Could not open " << source.string() << "\n";
+				return false;
+			}
+			bytes = Cook(Json::parse(input, nullptr, true, true));
+		}
+		catch (const std::exception& error)
+		{
+			std::cerr << "[Error] " << source.string() << ": " << error.what() << "\n";
+			return false;
+		}
+
+		// Written aside and renamed: a reader never maps half a file.
+		auto temporary = destination;
+		temporary += ".tmp";
+		{
+			std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+			output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			if (!output)
+			{
+				std::cerr << "[Error] Could not write " << temporary.string() << "\n";
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, destination, error);
+		if (error)
+		{
+			std::cerr << "[Error] Could not write " << destination.string() << ": " << error.message() << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+		if (!file_.Open(path)) return false;
+		data_ = file_.GetData();
+		size_ = file_.GetSize();
+		return Load(path.string());
+	}
+
+	bool SceneFile::Open(std::span<const std::byte> bytes, std::string_view name)
+	{
+		Close();
+		copy_ = std::make_unique_for_overwrite<std::byte[]>(bytes.size());
+		std::memcpy(copy_.get(), bytes.data(), bytes.size());
+		data_ = copy_.get();
+		size_ = bytes.size();
+		return Load(name);
+	}
+
+	void SceneFile::Close()
+	{
+		header_ = nullptr;
+		data_ = nullptr;
+		size_ = 0;
+		copy_.reset();
+		file_.Close();
+	}
+
+	bool SceneFile::Load(std::string_view name)
+	{
+		if (!Fixup(name) || !Validate(name))
+		{
+			Close();
+			return false;
+		}
+		header_ = reinterpret_cast<const SceneFileHeader*>(data_);
+		return true;
+	}
+
+	bool SceneFile::Fixup(std::string_view name)
+	{
+		std::byte* data = data_;
+		const std::size_t size = size_;
+		SceneFileHeader header{};
+		if (size < sizeof(header))
+		{
+			std::cerr << "[Error] " << name << " is not a cooked scene\n";
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, kSceneFileMagic, sizeof(header.magic)) != 0 ||
+			header.version != kSceneFileVersion)
+		{
+			std::cerr << "[Error] " << name << " is not a cooked scene of version " << kSceneFileVersion << "\n";
+			return false;
+		}
+		if (header.size != size ||
+			header.fixupOffset % alignof(std::uint64_t) != 0 ||
+			header.fixupOffset > size ||
+			header.fixupCount > (size - header.fixupOffset) / sizeof(std::uint64_t))
+		{
+			std::cerr << "[Error] " << name << " is truncated or corrupt\n";
+			return false;
+		}
+		// Offset to address, in place: only the pages holding pointers are
+		// copied from the page cache.
+		const std::byte* table = data + header.fixupOffset;
+		for (std::uint64_t i = 0; i < header.fixupCount; ++i)
+		{
+			std::uint64_t slot = 0;
+			std::memcpy(&slot, table + i * sizeof(slot), sizeof(slot));
+			std::uint64_t target = 0;
+			if (slot % alignof(void*) != 0 || slot > size - sizeof(target))
+			{
+				std::cerr << "[Error] " << name << " has a pointer outside the file\n";
+				return false;
+			}
+			std::memcpy(&target, data + slot, sizeof(target));
+			if (target >= size)
+			{
+				std::cerr << "[Error] " << name << " has a pointer outside the file\n";
+				return false;
+			}
+			std::byte* pointer = data + target;
+			std::memcpy(data + slot, &pointer, sizeof(pointer));
+		}
+		return true;
+	}
+
+	bool SceneFile::Validate(std::string_view name) const
+	{
+		const std::byte* begin = data_;
+		const std::byte* end = begin + size_;
+		const auto& header = *reinterpret_cast<const SceneFileHeader*>(begin);
+		const auto inFile = [begin, end](const void* pointer, std::size_t bytes, std::size_t alignment)
+			{
+				const auto* start = static_cast<const std::byte*>(pointer);
+				return start >= begin && start <= end &&
+					bytes <= static_cast<std::size_t>(end - start) &&
+					reinterpret_cast<std::uintptr_t>(start) % alignment == 0;
+			};
+		const auto isString = [&inFile, end](const char* string)
+			{
+				return inFile(string, 1, 1) &&
+					std::memchr(string, 0, static_cast<std::size_t>(end - reinterpret_cast<const std::byte*>(string))) != nullptr;
+			};
+
+		bool valid =
+			inFile(header.assets, header.assetCount * sizeof(SceneFileAsset), alignof(SceneFileAsset)) &&
+			inFile(header.entities, header.entityCount * sizeof(SceneFileEntity), alignof(SceneFileEntity)) &&
+			inFile(header.transforms, header.entityCount * sizeof(Transform), alignof(Transform)) &&
+			inFile(header.instances, header.instanceCount * sizeof(SceneFileInstances), alignof(SceneFileInstances));
+		for (std::uint32_t i = 0; valid && i < header.assetCount; ++i)
+		{
+			valid = isString(header.assets[i].name) && isString(header.assets[i].path);
+		}
+		for (std::uint32_t i = 0; valid && i < header.entityCount; ++i)
+		{
+			const SceneFileEntity& entity = header.entities[i];
+			valid = isString(entity.name) &&
+				(entity.parent == kSceneFileNone || entity.parent < i) &&
+				(entity.model == kSceneFileNone || entity.model < header.assetCount);
+		}
+		for (std::uint32_t i = 0; valid && i < header.instanceCount; ++i)
+		{
+			const SceneFileInstances& instances = header.instances[i];
+			valid = instances.model < header.assetCount &&
+				inFile(instances.matrices, instances.count * sizeof(glm::mat4), alignof(glm::mat4));
+		}
+		if (!valid)
+		{
+			std::cerr << "[Error] " << name << " is corrupt\n";
+		}
+		return valid;
+	}
+
+} // End namespace gl.
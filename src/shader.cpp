@@ -1,81 +1,24 @@
 #include "shader.h"
 
+#include "vfs.h"
+
 namespace gl
 {
 	// constructor generates the shader on the fly
 
 	Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath)
 	{
-		// 1. retrieve the vertex/fragment source code from filePath
-		std::string vertexCode;
-		std::string fragmentCode;
-		std::string geometryCode;
-		std::ifstream vShaderFile;
-		std::ifstream fShaderFile;
-		std::ifstream gShaderFile;
-		// ensure ifstream objects can throw exceptions:
-		vShaderFile.exceptions(
-			std::ifstream::failbit | std::ifstream::badbit);
-		fShaderFile.exceptions(
-			std::ifstream::failbit | std::ifstream::badbit);
-		gShaderFile.exceptions(
-			std::ifstream::failbit | std::ifstream::badbit);
-		try
-		{
-			// open files
-			vShaderFile.open(vertexPath);
-			fShaderFile.open(fragmentPath);
-			std::stringstream vShaderStream, fShaderStream;
-			// read file's buffer contents into streams
-			vShaderStream << vShaderFile.rdbuf();
-			fShaderStream << fShaderFile.rdbuf();
-			// close file handlers
-			vShaderFile.close();
-			fShaderFile.close();
-			// convert stream into string
-			vertexCode = vShaderStream.str();
-			fragmentCode = fShaderStream.str();
-			// if geometry shader path is present, also load a geometry
-			// shader
-			if (!geometryPath.empty())
-			{
-				gShaderFile.open(geometryPath);
-				std::stringstream gShaderStream;
-				gShaderStream << gShaderFile.rdbuf();
-				gShaderFile.close();
-				geometryCode = gShaderStream.str();
-			}
-		}
-		catch (std::ifstream::failure& e)
-		{
-			throw std::runtime_error(e.what());
-		}
-		const char* vShaderCode = vertexCode.c_str();
-		const char* fShaderCode = fragmentCode.c_str();
-		// 2. compile shaders
-		unsigned int vertex, fragment;
-		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		CheckCompileErrors(vertex, "VERTEX");
-		// fragment Shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		CheckCompileErrors(fragment, "FRAGMENT");
+		// 1. compile the stages, their sources read through the Vfs
+		unsigned int vertex = CompileStage(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+		unsigned int fragment = CompileStage(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
 		// if geometry shader is given, compile geometry shader
 		unsigned int geometry;
 		if (!geometryPath.empty())
 		{
-			const char* gShaderCode = geometryCode.c_str();
-			geometry = glCreateShader(GL_GEOMETRY_SHADER);
-			glShaderSource(geometry, 1, &gShaderCode, NULL);
-			glCompileShader(geometry);
-			CheckCompileErrors(geometry, "GEOMETRY");
+			geometry = CompileStage(GL_GEOMETRY_SHADER, geometryPath, "GEOMETRY");
 		}
 		// shader Program
-		id = glCreateProgram();
+		id = GlProgram(glCreateProgram(), "Shader");
 		glAttachShader(id, vertex);
 		glAttachShader(id, fragment);
 		if (!geometryPath.empty())
@@ -94,6 +37,32 @@ namespace gl
 		}
 	}
 
+	GLuint Shader::CompileStage(GLenum stage, const std::string& path, const std::string& type)
+	{
+		const VfsFile file = Vfs::Read(path);
+		if (!file.IsValid())
+		{
+			++buildFailures_;
+			throw std::runtime_error("Cannot load shader: " + path);
+		}
+		// Straight from the file's bytes (a view of the pack when it is
+		// stored): not null terminated, hence the length.
+		const char* code = file.GetText().data();
+		const GLint length = static_cast<GLint>(file.GetText().size());
+		GLuint shader = glCreateShader(stage);
+		glShaderSource(shader, 1, &code, &length);
+		glCompileShader(shader);
+		CheckCompileErrors(shader, type);
+		return shader;
+	}
+
+	std::size_t Shader::buildFailures_ = 0;
+
+	std::size_t Shader::GetBuildFailureCount()
+	{
+		return buildFailures_;
+	}
+
 	// activate the shader
 
 	void Shader::Use() const
@@ -103,67 +72,77 @@ namespace gl
 
 	// utility uniform functions
 
-	void Shader::SetBool(const std::string& name, bool value) const
+	void Shader::SetBool(std::string_view name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
+		glUniform1i(GetUniformLocation(name), (int)value);
 	}
-	void Shader::SetInt(const std::string& name, int value) const
+	void Shader::SetInt(std::string_view name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+		glUniform1i(GetUniformLocation(name), value);
 	}
-	void Shader::SetFloat(const std::string& name, float value) const
+	void Shader::SetFloat(std::string_view name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+		glUniform1f(GetUniformLocation(name), value);
 	}
-	void Shader::SetVec2(const std::string& name, const glm::vec2& value) const
+	void Shader::SetVec2(std::string_view name, const glm::vec2& value) const
 	{
-		glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+		glUniform2fv(GetUniformLocation(name), 1, &value[0]);
 	}
-	void Shader::SetVec2(const std::string& name, float x, float y) const
+	void Shader::SetVec2(std::string_view name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(id, name.c_str()), x, y);
+		glUniform2f(GetUniformLocation(name), x, y);
 	}
-	void Shader::SetVec3(const std::string& name, const glm::vec3& value) const
+	void Shader::SetVec3(std::string_view name, const glm::vec3& value) const
 	{
-		glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+		glUniform3fv(GetUniformLocation(name), 1, &value[0]);
 	}
-	void Shader::SetVec3(const std::string& name, float x, float y, float z) const
+	void Shader::SetVec3(std::string_view name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(id, name.c_str()), x, y, z);
+		glUniform3f(GetUniformLocation(name), x, y, z);
 	}
-	void Shader::SetVec4(const std::string& name, const glm::vec4& value) const
+	void Shader::SetVec4(std::string_view name, const glm::vec4& value) const
 	{
-		glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+		glUniform4fv(GetUniformLocation(name), 1, &value[0]);
 	}
-	void Shader::SetVec4(const std::string& name, float x, float y, float z, float w)
+	void Shader::SetVec4(std::string_view name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(id, name.c_str()), x, y, z, w);
+		glUniform4f(GetUniformLocation(name), x, y, z, w);
 	}
-	void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const
+	void Shader::SetMat2(std::string_view name, const glm::mat2& mat) const
 	{
 		glUniformMatrix2fv(
-			glGetUniformLocation(id, name.c_str()),
+			GetUniformLocation(name),
 			1,
 			GL_FALSE,
 			&mat[0][0]);
 	}
-	void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const
+	void Shader::SetMat3(std::string_view name, const glm::mat3& mat) const
 	{
 		glUniformMatrix3fv(
-			glGetUniformLocation(id, name.c_str()),
+			GetUniformLocation(name),
 			1,
 			GL_FALSE,
 			&mat[0][0]);
 	}
-	void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const
+	void Shader::SetMat4(std::string_view name, const glm::mat4& mat) const
 	{
 		glUniformMatrix4fv(
-			glGetUniformLocation(id, name.c_str()),
+			GetUniformLocation(name),
 			1,
 			GL_FALSE,
 			&mat[0][0]);
 	}
 
+	GLint Shader::GetUniformLocation(std::string_view name) const
+	{
+		const auto it = uniformLocations_.find(name);
+		if (it != uniformLocations_.end()) return it->second;
+		std::string key(name);
+		const GLint location = glGetUniformLocation(id, key.c_str());
+		uniformLocations_.emplace(std::move(key), location);
+		return location;
+	}
+
 	// utility function for checking shader compilation/linking errors.
 
 	void Shader::CheckCompileErrors(GLuint shader, std::string type)
@@ -175,6 +154,7 @@ namespace gl
 			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 			if (!success)
 			{
+				++buildFailures_;
 				glGetShaderInfoLog(shader, 1024, NULL, infoLog);
 				throw std::runtime_error(
 					"Shader compilation error: " + type + " : " + infoLog);
@@ -185,7 +165,8 @@ namespace gl
 			glGetProgramiv(shader, GL_LINK_STATUS, &success);
 			if (!success)
 			{
-				glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+				++buildFailures_;
+				glGetProgramInfoLog(shader, 1024, NULL, infoLog);
 				throw std::runtime_error(
 					"Shader linking error: " + type + " : " + infoLog);
 			}
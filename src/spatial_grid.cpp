@@ -0,0 +1,230 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace gl {
+
+	SpatialGrid::SpatialGrid(float cellSize) :
+		requestedCellSize_(cellSize),
+		cellSize_(cellSize)
+	{
+	}
+
+	void SpatialGrid::Build(
+		const float* x,
+		const float* y,
+		const float* z,
+		std::size_t count)
+	{
+		indices_.resize(count);
+		positions_.resize(count);
+		if (count == 0)
+		{
+			dimensions_ = glm::ivec3(0);
+			cellStart_.assign(1, 0);
+			return;
+		}
+
+		glm::vec3 minimum(std::numeric_limits<float>::max());
+		glm::vec3 maximum(std::numeric_limits<float>::lowest());
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			minimum = glm::min(minimum, glm::vec3(x[i], y[i], z[i]));
+			maximum = glm::max(maximum, glm::vec3(x[i], y[i], z[i]));
+		}
+		origin_ = minimum;
+		const glm::vec3 extent = maximum - minimum;
+
+		// Grow the cells until the grid stays in proportion to the points.
+		const double maxCells = 2.0 * static_cast<double>(count) + 64.0;
+		cellSize_ = requestedCellSize_;
+		for (;;)
+		{
+			dimensions_ = glm::ivec3(extent / cellSize_) + glm::ivec3(1);
+			const double cells =
+				static_cast<double>(dimensions_.x) *
+				static_cast<double>(dimensions_.y) *
+				static_cast<double>(dimensions_.z);
+			if (cells <= maxCells) break;
+			cellSize_ *= 1.5f;
+		}
+
+		// Counting sort of the points by cell.
+		const std::size_t cellCount =
+			static_cast<std::size_t>(dimensions_.x) * dimensions_.y * dimensions_.z;
+		cellStart_.assign(cellCount + 1, 0);
+		cellOfPoint_.resize(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const auto cell = static_cast<std::uint32_t>(
+				CellIndex(CellOf(glm::vec3(x[i], y[i], z[i]))));
+			cellOfPoint_[i] = cell;
+			++cellStart_[cell + 1];
+		}
+		for (std::size_t cell = 0; cell < cellCount; ++cell)
+		{
+			cellStart_[cell + 1] += cellStart_[cell];
+		}
+		cursor_.assign(cellStart_.begin(), cellStart_.end() - 1);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::uint32_t slot = cursor_[cellOfPoint_[i]]++;
+			indices_[slot] = static_cast<std::uint32_t>(i);
+			positions_[slot] = glm::vec3(x[i], y[i], z[i]);
+		}
+	}
+
+	glm::ivec3 SpatialGrid::CellOf(const glm::vec3& position) const
+	{
+		const glm::ivec3 cell(glm::floor((position - origin_) / cellSize_));
+		return glm::clamp(cell, glm::ivec3(0), dimensions_ - glm::ivec3(1));
+	}
+
+	std::size_t SpatialGrid::CellIndex(const glm::ivec3& cell) const
+	{
+		return (static_cast<std::size_t>(cell.z) * dimensions_.y + cell.y) * dimensions_.x + cell.x;
+	}
+
+	template<typename Visitor>
+	void SpatialGrid::ForEachInCells(glm::ivec3 minCell, glm::ivec3 maxCell, Visitor visit) const
+	{
+		minCell = glm::max(minCell, glm::ivec3(0));
+		maxCell = glm::min(maxCell, dimensions_ - glm::ivec3(1));
+		if (minCell.x > maxCell.x) return;
+		for (int z = minCell.z; z <= maxCell.z; ++z)
+		{
+			for (int y = minCell.y; y <= maxCell.y; ++y)
+			{
+				// Cells of a row are contiguous, so are their points.
+				const std::size_t rowBegin = CellIndex(glm::ivec3(minCell.x, y, z));
+				const std::size_t rowEnd = CellIndex(glm::ivec3(maxCell.x, y, z)) + 1;
+				for (std::uint32_t slot = cellStart_[rowBegin]; slot < cellStart_[rowEnd]; ++slot)
+				{
+					visit(slot);
+				}
+			}
+		}
+	}
+
+	std::size_t SpatialGrid::QueryRadius(
+		const glm::vec3& center,
+		float radius,
+		std::vector<std::uint32_t>& out) const
+	{
+		if (indices_.empty() || radius < 0.0f) return 0;
+		const std::size_t before = out.size();
+		const float radiusSquared = radius * radius;
+		const glm::ivec3 minCell(glm::floor((center - glm::vec3(radius) - origin_) / cellSize_));
+		const glm::ivec3 maxCell(glm::floor((center + glm::vec3(radius) - origin_) / cellSize_));
+		if (glm::any(glm::lessThan(maxCell, glm::ivec3(0))) ||
+			glm::any(glm::greaterThanEqual(minCell, dimensions_)))
+		{
+			return 0;
+		}
+		ForEachInCells(minCell, maxCell, [&](std::uint32_t slot)
+			{
+				const glm::vec3 delta = positions_[slot] - center;
+				if (glm::dot(delta, delta) <= radiusSquared)
+				{
+					out.push_back(indices_[slot]);
+				}
+			});
+		return out.size() - before;
+	}
+
+	void SpatialGrid::QueryNearest(
+		const glm::vec3& center,
+		std::size_t n,
+		std::vector<std::uint32_t>& out) const
+	{
+		out.clear();
+		n = std::min(n, indices_.size());
+		if (n == 0) return;
+
+		// Max-heap of the best n candidates as (distance squared, index).
+		std::vector<std::pair<float, std::uint32_t>> best;
+		best.reserve(n);
+		const auto consider = [&](std::uint32_t slot)
+		{
+			const glm::vec3 delta = positions_[slot] - center;
+			const float distanceSquared = glm::dot(delta, delta);
+			if (best.size() < n)
+			{
+				best.emplace_back(distanceSquared, indices_[slot]);
+				std::push_heap(best.begin(), best.end());
+			}
+			else if (distanceSquared < best.front().first)
+			{
+				std::pop_heap(best.begin(), best.end());
+				best.back() = { distanceSquared, indices_[slot] };
+				std::push_heap(best.begin(), best.end());
+			}
+		};
+
+		// Visit shells of cells around the center cell, ring by ring. Once
+		// n candidates are known, stop when the next ring cannot hold a
+		// closer point than the current worst one.
+		const glm::ivec3 centerCell(glm::floor((center - origin_) / cellSize_));
+		const int maxRing = glm::max(
+			glm::max(
+				glm::max(centerCell.x, dimensions_.x - 1 - centerCell.x),
+				glm::max(centerCell.y, dimensions_.y - 1 - centerCell.y)),
+			glm::max(centerCell.z, dimensions_.z - 1 - centerCell.z));
+		// Distance from center to the border of its own cell.
+		const glm::vec3 local = center - origin_ - glm::vec3(centerCell) * cellSize_;
+		const float inner = glm::min(
+			glm::min(glm::min(local.x, cellSize_ - local.x), glm::min(local.y, cellSize_ - local.y)),
+			glm::min(local.z, cellSize_ - local.z));
+		for (int ring = 0; ring <= maxRing; ++ring)
+		{
+			if (best.size() == n)
+			{
+				// Any point of this ring is at least this far away.
+				const float reach = glm::max(0.0f, inner + static_cast<float>(ring - 1) * cellSize_);
+				if (reach * reach > best.front().first) break;
+			}
+			for (int z = centerCell.z - ring; z <= centerCell.z + ring; ++z)
+			{
+				for (int y = centerCell.y - ring; y <= centerCell.y + ring; ++y)
+				{
+					const bool faceRow =
+						z == centerCell.z - ring || z == centerCell.z + ring ||
+						y == centerCell.y - ring || y == centerCell.y + ring;
+					if (faceRow)
+					{
+						ForEachInCells(
+							glm::ivec3(centerCell.x - ring, y, z),
+							glm::ivec3(centerCell.x + ring, y, z),
+							consider);
+					}
+					else
+					{
+						// Only the two ends of the row belong to the shell.
+						ForEachInCells(
+							glm::ivec3(centerCell.x - ring, y, z),
+							glm::ivec3(centerCell.x - ring, y, z),
+							consider);
+						if (ring > 0)
+						{
+							ForEachInCells(
+								glm::ivec3(centerCell.x + ring, y, z),
+								glm::ivec3(centerCell.x + ring, y, z),
+								consider);
+						}
+					}
+				}
+			}
+		}
+
+		std::sort_heap(best.begin(), best.end());
+		out.reserve(best.size());
+		for (const auto& candidate : best)
+		{
+			out.push_back(candidate.second);
+		}
+	}
+
+} // End namespace gl.
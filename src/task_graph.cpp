@@ -0,0 +1,83 @@
+#include "task_graph.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "profiler.h"
+
+namespace gl {
+
+	TaskGraph::TaskId TaskGraph::AddTask(
+		std::string name,
+		TaskFunction func,
+		const std::vector<TaskId>& dependencies)
+	{
+		const TaskId id = tasks_.size();
+		auto task = std::make_unique<Task>();
+		task->name = std::move(name);
+		task->profileName = Profiler::Get().Intern(task->name);
+		task->func = std::move(func);
+		task->dependencyCount = dependencies.size();
+		for (const TaskId dependency : dependencies)
+		{
+			assert(dependency < id);
+			tasks_[dependency]->successors.push_back(id);
+		}
+		tasks_.push_back(std::move(task));
+		return id;
+	}
+
+	void TaskGraph::Run(JobSystem& jobSystem)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		JobCounter counter;
+		jobSystem_ = &jobSystem;
+		counter_ = &counter;
+		for (auto& task : tasks_)
+		{
+			task->pending.store(task->dependencyCount, std::memory_order_relaxed);
+		}
+		for (TaskId id = 0; id < tasks_.size(); ++id)
+		{
+			if (tasks_[id]->dependencyCount == 0)
+			{
+				Schedule(id);
+			}
+		}
+		jobSystem.Wait(counter);
+		jobSystem_ = nullptr;
+		counter_ = nullptr;
+		milliseconds_ = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	void TaskGraph::Clear()
+	{
+		tasks_.clear();
+	}
+
+	void TaskGraph::Schedule(TaskId id)
+	{
+		jobSystem_->Run([this, id]()
+			{
+				Task& task = *tasks_[id];
+				const auto start = std::chrono::steady_clock::now();
+				{
+					GPR5300_PROFILE_ZONE(task.profileName);
+					task.func();
+				}
+				task.milliseconds = std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - start).count();
+				// Successors are queued before this job leaves the counter,
+				// so the counter cannot reach zero with work left.
+				for (const TaskId successor : task.successors)
+				{
+					if (tasks_[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						Schedule(successor);
+					}
+				}
+			}, counter_);
+	}
+
+} // End namespace gl.
@@ -1,21 +1,53 @@
 #include "texture.h"
 
+#include <cassert>
+#include <iostream>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "vfs.h"
+
 namespace gl {
-	Texture::Texture(const std::string& file_name)
+	void TextureImage::PixelsDeleter::operator()(unsigned char* pixels) const
+	{
+		stbi_image_free(pixels);
+	}
+
+	TextureImage TextureImage::Load(const std::string& file_name)
+	{
+		TextureImage image;
+		const VfsFile file = Vfs::Read(file_name);
+		if (!file.IsValid()) return image;
+		// Per thread: images are decoded on job threads side by side.
+		stbi_set_flip_vertically_on_load_thread(true);
+		image.pixels.reset(stbi_load_from_memory(
+			reinterpret_cast<const stbi_uc*>(file.GetBytes().data()),
+			static_cast<int>(file.GetBytes().size()),
+			&image.width,
+			&image.height,
+			&image.channels,
+			0));
+		if (image.pixels == nullptr)
+		{
+			std::cerr << "[Error] Could not load " << file_name << ": " << stbi_failure_reason() << "\n";
+		}
+		return image;
+	}
+
+	Texture::Texture(const std::string& file_name) :
+		Texture(TextureImage::Load(file_name))
+	{
+	}
+
+	Texture::Texture(const TextureImage& image)
 	{
-		int width, height, nrChannels;
-			stbi_set_flip_vertically_on_load(true);
-			unsigned char* dataDiffuse = stbi_load(
-				file_name.c_str(),
-				&width,
-				&height,
-				&nrChannels,
-				0);
+		const int width = image.width;
+		const int height = image.height;
+		const int nrChannels = image.channels;
+		const unsigned char* dataDiffuse = image.pixels.get();
 			assert(dataDiffuse);
-			glGenTextures(1, &id);
+			id = GlTexture::Create("Texture");
 			glBindTexture(GL_TEXTURE_2D, id);
 			if (nrChannels == 1)
 			{
@@ -68,6 +100,7 @@ namespace gl {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glGenerateMipmap(GL_TEXTURE_2D);
 			glBindTexture(GL_TEXTURE_2D, 0);
+			id.SetBytes(TextureBytes(width, height, nrChannels, true));
 	}
 
 	void Texture::Bind(unsigned int i) const
@@ -0,0 +1,287 @@
+#include "transform_hierarchy.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "scene.h"
+
+namespace gl {
+
+	namespace {
+
+		// parent * local for affine matrices: the last rows are (0, 0, 0, 1)
+		// and need no products.
+		glm::mat4 MultiplyAffine(const glm::mat4& parent, const glm::mat4& local)
+		{
+			glm::mat4 result;
+			for (int column = 0; column < 3; ++column)
+			{
+				result[column] =
+					parent[0] * local[column].x +
+					parent[1] * local[column].y +
+					parent[2] * local[column].z;
+			}
+			result[3] =
+				parent[0] * local[3].x +
+				parent[1] * local[3].y +
+				parent[2] * local[3].z +
+				parent[3];
+			return result;
+		}
+
+	} // namespace
+
+	glm::mat3 ComputeNormalMatrix(const glm::mat4& model)
+	{
+		const glm::vec3 x(model[0]);
+		const glm::vec3 y(model[1]);
+		const glm::vec3 z(model[2]);
+		// The rows of the inverse are these over the determinant.
+		const glm::vec3 yz = glm::cross(y, z);
+		const glm::vec3 zx = glm::cross(z, x);
+		const glm::vec3 xy = glm::cross(x, y);
+		const float inverseDeterminant = 1.0f / glm::dot(x, yz);
+		return glm::mat3(yz * inverseDeterminant, zx * inverseDeterminant, xy * inverseDeterminant);
+	}
+
+	TransformHierarchy::NodeId TransformHierarchy::CreateNode(const Transform& local, NodeId parent)
+	{
+		NodeId node;
+		if (!freeIds_.empty())
+		{
+			node = freeIds_.back();
+			freeIds_.pop_back();
+		}
+		else
+		{
+			node = static_cast<NodeId>(indices_.size());
+			indices_.push_back(kNoIndex);
+		}
+		// Appended after every existing node, so after its parent too.
+		const auto index = static_cast<std::uint32_t>(parents_.size());
+		indices_[node] = index;
+		parents_.push_back(parent == kNullNode ? kNoIndex : GetIndex(parent));
+		locals_.push_back(local);
+		worlds_.emplace_back(1.0f);
+		normals_.emplace_back(1.0f);
+		dirty_.push_back(0);
+		ids_.push_back(node);
+		MarkDirty(index);
+		return node;
+	}
+
+	void TransformHierarchy::DestroyNode(NodeId node)
+	{
+		if (!IsAlive(node)) return;
+		if (!sorted_) Sort();
+		// The subtree is after the node: flag it in one pass, then pack the
+		// nodes left, keeping their order.
+		const std::uint32_t first = GetIndex(node);
+		std::vector<std::uint32_t> remap(parents_.size(), kNoIndex);
+		std::uint32_t kept = first;
+		for (std::uint32_t index = first; index < parents_.size(); ++index)
+		{
+			const std::uint32_t parent = parents_[index];
+			if (index == first || (parent != kNoIndex && parent >= first && remap[parent] == kNoIndex))
+			{
+				indices_[ids_[index]] = kNoIndex;
+				freeIds_.push_back(ids_[index]);
+				continue;
+			}
+			remap[index] = kept;
+			parents_[kept] = parent != kNoIndex && parent >= first ? remap[parent] : parent;
+			locals_[kept] = locals_[index];
+			worlds_[kept] = worlds_[index];
+			normals_[kept] = normals_[index];
+			dirty_[kept] = dirty_[index];
+			ids_[kept] = ids_[index];
+			indices_[ids_[kept]] = kept;
+			++kept;
+		}
+		parents_.resize(kept);
+		locals_.resize(kept);
+		worlds_.resize(kept);
+		normals_.resize(kept);
+		dirty_.resize(kept);
+		ids_.resize(kept);
+		firstDirty_ = std::min<std::size_t>(firstDirty_, first);
+	}
+
+	bool TransformHierarchy::IsAlive(NodeId node) const
+	{
+		return node < indices_.size() && indices_[node] != kNoIndex;
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		parents_.clear();
+		locals_.clear();
+		worlds_.clear();
+		normals_.clear();
+		dirty_.clear();
+		ids_.clear();
+		indices_.clear();
+		freeIds_.clear();
+		updated_.clear();
+		firstDirty_ = 0;
+		sorted_ = true;
+	}
+
+	bool TransformHierarchy::SetParent(NodeId node, NodeId parent)
+	{
+		const std::uint32_t index = GetIndex(node);
+		std::uint32_t parentIndex = kNoIndex;
+		if (parent != kNullNode)
+		{
+			parentIndex = GetIndex(parent);
+			for (std::uint32_t ancestor = parentIndex; ancestor != kNoIndex; ancestor = parents_[ancestor])
+			{
+				if (ancestor == index)
+				{
+					std::cerr << "[Error] Node " << parent << " is inside the subtree of node " << node << "\n";
+					return false;
+				}
+			}
+		}
+		parents_[index] = parentIndex;
+		if (parentIndex != kNoIndex && parentIndex > index)
+		{
+			sorted_ = false;
+		}
+		MarkDirty(index);
+		return true;
+	}
+
+	TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const
+	{
+		const std::uint32_t parent = parents_[GetIndex(node)];
+		return parent == kNoIndex ? kNullNode : ids_[parent];
+	}
+
+	void TransformHierarchy::SetLocal(NodeId node, const Transform& local)
+	{
+		const std::uint32_t index = GetIndex(node);
+		locals_[index] = local;
+		MarkDirty(index);
+	}
+
+	const Transform& TransformHierarchy::GetLocal(NodeId node) const
+	{
+		return locals_[GetIndex(node)];
+	}
+
+	const glm::mat4& TransformHierarchy::GetWorld(NodeId node) const
+	{
+		return worlds_[GetIndex(node)];
+	}
+
+	const glm::mat3& TransformHierarchy::GetNormalMatrix(NodeId node) const
+	{
+		return normals_[GetIndex(node)];
+	}
+
+	void TransformHierarchy::Update()
+	{
+		updated_.clear();
+		if (!sorted_) Sort();
+		const std::size_t count = parents_.size();
+		if (firstDirty_ >= count) return;
+		// Parents come first, so a parent's flag is final when its children
+		// are reached: a child of a recomputed node is flagged in turn.
+		for (std::size_t index = firstDirty_; index < count; ++index)
+		{
+			const std::uint32_t parent = parents_[index];
+			if (dirty_[index] == 0 && (parent == kNoIndex || dirty_[parent] == 0)) continue;
+			dirty_[index] = 1;
+			const glm::mat4 local = locals_[index].ToMatrix();
+			worlds_[index] = parent == kNoIndex ? local : MultiplyAffine(worlds_[parent], local);
+			normals_[index] = ComputeNormalMatrix(worlds_[index]);
+			updated_.push_back(ids_[index]);
+		}
+		std::fill(dirty_.begin() + static_cast<std::ptrdiff_t>(firstDirty_), dirty_.end(), std::uint8_t(0));
+		firstDirty_ = count;
+	}
+
+	void TransformHierarchy::MarkDirty(std::uint32_t index)
+	{
+		dirty_[index] = 1;
+		firstDirty_ = std::min<std::size_t>(firstDirty_, index);
+	}
+
+	void TransformHierarchy::Sort()
+	{
+		// Nodes by depth (stable): a parent is always one level above.
+		const std::size_t count = parents_.size();
+		constexpr std::uint32_t kUnknown = kNoIndex;
+		std::vector<std::uint32_t> depths(count, kUnknown);
+		std::vector<std::uint32_t> path;
+		std::uint32_t maxDepth = 0;
+		for (std::uint32_t index = 0; index < count; ++index)
+		{
+			std::uint32_t node = index;
+			while (node != kNoIndex && depths[node] == kUnknown)
+			{
+				path.push_back(node);
+				node = parents_[node];
+			}
+			std::uint32_t depth = node == kNoIndex ? 0 : depths[node] + 1;
+			while (!path.empty())
+			{
+				depths[path.back()] = depth++;
+				path.pop_back();
+			}
+			maxDepth = std::max(maxDepth, depths[index]);
+		}
+		std::vector<std::uint32_t> starts(maxDepth + 2, 0);
+		for (const std::uint32_t depth : depths)
+		{
+			++starts[depth + 1];
+		}
+		for (std::size_t depth = 1; depth < starts.size(); ++depth)
+		{
+			starts[depth] += starts[depth - 1];
+		}
+		std::vector<std::uint32_t> remap(count);
+		for (std::uint32_t index = 0; index < count; ++index)
+		{
+			remap[index] = starts[depths[index]]++;
+		}
+
+		std::vector<std::uint32_t> parents(count);
+		std::vector<Transform> locals(count);
+		std::vector<glm::mat4> worlds(count);
+		std::vector<glm::mat3> normals(count);
+		std::vector<std::uint8_t> dirty(count);
+		std::vector<NodeId> ids(count);
+		firstDirty_ = count;
+		for (std::uint32_t index = 0; index < count; ++index)
+		{
+			const std::uint32_t sorted = remap[index];
+			parents[sorted] = parents_[index] == kNoIndex ? kNoIndex : remap[parents_[index]];
+			locals[sorted] = locals_[index];
+			worlds[sorted] = worlds_[index];
+			normals[sorted] = normals_[index];
+			dirty[sorted] = dirty_[index];
+			ids[sorted] = ids_[index];
+			indices_[ids_[index]] = sorted;
+			if (dirty_[index] != 0) firstDirty_ = std::min<std::size_t>(firstDirty_, sorted);
+		}
+		parents_ = std::move(parents);
+		locals_ = std::move(locals);
+		worlds_ = std::move(worlds);
+		normals_ = std::move(normals);
+		dirty_ = std::move(dirty);
+		ids_ = std::move(ids);
+		sorted_ = true;
+	}
+
+	void SyncTransformNodes(Scene& scene, TransformHierarchy& hierarchy)
+	{
+		scene.ForEach<const Transform, const Velocity, const TransformNode>(
+			[&hierarchy](const Transform& transform, const Velocity&, const TransformNode& node)
+			{
+				hierarchy.SetLocal(node.node, transform);
+			});
+	}
+
+} // End namespace gl.
@@ -0,0 +1,347 @@
+#include "vfs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include "mapped_file.h"
+
+namespace gl {
+
+	static_assert(sizeof(PackHeader) % alignof(PackEntry) == 0);
+
+	namespace {
+
+		struct Pack
+		{
+			MappedFile file;
+			const PackEntry* entries = nullptr;
+			std::uint32_t entryCount = 0;
+		};
+
+		Pack& GetPack()
+		{
+			static Pack pack;
+			return pack;
+		}
+
+		std::filesystem::path& GetLooseRootPath()
+		{
+			static std::filesystem::path root = "../data";
+			return root;
+		}
+
+		std::uint64_t AlignUp(std::uint64_t offset, std::uint64_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		std::string_view GetEntryPath(const Pack& pack, const PackEntry& entry)
+		{
+			return { reinterpret_cast<const char*>(pack.file.GetData()) + entry.pathOffset, entry.pathSize };
+		}
+
+		const PackEntry* Find(std::string_view name)
+		{
+			const Pack& pack = GetPack();
+			if (pack.entries == nullptr) return nullptr;
+			const PackEntry* end = pack.entries + pack.entryCount;
+			const PackEntry* entry = std::lower_bound(
+				pack.entries,
+				end,
+				name,
+				[&pack](const PackEntry& entry, std::string_view name)
+				{
+					return GetEntryPath(pack, entry) < name;
+				});
+			return entry != end && GetEntryPath(pack, *entry) == name ? entry : nullptr;
+		}
+
+		bool ReadWhole(const std::filesystem::path& path, std::vector<char>& contents)
+		{
+			std::ifstream input(path, std::ios::binary | std::ios::ate);
+			if (!input) return false;
+			contents.resize(static_cast<std::size_t>(input.tellg()));
+			input.seekg(0);
+			input.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+			return static_cast<bool>(input);
+		}
+
+		bool Validate(const Pack& pack, const std::filesystem::path& path)
+		{
+			const std::uint64_t size = pack.file.GetSize();
+			std::string_view previous;
+			for (std::uint32_t i = 0; i < pack.entryCount; ++i)
+			{
+				const PackEntry& entry = pack.entries[i];
+				const bool compressed = (entry.flags & kPackEntryLz4) != 0;
+				const bool valid =
+					entry.pathOffset <= size && entry.pathSize <= size - entry.pathOffset &&
+					entry.offset % kPackAlignment == 0 &&
+					entry.offset <= size && entry.storedSize <= size - entry.offset &&
+					(compressed ?
+						entry.storedSize <= static_cast<std::uint64_t>(std::numeric_limits<int>::max()) &&
+						entry.size <= static_cast<std::uint64_t>(std::numeric_limits<int>::max()) :
+						entry.storedSize == entry.size);
+				// Sorted and unique, or the lookups miss.
+				if (!valid || (i > 0 && GetEntryPath(pack, entry) <= previous))
+				{
+					std::cerr << "[Error] " << path.string() << " is corrupt\n";
+					return false;
+				}
+				previous = GetEntryPath(pack, entry);
+			}
+			return true;
+		}
+
+	} // namespace
+
+	bool WritePack(
+		const std::filesystem::path& directory,
+		const std::filesystem::path& destination,
+		bool compress)
+	{
+		struct Source
+		{
+			std::filesystem::path file;
+			std::string name;
+		};
+		auto temporary = destination;
+		temporary += ".tmp";
+		std::error_code ignored;
+		const auto skipped = {
+			std::filesystem::weakly_canonical(destination, ignored),
+			std::filesystem::weakly_canonical(temporary, ignored) };
+		std::error_code error;
+		std::vector<Source> sources;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			if (!entry.is_regular_file()) continue;
+			// A pack written into the directory it packs.
+			const auto canonical = std::filesystem::weakly_canonical(entry.path(), ignored);
+			if (std::find(skipped.begin(), skipped.end(), canonical) != skipped.end()) continue;
+			sources.push_back({
+				entry.path(),
+				Vfs::Normalize(entry.path().lexically_relative(directory).generic_string()) });
+		}
+		if (error)
+		{
+			std::cerr << "[Error] Could not list " << directory.string() << ": " << error.message() << "\n";
+			return false;
+		}
+		std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.name < b.name; });
+
+		// Header, entries, paths, then the data from the next boundary on.
+		PackHeader header{};
+		std::memcpy(header.magic, kPackMagic, sizeof(header.magic));
+		header.version = kPackVersion;
+		header.entryOffset = sizeof(PackHeader);
+		header.entryCount = static_cast<std::uint32_t>(sources.size());
+		std::vector<PackEntry> entries(sources.size());
+		std::string paths;
+		const std::uint64_t pathStart = header.entryOffset + entries.size() * sizeof(PackEntry);
+		for (std::size_t i = 0; i < sources.size(); ++i)
+		{
+			entries[i].pathOffset = static_cast<std::uint32_t>(pathStart + paths.size());
+			entries[i].pathSize = static_cast<std::uint32_t>(sources[i].name.size());
+			paths += sources[i].name;
+		}
+		const std::uint64_t dataStart = AlignUp(pathStart + paths.size(), kPackAlignment);
+
+		std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+		const std::vector<char> zeros(kPackAlignment);
+		for (std::uint64_t offset = 0; offset < dataStart; offset += kPackAlignment)
+		{
+			output.write(zeros.data(), kPackAlignment);
+		}
+		std::uint64_t offset = dataStart;
+		std::vector<char> contents;
+		std::vector<char> compressed;
+		for (std::size_t i = 0; i < sources.size() && output; ++i)
+		{
+			if (!ReadWhole(sources[i].file, contents))
+			{
+				std::cerr << "[Error] Could not read " << sources[i].file.string() << "\n";
+				return false;
+			}
+			PackEntry& entry = entries[i];
+			const char* stored = contents.data();
+			entry.offset = offset;
+			entry.size = contents.size();
+			entry.storedSize = contents.size();
+			// Kept only when it saves an eighth: images already compressed
+			// stay as they are, and are then read without a copy.
+			if (compress && !contents.empty() && contents.size() <= static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE))
+			{
+				const int size = static_cast<int>(contents.size());
+				compressed.resize(static_cast<std::size_t>(LZ4_compressBound(size)));
+				const int compressedSize = LZ4_compress_HC(
+					contents.data(),
+					compressed.data(),
+					size,
+					static_cast<int>(compressed.size()),
+					LZ4HC_CLEVEL_MAX);
+				if (compressedSize > 0 && compressedSize < size - size / 8)
+				{
+					stored = compressed.data();
+					entry.storedSize = static_cast<std::uint64_t>(compressedSize);
+					entry.flags |= kPackEntryLz4;
+				}
+			}
+			output.write(stored, static_cast<std::streamsize>(entry.storedSize));
+			header.size = offset + entry.storedSize;
+			offset = AlignUp(header.size, kPackAlignment);
+			if (i + 1 < sources.size())
+			{
+				output.write(zeros.data(), static_cast<std::streamsize>(offset - header.size));
+			}
+		}
+		if (sources.empty()) header.size = dataStart;
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+		output.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+		output.close();
+		if (!output)
+		{
+			std::cerr << "[Error] Could not write " << temporary.string() << "\n";
+			return false;
+		}
+		// Renamed once whole, as cooked scenes are.
+		std::filesystem::rename(temporary, destination, error);
+		if (error)
+		{
+			std::cerr << "[Error] Could not write " << destination.string() << ": " << error.message() << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool Vfs::Mount(const std::filesystem::path& pack)
+	{
+		Unmount();
+		Pack mounted;
+		if (!mounted.file.Open(pack)) return false;
+		const std::byte* data = mounted.file.GetData();
+		const std::uint64_t size = mounted.file.GetSize();
+		PackHeader header{};
+		if (size < sizeof(header))
+		{
+			std::cerr << "[Error] " << pack.string() << " is not a pack\n";
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, kPackMagic, sizeof(header.magic)) != 0 ||
+			header.version != kPackVersion)
+		{
+			std::cerr << "[Error] " << pack.string() << " is not a pack of version " << kPackVersion << "\n";
+			return false;
+		}
+		if (header.size != size ||
+			header.entryOffset % alignof(PackEntry) != 0 ||
+			header.entryOffset > size ||
+			header.entryCount > (size - header.entryOffset) / sizeof(PackEntry))
+		{
+			std::cerr << "[Error] " << pack.string() << " is truncated or corrupt\n";
+			return false;
+		}
+		mounted.entries = reinterpret_cast<const PackEntry*>(data + header.entryOffset);
+		mounted.entryCount = header.entryCount;
+		if (!Validate(mounted, pack)) return false;
+		GetPack() = std::move(mounted);
+		return true;
+	}
+
+	void Vfs::Unmount()
+	{
+		Pack& pack = GetPack();
+		pack.entries = nullptr;
+		pack.entryCount = 0;
+		pack.file.Close();
+	}
+
+	bool Vfs::IsMounted()
+	{
+		return GetPack().entries != nullptr;
+	}
+
+	void Vfs::SetLooseRoot(const std::filesystem::path& directory)
+	{
+		GetLooseRootPath() = directory;
+	}
+
+	VfsFile Vfs::Read(std::string_view path)
+	{
+		const std::string name = Normalize(path);
+		VfsFile file;
+		if (const PackEntry* entry = Find(name))
+		{
+			const std::byte* stored = GetPack().file.GetData() + entry->offset;
+			if ((entry->flags & kPackEntryLz4) == 0)
+			{
+				file.bytes_ = { stored, entry->size };
+				file.valid_ = true;
+				return file;
+			}
+			file.owned_ = std::make_unique_for_overwrite<std::byte[]>(entry->size);
+			const int size = LZ4_decompress_safe(
+				reinterpret_cast<const char*>(stored),
+				reinterpret_cast<char*>(file.owned_.get()),
+				static_cast<int>(entry->storedSize),
+				static_cast<int>(entry->size));
+			if (size < 0 || static_cast<std::uint64_t>(size) != entry->size)
+			{
+				std::cerr << "[Error] " << name << " is corrupt in the pack\n";
+				return {};
+			}
+			file.bytes_ = { file.owned_.get(), entry->size };
+			file.valid_ = true;
+			return file;
+		}
+
+		const auto loose = GetLoosePath(name);
+		std::ifstream input(loose, std::ios::binary | std::ios::ate);
+		if (!input)
+		{
+			std::cerr << "[Error] Could not open " << loose.string() << "\n";
+			return {};
+		}
+		const auto size = static_cast<std::size_t>(input.tellg());
+		input.seekg(0);
+		file.owned_ = std::make_unique_for_overwrite<std::byte[]>(size);
+		input.read(reinterpret_cast<char*>(file.owned_.get()), static_cast<std::streamsize>(size));
+		if (!input)
+		{
+			std::cerr << "[Error] Could not read " << loose.string() << "\n";
+			return {};
+		}
+		file.bytes_ = { file.owned_.get(), size };
+		file.valid_ = true;
+		return file;
+	}
+
+	bool Vfs::IsPacked(std::string_view path)
+	{
+		return Find(Normalize(path)) != nullptr;
+	}
+
+	std::filesystem::path Vfs::GetLoosePath(std::string_view path)
+	{
+		// An absolute path replaces the root.
+		return GetLooseRootPath() / std::filesystem::path(Normalize(path));
+	}
+
+	std::string Vfs::Normalize(std::string_view path)
+	{
+		std::string name(path);
+		std::replace(name.begin(), name.end(), '\\', '/');
+		return std::filesystem::path(name).lexically_normal().generic_string();
+	}
+
+} // End namespace gl.
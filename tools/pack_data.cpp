@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "scene_file.h"
+#include "vfs.h"
+
+// Packs a data directory into one file for the Vfs (see include/vfs.h).
+// The JSON levels in scenes/ are cooked first, so the pack holds their
+// cooked form next to them and the demos never cook at load time.
+//
+//     pack_data [--store] <data directory> <pack>
+//
+// --store: no LZ4, every entry is read in place.
+
+int main(int argc, char** argv)
+{
+	bool compress = true;
+	std::vector<std::filesystem::path> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string_view(argv[i]) == "--store")
+		{
+			compress = false;
+		}
+		else
+		{
+			paths.emplace_back(argv[i]);
+		}
+	}
+	if (paths.size() != 2)
+	{
+		std::cerr << "Usage: pack_data [--store] <data directory> <pack>\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path& directory = paths[0];
+	const std::filesystem::path& pack = paths[1];
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory / "scenes", error))
+	{
+		if (entry.path().extension() != ".json") continue;
+		auto cooked = entry.path();
+		cooked.replace_extension(".scene");
+		if (!gl::CookScene(entry.path(), cooked)) return EXIT_FAILURE;
+	}
+	if (!gl::WritePack(directory, pack, compress)) return EXIT_FAILURE;
+	std::cout << "Packed " << directory.string() << " into " << pack.string() <<
+		" (" << std::filesystem::file_size(pack, error) << " bytes)\n";
+	return EXIT_SUCCESS;
+}